@@ -21,13 +21,28 @@
 
 using namespace dds::core::xtypes;
 
-long double
-    rti::common::dynamic_data::get_dds_primitive_or_enum_type_value(
+/*
+ * The helpers may identify a member either by its name or by its index. The
+ * functions below are shared by both flavors of each helper.
+ */
+static std::string member_name(const std::string& field)
+{
+    return field;
+}
+
+static std::string member_name(uint32_t index)
+{
+    return "#" + std::to_string(index);
+}
+
+template <typename MemberKey>
+static long double get_primitive_or_enum_value(
         const DynamicData& data,
-        const std::string &field)
+        const TypeKind kind,
+        const MemberKey& field)
 {
     long double float_value = 0;
-    switch (data.member_info(field).member_kind().underlying()) {
+    switch (kind.underlying()) {
     case TypeKind::BOOLEAN_TYPE:
         float_value = data.value<bool>(field) ? 1 : 0;
         break;
@@ -63,21 +78,22 @@ long double
         float_value = data.value<double>(field);
         break;
     default:
-        std::string error("unsupported type of <" + field + ">");
+        std::string error("unsupported type of <" + member_name(field) + ">");
         throw std::runtime_error(error);
     }
     return float_value;
 }
 
-std::vector<long double>
-    rti::common::dynamic_data::get_vector_values(
+template <typename MemberKey>
+static std::vector<long double> get_member_vector_values(
         const DynamicData& data,
-        const std::string& field)
+        const TypeKind element_kind,
+        const MemberKey& field)
 {
     std::vector<long double> float_vector;
     size_t size = data.member_info(field).element_count();
 
-    switch (data.member_info(field).element_kind().underlying()) {
+    switch (element_kind.underlying()) {
     case TypeKind::CHAR_8_TYPE: {
         std::vector<char> members(size);
         data.get_values<char>(field, members);
@@ -162,17 +178,19 @@ std::vector<long double>
         break;
     }
     default:
-        std::string error("unsupported member type of <" + field + ">");
+        std::string error(
+                "unsupported member type of <" + member_name(field) + ">");
         throw std::runtime_error(error);
     }
     return float_vector;
 }
 
 
-void rti::common::dynamic_data::set_dds_primitive_or_enum_type_value(
+template <typename MemberKey>
+static void set_primitive_or_enum_value(
         DynamicData& data,
         const TypeKind type,
-        const std::string& field,
+        const MemberKey& field,
         const long double& float_value)
 {
     switch (type.underlying()) {
@@ -233,15 +251,16 @@ void rti::common::dynamic_data::set_dds_primitive_or_enum_type_value(
                 rti::utils::long_double::safe_cast<double>(float_value));
         break;
     default:
-        std::string error("unsupported type of <" + field + ">");
+        std::string error("unsupported type of <" + member_name(field) + ">");
         throw std::runtime_error(error);
     }
 }
 
-void rti::common::dynamic_data::set_vector_values(
+template <typename MemberKey>
+static void set_member_vector_values(
         DynamicData& data,
         const TypeKind type,
-        const std::string& field,
+        const MemberKey& field,
         const std::vector<long double>& float_vector)
 {
     switch (type.underlying()) {
@@ -338,11 +357,88 @@ void rti::common::dynamic_data::set_vector_values(
         break;
     }
     default:
-        std::string error("unsupported member type of <" + field + ">");
+        std::string error(
+                "unsupported member type of <" + member_name(field) + ">");
         throw std::runtime_error(error);
     }
 }
 
+long double
+    rti::common::dynamic_data::get_dds_primitive_or_enum_type_value(
+        const DynamicData& data,
+        const std::string &field)
+{
+    return get_primitive_or_enum_value(
+            data,
+            data.member_info(field).member_kind(),
+            field);
+}
+
+long double
+    rti::common::dynamic_data::get_dds_primitive_or_enum_type_value(
+        const DynamicData& data,
+        const TypeKind kind,
+        uint32_t index)
+{
+    return get_primitive_or_enum_value(data, kind, index);
+}
+
+std::vector<long double>
+    rti::common::dynamic_data::get_vector_values(
+        const DynamicData& data,
+        const std::string& field)
+{
+    return get_member_vector_values(
+            data,
+            data.member_info(field).element_kind(),
+            field);
+}
+
+std::vector<long double>
+    rti::common::dynamic_data::get_vector_values(
+        const DynamicData& data,
+        const TypeKind element_kind,
+        uint32_t index)
+{
+    return get_member_vector_values(data, element_kind, index);
+}
+
+void rti::common::dynamic_data::set_dds_primitive_or_enum_type_value(
+        DynamicData& data,
+        const TypeKind type,
+        const std::string& field,
+        const long double& float_value)
+{
+    set_primitive_or_enum_value(data, type, field, float_value);
+}
+
+void rti::common::dynamic_data::set_dds_primitive_or_enum_type_value(
+        DynamicData& data,
+        const TypeKind type,
+        uint32_t index,
+        const long double& float_value)
+{
+    set_primitive_or_enum_value(data, type, index, float_value);
+}
+
+void rti::common::dynamic_data::set_vector_values(
+        DynamicData& data,
+        const TypeKind type,
+        const std::string& field,
+        const std::vector<long double>& float_vector)
+{
+    set_member_vector_values(data, type, field, float_vector);
+}
+
+void rti::common::dynamic_data::set_vector_values(
+        DynamicData& data,
+        const TypeKind type,
+        uint32_t index,
+        const std::vector<long double>& float_vector)
+{
+    set_member_vector_values(data, type, index, float_vector);
+}
+
 bool rti::common::dynamic_data::is_signed_kind(TypeKind kind)
 {
     switch (kind.underlying()) {
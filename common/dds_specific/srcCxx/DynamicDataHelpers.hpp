@@ -28,6 +28,18 @@ long double get_dds_primitive_or_enum_type_value(
         const dds::core::xtypes::DynamicData& data,
         const std::string& field);
 
+/**
+ * @brief Gets a DDS primitive or enum value for the member at an index.
+ * @param data Dynamic Data which contains the value.
+ * @param kind the typekind of the member.
+ * @param index Index of the member of the DynamicData.
+ * @return The value from 'data' at 'index' as a long double.
+ */
+long double get_dds_primitive_or_enum_type_value(
+        const dds::core::xtypes::DynamicData& data,
+        const dds::core::xtypes::TypeKind kind,
+        uint32_t index);
+
 /**
  * @brief Gets a DDS vector of values for a specific field.
  * @param data Dynamic Data which contains the value.
@@ -38,6 +50,18 @@ std::vector<long double> get_vector_values(
         const dds::core::xtypes::DynamicData& data,
         const std::string& field);
 
+/**
+ * @brief Gets a DDS vector of values for the member at an index.
+ * @param data Dynamic Data which contains the value.
+ * @param element_kind the typekind of the elements of the member.
+ * @param index Index of the member of the DynamicData.
+ * @return The value from 'data' at 'index' as a long double vector.
+ */
+std::vector<long double> get_vector_values(
+        const dds::core::xtypes::DynamicData& data,
+        const dds::core::xtypes::TypeKind element_kind,
+        uint32_t index);
+
 /**
  * @brief Set a Dynamic Data primitive or enum value from a long double.
  * @param data Dynamic Data which contains the value.
@@ -51,6 +75,19 @@ void set_dds_primitive_or_enum_type_value(
         const std::string& field,
         const long double& float_value);
 
+/**
+ * @brief Set a Dynamic Data primitive or enum value from a long double.
+ * @param data Dynamic Data which contains the value.
+ * @param type the typekind of the element to set.
+ * @param index Index of the member of the DynamicData to set.
+ * @param float_value the value to set.
+ */
+void set_dds_primitive_or_enum_type_value(
+        dds::core::xtypes::DynamicData& data,
+        const dds::core::xtypes::TypeKind type,
+        uint32_t index,
+        const long double& float_value);
+
 /**
  * @brief Set a Dynamic Data array from a long double vector.
  * @param data Dynamic Data which contains the value.
@@ -64,6 +101,19 @@ void set_vector_values(
         const std::string& field,
         const std::vector<long double>& float_vector);
 
+/**
+ * @brief Set a Dynamic Data array from a long double vector.
+ * @param data Dynamic Data which contains the value.
+ * @param type the typekind of the element inside the vector
+ * @param index Index of the member of the DynamicData to set.
+ * @param float_vector the array to set.
+ */
+void set_vector_values(
+        dds::core::xtypes::DynamicData& data,
+        const dds::core::xtypes::TypeKind type,
+        uint32_t index,
+        const std::vector<long double>& float_vector);
+
 /**
  * @brief Check whether a TypeKind is signed or unsigned.
  * @param kind TypeKind for checking.
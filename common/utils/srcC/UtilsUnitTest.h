@@ -0,0 +1,123 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+
+#ifndef UTILSUNITTEST_H
+#define UTILSUNITTEST_H
+
+/*
+ * Minimal unit test harness shared by the tests of every plugin, which can
+ * be used both from C and from C++. Every test is a function that returns
+ * non-zero when it passes, and every test program returns a non-zero exit
+ * code when any of its tests fails, so that it can be run by CTest.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Checks a condition inside a unit test. If it is false, the condition is
+ * printed and `fail_` is executed (e.g. "goto done" to release resources
+ * before failing).
+ */
+#define RTI_UTILS_TEST_CHECK_OR(cond_, fail_)                  \
+    do {                                                       \
+        if (!(cond_)) {                                        \
+            fprintf(stderr,                                    \
+                    "%s:%d: check failed: %s\n",               \
+                    __FILE__,                                  \
+                    __LINE__,                                  \
+                    #cond_);                                   \
+            fail_;                                             \
+        }                                                      \
+    } while (0)
+
+/* Checks a condition inside a unit test, which fails if it is false */
+#define RTI_UTILS_TEST_CHECK(cond_) RTI_UTILS_TEST_CHECK_OR(cond_, return 0)
+
+struct RTI_UTILS_UnitTest {
+    const char *name;
+    int (*run)(void);
+};
+
+/* Prints the result of a test, and counts it if it failed */
+static inline void RTI_UTILS_UnitTest_report(
+        const char *name,
+        int passed,
+        int *failed)
+{
+    printf("%s: %s\n", passed ? "PASSED" : "FAILED", name);
+    fflush(stdout);
+    if (!passed) {
+        *failed += 1;
+    }
+}
+
+/*
+ * Runs a set of unit tests, and returns the exit code of the test program:
+ * 0 if all the tests pass.
+ */
+static inline int RTI_UTILS_UnitTest_run_all(
+        const struct RTI_UTILS_UnitTest *tests,
+        size_t count)
+{
+    int failed = 0;
+    size_t i = 0;
+
+    for (i = 0; i < count; i++) {
+        RTI_UTILS_UnitTest_report(tests[i].name, tests[i].run(), &failed);
+    }
+
+    return failed == 0 ? 0 : 1;
+}
+
+#ifdef __cplusplus
+
+#include <exception>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rti { namespace utils { namespace test {
+
+typedef std::pair<std::string, std::function<bool()>> UnitTest;
+
+/*
+ * Runs a set of unit tests, and returns the exit code of the test program.
+ * A test fails if it returns false or throws an exception.
+ */
+inline int run_unit_tests(const std::vector<UnitTest> &tests)
+{
+    int failed = 0;
+
+    for (auto &test : tests) {
+        bool passed = false;
+        try {
+            passed = test.second();
+        } catch (const std::exception &ex) {
+            fprintf(stderr, "%s: %s\n", test.first.c_str(), ex.what());
+        }
+        RTI_UTILS_UnitTest_report(test.first.c_str(), passed, &failed);
+    }
+
+    return failed == 0 ? 0 : 1;
+}
+
+}}}  // namespace rti::utils::test
+
+#endif /* __cplusplus */
+
+#endif /* UTILSUNITTEST_H */
@@ -133,6 +133,13 @@ RTI_RoutingServiceConnection RTI_RS_KafkaAdapterPlugin_create_connection(
         RTI_RoutingServiceEnvironment_set_error(
                 env,
                 "bootstrap.servers missing property brokers");
+        free(connection);
+        return NULL;
+    }
+
+    if (RTI_RS_KafkaConnection_initialize(connection, properties, env)) {
+        RTI_RS_KafkaConnection_finalize(connection);
+        free(connection);
         return NULL;
     }
 
@@ -149,5 +156,7 @@ void RTI_RS_KafkaAdapterPlugin_delete_connection(
             "%s",
             __func__);
 
+    RTI_RS_KafkaConnection_finalize(
+            (struct RTI_RS_KafkaConnection *) connection);
     free(connection);
 }
@@ -13,6 +13,10 @@
 /*                                                                            */
 /******************************************************************************/
 
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+
 #include "KafkaConnection.h"
 
 /**
@@ -24,7 +28,7 @@
  * failed delivery (rkmessage->err != RD_KAFKA_RESP_ERR_NO_ERROR).
  *
  * The callback is triggered from rd_kafka_poll() and executes on
- * the application's thread.
+ * the poller thread of the connection.
  */
 
 static void RTI_RS_KafkaConnection_dr_msg_cb(
@@ -32,6 +36,9 @@ static void RTI_RS_KafkaConnection_dr_msg_cb(
         const rd_kafka_message_t *rkmessage,
         void *opaque)
 {
+    struct RTI_RS_KafkaConnection *connection =
+            (struct RTI_RS_KafkaConnection *) opaque;
+
     RTI_RoutingServiceLogger_log(
             RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
             "%s",
@@ -50,9 +57,176 @@ static void RTI_RS_KafkaConnection_dr_msg_cb(
                 rkmessage->partition);
     }
 
+    /* Each message is produced with the buffer of its payload as opaque,
+     * which is returned to its stream writer, if it was taken from its
+     * pool, so it can be reused for another message. */
+    if (rkmessage->_private != NULL) {
+        RTI_RS_KafkaStreamWriter_on_delivery(
+                (struct RTI_RS_KafkaStreamWriterBuffer *) rkmessage->_private);
+    }
+
+    RTI_RS_KafkaConnection_notify_queue_space(connection);
+
     /* The rkmessage is destroyed automatically by librdkafka */
 }
 
+/*
+ * Properties in <route>/<input|output>/<property> which configure the
+ * adapter itself, and must not be passed on to librdkafka.
+ */
+static int RTI_RS_KafkaConnection_is_adapter_property(const char *name)
+{
+    return (strcmp(name, "topic") == 0)
+            || (strcmp(name, "rti.routing_service.entity.resource_name") == 0)
+            || (strcmp(name, CONSUMER_BATCH_MAX_SIZE_PROPERTY) == 0)
+            || (strcmp(name, CONSUMER_BATCH_MAX_WAIT_PROPERTY) == 0)
+            || (strcmp(name, CONSUMER_WORKERS_PROPERTY) == 0)
+            || (strcmp(name, PRODUCER_REUSE_PAYLOAD_BUFFER_PROPERTY) == 0)
+            || (strcmp(name, PRODUCER_KEY_FROM_INSTANCE_PROPERTY) == 0)
+            || (strcmp(name, PRODUCER_HEADERS_PROPERTY) == 0)
+            || (strcmp(name, PRODUCER_MAX_BLOCKING_TIME_PROPERTY) == 0);
+}
+
+/*
+ * Parse an optional integer property, leaving value_out untouched if the
+ * property is not set. Returns -1 if the value is not a number >= min_value.
+ */
+static int RTI_RS_KafkaConnection_lookup_int_property(
+        const struct RTI_RoutingServiceProperties *properties,
+        const char *name,
+        int min_value,
+        int *value_out)
+{
+    const char *value_str = NULL;
+    char *end = NULL;
+    long value = 0;
+
+    value_str = RTI_RoutingServiceProperties_lookup_property(properties, name);
+    if (value_str == NULL) {
+        return 0;
+    }
+
+    errno = 0;
+    value = strtol(value_str, &end, 10);
+    if (end == value_str || *end != '\0' || errno == ERANGE
+        || value < min_value || value > INT_MAX) {
+        return -1;
+    }
+
+    *value_out = (int) value;
+    return 0;
+}
+
+/*
+ * Parse an optional boolean property ("true"/"1" or "false"/"0"), leaving
+ * value_out untouched if the property is not set. Returns -1 if the value
+ * is not a boolean.
+ */
+static int RTI_RS_KafkaConnection_lookup_bool_property(
+        const struct RTI_RoutingServiceProperties *properties,
+        const char *name,
+        int *value_out)
+{
+    const char *value_str = NULL;
+
+    value_str = RTI_RoutingServiceProperties_lookup_property(properties, name);
+    if (value_str == NULL) {
+        return 0;
+    }
+
+    if (strcmp(value_str, "true") == 0 || strcmp(value_str, "1") == 0) {
+        *value_out = 1;
+    } else if (strcmp(value_str, "false") == 0 || strcmp(value_str, "0") == 0) {
+        *value_out = 0;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+const char *RTI_RS_KafkaConnection_parse_writer_properties(
+        struct RTI_RS_KafkaStreamWriter *writer,
+        const struct RTI_RoutingServiceProperties *properties)
+{
+    writer->max_blocking_time = PRODUCER_MAX_BLOCKING_TIME;
+
+    if (RTI_RS_KafkaConnection_lookup_bool_property(
+                properties,
+                PRODUCER_REUSE_PAYLOAD_BUFFER_PROPERTY,
+                &writer->reuse_payload_buffer)) {
+        return PRODUCER_REUSE_PAYLOAD_BUFFER_PROPERTY;
+    }
+    if (RTI_RS_KafkaConnection_lookup_bool_property(
+                properties,
+                PRODUCER_KEY_FROM_INSTANCE_PROPERTY,
+                &writer->key_from_instance)) {
+        return PRODUCER_KEY_FROM_INSTANCE_PROPERTY;
+    }
+    if (RTI_RS_KafkaConnection_lookup_bool_property(
+                properties,
+                PRODUCER_HEADERS_PROPERTY,
+                &writer->headers)) {
+        return PRODUCER_HEADERS_PROPERTY;
+    }
+    if (RTI_RS_KafkaConnection_lookup_int_property(
+                properties,
+                PRODUCER_MAX_BLOCKING_TIME_PROPERTY,
+                0,
+                &writer->max_blocking_time)) {
+        return PRODUCER_MAX_BLOCKING_TIME_PROPERTY;
+    }
+
+    return NULL;
+}
+
+const char *RTI_RS_KafkaConnection_parse_reader_properties(
+        struct RTI_RS_KafkaStreamReader *reader,
+        int *worker_count_out,
+        const struct RTI_RoutingServiceProperties *properties)
+{
+    reader->batch_max_size = CONSUMER_BATCH_MAX_SIZE;
+    reader->batch_max_wait = CONSUMER_POLL_TIMEOUT;
+    *worker_count_out = 1;
+
+    if (RTI_RS_KafkaConnection_lookup_int_property(
+                properties,
+                CONSUMER_BATCH_MAX_SIZE_PROPERTY,
+                1,
+                &reader->batch_max_size)) {
+        return CONSUMER_BATCH_MAX_SIZE_PROPERTY;
+    }
+    if (RTI_RS_KafkaConnection_lookup_int_property(
+                properties,
+                CONSUMER_BATCH_MAX_WAIT_PROPERTY,
+                0,
+                &reader->batch_max_wait)) {
+        return CONSUMER_BATCH_MAX_WAIT_PROPERTY;
+    }
+    if (RTI_RS_KafkaConnection_lookup_int_property(
+                properties,
+                CONSUMER_WORKERS_PROPERTY,
+                1,
+                worker_count_out)) {
+        return CONSUMER_WORKERS_PROPERTY;
+    }
+
+    return NULL;
+}
+
+/* Whether a type has a (top-level) member with the specified name */
+static int RTI_RS_KafkaConnection_type_has_member(
+        struct DDS_TypeCode *type_code,
+        const char *name)
+{
+    DDS_ExceptionCode_t ex = DDS_NO_EXCEPTION_CODE;
+    DDS_UnsignedLong index = 0;
+
+    index = DDS_TypeCode_find_member_by_name(type_code, name, &ex);
+    return (ex == DDS_NO_EXCEPTION_CODE
+            && index != DDS_TYPECODE_INDEX_INVALID);
+}
+
 void RTI_RS_KafkaConnection_cleanup_stream_writer(struct RTI_RS_KafkaStreamWriter *self)
 {
     RTI_RoutingServiceLogger_log(
@@ -60,16 +234,292 @@ void RTI_RS_KafkaConnection_cleanup_stream_writer(struct RTI_RS_KafkaStreamWrite
             "%s",
             __func__);
 
-    /* Free allocated resources */
-    if (self->rk != NULL) {
-        rd_kafka_destroy(self->rk);
-        self->rk = NULL;
+    if (self == NULL) {
+        return;
+    }
+
+    /* Free allocated resources. The producer belongs to the connection. */
+    if (self->rkt != NULL) {
+        rd_kafka_topic_destroy(self->rkt);
+        self->rkt = NULL;
+    }
+
+    RTI_RS_KafkaStreamWriter_finalize_buffers(self);
+    DDS_OctetSeq_finalize(&self->copy_buffer.payload);
+    DDS_OctetSeq_finalize(&self->key);
+
+    if (self->mutex != NULL) {
+        RTIOsapiSemaphore_delete(self->mutex);
+    }
+
+    free(self);
+}
+
+/*
+ * This function will run as a separate thread and serve the delivery
+ * reports (and any other callbacks) of the producer shared by the stream
+ * writers of a connection.
+ */
+static void *RTI_RS_KafkaConnection_producer_poller_thread(void *thread_params)
+{
+    struct RTI_RS_KafkaConnection *self = thread_params;
+
+    RTI_RoutingServiceLogger_log(
+            RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
+            "%s",
+            __func__);
+
+    while (self->run_poller_thread) {
+        rd_kafka_poll(self->producer, PRODUCER_POLL_TIMEOUT);
+    }
+
+    return NULL;
+}
+
+int RTI_RS_KafkaConnection_initialize(
+        struct RTI_RS_KafkaConnection *self,
+        const struct RTI_RoutingServiceProperties *properties,
+        RTI_RoutingServiceEnvironment *env)
+{
+    /* librdkafka API error reporting buffer */
+    char errstr[ERR_MSG_BUF_SIZE] = {0};
+    int i = 0;
+
+    self->producer_mutex =
+            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_MUTEX, NULL);
+    if (self->producer_mutex == NULL) {
+        RTI_RoutingServiceEnvironment_set_error(env, "Error creating mutex");
+        return -1;
+    }
+
+    self->queue_space_mutex =
+            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_MUTEX, NULL);
+    if (self->queue_space_mutex == NULL) {
+        RTI_RoutingServiceEnvironment_set_error(env, "Error creating mutex");
+        return -1;
+    }
+
+    self->queue_space_sem =
+            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_COUNTING, NULL);
+    if (self->queue_space_sem == NULL) {
+        RTI_RoutingServiceEnvironment_set_error(
+                env,
+                "Error creating semaphore");
+        return -1;
+    }
+
+    /* The producer is only created with the first stream writer, but its
+     * configuration is validated right away. bootstrap.servers is one of
+     * the <connection>/<property> elements. */
+    self->producer_conf = rd_kafka_conf_new();
+
+    for (i = 0; i < properties->count; i++) {
+        if (RTI_RS_KafkaConnection_is_adapter_property(
+                    properties->properties[i].name)) {
+            continue;
+        }
+        if (rd_kafka_conf_set(
+                    self->producer_conf,
+                    properties->properties[i].name,
+                    properties->properties[i].value,
+                    errstr,
+                    sizeof(errstr))
+            != RD_KAFKA_CONF_OK) {
+            RTI_RoutingServiceEnvironment_set_error(env, errstr);
+            return -1;
+        }
+    }
+
+    /* Set the delivery report callback.
+     * This callback will be called once per message to inform
+     * the application if delivery succeeded or failed.
+     * See dr_msg_cb() above.
+     * The callback is only triggered from rd_kafka_poll() and
+     * rd_kafka_flush(). */
+    rd_kafka_conf_set_dr_msg_cb(
+            self->producer_conf,
+            RTI_RS_KafkaConnection_dr_msg_cb);
+    rd_kafka_conf_set_opaque(self->producer_conf, self);
+
+    return 0;
+}
+
+void RTI_RS_KafkaConnection_finalize(struct RTI_RS_KafkaConnection *self)
+{
+    struct RTI_RS_KafkaStreamWriter *writer = NULL;
+
+    RTI_RoutingServiceLogger_log(
+            RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
+            "%s",
+            __func__);
+
+    if (self->poller_thread != NULL) {
+        self->run_poller_thread = RTI_FALSE;
+        if (!RTIOsapiJoinableThread_stopAndDelete(
+                    self->poller_thread,
+                    RTI_OSAPI_THREAD_INFINITE_BLOCKING_TIMEOUT)) {
+            RTI_RoutingServiceLogger_log(
+                    RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                    "Error deleting "
+                    "RTI_RS_KafkaConnection_producer_poller_thread");
+        }
+        self->poller_thread = NULL;
+    }
+
+    if (self->producer != NULL) {
+        /* Wait for final messages to be delivered or fail.
+         * rd_kafka_flush() is an abstraction over rd_kafka_poll() which
+         * waits for all messages to be delivered. */
+        RTI_RoutingServiceLogger_log(
+                RTI_ROUTING_SERVICE_VERBOSITY_INFO,
+                "Flushing final messages...");
+        rd_kafka_flush(self->producer, PRODUCER_FLUSH_TIMEOUT);
+
+        /* If the output queue is still not empty there is an issue
+         * with producing messages to the clusters. */
+        if (rd_kafka_outq_len(self->producer) > 0) {
+            RTI_RoutingServiceLogger_log(
+                    RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                    "%d message(s) were not delivered",
+                    rd_kafka_outq_len(self->producer));
+        }
+
+        rd_kafka_destroy(self->producer);
+        self->producer = NULL;
+    }
+
+    /* librdkafka no longer references the buffers of retired writers */
+    while (self->retired_writers != NULL) {
+        writer = self->retired_writers;
+        self->retired_writers = writer->next_retired;
+        RTI_RS_KafkaConnection_cleanup_stream_writer(writer);
+    }
+
+    if (self->producer_conf != NULL) {
+        rd_kafka_conf_destroy(self->producer_conf);
+        self->producer_conf = NULL;
+    }
+
+    if (self->producer_mutex != NULL) {
+        RTIOsapiSemaphore_delete(self->producer_mutex);
+        self->producer_mutex = NULL;
+    }
+
+    if (self->queue_space_sem != NULL) {
+        RTIOsapiSemaphore_delete(self->queue_space_sem);
+        self->queue_space_sem = NULL;
+    }
+
+    if (self->queue_space_mutex != NULL) {
+        RTIOsapiSemaphore_delete(self->queue_space_mutex);
+        self->queue_space_mutex = NULL;
+    }
+}
+
+void RTI_RS_KafkaConnection_notify_queue_space(
+        struct RTI_RS_KafkaConnection *self)
+{
+    RTIOsapiSemaphore_take(self->queue_space_mutex, NULL);
+    if (self->queue_space_waiters > 0) {
+        for (; self->queue_space_waiters > 0; self->queue_space_waiters--) {
+            RTIOsapiSemaphore_give(self->queue_space_sem);
+        }
+        self->queue_space_generation++;
+    }
+    RTIOsapiSemaphore_give(self->queue_space_mutex);
+}
+
+int RTI_RS_KafkaConnection_wait_for_queue_space(
+        struct RTI_RS_KafkaConnection *self,
+        int timeout)
+{
+    struct RTINtpTime timeout_time = RTI_NTP_TIME_ZERO;
+    unsigned int generation = 0;
+
+    RTINtpTime_packFromMillisec(timeout_time, 0, timeout);
+
+    RTIOsapiSemaphore_take(self->queue_space_mutex, NULL);
+    self->queue_space_waiters++;
+    generation = self->queue_space_generation;
+    RTIOsapiSemaphore_give(self->queue_space_mutex);
+
+    /* A timeout is not an error: the caller retries anyway */
+    if (RTIOsapiSemaphore_take(self->queue_space_sem, &timeout_time)
+        == RTI_OSAPI_SEMAPHORE_STATUS_OK) {
+        return 1;
+    }
+
+    /* Stop counting this writer as a waiter, unless a delivery report was
+     * received in the meantime. The semaphore was then given for this
+     * writer too, which will only cause a spurious retry later on. */
+    RTIOsapiSemaphore_take(self->queue_space_mutex, NULL);
+    if (generation == self->queue_space_generation
+        && self->queue_space_waiters > 0) {
+        self->queue_space_waiters--;
+    }
+    RTIOsapiSemaphore_give(self->queue_space_mutex);
+
+    return 0;
+}
+
+/*
+ * Get the producer of a connection, creating it (and its poller thread)
+ * if this is the first stream writer of the connection.
+ */
+static rd_kafka_t *RTI_RS_KafkaConnection_get_producer(
+        struct RTI_RS_KafkaConnection *self,
+        RTI_RoutingServiceEnvironment *env)
+{
+    /* librdkafka API error reporting buffer */
+    char errstr[ERR_MSG_BUF_SIZE] = {0};
+    rd_kafka_t *producer = NULL;
+
+    RTIOsapiSemaphore_take(self->producer_mutex, NULL);
+
+    if (self->producer != NULL) {
+        producer = self->producer;
+        goto done;
+    }
+
+    /*
+     * Create producer instance.
+     *
+     * NOTE: rd_kafka_new() takes ownership of the conf object
+     *       and the application must not reference it again after
+     *       this call, so the producer is created from a copy.
+     */
+    self->producer = rd_kafka_new(
+            RD_KAFKA_PRODUCER,
+            rd_kafka_conf_dup(self->producer_conf),
+            errstr,
+            sizeof(errstr));
+    if (self->producer == NULL) {
+        RTI_RoutingServiceEnvironment_set_error(env, errstr);
+        goto done;
     }
 
-    if (self != NULL) {
-        free(self);
-        self = NULL;
+    self->run_poller_thread = RTI_TRUE;
+    self->poller_thread = RTIOsapiJoinableThread_new(
+            "KafkaConnection_poll",
+            RTI_OSAPI_THREAD_PRIORITY_DEFAULT,
+            RTI_OSAPI_THREAD_OPTION_DEFAULT,
+            RTI_OSAPI_THREAD_STACK_SIZE_DEFAULT,
+            NULL,
+            RTI_RS_KafkaConnection_producer_poller_thread,
+            (void *) self);
+    if (self->poller_thread == NULL) {
+        RTI_RoutingServiceEnvironment_set_error(
+                env,
+                "Error creating poller_thread");
+        rd_kafka_destroy(self->producer);
+        self->producer = NULL;
+        goto done;
     }
+
+    producer = self->producer;
+done:
+    RTIOsapiSemaphore_give(self->producer_mutex);
+    return producer;
 }
 
 RTI_RoutingServiceStreamWriter RTI_RS_KafkaConnection_create_stream_writer(
@@ -82,10 +532,12 @@ RTI_RoutingServiceStreamWriter RTI_RS_KafkaConnection_create_stream_writer(
     struct RTI_RS_KafkaConnection *kafka_connection =
             (struct RTI_RS_KafkaConnection *) connection;
     struct RTI_RS_KafkaStreamWriter *stream_writer = NULL;
-    char errstr[ERR_MSG_BUF_SIZE] = {0}; /* librdkafka API error reporting buffer */
+    /* librdkafka API error reporting buffer */
+    char errstr[ERR_MSG_BUF_SIZE] = {0};
     int i = 0;
     rd_kafka_conf_res_t res = RD_KAFKA_CONF_UNKNOWN;
-    rd_kafka_conf_t *conf = NULL;   /* rdkafka configuration object */
+    rd_kafka_topic_conf_t *topic_conf = NULL; /* rdkafka topic configuration */
+    const char *invalid_property = NULL;
 
     RTI_RoutingServiceLogger_log(
             RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
@@ -100,6 +552,24 @@ RTI_RoutingServiceStreamWriter RTI_RS_KafkaConnection_create_stream_writer(
         goto error;
     }
 
+    if (!DDS_OctetSeq_initialize(&stream_writer->copy_buffer.payload)
+        || !DDS_OctetSeq_initialize(&stream_writer->key)) {
+        RTI_RoutingServiceEnvironment_set_error(
+                env,
+                "DDS_OctetSeq_initialize error");
+        free(stream_writer);
+        return NULL;
+    }
+    stream_writer->copy_buffer.writer = stream_writer;
+    stream_writer->connection = kafka_connection;
+
+    stream_writer->mutex =
+            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_MUTEX, NULL);
+    if (stream_writer->mutex == NULL) {
+        RTI_RoutingServiceEnvironment_set_error(env, "Error creating mutex");
+        goto error;
+    }
+
     if (stream_info->stream_name == NULL) {
         RTI_RoutingServiceEnvironment_set_error(env, "stream_name is null");
         goto error;
@@ -113,24 +583,27 @@ RTI_RoutingServiceStreamWriter RTI_RS_KafkaConnection_create_stream_writer(
         goto error;
     }
 
-    conf = rd_kafka_conf_new();
-
-    /* Set bootstrap broker(s) as a comma-separated list of
-     * host or host:port (default port 9092).
-     * librdkafka will use the bootstrap brokers to acquire the full
-     * set of brokers from the cluster. */
-    if (rd_kafka_conf_set(
-                conf,
-                "bootstrap.servers",
-                kafka_connection->bootstrap_servers,
-                errstr,
-                sizeof(errstr))
-        != RD_KAFKA_CONF_OK) {
-        RTI_RoutingServiceEnvironment_set_error(env, errstr);
+    invalid_property = RTI_RS_KafkaConnection_parse_writer_properties(
+            stream_writer,
+            properties);
+    if (invalid_property != NULL) {
+        RTI_RoutingServiceEnvironment_set_error(
+                env,
+                "invalid value for %s",
+                invalid_property);
         goto error;
     }
 
-    /* Set Kafka configurations from <route>/<output>/<property> */
+    /* The message key is taken from the "key" member, if there's one */
+    stream_writer->has_key_member = RTI_RS_KafkaConnection_type_has_member(
+            (struct DDS_TypeCode *) stream_info->type_info.type_representation,
+            "key");
+
+    /* Set Kafka topic configurations from <route>/<output>/<property>.
+     * Producer configurations are shared by all the stream writers, and
+     * they must be set in <connection>/<property>. */
+    topic_conf = rd_kafka_topic_conf_new();
+
     for (i = 0; i < properties->count; i++) {
         RTI_RoutingServiceLogger_log(
                 RTI_ROUTING_SERVICE_VERBOSITY_INFO,
@@ -143,56 +616,70 @@ RTI_RoutingServiceStreamWriter RTI_RS_KafkaConnection_create_stream_writer(
                 i,
                 properties->properties[i].value);
         /* Skip RTI Connext configurations */
-        if ((strcmp(properties->properties[i].name, "topic") == 0)
-            || (strcmp(properties->properties[i].name,
-                       "rti.routing_service.entity.resource_name")
-                == 0)) {
+        if (RTI_RS_KafkaConnection_is_adapter_property(
+                    properties->properties[i].name)) {
             RTI_RoutingServiceLogger_log(
                     RTI_ROUTING_SERVICE_VERBOSITY_INFO,
                     "%s is skipped\n",
                     properties->properties[i].name);
         } else {
-            res = rd_kafka_conf_set(
-                    conf,
+            res = rd_kafka_topic_conf_set(
+                    topic_conf,
                     properties->properties[i].name,
                     properties->properties[i].value,
                     errstr,
                     sizeof(errstr));
-            if (res != RD_KAFKA_CONF_OK) {
+            if (res == RD_KAFKA_CONF_UNKNOWN) {
+                /* Most likely a producer property, which would silently
+                 * have no effect on the shared producer */
+                RTI_RoutingServiceEnvironment_set_error(
+                        env,
+                        "%s is not a topic property: %s (producer "
+                        "properties must be set in the <connection>)",
+                        properties->properties[i].name,
+                        errstr);
+                goto error;
+            } else if (res != RD_KAFKA_CONF_OK) {
                 RTI_RoutingServiceEnvironment_set_error(env, errstr);
                 goto error;
             }
         }
     }
 
-    /* Set the delivery report callback.
-     * This callback will be called once per message to inform
-     * the application if delivery succeeded or failed.
-     * See dr_msg_cb() above.
-     * The callback is only triggered from rd_kafka_poll() and
-     * rd_kafka_flush(). */
-    rd_kafka_conf_set_dr_msg_cb(conf, RTI_RS_KafkaConnection_dr_msg_cb);
+    stream_writer->rk = RTI_RS_KafkaConnection_get_producer(
+            kafka_connection,
+            env);
+    if (stream_writer->rk == NULL) {
+        goto error;
+    }
 
     /*
-     * Create producer instance.
+     * Create the topic handle.
      *
-     * NOTE: rd_kafka_new() takes ownership of the conf object
+     * NOTE: rd_kafka_topic_new() takes ownership of the topic_conf object
      *       and the application must not reference it again after
      *       this call.
      */
-    stream_writer->rk = rd_kafka_new(
-            RD_KAFKA_PRODUCER,
-            conf,
-            errstr,
-            sizeof(errstr));
-    if (!stream_writer->rk) {
-        RTI_RoutingServiceEnvironment_set_error(env, errstr);
+    stream_writer->rkt = rd_kafka_topic_new(
+            stream_writer->rk,
+            stream_writer->topic,
+            topic_conf);
+    topic_conf = NULL;
+    if (stream_writer->rkt == NULL) {
+        RTI_RoutingServiceEnvironment_set_error(
+                env,
+                "Failed to create topic %s: %s",
+                stream_writer->topic,
+                rd_kafka_err2str(rd_kafka_last_error()));
         goto error;
     }
 
     return stream_writer;
 
 error:
+    if (topic_conf != NULL) {
+        rd_kafka_topic_conf_destroy(topic_conf);
+    }
     RTI_RS_KafkaConnection_cleanup_stream_writer(stream_writer);
     return NULL;
 }
@@ -202,55 +689,211 @@ void RTI_RS_KafkaConnection_delete_stream_writer(
         RTI_RoutingServiceStreamWriter stream_writer,
         RTI_RoutingServiceEnvironment *env)
 {
+    struct RTI_RS_KafkaConnection *kafka_connection =
+            (struct RTI_RS_KafkaConnection *) connection;
     struct RTI_RS_KafkaStreamWriter *self =
             (struct RTI_RS_KafkaStreamWriter *) stream_writer;
+    int waited = 0;
+    int inflight = 0;
 
     RTI_RoutingServiceLogger_log(
             RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
             "%s",
             __func__);
 
-    /* Wait for final messages to be delivered or fail.
-     * rd_kafka_flush() is an abstraction over rd_kafka_poll() which
-     * waits for all messages to be delivered. */
+    /* Wait for the final messages of this stream writer to be delivered or
+     * fail. The producer is shared, so it can't be flushed, since the other
+     * stream writers may keep producing messages. */
     RTI_RoutingServiceLogger_log(
             RTI_ROUTING_SERVICE_VERBOSITY_INFO,
             "Flushing final messages...");
-    rd_kafka_flush(self->rk, 10 * 1000 /* wait for max 10 seconds */);
+    inflight = RTI_RS_KafkaStreamWriter_get_inflight(self);
+    while (inflight > 0 && waited < PRODUCER_FLUSH_TIMEOUT) {
+        rd_kafka_poll(self->rk, 10); /* block for max 10ms */
+        waited += 10;
+        inflight = RTI_RS_KafkaStreamWriter_get_inflight(self);
+    }
 
-    /* If the output queue is still not empty there is an issue
-     * with producing messages to the clusters. */
-    if (rd_kafka_outq_len(self->rk) > 0) {
+    /* If there are still messages in flight, their delivery reports will
+     * reference the stream writer, which is kept until the producer is
+     * destroyed. */
+    if (inflight > 0) {
         RTI_RoutingServiceLogger_log(
                 RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
                 "%d message(s) were not delivered",
-                rd_kafka_outq_len(self->rk));
+                inflight);
+        rd_kafka_topic_destroy(self->rkt);
+        self->rkt = NULL;
+        RTIOsapiSemaphore_take(kafka_connection->producer_mutex, NULL);
+        self->next_retired = kafka_connection->retired_writers;
+        kafka_connection->retired_writers = self;
+        RTIOsapiSemaphore_give(kafka_connection->producer_mutex);
+        return;
     }
 
-    RTI_RS_KafkaConnection_cleanup_stream_writer(stream_writer);
+    RTI_RS_KafkaConnection_cleanup_stream_writer(self);
+}
+
+static void RTI_RS_KafkaConnection_finalize_reader_worker(
+        struct RTI_RS_KafkaStreamReader *reader,
+        struct RTI_RS_KafkaStreamReaderWorker *worker)
+{
+    int i = 0;
+
+    if (worker->queue != NULL) {
+        rd_kafka_queue_destroy(worker->queue);
+        worker->queue = NULL;
+    }
+
+    DDS_OctetSeq_finalize(&worker->payload);
+    DDS_OctetSeq_finalize(&worker->key);
+
+    if (worker->poll_sem != NULL) {
+        RTIOsapiSemaphore_delete(worker->poll_sem);
+        worker->poll_sem = NULL;
+    }
+
+    if (worker->rkm_list != NULL) {
+        free(worker->rkm_list);
+        worker->rkm_list = NULL;
+    }
+
+    if (worker->sample_list != NULL) {
+        for (i = 0; i < reader->batch_max_size; i++) {
+            if (worker->sample_list[i] != NULL) {
+                DDS_DynamicData_delete(worker->sample_list[i]);
+            }
+        }
+        free(worker->sample_list);
+        worker->sample_list = NULL;
+    }
+
+    if (worker->info_list != NULL) {
+        for (i = 0; i < reader->batch_max_size; i++) {
+            free(worker->info_list[i]);
+        }
+        free(worker->info_list);
+        worker->info_list = NULL;
+    }
+}
+
+/*
+ * Pre-allocate one sample for each message in a batch of a worker
+ */
+static int RTI_RS_KafkaConnection_initialize_reader_worker(
+        struct RTI_RS_KafkaStreamReader *reader,
+        struct RTI_RS_KafkaStreamReaderWorker *worker,
+        RTI_RoutingServiceEnvironment *env)
+{
+    struct DDS_DynamicDataProperty_t dynamicDataProps =
+            DDS_DynamicDataProperty_t_INITIALIZER;
+    int i = 0;
+
+    worker->reader = reader;
+
+    if (!DDS_OctetSeq_initialize(&worker->payload)
+        || !DDS_OctetSeq_initialize(&worker->key)) {
+        RTI_RoutingServiceEnvironment_set_error(
+                env,
+                "DDS_OctetSeq_initialize error");
+        return -1;
+    }
+
+    worker->poll_sem =
+            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_BINARY, NULL);
+    if (!worker->poll_sem) {
+        RTI_RoutingServiceEnvironment_set_error(
+                env,
+                "Error creating semaphore");
+        return -1;
+    }
+
+    worker->rkm_list =
+            calloc(reader->batch_max_size, sizeof(rd_kafka_message_t *));
+    worker->sample_list =
+            calloc(reader->batch_max_size, sizeof(DDS_DynamicData *));
+    worker->info_list =
+            calloc(reader->batch_max_size, sizeof(struct DDS_SampleInfo *));
+
+    if (worker->rkm_list == NULL) {
+        RTI_RoutingServiceEnvironment_set_error(
+                env,
+                "Memory allocation error (rkm_list)");
+        return -1;
+    }
+    if (worker->sample_list == NULL) {
+        RTI_RoutingServiceEnvironment_set_error(
+                env,
+                "Memory allocation error (sample_list)");
+        return -1;
+    }
+    if (worker->info_list == NULL) {
+        RTI_RoutingServiceEnvironment_set_error(
+                env,
+                "Memory allocation error (info_list)");
+        return -1;
+    }
+
+    for (i = 0; i < reader->batch_max_size; i++) {
+        worker->sample_list[i] =
+                DDS_DynamicData_new(reader->type_code, &dynamicDataProps);
+        if (worker->sample_list[i] == NULL) {
+            RTI_RoutingServiceEnvironment_set_error(
+                    env,
+                    "Failure creating sample");
+            return -1;
+        }
+
+        worker->info_list[i] = (struct DDS_SampleInfo *) calloc(
+                1,
+                sizeof(struct DDS_SampleInfo));
+        if (worker->info_list[i] == NULL) {
+            RTI_RoutingServiceEnvironment_set_error(
+                    env,
+                    "Failure creating sample info");
+            return -1;
+        }
+
+        *(worker->info_list[i]) = DDS_SAMPLEINFO_DEFAULT;
+        worker->info_list[i]->instance_handle = DDS_HANDLE_NIL;
+        worker->info_list[i]->valid_data = 1;
+        worker->info_list[i]->instance_state = DDS_ALIVE_INSTANCE_STATE;
+    }
+
+    return 0;
 }
 
 void RTI_RS_KafkaConnection_cleanup_stream_reader(struct RTI_RS_KafkaStreamReader *self)
 {
+    int i = 0;
+
     RTI_RoutingServiceLogger_log(
             RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
             "%s",
             __func__);
 
-    /* Free allocated resources */
-    if (self->rk != NULL) {
-        rd_kafka_destroy(self->rk);
+    if (self == NULL) {
+        return;
     }
 
-    // TODO: Check self->payload is not NULL?
-    DDS_OctetSeq_finalize(&self->payload);
+    /* Free allocated resources. The queues must be destroyed before the
+     * consumer. */
+    if (self->workers != NULL) {
+        for (i = 0; i < self->worker_count; i++) {
+            RTI_RS_KafkaConnection_finalize_reader_worker(
+                    self,
+                    &self->workers[i]);
+        }
+        free(self->workers);
+        self->workers = NULL;
+    }
 
-    if (self->poll_sem != NULL) {
-        RTIOsapiSemaphore_delete(self->poll_sem);
+    if (self->rk != NULL) {
+        rd_kafka_destroy(self->rk);
     }
 
-    if (self->read_sem != NULL) {
-        RTIOsapiSemaphore_delete(self->read_sem);
+    if (self->mutex != NULL) {
+        RTIOsapiSemaphore_delete(self->mutex);
     }
 
     if (self->sample_list != NULL) {
@@ -263,8 +906,51 @@ void RTI_RS_KafkaConnection_cleanup_stream_reader(struct RTI_RS_KafkaStreamReade
         self->info_list = NULL;
     }
 
-    if (self != NULL) {
-        free(self);
+    if (self->type_support != NULL) {
+        DDS_DynamicDataTypeSupport_delete(self->type_support);
+    }
+
+    free(self);
+}
+
+/*
+ * Stop the threads of a stream reader. A worker waiting for the loan on its
+ * samples to be returned is woken up, since the loan won't be returned.
+ */
+static void RTI_RS_KafkaConnection_stop_stream_reader(
+        struct RTI_RS_KafkaStreamReader *self)
+{
+    struct RTI_RS_KafkaStreamReaderWorker *worker = NULL;
+    int i = 0;
+
+    self->run_thread = RTI_FALSE;
+
+    for (i = 0; i < self->worker_count; i++) {
+        worker = &self->workers[i];
+        if (worker->polling_thread == NULL) {
+            continue;
+        }
+        RTIOsapiSemaphore_give(worker->poll_sem);
+        if (!RTIOsapiJoinableThread_stopAndDelete(
+                    worker->polling_thread,
+                    RTI_OSAPI_THREAD_INFINITE_BLOCKING_TIMEOUT)) {
+            RTI_RoutingServiceLogger_log(
+                    RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                    "Error deleting "
+                    "RTI_RS_KafkaStreamReader_on_data_availabe_thread");
+        }
+        worker->polling_thread = NULL;
+    }
+
+    if (self->events_thread != NULL) {
+        if (!RTIOsapiJoinableThread_stopAndDelete(
+                    self->events_thread,
+                    RTI_OSAPI_THREAD_INFINITE_BLOCKING_TIMEOUT)) {
+            RTI_RoutingServiceLogger_log(
+                    RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                    "Error deleting RTI_RS_KafkaStreamReader_events_thread");
+        }
+        self->events_thread = NULL;
     }
 }
 
@@ -282,11 +968,11 @@ RTI_RoutingServiceStreamReader RTI_RS_KafkaConnection_create_stream_reader(
     char errstr[ERR_MSG_BUF_SIZE]; /* librdkafka API error reporting buffer */
     int error = 0;
     rd_kafka_topic_partition_list_t *subscription; /* Subscribed topics */
-    struct DDS_DynamicDataProperty_t dynamicDataProps =
-            DDS_DynamicDataProperty_t_INITIALIZER;
     struct DDS_DynamicDataTypeProperty_t dynamicDataTypeProp =
     	DDS_DynamicDataTypeProperty_t_INITIALIZER;
     int i = 0;
+    int worker_count = 1;
+    const char *invalid_property = NULL;
     rd_kafka_conf_res_t res;
     rd_kafka_conf_t *conf = NULL;
 
@@ -308,8 +994,59 @@ RTI_RoutingServiceStreamReader RTI_RS_KafkaConnection_create_stream_reader(
             (struct DDS_TypeCode *) stream_info->type_info.type_representation;
     stream_reader->run_thread = RTI_TRUE;
 
-    stream_reader->sample_list = calloc(1, sizeof(DDS_DynamicData *));
-    stream_reader->info_list = calloc(1, sizeof(struct DDS_SampleInfo *));
+    /* The key, partition and offset of each message are only exposed if
+     * the type has members to store them */
+    stream_reader->has_key_member = RTI_RS_KafkaConnection_type_has_member(
+            stream_reader->type_code,
+            "key");
+    stream_reader->has_partition_member =
+            RTI_RS_KafkaConnection_type_has_member(
+                    stream_reader->type_code,
+                    "partition");
+    stream_reader->has_offset_member = RTI_RS_KafkaConnection_type_has_member(
+            stream_reader->type_code,
+            "offset");
+
+    /*
+     * Get the configuration properties in <route>/<input>/<property>
+     */
+
+    stream_reader->topic =
+            RTI_RoutingServiceProperties_lookup_property(properties, "topic");
+    if (stream_reader->topic == NULL) {
+        RTI_RoutingServiceEnvironment_set_error(env, "topic missing");
+        goto error;
+    }
+
+    invalid_property = RTI_RS_KafkaConnection_parse_reader_properties(
+            stream_reader,
+            &worker_count,
+            properties);
+    if (invalid_property != NULL) {
+        RTI_RoutingServiceEnvironment_set_error(
+                env,
+                "invalid value for %s",
+                invalid_property);
+        goto error;
+    }
+
+    stream_reader->mutex =
+            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_MUTEX, NULL);
+    if (!stream_reader->mutex) {
+        RTI_RoutingServiceEnvironment_set_error(env, "Error creating mutex");
+        goto error;
+    }
+
+    /* A read may return the batches of all the workers */
+    stream_reader->sample_list = calloc(
+            worker_count * stream_reader->batch_max_size,
+            sizeof(DDS_DynamicData *));
+    stream_reader->info_list = calloc(
+            worker_count * stream_reader->batch_max_size,
+            sizeof(struct DDS_SampleInfo *));
+    stream_reader->workers = calloc(
+            worker_count,
+            sizeof(struct RTI_RS_KafkaStreamReaderWorker));
 
     if (stream_reader->sample_list == NULL) {
         RTI_RoutingServiceEnvironment_set_error(
@@ -323,47 +1060,30 @@ RTI_RoutingServiceStreamReader RTI_RS_KafkaConnection_create_stream_reader(
                 "Memory allocation error (info_list)");
         goto error;
     }
-
-    stream_reader->type_support = DDS_DynamicDataTypeSupport_new(
-            stream_reader->type_code,
-            &dynamicDataTypeProp);
-
-    stream_reader->sample_list[0] =
-            DDS_DynamicData_new(stream_reader->type_code, &dynamicDataProps);
-    stream_reader->info_list[0] =
-            (struct DDS_SampleInfo *) calloc(1, sizeof(struct DDS_SampleInfo));
-    if (stream_reader->info_list[0] == NULL) {
+    if (stream_reader->workers == NULL) {
         RTI_RoutingServiceEnvironment_set_error(
                 env,
-                "Failure creating sample info");
-        return NULL;
+                "Memory allocation error (workers)");
+        goto error;
     }
 
-    *(stream_reader->info_list[0]) = DDS_SAMPLEINFO_DEFAULT;
-    stream_reader->info_list[0]->instance_handle = DDS_HANDLE_NIL;
-    stream_reader->info_list[0]->valid_data = 1;
-    stream_reader->info_list[0]->instance_state = DDS_ALIVE_INSTANCE_STATE;
-
-    /*
-     * Get the configuration properties in <route>/<input>/<property>
-     */
+    stream_reader->type_support = DDS_DynamicDataTypeSupport_new(
+            stream_reader->type_code,
+            &dynamicDataTypeProp);
 
-    stream_reader->topic =
-            RTI_RoutingServiceProperties_lookup_property(properties, "topic");
-    if (stream_reader->topic == NULL) {
-        RTI_RoutingServiceEnvironment_set_error(env, "topic missing");
-        goto error;
+    /* worker_count only counts the workers to finalize on error */
+    for (i = 0; i < worker_count; i++) {
+        stream_reader->worker_count++;
+        if (RTI_RS_KafkaConnection_initialize_reader_worker(
+                    stream_reader,
+                    &stream_reader->workers[i],
+                    env)) {
+            goto error;
+        }
     }
 
     conf = rd_kafka_conf_new();
 
-    if (!DDS_OctetSeq_initialize(&stream_reader->payload)) {
-        RTI_RoutingServiceEnvironment_set_error(
-                env,
-                "DDS_OctetSeq_initialize error");
-        goto error;
-    }
-
     /* Set bootstrap broker(s) as a comma-separated list of
      * host or host:port (default port 9092).
      * librdkafka will use the bootstrap brokers to acquire the full
@@ -408,10 +1128,8 @@ RTI_RoutingServiceStreamReader RTI_RS_KafkaConnection_create_stream_reader(
                 i,
                 properties->properties[i].value);
         // Skip RTI Connext configurations
-        if ((strcmp(properties->properties[i].name, "topic") == 0)
-            || (strcmp(properties->properties[i].name,
-                       "rti.routing_service.entity.resource_name")
-                == 0)) {
+        if (RTI_RS_KafkaConnection_is_adapter_property(
+                    properties->properties[i].name)) {
             RTI_RoutingServiceLogger_log(
                     RTI_ROUTING_SERVICE_VERBOSITY_INFO,
                     "%s is skipped\n",
@@ -430,6 +1148,15 @@ RTI_RoutingServiceStreamReader RTI_RS_KafkaConnection_create_stream_reader(
         }
     }
 
+    /* With more than one worker, assigned partitions are forwarded to the
+     * worker queues by the rebalance callback */
+    if (stream_reader->worker_count > 1) {
+        rd_kafka_conf_set_rebalance_cb(
+                conf,
+                RTI_RS_KafkaStreamReader_rebalance_cb);
+        rd_kafka_conf_set_opaque(conf, stream_reader);
+    }
+
     /*
      * Create consumer instance.
      *
@@ -442,6 +1169,7 @@ RTI_RoutingServiceStreamReader RTI_RS_KafkaConnection_create_stream_reader(
             conf,
             errstr,
             sizeof(errstr));
+    conf = NULL;
     if (!stream_reader->rk) {
         RTI_RoutingServiceEnvironment_set_error(env, errstr);
         goto error;
@@ -451,12 +1179,23 @@ RTI_RoutingServiceStreamReader RTI_RS_KafkaConnection_create_stream_reader(
      * the main queue so that messages can be consumed with one
      * call from all assigned partitions.
      *
-     * The alternative is to poll the main queue (for events)
-     * and each partition queue separately, which requires setting
-     * up a rebalance callback and keeping track of the assignment:
-     * but that is more complex and typically not recommended. */
+     * With more than one worker, the main queue only carries events, and
+     * the messages of each partition are forwarded to the queue of a
+     * worker instead (see RTI_RS_KafkaStreamReader_rebalance_cb()). */
     rd_kafka_poll_set_consumer(stream_reader->rk);
 
+    for (i = 0; i < stream_reader->worker_count; i++) {
+        stream_reader->workers[i].queue = (stream_reader->worker_count == 1)
+                ? rd_kafka_queue_get_consumer(stream_reader->rk)
+                : rd_kafka_queue_new(stream_reader->rk);
+        if (stream_reader->workers[i].queue == NULL) {
+            RTI_RoutingServiceEnvironment_set_error(
+                    env,
+                    "Error getting consumer queue");
+            goto error;
+        }
+    }
+
     subscription = rd_kafka_topic_partition_list_new(1);
     rd_kafka_topic_partition_list_add(
             subscription,
@@ -484,60 +1223,51 @@ RTI_RoutingServiceStreamReader RTI_RS_KafkaConnection_create_stream_reader(
 
     rd_kafka_topic_partition_list_destroy(subscription);
 
-
-    stream_reader->poll_sem =
-            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_BINARY, NULL);
-    if (!stream_reader->poll_sem) {
-        RTI_RoutingServiceEnvironment_set_error(
-                env,
-                "Error creating semaphore");
-        goto error;
-    }
-
-    stream_reader->read_sem =
-            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_BINARY, NULL);
-    if (!stream_reader->read_sem) {
-        RTI_RoutingServiceEnvironment_set_error(
-                env,
-                "Error creating semaphore");
-        goto error;
-    }
-
-    stream_reader->poll_sem =
-            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_BINARY, NULL);
-    if (!stream_reader->poll_sem) {
-        RTI_RoutingServiceEnvironment_set_error(env, "Error creating mutex");
-        goto error;
-    }
-    // Initialize semaphore to available
-    RTIOsapiSemaphore_give(stream_reader->poll_sem);
-
-    stream_reader->read_sem =
-            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_BINARY, NULL);
-    if (!stream_reader->read_sem) {
-        RTI_RoutingServiceEnvironment_set_error(env, "Error creating mutex");
-        goto error;
+    for (i = 0; i < stream_reader->worker_count; i++) {
+        stream_reader->workers[i].polling_thread = RTIOsapiJoinableThread_new(
+                "KafkaStreamReader_run",
+                RTI_OSAPI_THREAD_PRIORITY_DEFAULT,
+                RTI_OSAPI_THREAD_OPTION_DEFAULT,
+                RTI_OSAPI_THREAD_STACK_SIZE_DEFAULT,
+                NULL,
+                RTI_RS_KafkaStreamReader_on_data_availabe_thread,
+                (void *) &stream_reader->workers[i]);
+
+        if (!stream_reader->workers[i].polling_thread) {
+            RTI_RoutingServiceEnvironment_set_error(
+                    env,
+                    "Error creating polling_thread");
+            goto error;
+        }
     }
 
-    stream_reader->polling_thread = RTIOsapiJoinableThread_new(
-            "KafkaStreamReader_run",
-            RTI_OSAPI_THREAD_PRIORITY_DEFAULT,
-            RTI_OSAPI_THREAD_OPTION_DEFAULT,
-            RTI_OSAPI_THREAD_STACK_SIZE_DEFAULT,
-            NULL,
-            RTI_RS_KafkaStreamReader_on_data_availabe_thread,
-            (void *) stream_reader);
-
-    if (!stream_reader->polling_thread) {
-        RTI_RoutingServiceEnvironment_set_error(
-                env,
-                "Error creating polling_thread");
-        goto error;
+    if (stream_reader->worker_count > 1) {
+        stream_reader->events_thread = RTIOsapiJoinableThread_new(
+                "KafkaStreamReader_events",
+                RTI_OSAPI_THREAD_PRIORITY_DEFAULT,
+                RTI_OSAPI_THREAD_OPTION_DEFAULT,
+                RTI_OSAPI_THREAD_STACK_SIZE_DEFAULT,
+                NULL,
+                RTI_RS_KafkaStreamReader_events_thread,
+                (void *) stream_reader);
+
+        if (!stream_reader->events_thread) {
+            RTI_RoutingServiceEnvironment_set_error(
+                    env,
+                    "Error creating events_thread");
+            goto error;
+        }
     }
 
     return stream_reader;
 
 error:
+    if (conf != NULL) {
+        rd_kafka_conf_destroy(conf);
+    }
+    if (stream_reader != NULL) {
+        RTI_RS_KafkaConnection_stop_stream_reader(stream_reader);
+    }
     RTI_RS_KafkaConnection_cleanup_stream_reader(stream_reader);
     return NULL;
 }
@@ -550,23 +1280,12 @@ void RTI_RS_KafkaConnection_delete_stream_reader(
     struct RTI_RS_KafkaStreamReader *self =
             (struct RTI_RS_KafkaStreamReader *) stream_reader;
 
-    void *value = NULL;
-
     RTI_RoutingServiceLogger_log(
             RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
             "%s\n",
             __func__);
 
-    self->run_thread = RTI_FALSE;
-    if (!RTIOsapiJoinableThread_stopAndDelete(
-                self->polling_thread,
-                RTI_OSAPI_THREAD_INFINITE_BLOCKING_TIMEOUT)) {
-        RTI_RoutingServiceLogger_log(
-                RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
-                "Error deleting "
-                "RTI_RS_KafkaStreamReader_on_data_availabe_thread");
-    }
-    self->polling_thread = NULL;
+    RTI_RS_KafkaConnection_stop_stream_reader(self);
 
     /* Close the consumer: commit final offsets and leave the group. */
     RTI_RoutingServiceLogger_log(
@@ -17,6 +17,8 @@
 #define KafkaConnection_h
 
 #define ERR_MSG_BUF_SIZE 512
+#define PRODUCER_POLL_TIMEOUT 100 /*100 ms*/
+#define PRODUCER_FLUSH_TIMEOUT 10000 /*10 s*/
 
 #include "ndds/ndds_c.h"
 
@@ -33,8 +35,60 @@ struct RTI_RS_KafkaConnection {
     struct RTI_RS_KafkaAdapterPlugin *adapter;
     const char *bootstrap_servers; /* Initial list of brokers as a CSV list of
                                       broker host or host:port */
+    /* Configuration of the producer, from <connection>/<property> */
+    rd_kafka_conf_t *producer_conf;
+    /* Producer shared by all stream writers, created with the first one */
+    rd_kafka_t *producer;
+    struct RTIOsapiSemaphore *producer_mutex;
+    /* Thread serving the delivery reports of the producer */
+    struct RTIOsapiJoinableThread *poller_thread;
+    int run_poller_thread;
+    /* Number of stream writers waiting for space in the queue of the
+     * producer, protected by queue_space_mutex. The delivery report
+     * callback gives queue_space_sem once per waiting writer, so that all
+     * of them are woken up, and starts a new wait generation. */
+    struct RTIOsapiSemaphore *queue_space_mutex;
+    struct RTIOsapiSemaphore *queue_space_sem;
+    int queue_space_waiters;
+    unsigned int queue_space_generation;
+    /* Stream writers deleted before all their messages were delivered */
+    struct RTI_RS_KafkaStreamWriter *retired_writers;
 };
 
+int RTI_RS_KafkaConnection_initialize(
+        struct RTI_RS_KafkaConnection *self,
+        const struct RTI_RoutingServiceProperties *properties,
+        RTI_RoutingServiceEnvironment *env);
+
+void RTI_RS_KafkaConnection_finalize(struct RTI_RS_KafkaConnection *self);
+
+/*
+ * Block until a delivery report is received, which frees space in the
+ * queue of the producer, or until timeout (in ms) expires. Returns 1 if
+ * woken up by a delivery report, 0 if the timeout expired.
+ */
+int RTI_RS_KafkaConnection_wait_for_queue_space(
+        struct RTI_RS_KafkaConnection *self,
+        int timeout);
+
+/* Wake up all the stream writers waiting for space in the queue */
+void RTI_RS_KafkaConnection_notify_queue_space(
+        struct RTI_RS_KafkaConnection *self);
+
+/*
+ * Set the adapter configuration of a stream writer or reader from the
+ * properties in <route>/<output|input>/<property>, or their defaults.
+ * Return the name of the first property with an invalid value, or NULL.
+ */
+const char *RTI_RS_KafkaConnection_parse_writer_properties(
+        struct RTI_RS_KafkaStreamWriter *writer,
+        const struct RTI_RoutingServiceProperties *properties);
+
+const char *RTI_RS_KafkaConnection_parse_reader_properties(
+        struct RTI_RS_KafkaStreamReader *reader,
+        int *worker_count_out,
+        const struct RTI_RoutingServiceProperties *properties);
+
 RTI_RoutingServiceStreamWriter RTI_RS_KafkaConnection_create_stream_writer(
         RTI_RoutingServiceConnection connection,
         RTI_RoutingServiceSession session,
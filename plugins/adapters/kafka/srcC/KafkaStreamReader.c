@@ -21,27 +21,127 @@
 #include "KafkaStreamReader.h"
 
 
-int RTI_RS_KafkaStreamReader_error_cleanup(struct RTI_RS_KafkaStreamReader *stream_reader)
+/*
+ * Set an octet sequence member of a sample, loaning the data to seq, so it's
+ * only copied once, by the DynamicData sample. A NULL data sets an empty
+ * sequence.
+ */
+static DDS_ReturnCode_t RTI_RS_KafkaStreamReader_set_octets(
+        struct DDS_DynamicData *sample,
+        const char *member_name,
+        struct DDS_OctetSeq *seq,
+        void *data,
+        size_t len)
+{
+    DDS_ReturnCode_t retcode = DDS_RETCODE_OK;
+
+    if (data != NULL
+        && !DDS_OctetSeq_loan_contiguous(
+                seq,
+                (DDS_Octet *) data,
+                len,
+                len)) {
+        return DDS_RETCODE_ERROR;
+    }
+
+    retcode = DDS_DynamicData_set_octet_seq(
+            sample,
+            member_name,
+            DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED,
+            seq);
+
+    if (data != NULL) {
+        DDS_OctetSeq_unloan(seq);
+    }
+
+    return retcode;
+}
+
+/*
+ * Copy a Kafka message into a sample of the sample pool. Besides the
+ * payload, the key, partition and offset of the message are stored in the
+ * members of the same name, if the type has them.
+ */
+static int RTI_RS_KafkaStreamReader_set_sample(
+        struct RTI_RS_KafkaStreamReaderWorker *worker,
+        struct DDS_DynamicData *sample,
+        const rd_kafka_message_t *rkm)
 {
-    if (stream_reader->rkm != NULL) {
-        rd_kafka_message_destroy(stream_reader->rkm);
+    struct RTI_RS_KafkaStreamReader *self = worker->reader;
+
+    if (RTI_RS_KafkaStreamReader_set_octets(
+                sample,
+                "payload.data",
+                &worker->payload,
+                rkm->payload,
+                rkm->len)
+        != DDS_RETCODE_OK) {
+        RTI_RoutingServiceLogger_log(
+                RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                "Error setting payload data");
+        return -1;
     }
-    if (RTIOsapiSemaphore_give(stream_reader->poll_sem)
-        != RTI_OSAPI_SEMAPHORE_STATUS_OK) {
+
+    if (self->has_key_member
+        && RTI_RS_KafkaStreamReader_set_octets(
+                   sample,
+                   "key",
+                   &worker->key,
+                   rkm->key,
+                   rkm->key_len)
+                != DDS_RETCODE_OK) {
         RTI_RoutingServiceLogger_log(
                 RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
-                "Error giving poll semaphore");
+                "Error setting key");
         return -1;
     }
+
+    if (self->has_partition_member
+        && DDS_DynamicData_set_long(
+                   sample,
+                   "partition",
+                   DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED,
+                   rkm->partition)
+                != DDS_RETCODE_OK) {
+        RTI_RoutingServiceLogger_log(
+                RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                "Error setting partition");
+        return -1;
+    }
+
+    if (self->has_offset_member
+        && DDS_DynamicData_set_longlong(
+                   sample,
+                   "offset",
+                   DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED,
+                   rkm->offset)
+                != DDS_RETCODE_OK) {
+        RTI_RoutingServiceLogger_log(
+                RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                "Error setting offset");
+        return -1;
+    }
+
     return 0;
 }
+
 /*
- * This function will run as a separate thread and
- * notify of data availability in Kafka consumer
+ * This function will run as a separate thread for each worker and
+ * notify of data availability in Kafka consumer.
+ *
+ * Messages are consumed from the worker's queue in batches of up to
+ * batch_max_size messages, which are copied into the worker's sample pool
+ * and handed over to RTI_RS_KafkaStreamReader_read() all at once. The next
+ * batch is only consumed once the loan on the previous one has been
+ * returned.
  */
 void *RTI_RS_KafkaStreamReader_on_data_availabe_thread(void *thread_params)
 {
-    struct RTI_RS_KafkaStreamReader *self = thread_params;
+    struct RTI_RS_KafkaStreamReaderWorker *worker = thread_params;
+    struct RTI_RS_KafkaStreamReader *self = worker->reader;
+    rd_kafka_message_t *rkm = NULL;
+    ssize_t rkm_count = 0;
+    ssize_t i = 0;
 
     RTI_RoutingServiceLogger_log(
             RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
@@ -49,94 +149,197 @@ void *RTI_RS_KafkaStreamReader_on_data_availabe_thread(void *thread_params)
             __func__);
 
     while (self->run_thread) {
-        /* Block until the read thread returns loaned sample is done */
-        if (RTIOsapiSemaphore_take(self->poll_sem, NULL)
-            != RTI_OSAPI_SEMAPHORE_STATUS_OK) {
+        /* Return as soon as the batch is full, or after batch_max_wait ms
+         * with whatever messages were received in the meantime. */
+        rkm_count = rd_kafka_consume_batch_queue(
+                worker->queue,
+                self->batch_max_wait,
+                worker->rkm_list,
+                self->batch_max_size);
+        if (rkm_count < 0) {
             RTI_RoutingServiceLogger_log(
                     RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
-                    "Error taking poll semaphore");
-            return NULL;
+                    "Consumer error: %s\n",
+                    rd_kafka_err2str(rd_kafka_last_error()));
+            rkm_count = 0;
         }
 
-        self->rkm = rd_kafka_consumer_poll(self->rk, CONSUMER_POLL_TIMEOUT);
+        worker->sample_count = 0;
+        for (i = 0; i < rkm_count; i++) {
+            rkm = worker->rkm_list[i];
+            worker->rkm_list[i] = NULL;
 
-        /* Timeout: no message within CONSUMER_POLL_TIMEOUT */
-        if (!self->rkm) {
-            if (RTIOsapiSemaphore_give(self->poll_sem)
-                != RTI_OSAPI_SEMAPHORE_STATUS_OK) {
+            if (rkm->err) {
+                /* Consumer errors are generally to be considered
+                 * informational as the consumer will automatically
+                 * try to recover from all types of errors. */
                 RTI_RoutingServiceLogger_log(
                         RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
-                        "Error giving poll semaphore");
-                return NULL;
+                        "Consumer error: %s\n",
+                        rd_kafka_message_errstr(rkm));
+            } else {
+                RTI_RoutingServiceLogger_log(
+                        RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
+                        "Message on %s [%" PRId32 "] at offset %" PRId64 ":",
+                        rd_kafka_topic_name(rkm->rkt),
+                        rkm->partition,
+                        rkm->offset);
+
+                if (RTI_RS_KafkaStreamReader_set_sample(
+                            worker,
+                            worker->sample_list[worker->sample_count],
+                            rkm)
+                    == 0) {
+                    worker->sample_count++;
+                }
             }
+
+            /* The payload has been copied into the sample */
+            rd_kafka_message_destroy(rkm);
+        }
+
+        /* Timeout or only errors: nothing to notify. Nothing is notified
+         * either once the stream reader is being deleted. */
+        if (worker->sample_count == 0 || !self->run_thread) {
             continue;
         }
 
-        /* consumer_poll() will return either a proper message
-         * or a consumer error (rkm->err is set). */
-        if (self->rkm->err) {
-            /* Consumer errors are generally to be considered
-             * informational as the consumer will automatically
-             * try to recover from all types of errors. */
+        RTIOsapiSemaphore_take(self->mutex, NULL);
+        worker->ready = RTI_TRUE;
+        RTIOsapiSemaphore_give(self->mutex);
+
+        self->listener.on_data_available(self, self->listener.listener_data);
 
+        /* Block until the read thread returns the loaned samples */
+        if (RTIOsapiSemaphore_take(worker->poll_sem, NULL)
+            != RTI_OSAPI_SEMAPHORE_STATUS_OK) {
             RTI_RoutingServiceLogger_log(
                     RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
-                    "Consumer error: %s\n",
-                    rd_kafka_message_errstr(self->rkm));
-            if (!RTI_RS_KafkaStreamReader_error_cleanup(self)) {
-                return NULL;
-            }
-            continue;
+                    "Error taking poll semaphore");
+            return NULL;
         }
+    }
 
-        /* Proper message. */
-        RTI_RoutingServiceLogger_log(
-                RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
-                "Message on %s [%" PRId32 "] at offset %" PRId64 ":",
-                rd_kafka_topic_name(self->rkm->rkt),
-                self->rkm->partition,
-                self->rkm->offset);
+    return NULL;
+}
 
-        /* Print the message value/payload. */
-        RTI_RoutingServiceLogger_log(
-                RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
-                "Value: %.*s",
-                (int) self->rkm->len,
-                (const char *) self->rkm->payload);
+/*
+ * This function will run as a separate thread when there is more than one
+ * worker, to serve the rebalance callback and the consumer errors from the
+ * consumer queue. Messages are forwarded to the worker queues before their
+ * partitions are assigned, so none are expected here.
+ */
+void *RTI_RS_KafkaStreamReader_events_thread(void *thread_params)
+{
+    struct RTI_RS_KafkaStreamReader *self = thread_params;
+    rd_kafka_message_t *rkm = NULL;
+
+    RTI_RoutingServiceLogger_log(
+            RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
+            "%s",
+            __func__);
 
-        if (!DDS_OctetSeq_initialize(&self->payload)) {
+    while (self->run_thread) {
+        rkm = rd_kafka_consumer_poll(self->rk, CONSUMER_POLL_TIMEOUT);
+        if (rkm == NULL) {
+            continue;
+        }
+
+        if (rkm->err) {
             RTI_RoutingServiceLogger_log(
                     RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
-                    "Error initialize buffer");
-            if (!RTI_RS_KafkaStreamReader_error_cleanup(self)) {
-                return NULL;
-            }
-            continue;
+                    "Consumer error: %s\n",
+                    rd_kafka_message_errstr(rkm));
+        } else {
+            RTI_RoutingServiceLogger_log(
+                    RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                    "Message on %s [%" PRId32 "] at offset %" PRId64
+                    " not forwarded to a worker",
+                    rd_kafka_topic_name(rkm->rkt),
+                    rkm->partition,
+                    rkm->offset);
         }
+        rd_kafka_message_destroy(rkm);
+    }
+
+    return NULL;
+}
+
+void RTI_RS_KafkaStreamReader_rebalance_cb(
+        rd_kafka_t *rk,
+        rd_kafka_resp_err_t err,
+        rd_kafka_topic_partition_list_t *partitions,
+        void *opaque)
+{
+    struct RTI_RS_KafkaStreamReader *self = opaque;
+    struct RTI_RS_KafkaStreamReaderWorker *worker = NULL;
+    rd_kafka_topic_partition_t *partition = NULL;
+    rd_kafka_queue_t *partition_queue = NULL;
+    rd_kafka_error_t *error = NULL;
+    int cooperative = 0;
+    int i = 0;
+
+    RTI_RoutingServiceLogger_log(
+            RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
+            "%s",
+            __func__);
 
-        if (!DDS_OctetSeq_loan_contiguous(
-                    &self->payload,
-                    (DDS_Octet *) self->rkm->payload,
-                    self->rkm->len,
-                    self->rkm->len)) {
-            if (!RTI_RS_KafkaStreamReader_error_cleanup(self)) {
-                return NULL;
+    cooperative = (strcmp(rd_kafka_rebalance_protocol(rk), "COOPERATIVE") == 0);
+
+    switch (err) {
+    case RD_KAFKA_RESP_ERR__ASSIGN_PARTITIONS:
+        /* Forward the partitions before they are assigned, so that no
+         * message is fetched into the consumer queue */
+        for (i = 0; i < partitions->cnt; i++) {
+            partition = &partitions->elems[i];
+            worker = &self->workers[partition->partition % self->worker_count];
+            partition_queue = rd_kafka_queue_get_partition(
+                    rk,
+                    partition->topic,
+                    partition->partition);
+            if (partition_queue == NULL) {
+                RTI_RoutingServiceLogger_log(
+                        RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                        "Error getting queue of partition %s [%" PRId32 "]",
+                        partition->topic,
+                        partition->partition);
+                continue;
             }
-            continue;
+            rd_kafka_queue_forward(partition_queue, worker->queue);
+            rd_kafka_queue_destroy(partition_queue);
         }
 
-        self->listener.on_data_available(self, self->listener.listener_data);
+        if (cooperative) {
+            error = rd_kafka_incremental_assign(rk, partitions);
+        } else {
+            rd_kafka_assign(rk, partitions);
+        }
+        break;
 
-        if (RTIOsapiSemaphore_give(self->read_sem)
-            != RTI_OSAPI_SEMAPHORE_STATUS_OK) {
-            RTI_RoutingServiceLogger_log(
-                    RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
-                    "Error giving read semaphore");
-            return NULL;
+    case RD_KAFKA_RESP_ERR__REVOKE_PARTITIONS:
+        if (cooperative) {
+            error = rd_kafka_incremental_unassign(rk, partitions);
+        } else {
+            rd_kafka_assign(rk, NULL);
         }
+        break;
+
+    default:
+        RTI_RoutingServiceLogger_log(
+                RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                "Rebalance failed: %s",
+                rd_kafka_err2str(err));
+        rd_kafka_assign(rk, NULL);
+        break;
     }
 
-    return NULL;
+    if (error != NULL) {
+        RTI_RoutingServiceLogger_log(
+                RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                "Incremental rebalance failed: %s",
+                rd_kafka_error_string(error));
+        rd_kafka_error_destroy(error);
+    }
 }
 
 void RTI_RS_KafkaStreamReader_read(
@@ -148,6 +351,9 @@ void RTI_RS_KafkaStreamReader_read(
 {
     struct RTI_RS_KafkaStreamReader *self =
             (struct RTI_RS_KafkaStreamReader *) stream_reader;
+    struct RTI_RS_KafkaStreamReaderWorker *worker = NULL;
+    int sample_count = 0;
+    int i = 0;
 
     RTI_RoutingServiceLogger_log(
             RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
@@ -158,34 +364,31 @@ void RTI_RS_KafkaStreamReader_read(
     *info_list = NULL;
     *count = 0;
 
-    struct DDS_DynamicData *sample = NULL;
-    struct DDS_SampleInfo *info = NULL;
-    sample = self->sample_list[0];
-    info = self->info_list[0];
-
-    DDS_ReturnCode_t retcode = DDS_RETCODE_OK;
+    /* Return the batches of all the workers with one ready. The samples
+     * were filled by the worker threads. */
+    RTIOsapiSemaphore_take(self->mutex, NULL);
+    for (i = 0; i < self->worker_count; i++) {
+        worker = &self->workers[i];
+        if (!worker->ready || worker->loaned) {
+            continue;
+        }
 
-    if (RTIOsapiSemaphore_take(self->read_sem, NULL)
-        != RTI_OSAPI_SEMAPHORE_STATUS_OK) {
-        RTI_RoutingServiceLogger_log(
-                RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
-                "Error taking read semaphore");
-        return;
+        memcpy(&self->sample_list[sample_count],
+               worker->sample_list,
+               worker->sample_count * sizeof(struct DDS_DynamicData *));
+        memcpy(&self->info_list[sample_count],
+               worker->info_list,
+               worker->sample_count * sizeof(struct DDS_SampleInfo *));
+        sample_count += worker->sample_count;
+        worker->loaned = RTI_TRUE;
     }
+    RTIOsapiSemaphore_give(self->mutex);
 
-    retcode = DDS_DynamicData_set_octet_seq(
-            sample,
-            "payload.data",
-            DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED,
-            &self->payload);
-    if (retcode != DDS_RETCODE_OK) {
-        RTI_RoutingServiceLogger_log(
-                RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
-                "Error setting payload data");
+    if (sample_count == 0) {
         return;
     }
 
-    *count = 1;
+    *count = sample_count;
     *sample_list = (RTI_RoutingServiceSample *) self->sample_list;
     *info_list = (RTI_RoutingServiceSampleInfo *) self->info_list;
 }
@@ -197,25 +400,33 @@ void RTI_RS_KafkaStreamReader_return_loan(
         int count,
         RTI_RoutingServiceEnvironment *env)
 {
+    struct RTI_RS_KafkaStreamReader *self =
+            (struct RTI_RS_KafkaStreamReader *) stream_reader;
+    struct RTI_RS_KafkaStreamReaderWorker *worker = NULL;
+    int i = 0;
+
     RTI_RoutingServiceLogger_log(
             RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
             "%s",
             __func__);
 
-    struct RTI_RS_KafkaStreamReader *self =
-            (struct RTI_RS_KafkaStreamReader *) stream_reader;
-
-    /* Destroy message if it exist */
-    if (self->rkm != NULL) {
-        rd_kafka_message_destroy(self->rkm);
-    }
+    /* The samples are reused for the next batch of each worker */
+    RTIOsapiSemaphore_take(self->mutex, NULL);
+    for (i = 0; i < self->worker_count; i++) {
+        worker = &self->workers[i];
+        if (!worker->loaned) {
+            continue;
+        }
 
-    if (RTIOsapiSemaphore_give(self->poll_sem)
-        != RTI_OSAPI_SEMAPHORE_STATUS_OK) {
-        RTI_RoutingServiceLogger_log(
-                RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
-                "Error giving poll semaphore");
-        return;
+        worker->loaned = RTI_FALSE;
+        worker->ready = RTI_FALSE;
+        worker->sample_count = 0;
+        if (RTIOsapiSemaphore_give(worker->poll_sem)
+            != RTI_OSAPI_SEMAPHORE_STATUS_OK) {
+            RTI_RoutingServiceLogger_log(
+                    RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                    "Error giving poll semaphore");
+        }
     }
+    RTIOsapiSemaphore_give(self->mutex);
 }
-
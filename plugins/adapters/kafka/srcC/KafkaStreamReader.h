@@ -16,6 +16,17 @@
 #ifndef KafkaStreamReader_h
 #define KafkaStreamReader_h
 #define CONSUMER_POLL_TIMEOUT 100 /*100 ms*/
+#define CONSUMER_BATCH_MAX_SIZE 64
+
+/* Max number of messages consumed from Kafka at once, and max time (in ms)
+ * that the consumer waits for a batch to fill up before notifying the
+ * messages that it has already received. */
+#define CONSUMER_BATCH_MAX_SIZE_PROPERTY "consumer.batch.max_size"
+#define CONSUMER_BATCH_MAX_WAIT_PROPERTY "consumer.batch.max_wait_ms"
+/* Number of threads consuming the partitions assigned to the consumer. With
+ * more than one, each partition is consumed from its own queue, by the
+ * worker thread with index (partition % consumer.workers) */
+#define CONSUMER_WORKERS_PROPERTY "consumer.workers"
 
 #include "ndds/ndds_c.h"
 
@@ -25,20 +36,49 @@
 /* Kafka C library */
 #include "rdkafka.h"
 
+struct RTI_RS_KafkaStreamReader;
+
+/*
+ * A thread consuming batches of messages from a queue into its own pool of
+ * samples. A batch is read by Routing Service while the worker waits for
+ * its loan to be returned.
+ */
+struct RTI_RS_KafkaStreamReaderWorker {
+    struct RTI_RS_KafkaStreamReader *reader;
+    rd_kafka_queue_t *queue; /* rdkafka queue consumed by the worker */
+    rd_kafka_message_t **rkm_list; /* rdkafka messages of the last batch */
+    struct DDS_DynamicData **sample_list;
+    struct DDS_SampleInfo **info_list;
+    int sample_count;        /* Number of samples in sample_list */
+    int ready;               /* The batch is waiting to be read */
+    int loaned;              /* The batch is loaned to Routing Service */
+    struct RTIOsapiJoinableThread *polling_thread;
+    struct RTIOsapiSemaphore *poll_sem; /* Given when the loan is returned */
+    struct DDS_OctetSeq payload;
+    struct DDS_OctetSeq key;
+};
+
 struct RTI_RS_KafkaStreamReader {
     rd_kafka_t *rk;          /* rdkafka consumer instance handle */
-    rd_kafka_message_t *rkm; /*rdkafka message object */
+    int batch_max_size;      /* Max number of messages in a batch */
+    int batch_max_wait;      /* Max time (ms) to wait for a full batch */
+    int has_key_member;       /* The type has a "key" member */
+    int has_partition_member; /* The type has a "partition" member */
+    int has_offset_member;    /* The type has an "offset" member */
     const char *topic;       /* Topic to consume */
-    struct RTIOsapiJoinableThread *polling_thread;
-    struct RTIOsapiSemaphore *poll_sem;
-    struct RTIOsapiSemaphore *read_sem;
+    struct RTI_RS_KafkaStreamReaderWorker *workers;
+    int worker_count;
+    /* With more than one worker, serves the rebalance callback and the
+     * consumer errors, which are not forwarded to the worker queues */
+    struct RTIOsapiJoinableThread *events_thread;
+    struct RTIOsapiSemaphore *mutex; /* Protects ready and loaned */
     int run_thread;
     struct RTI_RoutingServiceStreamReaderListener listener;
+    /* The samples of all the batches returned by a read */
     struct DDS_DynamicData **sample_list;
     struct DDS_SampleInfo **info_list;
     struct DDS_TypeCode *type_code;
     struct DDS_DynamicDataTypeSupport *type_support;
-    struct DDS_OctetSeq payload;
 };
 
 void RTI_RS_KafkaStreamReader_read(
@@ -57,4 +97,16 @@ void RTI_RS_KafkaStreamReader_return_loan(
 
 void *RTI_RS_KafkaStreamReader_on_data_availabe_thread(void *thread_params);
 
+void *RTI_RS_KafkaStreamReader_events_thread(void *thread_params);
+
+/*
+ * Forward the queue of each assigned partition to the queue of a worker,
+ * so that partitions are consumed in parallel, but each one in order.
+ */
+void RTI_RS_KafkaStreamReader_rebalance_cb(
+        rd_kafka_t *rk,
+        rd_kafka_resp_err_t err,
+        rd_kafka_topic_partition_list_t *partitions,
+        void *opaque);
+
 #endif /* KafkaStreamReader_h */
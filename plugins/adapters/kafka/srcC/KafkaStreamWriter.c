@@ -20,6 +20,212 @@
  * supports                      */
 
 #include "KafkaStreamWriter.h"
+#include "KafkaConnection.h"
+
+static struct RTI_RS_KafkaStreamWriterBuffer *
+        RTI_RS_KafkaStreamWriter_get_buffer(
+                struct RTI_RS_KafkaStreamWriter *self)
+{
+    struct RTI_RS_KafkaStreamWriterBuffer *buffer = NULL;
+
+    RTIOsapiSemaphore_take(self->mutex, NULL);
+    buffer = self->free_buffers;
+    if (buffer != NULL) {
+        self->free_buffers = buffer->next;
+        buffer->next = NULL;
+    }
+    RTIOsapiSemaphore_give(self->mutex);
+
+    if (buffer != NULL) {
+        return buffer;
+    }
+
+    buffer = calloc(1, sizeof(struct RTI_RS_KafkaStreamWriterBuffer));
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    if (!DDS_OctetSeq_initialize(&buffer->payload)) {
+        free(buffer);
+        return NULL;
+    }
+    buffer->writer = self;
+
+    RTIOsapiSemaphore_take(self->mutex, NULL);
+    buffer->next_allocated = self->buffers;
+    self->buffers = buffer;
+    RTIOsapiSemaphore_give(self->mutex);
+
+    return buffer;
+}
+
+/* Must be called with self->mutex taken */
+static void RTI_RS_KafkaStreamWriter_return_buffer(
+        struct RTI_RS_KafkaStreamWriter *self,
+        struct RTI_RS_KafkaStreamWriterBuffer *buffer)
+{
+    /* The copy buffer is not part of the pool */
+    if (buffer == &self->copy_buffer) {
+        return;
+    }
+
+    buffer->next = self->free_buffers;
+    self->free_buffers = buffer;
+}
+
+void RTI_RS_KafkaStreamWriter_on_delivery(
+        struct RTI_RS_KafkaStreamWriterBuffer *buffer)
+{
+    struct RTI_RS_KafkaStreamWriter *self = buffer->writer;
+
+    RTIOsapiSemaphore_take(self->mutex, NULL);
+    self->inflight--;
+    RTI_RS_KafkaStreamWriter_return_buffer(self, buffer);
+    RTIOsapiSemaphore_give(self->mutex);
+}
+
+int RTI_RS_KafkaStreamWriter_get_inflight(
+        struct RTI_RS_KafkaStreamWriter *self)
+{
+    int inflight = 0;
+
+    RTIOsapiSemaphore_take(self->mutex, NULL);
+    inflight = self->inflight;
+    RTIOsapiSemaphore_give(self->mutex);
+
+    return inflight;
+}
+
+void RTI_RS_KafkaStreamWriter_finalize_buffers(
+        struct RTI_RS_KafkaStreamWriter *self)
+{
+    struct RTI_RS_KafkaStreamWriterBuffer *buffer = self->buffers;
+    struct RTI_RS_KafkaStreamWriterBuffer *next = NULL;
+
+    while (buffer != NULL) {
+        next = buffer->next_allocated;
+        DDS_OctetSeq_finalize(&buffer->payload);
+        free(buffer);
+        buffer = next;
+    }
+
+    self->buffers = NULL;
+    self->free_buffers = NULL;
+}
+
+/*
+ * Get the message key of a sample: the value of its "key" member, if the
+ * type has one and it's not empty, or else its DDS instance, if
+ * self->key_from_instance is set. The key is NULL if there's none.
+ */
+static int RTI_RS_KafkaStreamWriter_get_key(
+        struct RTI_RS_KafkaStreamWriter *self,
+        struct DDS_DynamicData *sample,
+        const struct DDS_SampleInfo *info,
+        void **key_out,
+        size_t *key_len_out)
+{
+    DDS_ReturnCode_t retcode = DDS_RETCODE_OK;
+
+    *key_out = NULL;
+    *key_len_out = 0;
+
+    if (self->has_key_member) {
+        retcode = DDS_DynamicData_get_octet_seq(
+                sample,
+                &self->key,
+                "key",
+                DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED);
+        if (retcode == DDS_RETCODE_OK
+            && DDS_OctetSeq_get_length(&self->key) > 0) {
+            *key_out = DDS_OctetSeq_get_contiguous_buffer(&self->key);
+            *key_len_out = DDS_OctetSeq_get_length(&self->key);
+            return 0;
+        }
+        /* An optional key member may be unset */
+        if (retcode != DDS_RETCODE_OK && retcode != DDS_RETCODE_NO_DATA) {
+            RTI_RoutingServiceLogger_log(
+                    RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                    "Error getting key");
+            return -1;
+        }
+    }
+
+    /* Messages of the same DDS instance are sent to the same partition,
+     * which preserves their order */
+    if (self->key_from_instance && info != NULL
+        && !DDS_InstanceHandle_is_nil(&info->instance_handle)) {
+        *key_out = (void *) info->instance_handle.keyHash.value;
+        *key_len_out = info->instance_handle.keyHash.length;
+    }
+
+    return 0;
+}
+
+/*
+ * Create the headers with the source timestamp (in nanoseconds) and the
+ * writer GUID (in hexadecimal) of a sample.
+ */
+static rd_kafka_headers_t *RTI_RS_KafkaStreamWriter_new_headers(
+        const struct DDS_SampleInfo *info)
+{
+    rd_kafka_headers_t *headers = NULL;
+    char value[2 * sizeof(info->original_publication_virtual_guid.value) + 1];
+    size_t i = 0;
+
+    headers = rd_kafka_headers_new(2);
+    if (headers == NULL) {
+        return NULL;
+    }
+
+    snprintf(
+            value,
+            sizeof(value),
+            "%lld",
+            (long long) info->source_timestamp.sec * 1000000000LL
+                    + info->source_timestamp.nanosec);
+    rd_kafka_header_add(headers, HEADER_SOURCE_TIMESTAMP, -1, value, -1);
+
+    for (i = 0; i < sizeof(info->original_publication_virtual_guid.value);
+         i++) {
+        snprintf(
+                value + 2 * i,
+                3,
+                "%02x",
+                info->original_publication_virtual_guid.value[i]);
+    }
+    rd_kafka_header_add(headers, HEADER_WRITER_GUID, -1, value, -1);
+
+    return headers;
+}
+
+static rd_kafka_resp_err_t RTI_RS_KafkaStreamWriter_produce(
+        struct RTI_RS_KafkaStreamWriter *self,
+        void *data,
+        size_t len,
+        void *key,
+        size_t key_len,
+        rd_kafka_headers_t *headers,
+        int msgflags,
+        void *msg_opaque)
+{
+    return rd_kafka_producev(
+            self->rk,
+            RD_KAFKA_V_RKT(self->rkt),
+            /* Either RD_KAFKA_MSG_F_COPY, or 0 if the payload is loaned. */
+            RD_KAFKA_V_MSGFLAGS(msgflags),
+            /* Message value and length */
+            RD_KAFKA_V_VALUE(data, len),
+            /* Message key, always copied. NULL for random partitioning. */
+            RD_KAFKA_V_KEY(key, key_len),
+            /* Headers, owned by librdkafka if the call succeeds. */
+            RD_KAFKA_V_HEADERS(headers),
+            /* Per-Message opaque, provided in delivery report callback as
+               msg_opaque. */
+            RD_KAFKA_V_OPAQUE(msg_opaque),
+            /* End sentinel */
+            RD_KAFKA_V_END);
+}
 
 int RTI_RS_KafkaStreamWriter_write(
         RTI_RoutingServiceStreamWriter stream_writer,
@@ -32,11 +238,21 @@ int RTI_RS_KafkaStreamWriter_write(
             (struct RTI_RS_KafkaStreamWriter *) stream_writer;
     struct DDS_DynamicData *sample = NULL;
     struct DDS_SampleInfo *sample_info = NULL;
-    struct DDS_OctetSeq buffer_seq = DDS_SEQUENCE_INITIALIZER;
-    char *buffer = NULL;
+    struct RTI_RS_KafkaStreamWriterBuffer *loaned_buffer = NULL;
+    struct RTI_RS_KafkaStreamWriterBuffer *msg_buffer = NULL;
+    rd_kafka_headers_t *headers = NULL;
+    void *key = NULL;
+    size_t key_len = 0;
+    struct DDS_OctetSeq *buffer_seq = NULL;
+    DDS_Octet *buffer = NULL;
 
     int i = 0;
+    int written = 0;
+    int blocked = 0; /* Time (ms) blocked on a full queue */
+    int wait = 0;
+    int queue_full = 0;
     size_t len = 0;
+    int msgflags = 0;
     rd_kafka_resp_err_t err = RD_KAFKA_RESP_ERR_NO_ERROR;
     int retcode;
 
@@ -52,122 +268,182 @@ int RTI_RS_KafkaStreamWriter_write(
 
     for (i = 0; i < count; i++) {
         sample = (struct DDS_DynamicData *) sample_list[i];
-        /* we are not using sample_info anywhere
-        sample_info = (struct DDS_SampleInfo *)info_list[i];
+        sample_info = (info_list != NULL)
+                ? (struct DDS_SampleInfo *) info_list[i]
+                : NULL;
 
-        if (sample_info) {
-            sample_info = (struct DDS_SampleInfo *)info_list[i];
+        /* With reuse_payload_buffer the payload is copied out of the sample
+         * into a pooled buffer which librdkafka keeps until the delivery
+         * report, otherwise into self->copy_buffer, which librdkafka copies
+         * right away. */
+        if (self->reuse_payload_buffer) {
+            loaned_buffer = RTI_RS_KafkaStreamWriter_get_buffer(self);
+            if (loaned_buffer == NULL) {
+                RTI_RoutingServiceLogger_log(
+                        RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                        "Error allocating payload buffer");
+                continue;
+            }
+            msg_buffer = loaned_buffer;
+            msgflags = 0;
+        } else {
+            msg_buffer = &self->copy_buffer;
+            msgflags = RD_KAFKA_MSG_F_COPY;
         }
-        */
+        buffer_seq = &msg_buffer->payload;
 
         retcode = DDS_DynamicData_get_octet_seq(
                 sample,
-                &buffer_seq,
+                buffer_seq,
                 "payload.data",
                 DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED);
         if (retcode != DDS_RETCODE_OK) {
             RTI_RoutingServiceLogger_log(
                     RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
                     "Error getting payload data");
-            continue;
+            goto next;
         }
 
-        buffer = DDS_OctetSeq_get_contiguous_buffer(&buffer_seq);
-        if (buffer == NULL) {
+        /* The payload may contain binary data (e.g. CDR), so its length is
+         * the length of the sequence, and not that of a string. */
+        len = DDS_OctetSeq_get_length(buffer_seq);
+        buffer = DDS_OctetSeq_get_contiguous_buffer(buffer_seq);
+        if (buffer == NULL && len > 0) {
             RTI_RoutingServiceLogger_log(
                     RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
                     "Error getting contiguous buffer");
-            continue;
+            goto next;
         }
 
         RTI_RoutingServiceLogger_log(
                 RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
-                "Payload data: %s",
-                buffer);
+                "Payload length: %zu",
+                len);
 
-        len = strlen(buffer);
+        if (RTI_RS_KafkaStreamWriter_get_key(
+                    self,
+                    sample,
+                    sample_info,
+                    &key,
+                    &key_len)) {
+            goto next;
+        }
 
-        RTI_RoutingServiceLogger_log(
-                RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
-                "Payload lenth: %d",
-                len);
+        if (self->headers && sample_info != NULL) {
+            headers = RTI_RS_KafkaStreamWriter_new_headers(sample_info);
+            if (headers == NULL) {
+                RTI_RoutingServiceLogger_log(
+                        RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                        "Error creating headers");
+                goto next;
+            }
+        }
+
+        /* Count the message before producing it, since its delivery report
+         * may be received by the poller thread right away */
+        RTIOsapiSemaphore_take(self->mutex, NULL);
+        self->inflight++;
+        RTIOsapiSemaphore_give(self->mutex);
+
+        err = RTI_RS_KafkaStreamWriter_produce(
+                self,
+                buffer,
+                len,
+                key,
+                key_len,
+                headers,
+                msgflags,
+                msg_buffer);
+        while (err == RD_KAFKA_RESP_ERR__QUEUE_FULL
+               && blocked < self->max_blocking_time) {
+            /* If the internal queue is full, wait for
+             * messages to be delivered and then retry.
+             * The internal queue represents both
+             * messages to be sent and messages that have
+             * been sent or failed, awaiting their
+             * delivery report callback to be called.
+
+             * The internal queue is limited by the
+             * configuration property
+             * queue.buffering.max.messages */
+            RTI_RoutingServiceLogger_log(
+                    RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
+                    "Internal queue is full. Waiting for messages to be "
+                    "delivered...");
+            wait = self->max_blocking_time - blocked;
+            if (wait > PRODUCER_QUEUE_FULL_WAIT) {
+                wait = PRODUCER_QUEUE_FULL_WAIT;
+            }
+            RTI_RS_KafkaConnection_wait_for_queue_space(
+                    self->connection,
+                    wait);
+            blocked += wait;
+            err = RTI_RS_KafkaStreamWriter_produce(
+                    self,
+                    buffer,
+                    len,
+                    key,
+                    key_len,
+                    headers,
+                    msgflags,
+                    msg_buffer);
+        }
 
-        err = rd_kafka_producev(
-                self->rk,
-                RD_KAFKA_V_TOPIC(self->topic),
-                /* Make a copy of the payload. */
-                RD_KAFKA_V_MSGFLAGS(RD_KAFKA_MSG_F_COPY),
-                /* Message value and length */
-                RD_KAFKA_V_VALUE(buffer, len),
-                /* Per-Message opaque, provided in delivery report callback as msg_opaque. */
-                RD_KAFKA_V_OPAQUE(NULL),
-                /* End sentinel */
-                RD_KAFKA_V_END);
-        if (err != RD_KAFKA_RESP_ERR_NO_ERROR) {
+        if (err == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
+            /* Back-pressure: the remaining samples are not written, and
+             * Routing Service is notified through the returned count */
+            RTI_RoutingServiceLogger_log(
+                    RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
+                    "Internal queue is still full after %d ms: "
+                    "%d of %d samples written to topic %s\n",
+                    blocked,
+                    written,
+                    count,
+                    self->topic);
+            queue_full = 1;
+        } else if (err != RD_KAFKA_RESP_ERR_NO_ERROR) {
             /* Failed to *enqueue* message for producing. */
             RTI_RoutingServiceLogger_log(
                     RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
                     "Failed to produce to topic %s: %s\n",
                     self->topic,
                     rd_kafka_err2str(err));
-            while (err == RD_KAFKA_RESP_ERR__QUEUE_FULL) {
-                /* If the internal queue is full, wait for
-                 * messages to be delivered and then retry.
-                 * The internal queue represents both
-                 * messages to be sent and messages that have
-                 * been sent or failed, awaiting their
-                 * delivery report callback to be called.
-
-                 * The internal queue is limited by the
-                 * configuration property
-                 * queue.buffering.max.messages */
-                RTI_RoutingServiceLogger_log(
-                        RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
-                        "Internal queue is full. Waiting for messages to be "
-                        "delivered...");
-                rd_kafka_poll(self->rk, 10); /* block for max 10ms */
-                err = rd_kafka_producev(
-                        self->rk,
-                        RD_KAFKA_V_TOPIC(self->topic),
-                        /* Make a copy of the payload. */
-                        RD_KAFKA_V_MSGFLAGS(RD_KAFKA_MSG_F_COPY),
-                        /* Message value and length */
-                        RD_KAFKA_V_VALUE(buffer, len),
-                        /* Per-Message opaque, provided in delivery report
-                           callback as msg_opaque. */
-                        RD_KAFKA_V_OPAQUE(NULL),
-                        /* End sentinel */
-                        RD_KAFKA_V_END);
-                if (err != RD_KAFKA_RESP_ERR_NO_ERROR) {
-                    RTI_RoutingServiceLogger_log(
-                            RTI_ROUTING_SERVICE_VERBOSITY_EXCEPTION,
-                            "Failed to produce to topic %s: %s\n",
-                            self->topic,
-                            rd_kafka_err2str(err));
-                }
-            }
-        } else {
+        }
+
+        if (err == RD_KAFKA_RESP_ERR_NO_ERROR) {
             RTI_RoutingServiceLogger_log(
                     RTI_ROUTING_SERVICE_VERBOSITY_DEBUG,
                     "Enqueued message (%zd bytes) "
                     "for topic %s\n",
                     len,
                     self->topic);
+            /* The buffer is now owned by librdkafka, and it will be
+             * returned by the delivery report callback, which is served
+             * by the poller thread of the connection */
+            loaned_buffer = NULL;
+            headers = NULL;
+            written++;
+        } else {
+            RTIOsapiSemaphore_take(self->mutex, NULL);
+            self->inflight--;
+            RTIOsapiSemaphore_give(self->mutex);
         }
 
-        /* A producer application should continually serve
-         * the delivery report queue by calling rd_kafka_poll()
-         * at frequent intervals.
-         * Either put the poll call in your main loop, or in a
-         * dedicated thread, or call it after every
-         * rd_kafka_produce() call.
-         * Just make sure that rd_kafka_poll() is still called
-         * during periods where you are not producing any messages
-         * to make sure previously produced messages have their
-         * delivery report callback served (and any other callbacks
-         * you register). */
-        rd_kafka_poll(self->rk, 0 /*non-blocking*/);
+    next:
+        if (headers != NULL) {
+            rd_kafka_headers_destroy(headers);
+            headers = NULL;
+        }
+        if (loaned_buffer != NULL) {
+            RTIOsapiSemaphore_take(self->mutex, NULL);
+            RTI_RS_KafkaStreamWriter_return_buffer(self, loaned_buffer);
+            RTIOsapiSemaphore_give(self->mutex);
+            loaned_buffer = NULL;
+        }
+        if (queue_full) {
+            break;
+        }
     }
 
-    return count;
+    return written;
 }
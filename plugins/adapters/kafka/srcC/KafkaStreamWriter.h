@@ -25,13 +25,76 @@
 #include "rdkafka.h"
 
 #include <ctype.h>
+#include <stdio.h>
 #include <time.h>
 
+/* If "true", payloads are copied into pooled buffers which librdkafka keeps
+ * until the delivery report, instead of being copied again by librdkafka */
+#define PRODUCER_REUSE_PAYLOAD_BUFFER_PROPERTY "producer.reuse_payload_buffer"
+/* If "true", the DDS instance of a sample is used as the message key when
+ * the sample has no "key" member, or the member is empty */
+#define PRODUCER_KEY_FROM_INSTANCE_PROPERTY "producer.key_from_instance"
+/* If "true", messages carry the source timestamp and the writer GUID of
+ * their DDS sample as headers */
+#define PRODUCER_HEADERS_PROPERTY "producer.headers"
+
+/* Max time (in ms) that a write may block while the producer queue is full,
+ * before returning the number of samples written so far */
+#define PRODUCER_MAX_BLOCKING_TIME_PROPERTY "producer.max_blocking_time_ms"
+#define PRODUCER_MAX_BLOCKING_TIME 1000 /*1 s*/
+/* Max time (in ms) to wait for a delivery report before retrying to
+ * produce a message to a full queue */
+#define PRODUCER_QUEUE_FULL_WAIT 10 /*10 ms*/
+
+#define HEADER_SOURCE_TIMESTAMP "rti.source_timestamp"
+#define HEADER_WRITER_GUID "rti.writer_guid"
+
+struct RTI_RS_KafkaConnection;
+struct RTI_RS_KafkaStreamWriter;
+
+/*
+ * Buffer holding the payload of a message. Every message is produced with
+ * a buffer as its opaque, so that its delivery report can be tracked back
+ * to the stream writer. When reuse_payload_buffer is set, the buffer is
+ * loaned to librdkafka until the delivery report of the message, and then reused for
+ * another message. Otherwise, librdkafka copies the payload, and all
+ * messages use the stream writer's copy_buffer.
+ */
+struct RTI_RS_KafkaStreamWriterBuffer {
+    struct RTI_RS_KafkaStreamWriter *writer;
+    struct DDS_OctetSeq payload;
+    struct RTI_RS_KafkaStreamWriterBuffer *next;           /* Next free */
+    struct RTI_RS_KafkaStreamWriterBuffer *next_allocated; /* Next in list */
+};
+
 struct RTI_RS_KafkaStreamWriter {
-    rd_kafka_t *rk;        /* rdkafka producer instance handle */
+    struct RTI_RS_KafkaConnection *connection;
+    rd_kafka_t *rk;        /* rdkafka producer shared by the connection */
+    rd_kafka_topic_t *rkt; /* rdkafka topic handle */
     const char *topic;     /* Topic to produce to */
+    /* Loan pooled payload buffers to librdkafka */
+    int reuse_payload_buffer;
+    int has_key_member;    /* The type has a "key" member */
+    int key_from_instance; /* Use the DDS instance as default key */
+    int headers;           /* Add source timestamp and writer GUID headers */
+    int max_blocking_time; /* Max time (ms) a write blocks on a full queue */
+    struct DDS_OctetSeq key;     /* Key, always copied by librdkafka */
+    /* Protects the buffers and inflight, which are also accessed by the
+     * delivery report callback */
+    struct RTIOsapiSemaphore *mutex;
+    int inflight;          /* Messages waiting for a delivery report */
+    struct RTI_RS_KafkaStreamWriterBuffer copy_buffer;
+    struct RTI_RS_KafkaStreamWriterBuffer *free_buffers;
+    struct RTI_RS_KafkaStreamWriterBuffer *buffers; /* All allocated buffers */
+    /* Next stream writer deleted with undelivered messages */
+    struct RTI_RS_KafkaStreamWriter *next_retired;
 };
 
+/*
+ * Produce a message for each sample. Returns the number of messages
+ * enqueued, which is less than count if some samples couldn't be written,
+ * or if the producer queue stayed full for longer than max_blocking_time.
+ */
 int RTI_RS_KafkaStreamWriter_write(
         RTI_RoutingServiceStreamWriter stream_writer,
         const RTI_RoutingServiceSample *sample_list,
@@ -39,6 +102,22 @@ int RTI_RS_KafkaStreamWriter_write(
         int count,
         RTI_RoutingServiceEnvironment *env);
 
+/*
+ * Account for the delivery report of a message produced with the specified
+ * buffer, and return the buffer to its stream writer, if it was loaned.
+ * Called by the delivery report callback, from the producer's poller thread.
+ */
+void RTI_RS_KafkaStreamWriter_on_delivery(
+        struct RTI_RS_KafkaStreamWriterBuffer *buffer);
+
+/* Number of messages produced and not yet reported as delivered (or not) */
+int RTI_RS_KafkaStreamWriter_get_inflight(
+        struct RTI_RS_KafkaStreamWriter *self);
+
+/* Free all the pooled payload buffers, whether loaned or not */
+void RTI_RS_KafkaStreamWriter_finalize_buffers(
+        struct RTI_RS_KafkaStreamWriter *self);
+
 static void RTI_RS_KafkaStreamWriter_dr_msg_cb(
         rd_kafka_t *rk,
         const rd_kafka_message_t *rkmessage,
@@ -0,0 +1,352 @@
+/******************************************************************************/
+/* (c) 2021 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "KafkaConnection.h"
+#include "UtilsUnitTest.h"
+
+/* Every test deletes its semaphores when a check fails */
+#define RTI_RS_KAFKA_TEST_CHECK(cond_) RTI_UTILS_TEST_CHECK_OR(cond_, goto done)
+
+#define RTI_RS_KAFKA_TEST_WAITERS 3
+/* Long enough to tell a wakeup from a timeout, even on a loaded machine */
+#define RTI_RS_KAFKA_TEST_LONG_WAIT 30000
+#define RTI_RS_KAFKA_TEST_SHORT_WAIT 10
+
+/*
+ * Queue-space tests
+ */
+
+struct RTI_RS_KafkaTestWaiter {
+    struct RTI_RS_KafkaConnection *connection;
+    int woken;
+};
+
+static void *RTI_RS_KafkaConnectionTest_waiter_thread(void *thread_params)
+{
+    struct RTI_RS_KafkaTestWaiter *waiter = thread_params;
+
+    waiter->woken = RTI_RS_KafkaConnection_wait_for_queue_space(
+            waiter->connection,
+            RTI_RS_KAFKA_TEST_LONG_WAIT);
+
+    return NULL;
+}
+
+/* Only the queue-space fields of the connection are used by the tests */
+static int RTI_RS_KafkaConnectionTest_initialize(
+        struct RTI_RS_KafkaConnection *connection)
+{
+    memset(connection, 0, sizeof(*connection));
+    connection->queue_space_mutex =
+            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_MUTEX, NULL);
+    connection->queue_space_sem =
+            RTIOsapiSemaphore_new(RTI_OSAPI_SEMAPHORE_KIND_COUNTING, NULL);
+
+    return connection->queue_space_mutex != NULL
+            && connection->queue_space_sem != NULL;
+}
+
+static void RTI_RS_KafkaConnectionTest_finalize(
+        struct RTI_RS_KafkaConnection *connection)
+{
+    if (connection->queue_space_sem != NULL) {
+        RTIOsapiSemaphore_delete(connection->queue_space_sem);
+    }
+    if (connection->queue_space_mutex != NULL) {
+        RTIOsapiSemaphore_delete(connection->queue_space_mutex);
+    }
+}
+
+static int RTI_RS_KafkaConnectionTest_get_waiters(
+        struct RTI_RS_KafkaConnection *connection)
+{
+    int waiters = 0;
+
+    RTIOsapiSemaphore_take(connection->queue_space_mutex, NULL);
+    waiters = connection->queue_space_waiters;
+    RTIOsapiSemaphore_give(connection->queue_space_mutex);
+
+    return waiters;
+}
+
+/* A single delivery report wakes up every writer waiting for space */
+static int RTI_RS_KafkaConnectionTest_notify_wakes_all_waiters(void)
+{
+    int retval = 0;
+    int i = 0;
+    int started = 0;
+    struct RTI_RS_KafkaConnection connection;
+    struct RTI_RS_KafkaTestWaiter waiters[RTI_RS_KAFKA_TEST_WAITERS];
+    struct RTIOsapiJoinableThread *threads[RTI_RS_KAFKA_TEST_WAITERS];
+    struct RTINtpTime poll_period = RTI_NTP_TIME_ZERO;
+
+    RTINtpTime_packFromMillisec(poll_period, 0, 1);
+    RTI_RS_KAFKA_TEST_CHECK(
+            RTI_RS_KafkaConnectionTest_initialize(&connection));
+
+    for (started = 0; started < RTI_RS_KAFKA_TEST_WAITERS; started++) {
+        waiters[started].connection = &connection;
+        waiters[started].woken = 0;
+        threads[started] = RTIOsapiJoinableThread_new(
+                "KafkaConnectionTest_waiter",
+                RTI_OSAPI_THREAD_PRIORITY_DEFAULT,
+                RTI_OSAPI_THREAD_OPTION_DEFAULT,
+                RTI_OSAPI_THREAD_STACK_SIZE_DEFAULT,
+                NULL,
+                RTI_RS_KafkaConnectionTest_waiter_thread,
+                &waiters[started]);
+        RTI_RS_KAFKA_TEST_CHECK(threads[started] != NULL);
+    }
+
+    /* Notify once all of them are blocked waiting */
+    while (RTI_RS_KafkaConnectionTest_get_waiters(&connection)
+           < RTI_RS_KAFKA_TEST_WAITERS) {
+        RTIOsapiThread_sleep(&poll_period);
+    }
+    RTI_RS_KafkaConnection_notify_queue_space(&connection);
+
+    for (i = 0; i < started; i++) {
+        RTI_RS_KAFKA_TEST_CHECK(RTIOsapiJoinableThread_stopAndDelete(
+                threads[i],
+                RTI_OSAPI_THREAD_INFINITE_BLOCKING_TIMEOUT));
+        threads[i] = NULL;
+        RTI_RS_KAFKA_TEST_CHECK(waiters[i].woken);
+    }
+    RTI_RS_KAFKA_TEST_CHECK(connection.queue_space_waiters == 0);
+    RTI_RS_KAFKA_TEST_CHECK(connection.queue_space_generation == 1);
+
+    retval = 1;
+done:
+    /* Unblock any waiter left behind by a failed check before joining it */
+    for (i = 0; i < started; i++) {
+        if (threads[i] != NULL) {
+            RTIOsapiSemaphore_give(connection.queue_space_sem);
+        }
+    }
+    for (i = 0; i < started; i++) {
+        if (threads[i] != NULL) {
+            RTIOsapiJoinableThread_stopAndDelete(
+                    threads[i],
+                    RTI_OSAPI_THREAD_INFINITE_BLOCKING_TIMEOUT);
+        }
+    }
+    RTI_RS_KafkaConnectionTest_finalize(&connection);
+    return retval;
+}
+
+/* A writer that times out stops counting as a waiter, so a later delivery
+ * report doesn't give the semaphore on its behalf */
+static int RTI_RS_KafkaConnectionTest_timeout_removes_waiter(void)
+{
+    int retval = 0;
+    struct RTI_RS_KafkaConnection connection;
+
+    RTI_RS_KAFKA_TEST_CHECK(
+            RTI_RS_KafkaConnectionTest_initialize(&connection));
+
+    RTI_RS_KAFKA_TEST_CHECK(!RTI_RS_KafkaConnection_wait_for_queue_space(
+            &connection,
+            RTI_RS_KAFKA_TEST_SHORT_WAIT));
+    RTI_RS_KAFKA_TEST_CHECK(connection.queue_space_waiters == 0);
+
+    RTI_RS_KafkaConnection_notify_queue_space(&connection);
+    RTI_RS_KAFKA_TEST_CHECK(connection.queue_space_generation == 0);
+    RTI_RS_KAFKA_TEST_CHECK(!RTI_RS_KafkaConnection_wait_for_queue_space(
+            &connection,
+            RTI_RS_KAFKA_TEST_SHORT_WAIT));
+    RTI_RS_KAFKA_TEST_CHECK(connection.queue_space_waiters == 0);
+
+    retval = 1;
+done:
+    RTI_RS_KafkaConnectionTest_finalize(&connection);
+    return retval;
+}
+
+/*
+ * Property tests
+ */
+
+#define RTI_RS_KAFKA_TEST_PROPERTIES(name_, ...)                   \
+    struct RTI_RoutingServiceNameValue name_##_values[] = {        \
+        __VA_ARGS__                                                \
+    };                                                             \
+    struct RTI_RoutingServiceProperties name_ = {                  \
+        sizeof(name_##_values) / sizeof(name_##_values[0]),        \
+        name_##_values                                             \
+    }
+
+/* The returned names are compared by value: the string literals of the
+ * library are not those of the test */
+static int RTI_RS_KafkaConnectionTest_is_invalid(
+        const char *invalid_property,
+        const char *expected)
+{
+    return invalid_property != NULL && strcmp(invalid_property, expected) == 0;
+}
+
+/* Returns the name of the invalid property, or NULL */
+static const char *RTI_RS_KafkaConnectionTest_parse_reader(
+        const char *name,
+        const char *value,
+        struct RTI_RS_KafkaStreamReader *reader,
+        int *worker_count)
+{
+    RTI_RS_KAFKA_TEST_PROPERTIES(properties, { name, value });
+
+    memset(reader, 0, sizeof(*reader));
+    return RTI_RS_KafkaConnection_parse_reader_properties(
+            reader,
+            worker_count,
+            &properties);
+}
+
+static int RTI_RS_KafkaConnectionTest_reader_properties(void)
+{
+    struct RTI_RS_KafkaStreamReader reader;
+    int workers = 0;
+    RTI_RS_KAFKA_TEST_PROPERTIES(
+            all,
+            { CONSUMER_BATCH_MAX_SIZE_PROPERTY, "16" },
+            { CONSUMER_BATCH_MAX_WAIT_PROPERTY, "0" },
+            { CONSUMER_WORKERS_PROPERTY, "4" });
+    RTI_RS_KAFKA_TEST_PROPERTIES(none, { "topic", "Square" });
+
+    /* Defaults */
+    memset(&reader, 0, sizeof(reader));
+    RTI_UTILS_TEST_CHECK(
+            RTI_RS_KafkaConnection_parse_reader_properties(
+                    &reader,
+                    &workers,
+                    &none)
+            == NULL);
+    RTI_UTILS_TEST_CHECK(reader.batch_max_size == CONSUMER_BATCH_MAX_SIZE);
+    RTI_UTILS_TEST_CHECK(reader.batch_max_wait == CONSUMER_POLL_TIMEOUT);
+    RTI_UTILS_TEST_CHECK(workers == 1);
+
+    memset(&reader, 0, sizeof(reader));
+    RTI_UTILS_TEST_CHECK(
+            RTI_RS_KafkaConnection_parse_reader_properties(
+                    &reader,
+                    &workers,
+                    &all)
+            == NULL);
+    RTI_UTILS_TEST_CHECK(reader.batch_max_size == 16);
+    RTI_UTILS_TEST_CHECK(reader.batch_max_wait == 0);
+    RTI_UTILS_TEST_CHECK(workers == 4);
+
+    /* A batch and a worker pool can't be empty, but the wait can be 0 */
+    RTI_UTILS_TEST_CHECK(RTI_RS_KafkaConnectionTest_is_invalid(
+            RTI_RS_KafkaConnectionTest_parse_reader(
+                    CONSUMER_BATCH_MAX_SIZE_PROPERTY, "0", &reader, &workers),
+            CONSUMER_BATCH_MAX_SIZE_PROPERTY));
+    RTI_UTILS_TEST_CHECK(RTI_RS_KafkaConnectionTest_is_invalid(
+            RTI_RS_KafkaConnectionTest_parse_reader(
+                    CONSUMER_WORKERS_PROPERTY, "0", &reader, &workers),
+            CONSUMER_WORKERS_PROPERTY));
+    RTI_UTILS_TEST_CHECK(RTI_RS_KafkaConnectionTest_is_invalid(
+            RTI_RS_KafkaConnectionTest_parse_reader(
+                    CONSUMER_BATCH_MAX_WAIT_PROPERTY, "-1", &reader, &workers),
+            CONSUMER_BATCH_MAX_WAIT_PROPERTY));
+
+    /* Only whole decimal numbers that fit in an int are accepted */
+    RTI_UTILS_TEST_CHECK(RTI_RS_KafkaConnectionTest_is_invalid(
+            RTI_RS_KafkaConnectionTest_parse_reader(
+                    CONSUMER_WORKERS_PROPERTY, "", &reader, &workers),
+            CONSUMER_WORKERS_PROPERTY));
+    RTI_UTILS_TEST_CHECK(RTI_RS_KafkaConnectionTest_is_invalid(
+            RTI_RS_KafkaConnectionTest_parse_reader(
+                    CONSUMER_WORKERS_PROPERTY, "two", &reader, &workers),
+            CONSUMER_WORKERS_PROPERTY));
+    RTI_UTILS_TEST_CHECK(RTI_RS_KafkaConnectionTest_is_invalid(
+            RTI_RS_KafkaConnectionTest_parse_reader(
+                    CONSUMER_WORKERS_PROPERTY, "2x", &reader, &workers),
+            CONSUMER_WORKERS_PROPERTY));
+    RTI_UTILS_TEST_CHECK(RTI_RS_KafkaConnectionTest_is_invalid(
+            RTI_RS_KafkaConnectionTest_parse_reader(
+                    CONSUMER_BATCH_MAX_SIZE_PROPERTY,
+                    "99999999999999999999",
+                    &reader,
+                    &workers),
+            CONSUMER_BATCH_MAX_SIZE_PROPERTY));
+
+    return 1;
+}
+
+static int RTI_RS_KafkaConnectionTest_writer_properties(void)
+{
+    struct RTI_RS_KafkaStreamWriter writer;
+    RTI_RS_KAFKA_TEST_PROPERTIES(
+            all,
+            { PRODUCER_REUSE_PAYLOAD_BUFFER_PROPERTY, "true" },
+            { PRODUCER_KEY_FROM_INSTANCE_PROPERTY, "1" },
+            { PRODUCER_HEADERS_PROPERTY, "false" },
+            { PRODUCER_MAX_BLOCKING_TIME_PROPERTY, "0" });
+    RTI_RS_KAFKA_TEST_PROPERTIES(none, { "topic", "Square" });
+    RTI_RS_KAFKA_TEST_PROPERTIES(
+            negative_time,
+            { PRODUCER_MAX_BLOCKING_TIME_PROPERTY, "-1" });
+    RTI_RS_KAFKA_TEST_PROPERTIES(
+            not_bool,
+            { PRODUCER_HEADERS_PROPERTY, "yes" });
+
+    memset(&writer, 0, sizeof(writer));
+    RTI_UTILS_TEST_CHECK(
+            RTI_RS_KafkaConnection_parse_writer_properties(&writer, &none)
+            == NULL);
+    RTI_UTILS_TEST_CHECK(
+            writer.max_blocking_time == PRODUCER_MAX_BLOCKING_TIME);
+    RTI_UTILS_TEST_CHECK(!writer.reuse_payload_buffer);
+
+    memset(&writer, 0, sizeof(writer));
+    writer.headers = 1;
+    RTI_UTILS_TEST_CHECK(
+            RTI_RS_KafkaConnection_parse_writer_properties(&writer, &all)
+            == NULL);
+    RTI_UTILS_TEST_CHECK(writer.reuse_payload_buffer);
+    RTI_UTILS_TEST_CHECK(writer.key_from_instance);
+    RTI_UTILS_TEST_CHECK(!writer.headers);
+    /* 0 makes a full queue fail the write right away */
+    RTI_UTILS_TEST_CHECK(writer.max_blocking_time == 0);
+
+    RTI_UTILS_TEST_CHECK(RTI_RS_KafkaConnectionTest_is_invalid(
+            RTI_RS_KafkaConnection_parse_writer_properties(
+                    &writer,
+                    &negative_time),
+            PRODUCER_MAX_BLOCKING_TIME_PROPERTY));
+    RTI_UTILS_TEST_CHECK(RTI_RS_KafkaConnectionTest_is_invalid(
+            RTI_RS_KafkaConnection_parse_writer_properties(&writer, &not_bool),
+            PRODUCER_HEADERS_PROPERTY));
+
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    struct RTI_UTILS_UnitTest tests[] = {
+        { "notify_wakes_all_waiters",
+          RTI_RS_KafkaConnectionTest_notify_wakes_all_waiters },
+        { "timeout_removes_waiter",
+          RTI_RS_KafkaConnectionTest_timeout_removes_waiter },
+        { "reader_properties", RTI_RS_KafkaConnectionTest_reader_properties },
+        { "writer_properties", RTI_RS_KafkaConnectionTest_writer_properties }
+    };
+
+    return RTI_UTILS_UnitTest_run_all(
+            tests,
+            sizeof(tests) / sizeof(tests[0]));
+}
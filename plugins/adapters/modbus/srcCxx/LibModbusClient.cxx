@@ -70,6 +70,8 @@ void LibModbusClient::disconnect()
 
 void LibModbusClient::set_slave_id(uint8_t slave_id)
 {
+    std::lock_guard<std::mutex> guard(connection_mutex_);
+
     if (modbus_set_slave(modbus_connection(), slave_id) != 0) {
         std::string error(
                 "Error setting the slave ID <" + std::to_string(slave_id)
@@ -82,6 +84,8 @@ void LibModbusClient::set_slave_id(uint8_t slave_id)
 
 int LibModbusClient::get_slave_id()
 {
+    std::lock_guard<std::mutex> guard(connection_mutex_);
+
     int slave_id = modbus_get_slave(modbus_connection());
     if (slave_id == -1) {
         std::string error(
@@ -213,6 +217,8 @@ int LibModbusClient::read_coils(
 
 void LibModbusClient::set_response_timeout(uint32_t sec, uint32_t usec)
 {
+    std::lock_guard<std::mutex> guard(connection_mutex_);
+
     if (modbus_set_response_timeout(modbus_connection(), sec, usec) != 0) {
         std::string error(
                 "Error setting response timeout " + std::to_string(sec)
@@ -45,6 +45,9 @@ ModbusAdapterConfigurationElement::ModbusAdapterConfigurationElement()
           modbus_valid_values_(),
           data_factor_(1),
           data_offset_(0),
+          deadband_(0),
+          deadband_percentage_(0),
+          polling_period_msec_(-1),
           constant_kind_(ConstantValueKind::undefined_kind),
           value_string_(""),
           value_numeric_(0),
@@ -171,7 +174,7 @@ bool ModbusAdapterConfigurationElement::is_compatible_dds_datatype(
 
 std::string ModbusAdapterConfigurationElement::get_value_string(
         long double value,
-        TypeKind element_kind)
+        TypeKind element_kind) const
 {
     switch (element_kind.underlying()) {
     case TypeKind::CHAR_8_TYPE:
@@ -280,6 +283,21 @@ void ModbusAdapterConfigurationElement::check_for_errors(void)
         }
     }
 
+    // constant values never change, so the deadbands and the polling period
+    // are ignored
+    if (modbus_datatype() == ModbusDataType::constant_value
+            && (deadband() != 0 || deadband_percentage() != 0)) {
+        std::cerr << "Warning: The parameters deadband and "
+                "deadband_percentage of the field <" << field() << "> will "
+                "be ignored as it has a constant value set." << std::endl;
+    }
+    if (modbus_datatype() == ModbusDataType::constant_value
+            && polling_period_msec() != -1) {
+        std::cerr << "Warning: The parameter polling_period_msec of the "
+                "field <" << field() << "> will be ignored as it has a "
+                "constant value set." << std::endl;
+    }
+
     // Additionally, if this is a CONSTANT_VALUE the following parameters will
     // be ignored:
     //  - modbus_register_address
@@ -309,7 +327,7 @@ void ModbusAdapterConfigurationElement::check_for_errors(void)
 void ModbusAdapterConfigurationElement::check_correct_value(
         long double float_value,
         size_t index,
-        TypeKind element_kind)
+        TypeKind element_kind) const
 {
     // The value is not out of range
     if (float_value < modbus_min_value() || float_value > modbus_max_value()) {
@@ -347,7 +365,7 @@ void ModbusAdapterConfigurationElement::check_correct_value(
 void ModbusAdapterConfigurationElement::get_registers_value(
         std::vector<uint16_t>& output,
         const std::vector<long double>& float_vector,
-        TypeKind element_kind)
+        TypeKind element_kind) const
 {
     auto array_data = reinterpret_cast<uint16_t *>(output.data());
     for (int i = 0; i < float_vector.size(); ++i) {
@@ -424,8 +442,8 @@ void ModbusAdapterConfigurationElement::get_registers_value(
 }
 
 std::vector<long double> ModbusAdapterConfigurationElement::get_float_value(
-        const std::vector<uint16_t>& input,
-        TypeKind element_kind)
+        const uint16_t *input,
+        TypeKind element_kind) const
 {
     std::vector<long double> float_vector;
 
@@ -495,7 +513,7 @@ std::vector<long double> ModbusAdapterConfigurationElement::get_float_value(
                 int32_t value = 0;
                 LibModbusClient::int16_to_int32(
                         (uint32_t &) value,
-                        const_cast<uint16_t *>(input.data()) + i);
+                        const_cast<uint16_t *>(input) + i);
 
                 check_correct_value(
                         static_cast<long double>(
@@ -511,7 +529,7 @@ std::vector<long double> ModbusAdapterConfigurationElement::get_float_value(
                 uint32_t value = 0;
                 LibModbusClient::int16_to_int32(
                         value,
-                        const_cast<uint16_t *>(input.data()) + i);
+                        const_cast<uint16_t *>(input) + i);
 
                 check_correct_value(
                         static_cast<long double>(
@@ -532,7 +550,7 @@ std::vector<long double> ModbusAdapterConfigurationElement::get_float_value(
                 int64_t value = 0;
                 LibModbusClient::int16_to_int64(
                         (uint64_t &) value,
-                        const_cast<uint16_t *>(input.data()) + i);
+                        const_cast<uint16_t *>(input) + i);
 
                 // The int16_to_int64() function uses unsigned types, but this
                 // case is for signed numbers, therefore we need to cast it
@@ -551,7 +569,7 @@ std::vector<long double> ModbusAdapterConfigurationElement::get_float_value(
                 uint64_t value = 0;
                 LibModbusClient::int16_to_int64(
                         value,
-                        const_cast<uint16_t *>(input.data()) + i);
+                        const_cast<uint16_t *>(input) + i);
 
                 check_correct_value(
                         static_cast<long double>(
@@ -571,7 +589,7 @@ std::vector<long double> ModbusAdapterConfigurationElement::get_float_value(
             float value = 0;
             LibModbusClient::int16_to_float_abcd(
                     value,
-                    const_cast<uint16_t *>(input.data()) + i);
+                    const_cast<uint16_t *>(input) + i);
 
             check_correct_value(
                     static_cast<long double>(value),
@@ -587,7 +605,7 @@ std::vector<long double> ModbusAdapterConfigurationElement::get_float_value(
             float value = 0;
             LibModbusClient::int16_to_float_badc(
                     value,
-                    const_cast<uint16_t *>(input.data()) + i);
+                    const_cast<uint16_t *>(input) + i);
 
             check_correct_value(
                     static_cast<long double>(value),
@@ -603,7 +621,7 @@ std::vector<long double> ModbusAdapterConfigurationElement::get_float_value(
             float value = 0;
             LibModbusClient::int16_to_float_cdab(
                     value,
-                    const_cast<uint16_t *>(input.data()) + i);
+                    const_cast<uint16_t *>(input) + i);
 
             check_correct_value(
                     static_cast<long double>(value),
@@ -619,7 +637,7 @@ std::vector<long double> ModbusAdapterConfigurationElement::get_float_value(
             float value = 0;
             LibModbusClient::int16_to_float_dcba(
                     value,
-                    const_cast<uint16_t *>(input.data()) + i);
+                    const_cast<uint16_t *>(input) + i);
 
             check_correct_value(
                     static_cast<long double>(value),
@@ -642,6 +660,7 @@ std::vector<long double> ModbusAdapterConfigurationElement::get_float_value(
 }
 
 size_t ModbusAdapterConfigurationElement::number_of_registers_primitive_type()
+        const
 {
     size_t number_of_registers_type = 0;
 
@@ -1037,6 +1056,82 @@ void ModbusAdapterConfiguration::parse_json_config_string(
                                 "value of <input_data_offset>.");
                     }
                 }
+            } else if (element_name == "deadband") {
+                if (kind() == RoutingServiceEntityType::stream_writer) {
+                    std::string error(
+                            "Error in the JSON configuration. Unsupported "
+                            "tag <deadband> of the element <"
+                            + element_name + "> in a StreamWriter.");
+                    throw std::runtime_error(error);
+                } else if (kind() == RoutingServiceEntityType::stream_reader) {
+                    json_value *number_node =
+                            node_object->u.object.values[j].value;
+
+                    if (number_node->type == json_integer) {
+                        mace.deadband_ =
+                                (long double) number_node->u.integer;
+                    } else if (number_node->type == json_double) {
+                        mace.deadband_ = (long double) number_node->u.dbl;
+                    } else {
+                        throw std::runtime_error(
+                                "Error in the JSON configuration "
+                                "value of <deadband>.");
+                    }
+                    if (mace.deadband_ < 0) {
+                        throw std::runtime_error(
+                                "Error in the JSON configuration "
+                                "<deadband> cannot be negative.");
+                    }
+                }
+            } else if (element_name == "deadband_percentage") {
+                if (kind() == RoutingServiceEntityType::stream_writer) {
+                    std::string error(
+                            "Error in the JSON configuration. Unsupported "
+                            "tag <deadband_percentage> of the element <"
+                            + element_name + "> in a StreamWriter.");
+                    throw std::runtime_error(error);
+                } else if (kind() == RoutingServiceEntityType::stream_reader) {
+                    json_value *number_node =
+                            node_object->u.object.values[j].value;
+
+                    if (number_node->type == json_integer) {
+                        mace.deadband_percentage_ =
+                                (long double) number_node->u.integer;
+                    } else if (number_node->type == json_double) {
+                        mace.deadband_percentage_ =
+                                (long double) number_node->u.dbl;
+                    } else {
+                        throw std::runtime_error(
+                                "Error in the JSON configuration "
+                                "value of <deadband_percentage>.");
+                    }
+                    if (mace.deadband_percentage_ < 0) {
+                        throw std::runtime_error(
+                                "Error in the JSON configuration "
+                                "<deadband_percentage> cannot be negative.");
+                    }
+                }
+            } else if (element_name == "polling_period_msec") {
+                if (kind() == RoutingServiceEntityType::stream_writer) {
+                    std::string error(
+                            "Error in the JSON configuration. Unsupported "
+                            "tag <polling_period_msec> of the element <"
+                            + element_name + "> in a StreamWriter.");
+                    throw std::runtime_error(error);
+                } else if (kind() == RoutingServiceEntityType::stream_reader) {
+                    json_value *number_node =
+                            node_object->u.object.values[j].value;
+
+                    if (number_node->type != json_integer
+                            || number_node->u.integer < 1) {
+                        throw std::runtime_error(
+                                "Error in the JSON configuration "
+                                "value of <polling_period_msec>, it must be "
+                                "a positive integer.");
+                    }
+                    mace.polling_period_msec_ =
+                            static_cast<int>(number_node->u.integer);
+                }
             } else if (element_name == "value") {
                 json_value *value_node = node_object->u.object.values[j].value;
                 if (value_node->type == json_integer) {
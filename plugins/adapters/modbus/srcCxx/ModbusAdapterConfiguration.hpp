@@ -150,7 +150,7 @@ public:
      */
     std::string get_value_string(
             long double value,
-            dds::core::xtypes::TypeKind element_kind);
+            dds::core::xtypes::TypeKind element_kind) const;
     /**
      * @brief Check that the value read or that will be written to a modbus
      * device is correct and consistent with the configuration. Throws
@@ -164,7 +164,7 @@ public:
     void check_correct_value(
             long double float_value,
             size_t index,
-            dds::core::xtypes::TypeKind element_kind);
+            dds::core::xtypes::TypeKind element_kind) const;
 
     /**
      * @brief Translates the float_vector into an array of uint16_t (registers)
@@ -178,20 +178,21 @@ public:
     void get_registers_value(
             std::vector<uint16_t>& output,
             const std::vector<long double>& float_vector,
-            dds::core::xtypes::TypeKind element_kind);
+            dds::core::xtypes::TypeKind element_kind) const;
 
     /**
      * @brief Translates an array of uint16_t (registers) into an array of
      * long_double and applies the linear transformation defined by data_factor
      * and data_offset.
-     * @param input the uint16 array that has been read from a modbus device
+     * @param input the uint16 array that has been read from a modbus device.
+     * It must contain at least modbus_register_count() registers.
      * @param element_kind the kind of the DDS datatype
      * @return The long double vector which contains the corresponding values
      * translated from the modbus registers (uint16_t)
      */
     std::vector<long double> get_float_value(
-            const std::vector<uint16_t>& input,
-            dds::core::xtypes::TypeKind element_kind);
+            const uint16_t *input,
+            dds::core::xtypes::TypeKind element_kind) const;
 
     /**
      * @brief Check that the configuration provided is consistent or has any
@@ -226,7 +227,7 @@ public:
     {
         return modbus_min_value_;
     }
-    inline long double const modbus_max_value()
+    inline long double const modbus_max_value() const
     {
         return modbus_max_value_;
     }
@@ -242,6 +243,18 @@ public:
     {
         return data_offset_;
     }
+    inline long double const deadband() const
+    {
+        return deadband_;
+    }
+    inline long double const deadband_percentage() const
+    {
+        return deadband_percentage_;
+    }
+    inline int const polling_period_msec() const
+    {
+        return polling_period_msec_;
+    }
     inline std::string const value_string() const
     {
         return value_string_;
@@ -271,7 +284,7 @@ private:
      * depending on the configuration provided.
      */
 
-    size_t number_of_registers_primitive_type();
+    size_t number_of_registers_primitive_type() const;
     /**
      * @brief Calculates the number of elements that an array will contain. This
      * is different of the register_count when the type cannot be stored in a
@@ -309,6 +322,13 @@ private:
     std::vector<long double> modbus_valid_values_;
     float data_factor_;
     float data_offset_;
+    // min change of the value (absolute, and percentage of the last published
+    // value) to be published when the StreamReader publishes on change.
+    long double deadband_;
+    long double deadband_percentage_;
+    // period to read the element from modbus, -1 to use the polling period
+    // of the StreamReader
+    int polling_period_msec_;
     std::string value_string_;
     long double value_numeric_;
     std::vector<long double> value_array_;
@@ -15,11 +15,16 @@
 
 #pragma once
 
+#include <string>
 #include <vector>
 
 namespace rti { namespace adapter { namespace modbus {
 class ModbusClient {
 public:
+    virtual ~ModbusClient()
+    {
+    }
+
     /**
      * @brief Connect to a modbus device.
      * @param ip of the modbus device.
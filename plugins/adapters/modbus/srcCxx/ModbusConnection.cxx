@@ -33,20 +33,41 @@ ModbusConnection::ModbusConnection(const PropertySet& properties)
         port_number_ = std::stoi(properties.at("modbus_server_port"));
     }
 
-    mbw_ = new LibModbusClient(ip_address_, port_number_);
+    size_t max_connections = ModbusConnectionPool::DEFAULT_MAX_CONNECTIONS;
+    if (properties.find("modbus_max_connections") != properties.end()) {
+        max_connections = std::stoi(properties.at("modbus_max_connections"));
+    }
+    size_t max_in_flight = ModbusConnectionPool::DEFAULT_MAX_IN_FLIGHT;
+    if (properties.find("modbus_max_requests_in_flight")
+            != properties.end()) {
+        max_in_flight =
+                std::stoi(properties.at("modbus_max_requests_in_flight"));
+    }
 
+    int response_timeout_msec = -1;
     if (properties.find("modbus_response_timeout_msec") != properties.end()) {
-        uint32_t msec = std::stoi(properties.at("modbus_response_timeout_msec"));
-        uint32_t sec = static_cast<uint32_t>(msec / 1000);
-        uint32_t usec = (msec - sec * 1000) * 1000;
-
-        mbw_->set_response_timeout(sec, usec);
+        response_timeout_msec =
+                std::stoi(properties.at("modbus_response_timeout_msec"));
     }
+
+    // the connections are shared with other Routing Service connections to
+    // the same modbus server with the same response timeout
+    connection_pool_ = ModbusConnectionPool::get(
+            ip_address_,
+            port_number_,
+            max_connections,
+            max_in_flight,
+            response_timeout_msec);
+
+    // the inputs are polled with as many threads as requests the pool may
+    // have in flight, so that the slaves are read concurrently
+    polling_scheduler_.reset(new ModbusPollingScheduler(
+            connection_pool_->max_connections()
+            * connection_pool_->max_in_flight()));
 }
 
 ModbusConnection::~ModbusConnection()
 {
-    delete mbw_;
 }
 
 StreamReader* ModbusConnection::create_stream_reader(
@@ -55,7 +76,12 @@ StreamReader* ModbusConnection::create_stream_reader(
         const PropertySet& properties,
         StreamReaderListener* listener)
 {
-    return new ModbusStreamReader(properties, info, listener, *mbw_);
+    return new ModbusStreamReader(
+            properties,
+            info,
+            listener,
+            *connection_pool_,
+            *polling_scheduler_);
 };
 
 void ModbusConnection::delete_stream_reader(StreamReader* reader)
@@ -68,7 +94,7 @@ StreamWriter* ModbusConnection::create_stream_writer(
         const StreamInfo& info,
         const PropertySet& properties)
 {
-    return new ModbusStreamWriter(properties, info, *mbw_);
+    return new ModbusStreamWriter(properties, info, *connection_pool_);
 };
 
 void ModbusConnection::delete_stream_writer(StreamWriter* writer)
@@ -22,6 +22,8 @@
 
 #include "ModbusClient.hpp"
 #include "LibModbusClient.hpp"
+#include "ModbusConnectionPool.hpp"
+#include "ModbusPollingScheduler.hpp"
 #include "ModbusStreamWriter.hpp"
 
 namespace rti { namespace adapter { namespace modbus {
@@ -55,7 +57,9 @@ public:
 private:
     std::string ip_address_ = "";
     uint16_t port_number_ = 0;
-    LibModbusClient *mbw_;
+    std::shared_ptr<ModbusConnectionPool> connection_pool_;
+    // polls the elements of all the StreamReaders of this connection
+    std::unique_ptr<ModbusPollingScheduler> polling_scheduler_;
 };
 
 }}}  // namespace rti::adapter::modbus
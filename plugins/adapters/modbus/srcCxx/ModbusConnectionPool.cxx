@@ -0,0 +1,266 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#include <iostream>
+#include <map>
+
+#include "ModbusConnectionPool.hpp"
+
+using namespace rti::adapter::modbus;
+
+std::shared_ptr<ModbusConnectionPool> ModbusConnectionPool::get(
+        const std::string& ip,
+        uint16_t port,
+        size_t max_connections,
+        size_t max_in_flight,
+        int response_timeout_msec)
+{
+    // pools are identified by the IP and port of the modbus server, and the
+    // response timeout of their connections
+    static std::map<std::string, std::weak_ptr<ModbusConnectionPool>> pools;
+    static std::mutex pools_mutex;
+
+    std::string server(ip + ":" + std::to_string(port));
+    std::string key(server);
+    if (response_timeout_msec >= 0) {
+        key += "/" + std::to_string(response_timeout_msec);
+    }
+    std::lock_guard<std::mutex> guard(pools_mutex);
+
+    std::shared_ptr<ModbusConnectionPool> pool = pools[key].lock();
+    if (pool) {
+        pool->reserve(max_connections);
+        if (pool->max_in_flight() != max_in_flight) {
+            std::cerr << "Warning: The max number of requests in flight to "
+                    "Modbus server <" << server << "> is already "
+                    << pool->max_in_flight() << ", " << max_in_flight
+                    << " will be ignored." << std::endl;
+        }
+    } else {
+        pool = std::make_shared<ModbusConnectionPool>(
+                ip,
+                port,
+                max_connections,
+                max_in_flight);
+        if (response_timeout_msec >= 0) {
+            uint32_t sec = static_cast<uint32_t>(response_timeout_msec / 1000);
+            uint32_t usec = (response_timeout_msec - sec * 1000) * 1000;
+            pool->set_response_timeout(sec, usec);
+        }
+        pools[key] = pool;
+    }
+    return pool;
+}
+
+ModbusConnectionPool::ModbusConnectionPool(
+        const std::string& ip,
+        uint16_t port,
+        size_t max_connections,
+        size_t max_in_flight)
+        : ip_address_(ip),
+          port_number_(port),
+          max_connections_(max_connections),
+          max_in_flight_(max_in_flight)
+{
+    if (max_connections_ < 1) {
+        std::string error(
+                "Error: the max number of connections to Modbus server <"
+                + ip + ":" + std::to_string(port) + "> must be at least 1.");
+        throw std::runtime_error(error);
+    }
+    if (max_in_flight_ < 1) {
+        std::string error(
+                "Error: the max number of requests in flight to Modbus "
+                "server <" + ip + ":" + std::to_string(port)
+                + "> must be at least 1.");
+        throw std::runtime_error(error);
+    }
+
+    std::shared_ptr<ModbusTcpPipeline> pipeline;
+    auto client = open_connection(pipeline);
+    idle_clients_.push_back(add_connection(std::move(client), pipeline));
+}
+
+void ModbusConnectionPool::reserve(size_t max_connections)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (max_connections > max_connections_) {
+        max_connections_ = max_connections;
+    }
+}
+
+void ModbusConnectionPool::set_response_timeout(uint32_t sec, uint32_t usec)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+
+    has_response_timeout_ = true;
+    response_timeout_sec_ = sec;
+    response_timeout_usec_ = usec;
+    // only the idle clients can be modified here, the ones in use get
+    // it when they are released
+    for (auto client : idle_clients_) {
+        client->set_response_timeout(sec, usec);
+    }
+}
+
+std::unique_ptr<ModbusClient> ModbusConnectionPool::open_connection(
+        std::shared_ptr<ModbusTcpPipeline>& pipeline)
+{
+    if (max_in_flight_ == 1) {
+        return std::unique_ptr<ModbusClient>(
+                new LibModbusClient(ip_address_, port_number_));
+    }
+    pipeline = std::make_shared<ModbusTcpPipeline>(
+            ip_address_,
+            port_number_,
+            max_in_flight_);
+    return std::unique_ptr<ModbusClient>(
+            new ModbusTcpPipelinedClient(pipeline));
+}
+
+ModbusClient *ModbusConnectionPool::add_connection(
+        std::unique_ptr<ModbusClient> client,
+        std::shared_ptr<ModbusTcpPipeline> pipeline)
+{
+    ++connections_;
+    if (pipeline) {
+        last_pipeline_ = pipeline;
+        last_pipeline_clients_ = 1;
+    }
+    if (has_response_timeout_) {
+        client->set_response_timeout(
+                response_timeout_sec_,
+                response_timeout_usec_);
+    }
+    clients_.push_back(std::move(client));
+    return clients_.back().get();
+}
+
+ModbusClient *ModbusConnectionPool::acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (idle_clients_.empty()) {
+        if (last_pipeline_ && last_pipeline_clients_ < max_in_flight_) {
+            // another request fits in the last connection, no need to
+            // open a new one
+            std::unique_ptr<ModbusClient> client(
+                    new ModbusTcpPipelinedClient(last_pipeline_));
+            ++last_pipeline_clients_;
+            if (has_response_timeout_) {
+                client->set_response_timeout(
+                        response_timeout_sec_,
+                        response_timeout_usec_);
+            }
+            clients_.push_back(std::move(client));
+            return clients_.back().get();
+        }
+        if (connections_ + opening_connections_ < max_connections_) {
+            // open a new connection without holding the lock, as it may
+            // take a while to connect to the server
+            std::shared_ptr<ModbusTcpPipeline> pipeline;
+            std::unique_ptr<ModbusClient> client;
+            ++opening_connections_;
+            lock.unlock();
+            try {
+                client = open_connection(pipeline);
+            } catch (...) {
+                lock.lock();
+                --opening_connections_;
+                throw;
+            }
+            lock.lock();
+            --opening_connections_;
+            return add_connection(std::move(client), pipeline);
+        }
+        idle_condition_.wait(lock);
+    }
+
+    ModbusClient *client = idle_clients_.back();
+    idle_clients_.pop_back();
+    return client;
+}
+
+void ModbusConnectionPool::release(ModbusClient *client)
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (has_response_timeout_) {
+            try {
+                client->set_response_timeout(
+                        response_timeout_sec_,
+                        response_timeout_usec_);
+            } catch (const std::exception &ex) {
+                std::cerr << ex.what() << std::endl;
+            }
+        }
+        idle_clients_.push_back(client);
+    }
+    idle_condition_.notify_one();
+}
+
+int ModbusConnectionPool::read_registers(
+        uint8_t slave_id,
+        std::vector<uint16_t>& registers,
+        uint32_t address,
+        uint32_t register_count,
+        bool read_input_registers)
+{
+    return transaction(slave_id, [&](ModbusClient& client) {
+        return client.read_registers(
+                registers,
+                address,
+                register_count,
+                read_input_registers);
+    });
+}
+
+int ModbusConnectionPool::read_coils(
+        uint8_t slave_id,
+        std::vector<uint8_t>& values,
+        uint32_t address,
+        uint32_t register_count,
+        bool read_discrete_inputs)
+{
+    return transaction(slave_id, [&](ModbusClient& client) {
+        return client.read_coils(
+                values,
+                address,
+                register_count,
+                read_discrete_inputs);
+    });
+}
+
+int ModbusConnectionPool::write_registers(
+        uint8_t slave_id,
+        uint32_t address,
+        uint32_t register_count,
+        const std::vector<uint16_t>& registers)
+{
+    return transaction(slave_id, [&](ModbusClient& client) {
+        return client.write_registers(address, register_count, registers);
+    });
+}
+
+int ModbusConnectionPool::write_coils(
+        uint8_t slave_id,
+        uint32_t address,
+        uint32_t register_count,
+        const std::vector<uint8_t>& values)
+{
+    return transaction(slave_id, [&](ModbusClient& client) {
+        return client.write_coils(address, register_count, values);
+    });
+}
@@ -0,0 +1,231 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "LibModbusClient.hpp"
+#include "ModbusTcpPipelinedClient.hpp"
+
+namespace rti { namespace adapter { namespace modbus {
+
+/**
+ * @class ModbusConnectionPool
+ *
+ * @brief Set of connections to the same modbus server (IP and port).
+ *
+ * Every operation is a transaction that sets the slave ID and reads/writes
+ * the registers/coils while holding one of the clients exclusively, so
+ * operations of different StreamReaders/StreamWriters never interleave on
+ * the same client and may run concurrently on different ones.
+ * Connections are opened on demand, up to max_connections().
+ *
+ * If max_in_flight() is 1, every client is a LibModbusClient with its own
+ * connection. Otherwise, every connection is a ModbusTcpPipeline shared by
+ * up to max_in_flight() ModbusTcpPipelinedClients, so that many requests
+ * are in flight at the same time on each connection.
+ */
+class ModbusConnectionPool {
+public:
+    static const size_t DEFAULT_MAX_CONNECTIONS = 1;
+    static const size_t DEFAULT_MAX_IN_FLIGHT = 1;
+
+    /**
+     * @brief Gets the pool of the connections to a modbus server, creating it
+     * if it doesn't exist. Pools are shared by all the Routing Service
+     * connections to the same server with the same response timeout, and are
+     * deleted when none of them use it.
+     * @param ip IP of the modbus server
+     * @param port port of the modbus server
+     * @param max_connections max number of connections that the pool may
+     * open. If the pool already exists, it is increased to this value.
+     * @param max_in_flight max number of requests in flight per connection.
+     * It cannot be changed once the pool exists.
+     * @param response_timeout_msec response timeout of the connections of
+     * the pool, or -1 to use the default one of the modbus client. Routing
+     * Service connections with different response timeouts use different
+     * pools, so they don't override each other's timeout.
+     */
+    static std::shared_ptr<ModbusConnectionPool> get(
+            const std::string& ip,
+            uint16_t port,
+            size_t max_connections,
+            size_t max_in_flight,
+            int response_timeout_msec);
+
+    /**
+     * @brief Parametrized constructor
+     * @details constructor that opens the first connection to the modbus
+     * server, so connection errors are reported when the pool is created.
+     */
+    ModbusConnectionPool(
+            const std::string& ip,
+            uint16_t port,
+            size_t max_connections,
+            size_t max_in_flight);
+
+    /**
+     * @brief Increases the number of connections that the pool may open
+     * @param max_connections the new max number of connections. It is
+     * ignored if it is not greater than the current one.
+     */
+    void reserve(size_t max_connections);
+
+    /**
+     * @brief Sets the response timeout of all the connections of the pool,
+     * including the ones that have not been opened yet. The pool may be
+     * shared, use get() to have a pool with a given response timeout.
+     * @param sec Seconds of the response timout.
+     * @param usec Microseconds of the response timout.
+     */
+    void set_response_timeout(uint32_t sec, uint32_t usec);
+
+    /**
+     * @brief Reads 1 or more registers from a slave of the modbus server.
+     * @see ModbusClient::read_registers
+     */
+    int read_registers(
+            uint8_t slave_id,
+            std::vector<uint16_t>& registers,
+            uint32_t address,
+            uint32_t register_count,
+            bool read_input_registers);
+
+    /**
+     * @brief Reads 1 or more coils from a slave of the modbus server.
+     * @see ModbusClient::read_coils
+     */
+    int read_coils(
+            uint8_t slave_id,
+            std::vector<uint8_t>& values,
+            uint32_t address,
+            uint32_t register_count,
+            bool read_discrete_inputs);
+
+    /**
+     * @brief Writes 1 or more registers to a slave of the modbus server.
+     * @see ModbusClient::write_registers
+     */
+    int write_registers(
+            uint8_t slave_id,
+            uint32_t address,
+            uint32_t register_count,
+            const std::vector<uint16_t>& registers);
+
+    /**
+     * @brief Writes 1 or more coils to a slave of the modbus server.
+     * @see ModbusClient::write_coils
+     */
+    int write_coils(
+            uint8_t slave_id,
+            uint32_t address,
+            uint32_t register_count,
+            const std::vector<uint8_t>& values);
+
+    // public getters
+    inline size_t max_connections()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return max_connections_;
+    }
+    inline size_t const max_in_flight() const
+    {
+        return max_in_flight_;
+    }
+
+private:
+    /**
+     * @brief Opens a new connection to the modbus server
+     * @param [out] pipeline the new connection if requests are pipelined
+     * @return The first client of the new connection
+     */
+    std::unique_ptr<ModbusClient> open_connection(
+            std::shared_ptr<ModbusTcpPipeline>& pipeline);
+
+    /**
+     * @brief Adds a client created with open_connection() to the pool
+     * @param client the client to add
+     * @param pipeline the connection of the client if requests are pipelined
+     */
+    ModbusClient *add_connection(
+            std::unique_ptr<ModbusClient> client,
+            std::shared_ptr<ModbusTcpPipeline> pipeline);
+
+    /**
+     * @brief Gets a client that is not being used. If all of them are being
+     * used, a new one is created if the last connection still has room for
+     * more requests in flight, or a new connection is opened if the pool is
+     * not full. Otherwise, it waits until one of them is released.
+     */
+    ModbusClient *acquire();
+
+    /**
+     * @brief Gives back a client obtained with acquire() to the pool
+     */
+    void release(ModbusClient *client);
+
+    /**
+     * @brief Runs function(client) with a connection that is only used by
+     * this transaction, after setting the slave ID on it.
+     */
+    template <typename Function>
+    int transaction(uint8_t slave_id, Function function)
+    {
+        ModbusClient *client = acquire();
+        int result = 0;
+
+        try {
+            // Sets the slave ID before the operation, only when the slave ID
+            // is different from the previous one of this connection.
+            if (client->get_slave_id() != slave_id) {
+                client->set_slave_id(slave_id);
+            }
+            result = function(*client);
+        } catch (...) {
+            release(client);
+            throw;
+        }
+        release(client);
+        return result;
+    }
+
+private:
+    std::string ip_address_;
+    uint16_t port_number_;
+    std::vector<std::unique_ptr<ModbusClient>> clients_;
+    std::vector<ModbusClient *> idle_clients_;
+    // connections opened, and being opened, which are counted as part of
+    // the pool
+    size_t connections_ = 0;
+    size_t opening_connections_ = 0;
+    size_t max_connections_;
+    size_t max_in_flight_;
+    // the last connection opened when requests are pipelined, and the number
+    // of clients that use it
+    std::shared_ptr<ModbusTcpPipeline> last_pipeline_;
+    size_t last_pipeline_clients_ = 0;
+    bool has_response_timeout_ = false;
+    uint32_t response_timeout_sec_ = 0;
+    uint32_t response_timeout_usec_ = 0;
+    std::mutex mutex_;
+    std::condition_variable idle_condition_;
+};
+
+}}}  // namespace rti::adapter::modbus
@@ -0,0 +1,125 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#include "UtilsStrings.hpp"
+#include "ModbusFieldPlan.hpp"
+
+using namespace dds::core::xtypes;
+
+using namespace rti::adapter::modbus;
+
+/*
+ * Gets the member index of every level of a (possibly nested) field name.
+ * The nested structs have to be loaned in order to get the index of their
+ * members, so this is done recursively.
+ */
+static void resolve_member_path(
+        DynamicData& data,
+        const std::vector<std::string>& member_names,
+        size_t depth,
+        std::vector<uint32_t>& member_path)
+{
+    member_path.push_back(data.member_index(member_names[depth]));
+    if (depth + 1 == member_names.size()) {
+        return;
+    }
+    auto loaned_member = data.loan_value(member_path.back());
+    resolve_member_path(
+            loaned_member.get(),
+            member_names,
+            depth + 1,
+            member_path);
+}
+
+ModbusFieldPlan::ModbusFieldPlan(
+        const ModbusAdapterConfiguration& config,
+        const StructType& dds_type)
+{
+    DynamicData sample(dds_type);
+
+    for (auto& mace : config.config()) {
+        ModbusFieldPlanEntry entry;
+        std::vector<std::string> member_names =
+                rti::utils::strings::split(mace.field(), '.');
+        const StructType *struct_type = &dds_type;
+        const DynamicType *member_type = nullptr;
+
+        entry.element = &mace;
+        entry.is_optional = false;
+        entry.is_collection = false;
+        entry.string_bounds = 0;
+
+        // get the type of the field, and whether it is optional in the
+        // struct that contains it
+        for (size_t i = 0; i < member_names.size(); ++i) {
+            if (member_type != nullptr) {
+                if (member_type->kind() != TypeKind::STRUCTURE_TYPE) {
+                    std::string error(
+                            "Error: nested member <" + mace.field()
+                            + "> only can belong to structs.");
+                    throw std::runtime_error(error);
+                }
+                struct_type = static_cast<const StructType *>(member_type);
+            }
+            auto& member = struct_type->member(member_names[i]);
+            member_type = &member.type();
+            entry.is_optional = member.is_optional();
+        }
+
+        entry.member_kind = member_type->kind();
+        entry.element_kind = entry.member_kind;
+        if (entry.member_kind == TypeKind::ARRAY_TYPE) {
+            const ArrayType &array_type =
+                    static_cast<const ArrayType &>(*member_type);
+            entry.element_kind = array_type.content_type().kind();
+            entry.is_collection = true;
+        } else if (entry.member_kind == TypeKind::SEQUENCE_TYPE) {
+            const SequenceType &sequence_type =
+                    static_cast<const SequenceType &>(*member_type);
+            entry.element_kind = sequence_type.content_type().kind();
+            entry.is_collection = true;
+        } else if (entry.member_kind == TypeKind::STRING_TYPE) {
+            const StringType &string_type =
+                    static_cast<const StringType &>(*member_type);
+            entry.string_bounds = string_type.bounds();
+        }
+
+        resolve_member_path(sample, member_names, 0, entry.member_path);
+
+        entries_.push_back(entry);
+    }
+}
+
+bool ModbusFieldPlan::member_exists(
+        DynamicData& data,
+        const ModbusFieldPlanEntry& entry)
+{
+    return member_exists(data, entry.member_path, 0);
+}
+
+bool ModbusFieldPlan::member_exists(
+        DynamicData& data,
+        const std::vector<uint32_t>& member_path,
+        size_t depth)
+{
+    if (!data.member_exists(member_path[depth])) {
+        return false;
+    }
+    if (depth + 1 == member_path.size()) {
+        return true;
+    }
+    auto loaned_member = data.loan_value(member_path[depth]);
+    return member_exists(loaned_member.get(), member_path, depth + 1);
+}
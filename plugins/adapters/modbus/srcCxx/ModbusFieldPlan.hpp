@@ -0,0 +1,134 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include <dds/dds.hpp>
+
+#include "ModbusAdapterConfiguration.hpp"
+
+namespace rti { namespace adapter { namespace modbus {
+
+/**
+ * @struct ModbusFieldPlanEntry
+ *
+ * @brief Everything needed to copy the values of a configuration element
+ * from/to its DynamicData field, resolved from the DDS type beforehand.
+ */
+struct ModbusFieldPlanEntry {
+    // the configuration element, owned by the ModbusAdapterConfiguration
+    const ModbusAdapterConfigurationElement *element;
+    // member indexes of the field and of the structs that contain it, from
+    // the outermost struct. A nested field "a.b" has two indexes.
+    std::vector<uint32_t> member_path;
+    // kind of the field, and of its elements if it is an array/sequence
+    dds::core::xtypes::TypeKind member_kind;
+    dds::core::xtypes::TypeKind element_kind;
+    // whether the field is an array or a sequence
+    bool is_collection;
+    // whether the field is optional in its struct
+    bool is_optional;
+    // max length of the field if it is a string, 0 otherwise
+    uint32_t string_bounds;
+};
+
+/**
+ * @class ModbusFieldPlan
+ *
+ * @brief Compiled form of a ModbusAdapterConfiguration for a specific DDS
+ * type. It contains one ModbusFieldPlanEntry for every element of the
+ * configuration, in the same order, so the fields can be accessed by member
+ * index instead of looking them up by name for every sample.
+ */
+class ModbusFieldPlan {
+public:
+    ModbusFieldPlan()
+    {
+    }
+
+    /**
+     * @brief Resolves the fields of all the elements of a configuration. The
+     * configuration must have been checked against the same type with
+     * check_configuration_consistency().
+     * @param config the configuration to compile
+     * @param dds_type the type that will be writing or reading data
+     * to/from DDS.
+     */
+    ModbusFieldPlan(
+            const ModbusAdapterConfiguration& config,
+            const dds::core::xtypes::StructType& dds_type);
+
+    /**
+     * @brief Calls a function with the DynamicData that directly contains
+     * the field of an entry, and with the member index of the field in it.
+     * The structs that contain a nested field are loaned, and are created
+     * if they are optional and unset.
+     * @param data the sample that contains the field
+     * @param entry the entry of the field
+     * @param function the function that is called as function(parent, index)
+     */
+    template <typename Function>
+    static void with_member(
+            dds::core::xtypes::DynamicData& data,
+            const ModbusFieldPlanEntry& entry,
+            Function function)
+    {
+        with_member(data, entry.member_path, 0, function);
+    }
+
+    /**
+     * @brief Checks whether the field of an entry is set in a sample. This is
+     * false if the field, or any of the structs that contain it, is an
+     * optional member that is not set.
+     * @param data the sample that contains the field
+     * @param entry the entry of the field
+     */
+    static bool member_exists(
+            dds::core::xtypes::DynamicData& data,
+            const ModbusFieldPlanEntry& entry);
+
+    // public getters
+    inline std::vector<ModbusFieldPlanEntry> const &entries() const
+    {
+        return entries_;
+    }
+
+private:
+    template <typename Function>
+    static void with_member(
+            dds::core::xtypes::DynamicData& data,
+            const std::vector<uint32_t>& member_path,
+            size_t depth,
+            Function function)
+    {
+        if (depth + 1 == member_path.size()) {
+            function(data, member_path[depth]);
+            return;
+        }
+        auto loaned_member = data.loan_value(member_path[depth]);
+        with_member(loaned_member.get(), member_path, depth + 1, function);
+    }
+
+    static bool member_exists(
+            dds::core::xtypes::DynamicData& data,
+            const std::vector<uint32_t>& member_path,
+            size_t depth);
+
+    std::vector<ModbusFieldPlanEntry> entries_;
+};
+
+}}}  // namespace rti::adapter::modbus
@@ -0,0 +1,219 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#include <algorithm>
+#include <iostream>
+
+#include "ModbusPollingScheduler.hpp"
+
+using namespace rti::adapter::modbus;
+
+ModbusPollingScheduler::ModbusPollingScheduler(size_t thread_count)
+{
+    if (thread_count < 1) {
+        thread_count = 1;
+    }
+    try {
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads_.push_back(
+                    std::thread(&ModbusPollingScheduler::run, this));
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stop_threads_ = true;
+        }
+        deadlines_condition_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+        throw;
+    }
+}
+
+ModbusPollingScheduler::~ModbusPollingScheduler()
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        stop_threads_ = true;
+    }
+    deadlines_condition_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+ModbusPollingScheduler::TaskId ModbusPollingScheduler::schedule(
+        std::chrono::milliseconds period,
+        std::function<void()> task)
+{
+    TaskId task_id = 0;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        task_id = next_task_id_++;
+        tasks_[task_id] = Task { period, task };
+        deadlines_.push(Deadline { std::chrono::steady_clock::now(), task_id });
+    }
+    deadlines_condition_.notify_all();
+    return task_id;
+}
+
+void ModbusPollingScheduler::cancel(TaskId task_id)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    tasks_.erase(task_id);
+    while (true) {
+        auto running_task = running_tasks_.find(task_id);
+        if (running_task == running_tasks_.end()) {
+            return;
+        }
+        if (running_task->second == std::this_thread::get_id()) {
+            // the task is cancelling itself, waiting for it to finish would
+            // never return. It is not called again as it has been erased.
+            return;
+        }
+        running_condition_.wait(lock);
+    }
+}
+
+void ModbusPollingScheduler::run_concurrently(
+        size_t count,
+        const std::function<void(size_t)>& function)
+{
+    auto job = std::make_shared<ConcurrentJob>();
+    job->count = count;
+    job->function = &function;
+    job->next = 0;
+    job->finished = 0;
+
+    // the first call is made by this thread, the rest of them may be
+    // taken by the idle threads
+    size_t helpers = std::min(count > 0 ? count - 1 : 0, threads_.size());
+    if (helpers > 0) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            for (size_t i = 0; i < helpers; ++i) {
+                jobs_.push_back(job);
+            }
+        }
+        deadlines_condition_.notify_all();
+    }
+
+    run_job(*job);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (job->finished < job->count) {
+        jobs_condition_.wait(lock);
+    }
+    // the threads that haven't taken the job yet don't need to
+    jobs_.erase(
+            std::remove(jobs_.begin(), jobs_.end(), job),
+            jobs_.end());
+}
+
+void ModbusPollingScheduler::run_job(ConcurrentJob& job)
+{
+    size_t finished = 0;
+
+    for (size_t i = job.next++; i < job.count; i = job.next++) {
+        try {
+            (*job.function)(i);
+        } catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+        }
+        ++finished;
+    }
+
+    if (finished > 0) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        job.finished += finished;
+        if (job.finished == job.count) {
+            jobs_condition_.notify_all();
+        }
+    }
+}
+
+void ModbusPollingScheduler::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stop_threads_) {
+        if (!jobs_.empty()) {
+            std::shared_ptr<ConcurrentJob> job = jobs_.front();
+            jobs_.pop_front();
+            lock.unlock();
+            run_job(*job);
+            lock.lock();
+            continue;
+        }
+        if (deadlines_.empty()) {
+            deadlines_condition_.wait(lock);
+            continue;
+        }
+
+        Deadline deadline = deadlines_.top();
+        auto task = tasks_.find(deadline.task_id);
+        if (task == tasks_.end()) {
+            // the task has been cancelled
+            deadlines_.pop();
+            continue;
+        }
+        if (std::chrono::steady_clock::now() < deadline.time) {
+            // wake up earlier if a new task is scheduled, another thread
+            // takes this deadline or the scheduler is stopped
+            deadlines_condition_.wait_until(lock, deadline.time);
+            continue;
+        }
+        deadlines_.pop();
+
+        std::chrono::milliseconds period = task->second.period;
+        std::function<void()> function = task->second.function;
+        running_tasks_[deadline.task_id] = std::this_thread::get_id();
+        // the next deadline may be due already, let another thread run it
+        deadlines_condition_.notify_one();
+
+        // the task runs without holding the lock, so tasks may be scheduled
+        // or cancelled meanwhile
+        lock.unlock();
+        try {
+            function();
+        } catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+        }
+        lock.lock();
+
+        running_tasks_.erase(deadline.task_id);
+        running_condition_.notify_all();
+        if (tasks_.find(deadline.task_id) == tasks_.end()) {
+            continue;
+        }
+
+        // the next deadline is based on the previous one and not on the
+        // current time, so the time spent in the task doesn't add up
+        auto now = std::chrono::steady_clock::now();
+        deadline.time += period;
+        if (period.count() <= 0) {
+            deadline.time = now;
+        } else if (deadline.time <= now) {
+            deadline.time += period * ((now - deadline.time) / period + 1);
+        }
+        deadlines_.push(deadline);
+        // the other threads may be waiting for a later deadline
+        deadlines_condition_.notify_all();
+    }
+}
@@ -0,0 +1,164 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace rti { namespace adapter { namespace modbus {
+
+/**
+ * @class ModbusPollingScheduler
+ *
+ * @brief Runs periodic tasks on a set of threads, shared by all the
+ * StreamReaders of a ModbusConnection.
+ *
+ * Every task has an absolute deadline that is increased by its period each
+ * time it runs, so the time spent in the task (e.g. modbus I/O) doesn't delay
+ * the following runs. If a task runs for longer than its period, the missed
+ * runs are skipped instead of running them in a burst.
+ *
+ * The tasks that are due run concurrently on the threads of the scheduler,
+ * which are as many as the requests that the ModbusConnectionPool may have
+ * in flight, so a slow slave doesn't delay the tasks of the other ones. A
+ * task never runs concurrently with itself.
+ */
+class ModbusPollingScheduler {
+public:
+    typedef uint64_t TaskId;
+
+    /**
+     * @brief Parametrized constructor
+     * @param thread_count number of threads that run the tasks. It is at
+     * least 1.
+     */
+    explicit ModbusPollingScheduler(size_t thread_count);
+
+    /**
+     * @brief Stops the threads of the scheduler. All the tasks must have been
+     * cancelled before.
+     */
+    ~ModbusPollingScheduler();
+
+    /**
+     * @brief Adds a periodic task. It runs for the first time as soon as
+     * possible.
+     * @param period the period of the task
+     * @param task the function that is called every period
+     * @return The identifier of the task, used to cancel it
+     *
+     * @see cancel
+     */
+    TaskId schedule(
+            std::chrono::milliseconds period,
+            std::function<void()> task);
+
+    /**
+     * @brief Removes a task. If the task is running, this waits until it
+     * finishes, so the task is never called after this returns.
+     * A task may cancel itself (or be cancelled from a function that it
+     * calls). In that case this doesn't wait, and the task is not called
+     * again once it returns.
+     * @param task_id the identifier returned by schedule()
+     *
+     * @see schedule
+     */
+    void cancel(TaskId task_id);
+
+    /**
+     * @brief Calls function(i) for every i in [0, count). The calls are
+     * spread over the calling thread and the threads of the scheduler that
+     * are idle, so they may run concurrently. It returns once all of them
+     * have finished.
+     * It may be called from a task, the calling thread always takes part
+     * in the calls, so it doesn't depend on other threads being idle.
+     * @param count number of calls
+     * @param function the function to call
+     */
+    void run_concurrently(
+            size_t count,
+            const std::function<void(size_t)>& function);
+
+private:
+    struct Task {
+        std::chrono::milliseconds period;
+        std::function<void()> function;
+    };
+
+    struct Deadline {
+        std::chrono::steady_clock::time_point time;
+        TaskId task_id;
+
+        // std::priority_queue puts the greatest element on top
+        bool operator<(const Deadline& other) const
+        {
+            return time > other.time;
+        }
+    };
+
+    // Calls of a run_concurrently() in progress
+    struct ConcurrentJob {
+        size_t count;
+        // only called while there are calls left, so it doesn't outlive
+        // run_concurrently()
+        const std::function<void(size_t)> *function;
+        // index of the next call
+        std::atomic<size_t> next;
+        // calls that have finished, protected by mutex_
+        size_t finished;
+    };
+
+    /**
+     * @brief Makes calls of a job until all of them have been taken
+     * @param job the job to run
+     */
+    void run_job(ConcurrentJob& job);
+
+    /**
+     * @brief Function executed by every thread of the scheduler. It waits for
+     * the earliest deadline and runs its task. Jobs of run_concurrently() run
+     * before any task.
+     */
+    void run();
+
+private:
+    std::map<TaskId, Task> tasks_;
+    // deadlines of cancelled tasks are discarded when they reach the top.
+    // The deadline of a running task is pushed again when it finishes.
+    std::priority_queue<Deadline> deadlines_;
+    TaskId next_task_id_ = 1;
+    // tasks that are running, and the thread that runs each of them
+    std::map<TaskId, std::thread::id> running_tasks_;
+    // jobs that the idle threads may help with, once per idle thread
+    std::deque<std::shared_ptr<ConcurrentJob>> jobs_;
+    bool stop_threads_ = false;
+    std::mutex mutex_;
+    std::condition_variable deadlines_condition_;
+    std::condition_variable running_condition_;
+    std::condition_variable jobs_condition_;
+    std::vector<std::thread> threads_;
+};
+
+}}}  // namespace rti::adapter::modbus
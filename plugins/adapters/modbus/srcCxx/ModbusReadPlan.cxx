@@ -0,0 +1,127 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#include <algorithm>
+
+#include "ModbusReadPlan.hpp"
+
+using namespace rti::adapter::modbus;
+
+ModbusReadPlan::ModbusReadPlan(const ModbusAdapterConfiguration& config)
+{
+    std::vector<size_t> elements;
+
+    for (size_t i = 0; i < config.config().size(); ++i) {
+        elements.push_back(i);
+    }
+    *this = ModbusReadPlan(config, elements);
+}
+
+ModbusReadPlan::ModbusReadPlan(
+        const ModbusAdapterConfiguration& config,
+        const std::vector<size_t>& elements)
+{
+    std::vector<ModbusReadRequest> element_requests;
+
+    // one request per element, constant values are not read from modbus
+    for (auto i : elements) {
+        auto& mace = config.config()[i];
+        if (mace.modbus_datatype() == ModbusDataType::constant_value) {
+            continue;
+        }
+
+        ModbusReadRequest request;
+        request.slave_id = mace.modbus_slave_device_id();
+        request.function = read_function(mace.modbus_datatype());
+        request.address = mace.modbus_register_address();
+        request.count = mace.modbus_register_count();
+        request.elements.push_back(i);
+        element_requests.push_back(request);
+    }
+
+    // requests that may be merged end up next to each other
+    std::stable_sort(
+            element_requests.begin(),
+            element_requests.end(),
+            [](const ModbusReadRequest& a, const ModbusReadRequest& b) {
+                if (a.slave_id != b.slave_id) {
+                    return a.slave_id < b.slave_id;
+                }
+                if (a.function != b.function) {
+                    return a.function < b.function;
+                }
+                return a.address < b.address;
+            });
+
+    for (auto& request : element_requests) {
+        if (!requests_.empty()) {
+            ModbusReadRequest& last = requests_.back();
+            int max_count = MAX_READ_REGISTERS;
+            if (last.function == ModbusReadFunction::read_coils
+                    || last.function
+                            == ModbusReadFunction::read_discrete_inputs) {
+                max_count = MAX_READ_COILS;
+            }
+            int end = std::max(
+                    last.address + last.count,
+                    request.address + request.count);
+
+            // only adjacent or overlapping addresses are merged, reading
+            // the gap between two elements may fail on some devices
+            if (last.slave_id == request.slave_id
+                    && last.function == request.function
+                    && request.address <= last.address + last.count
+                    && end - last.address <= max_count) {
+                last.count = end - last.address;
+                last.elements.push_back(request.elements[0]);
+                continue;
+            }
+        }
+        requests_.push_back(request);
+    }
+}
+
+ModbusReadFunction ModbusReadPlan::read_function(ModbusDataType datatype)
+{
+    switch (datatype) {
+    case ModbusDataType::coil_boolean:
+        return ModbusReadFunction::read_coils;
+    case ModbusDataType::discrete_input_boolean:
+        return ModbusReadFunction::read_discrete_inputs;
+    case ModbusDataType::input_register_int8:
+    case ModbusDataType::input_register_int16:
+    case ModbusDataType::input_register_int32:
+    case ModbusDataType::input_register_int64:
+    case ModbusDataType::input_register_float_abcd:
+    case ModbusDataType::input_register_float_badc:
+    case ModbusDataType::input_register_float_cdab:
+    case ModbusDataType::input_register_float_dcba:
+        return ModbusReadFunction::read_input_registers;
+    case ModbusDataType::holding_register_int8:
+    case ModbusDataType::holding_register_int16:
+    case ModbusDataType::holding_register_int32:
+    case ModbusDataType::holding_register_int64:
+    case ModbusDataType::holding_register_float_abcd:
+    case ModbusDataType::holding_register_float_badc:
+    case ModbusDataType::holding_register_float_cdab:
+    case ModbusDataType::holding_register_float_dcba:
+        return ModbusReadFunction::read_holding_registers;
+    default:
+        std::string error(
+                "Error: datatype <" + modbus_datatype_to_string(datatype)
+                + "> cannot be read from a modbus device.");
+        throw std::runtime_error(error);
+    }
+}
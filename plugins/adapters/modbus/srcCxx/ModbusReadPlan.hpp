@@ -0,0 +1,102 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+#include "ModbusAdapterConfiguration.hpp"
+
+namespace rti { namespace adapter { namespace modbus {
+
+// enum that identifies the modbus function used to read a range of addresses
+enum class ModbusReadFunction {
+    read_coils,
+    read_discrete_inputs,
+    read_holding_registers,
+    read_input_registers
+};
+
+/**
+ * @struct ModbusReadRequest
+ *
+ * @brief A single read request to a modbus device, that covers the
+ * registers/coils of one or more configuration elements.
+ */
+struct ModbusReadRequest {
+    uint8_t slave_id;
+    ModbusReadFunction function;
+    int address;
+    int count;
+    // indexes (in ModbusAdapterConfiguration::config()) of the elements
+    // whose registers/coils are read by this request
+    std::vector<size_t> elements;
+};
+
+/**
+ * @class ModbusReadPlan
+ *
+ * @brief Set of read requests needed to read all the elements of a
+ * ModbusAdapterConfiguration.
+ *
+ * Elements that are read from the same slave with the same function, and
+ * whose addresses are adjacent or overlap, are merged into a single request
+ * as long as it doesn't exceed the limits of the modbus protocol. Elements
+ * that are constant values are not part of the plan.
+ */
+class ModbusReadPlan {
+public:
+    // max number of registers/coils that may be read with a single request
+    static const int MAX_READ_REGISTERS = 125;
+    static const int MAX_READ_COILS = 2000;
+
+    ModbusReadPlan()
+    {
+    }
+
+    /**
+     * @brief Creates the read requests for the elements of a configuration.
+     * @param config the configuration of a StreamReader
+     */
+    ModbusReadPlan(const ModbusAdapterConfiguration& config);
+
+    /**
+     * @brief Creates the read requests for some of the elements of a
+     * configuration.
+     * @param config the configuration of a StreamReader
+     * @param elements indexes (in config.config()) of the elements to read
+     */
+    ModbusReadPlan(
+            const ModbusAdapterConfiguration& config,
+            const std::vector<size_t>& elements);
+
+    /**
+     * @brief Gets the modbus function used to read a modbus datatype.
+     * @param datatype the modbus datatype of a non-constant element
+     * @return The modbus function that reads the datatype
+     */
+    static ModbusReadFunction read_function(ModbusDataType datatype);
+
+    // public getters
+    inline std::vector<ModbusReadRequest> const &requests() const
+    {
+        return requests_;
+    }
+
+private:
+    std::vector<ModbusReadRequest> requests_;
+};
+
+}}}  // namespace rti::adapter::modbus
@@ -14,8 +14,10 @@
 /******************************************************************************/
 
 #include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <chrono>
 #include <string>
 
@@ -34,19 +36,13 @@ using namespace dds::domain;
 using namespace rti::common;
 using namespace rti::adapter::modbus;
 
-void ModbusStreamReader::on_data_available_thread()
+void ModbusStreamReader::poll(ModbusPollingGroup& group)
 {
-    while (!stop_thread_) {
-        read_data_from_modbus();
-        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_msecs_));
-    }
-}
-
-void ModbusStreamReader::modbus_reading_thread()
-{
-    while (!stop_thread_) {
+    bool has_changed = read_data_from_modbus(group);
+    // when publishing on change, the listener is only notified if there
+    // is something to publish
+    if (!publish_on_change_ || has_changed) {
         reader_listener_->on_data_available(this);
-        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_msecs_));
     }
 }
 
@@ -54,9 +50,11 @@ ModbusStreamReader::ModbusStreamReader(
         const PropertySet& properties,
         const rti::routing::StreamInfo& stream_info,
         rti::routing::adapter::StreamReaderListener* listener,
-        LibModbusClient& connection)
+        ModbusConnectionPool& connection,
+        ModbusPollingScheduler& scheduler)
         : info_(stream_info),
           connection_(connection),
+          scheduler_(scheduler),
           config_(RoutingServiceEntityType::stream_reader)
 {
     reader_listener_ = listener;
@@ -82,255 +80,483 @@ ModbusStreamReader::ModbusStreamReader(
     if (properties.find("polling_period_msec") != properties.end()) {
         timeout_msecs_ = std::stoi(properties.at("polling_period_msec"));
     }
+    if (properties.find("publish_on_change") != properties.end()) {
+        auto property_value = properties.at("publish_on_change");
+        if (property_value == "true" || property_value == "1") {
+            publish_on_change_ = true;
+        } else if (property_value == "false" || property_value == "0") {
+            publish_on_change_ = false;
+        } else {
+            std::string error(
+                    "Error: invalid value <" + property_value
+                    + "> of the property publish_on_change.");
+            throw std::runtime_error(error);
+        }
+    }
 
     const StructType &dynamic_struct =
             static_cast<const StructType &>(*adapter_type_);
 
     config_.check_configuration_consistency(dynamic_struct);
 
+    field_plan_ = ModbusFieldPlan(config_, dynamic_struct);
+    field_states_.resize(config_.config().size());
+    create_polling_groups();
+
+    // constant values never change, so they are only set once
+    for (auto& entry : field_plan_.entries()) {
+        if (entry.element->modbus_datatype()
+                == ModbusDataType::constant_value) {
+            set_constant_value(entry);
+        }
+    }
+
     if (timeout_msecs_ >= 0) {
-        modbus_thread_ =
-                std::thread(&ModbusStreamReader::modbus_reading_thread, this);
-        on_data_available_thread_ = std::thread(
-                &ModbusStreamReader::on_data_available_thread,
-                this);
+        for (auto& group : polling_groups_) {
+            ModbusPollingGroup *polling_group = &group;
+            group.task_id = scheduler_.schedule(
+                    std::chrono::milliseconds(group.period_msecs),
+                    [this, polling_group]() { poll(*polling_group); });
+        }
     }
 }
 
 ModbusStreamReader::~ModbusStreamReader()
 {
+    // the tasks are cancelled before deleting cached_data_, cancel() waits
+    // for them to finish if they are running
+    for (auto& group : polling_groups_) {
+        if (group.task_id != 0) {
+            scheduler_.cancel(group.task_id);
+        }
+    }
+
     std::lock_guard<std::mutex> guard(cached_data_mutex_);
     delete cached_data_;
+}
 
-    // To delete the threads we enable stop_thread and then join to them
-    stop_thread_ = true;
-    if (modbus_thread_.joinable()) {
-        modbus_thread_.join();
+void ModbusStreamReader::create_polling_groups()
+{
+    // Elements without a polling period of their own are read with the
+    // polling period of the StreamReader. The group of the StreamReader is
+    // always created, so the listener is notified with its period even if
+    // it only contains constant values.
+    std::map<int, std::vector<size_t>> period_elements;
+    period_elements[timeout_msecs_];
+
+    for (size_t i = 0; i < config_.config().size(); ++i) {
+        auto& mace = config_.config()[i];
+        int period_msecs = timeout_msecs_;
+
+        if (mace.polling_period_msec() != -1
+                && mace.modbus_datatype() != ModbusDataType::constant_value) {
+            if (timeout_msecs_ < 0) {
+                std::cerr << "Warning: The parameter polling_period_msec of "
+                        "the field <" << mace.field() << "> will be ignored "
+                        "as the polling_period_msec property of the input "
+                        "is not set." << std::endl;
+            } else {
+                period_msecs = mace.polling_period_msec();
+            }
+        }
+        period_elements[period_msecs].push_back(i);
     }
-    if (on_data_available_thread_.joinable()) {
-        on_data_available_thread_.join();
+
+    for (auto& period : period_elements) {
+        ModbusPollingGroup group;
+        group.period_msecs = period.first;
+        group.read_plan = ModbusReadPlan(config_, period.second);
+
+        // the requests of the plan are sorted by slave ID
+        auto& requests = group.read_plan.requests();
+        for (size_t i = 0; i < requests.size(); ++i) {
+            if (i == 0 || requests[i].slave_id != requests[i - 1].slave_id) {
+                group.slave_requests.push_back(std::vector<size_t>());
+            }
+            group.slave_requests.back().push_back(i);
+        }
+        polling_groups_.push_back(std::move(group));
     }
 }
 
-void ModbusStreamReader::read_data_from_modbus()
+void ModbusStreamReader::set_constant_value(const ModbusFieldPlanEntry& entry)
 {
-    // This protection is required since take() executes on a different
-    // Routing Service thread.
+    auto& mace = *entry.element;
+
+    if (mace.constant_kind() == ConstantValueKind::string_kind) {
+        if (entry.member_kind != TypeKind::STRING_TYPE) {
+            std::string error(
+                    "Error: unable to set field <" + mace.field() + ">."
+                    " This is set as a constant string, but its datatype"
+                    " is not compatible.");
+            throw std::runtime_error(error);
+        }
+        // If the type is a string, check that the content fits into
+        // the DDS String
+        if (entry.string_bounds < mace.value_string().length()) {
+            std::string error(
+                    "Error: the string constant value <"
+                    + mace.value_string()
+                    + "> doesn't fit in the bounds of the field <"
+                    + mace.field() + ">.");
+            throw std::runtime_error(error);
+        }
+        ModbusFieldPlan::with_member(
+                *cached_data_,
+                entry,
+                [&](DynamicData& data, uint32_t index) {
+                    data.value<std::string>(index, mace.value_string());
+                });
+    } else if (mace.constant_kind() == ConstantValueKind::array_kind) {
+        if (!entry.is_collection) {
+            std::string error(
+                    "Error: unable to set field <" + mace.field() + ">."
+                    " This is set as a constant array, but its datatype"
+                    " is not compatible.");
+            throw std::runtime_error(error);
+        }
+        // It is not needed to check the element_kind since it is done
+        // inside the set_vector_values
+        ModbusFieldPlan::with_member(
+                *cached_data_,
+                entry,
+                [&](DynamicData& data, uint32_t index) {
+                    dynamic_data::set_vector_values(
+                            data,
+                            entry.element_kind,
+                            index,
+                            mace.value_array());
+                });
+    } else {
+        // primitive type
+        if (mace.constant_kind() == ConstantValueKind::float_kind
+                || mace.constant_kind() == ConstantValueKind::boolean_kind
+                || mace.constant_kind()
+                        == ConstantValueKind::integer_kind) {
+            ModbusFieldPlan::with_member(
+                    *cached_data_,
+                    entry,
+                    [&](DynamicData& data, uint32_t index) {
+                        dynamic_data::set_dds_primitive_or_enum_type_value(
+                                data,
+                                entry.element_kind,
+                                index,
+                                mace.value_numeric());
+                    });
+        }
+    }
+}
 
-    std::lock_guard<std::mutex> guard(cached_data_mutex_);
+void ModbusStreamReader::set_member_value(
+        const ModbusFieldPlanEntry& entry,
+        const std::vector<long double>& float_vector)
+{
+    if (float_vector.size() == 1) {
+        // an array with one element means that it's a simple value
+        ModbusFieldPlan::with_member(
+                *cached_data_,
+                entry,
+                [&](DynamicData& data, uint32_t index) {
+                    dynamic_data::set_dds_primitive_or_enum_type_value(
+                            data,
+                            entry.element_kind,
+                            index,
+                            float_vector[0]);
+                });
+    } else if (float_vector.size() > 1) {
+        ModbusFieldPlan::with_member(
+                *cached_data_,
+                entry,
+                [&](DynamicData& data, uint32_t index) {
+                    dynamic_data::set_vector_values(
+                            data,
+                            entry.element_kind,
+                            index,
+                            float_vector);
+                });
+        // when checking type_consistency() we ensure that the number of
+        // elements won't be higher than mace.array_elements(). Therefore
+        // float_vector.size() can be used safely.
+    }
+    // in case of the size == 0, do nothing because nothing has been read
+}
 
-    const StructType &struct_type =
-            static_cast<const StructType &>(*adapter_type_);
+bool ModbusStreamReader::exceeds_deadband(
+        const ModbusAdapterConfigurationElement& mace,
+        const std::vector<long double>& previous,
+        const std::vector<long double>& current)
+{
+    if (previous.size() != current.size()) {
+        return true;
+    }
 
-    for (auto mace : config_.config()) {
-        auto member_kind =
-                dynamic_data::get_member_type(struct_type, mace.field())
-                        .kind();
-        TypeKind element_kind = member_kind;
-        std::vector<long double> float_vector;
+    for (size_t i = 0; i < current.size(); ++i) {
+        long double difference = std::fabs(current[i] - previous[i]);
 
-        // Sets the slave ID before reading, only when the datatype is not
-        // constant and the slave ID is different from the previous one.
-        try {
-            bool is_constant = mace.modbus_datatype()
-                    == ModbusDataType::constant_value;
-            bool is_same_slave_id = connection_.get_slave_id()
-                    == mace.modbus_slave_device_id();
-            if (!is_constant && !is_same_slave_id) {
-                connection_.set_slave_id(mace.modbus_slave_device_id());
+        if (mace.deadband() == 0 && mace.deadband_percentage() == 0) {
+            // no deadband, any change is published
+            if (difference != 0) {
+                return true;
             }
-        } catch (const std::exception &ex) {
-            std::cerr << ex.what() << std::endl;
             continue;
         }
+        if (mace.deadband() > 0 && difference > mace.deadband()) {
+            return true;
+        }
+        if (mace.deadband_percentage() > 0
+                && difference > std::fabs(previous[i])
+                                * mace.deadband_percentage() / 100) {
+            return true;
+        }
+    }
+    return false;
+}
 
-        // if this is an array or a sequence we should extract the kind of the
-        // internal elements
-        if (member_kind == TypeKind::ARRAY_TYPE) {
-            DynamicType dynamic_type =
-                    dynamic_data::get_member_type(struct_type, mace.field());
-            const ArrayType &array_type =
-                    static_cast<const ArrayType &>(dynamic_type);
-            element_kind = array_type.content_type().kind();
+bool ModbusStreamReader::clear_optional_members(
+        const ModbusReadRequest& request)
+{
+    bool has_changed = false;
+
+    for (auto index : request.elements) {
+        auto& entry = field_plan_.entries()[index];
+        if (entry.is_optional) {
+            // unset the field as it is optional and couldn't be read
+            ModbusFieldPlan::with_member(
+                    *cached_data_,
+                    entry,
+                    [](DynamicData& data, uint32_t index) {
+                        data.clear_optional_member(index);
+                    });
+            // it is only a change if the field was set before, the next
+            // value read will be published regardless of the deadbands
+            if (field_states_[index].is_set) {
+                has_changed = true;
+            }
+            field_states_[index] = ModbusFieldState();
         }
-        if (member_kind == TypeKind::SEQUENCE_TYPE) {
-            DynamicType dynamic_type =
-                    dynamic_data::get_member_type(struct_type, mace.field());
-            const SequenceType &sequence_type =
-                    static_cast<const SequenceType &>(dynamic_type);
-            element_kind = sequence_type.content_type().kind();
+    }
+    return has_changed;
+}
+
+void ModbusStreamReader::fetch_request(
+        const ModbusReadRequest& request,
+        ModbusReadResult& result)
+{
+    result.size = -1;
+    result.error.clear();
+
+    try {
+        if (request.function == ModbusReadFunction::read_coils
+                || request.function
+                        == ModbusReadFunction::read_discrete_inputs) {
+            // read coils and store them in a uint8_t array
+            result.coils.resize(request.count);
+            result.size = connection_.read_coils(
+                    request.slave_id,
+                    result.coils,
+                    request.address,
+                    request.count,
+                    request.function
+                            == ModbusReadFunction::read_discrete_inputs);
+        } else {
+            // read registers of any type
+            result.registers.resize(request.count);
+            result.size = connection_.read_registers(
+                    request.slave_id,
+                    result.registers,
+                    request.address,
+                    request.count,
+                    request.function
+                            == ModbusReadFunction::read_input_registers);
         }
+    } catch (const std::exception &ex) {
+        result.size = -1;
+        result.error = ex.what();
+    }
+}
 
-        if (mace.modbus_datatype() == ModbusDataType::constant_value) {
-            if (mace.constant_kind() == ConstantValueKind::string_kind) {
-                if (element_kind != TypeKind::STRING_TYPE) {
-                    std::string error(
-                            "Error: unable to set field <" + mace.field() + ">."
-                            " This is set as a constant string, but its datatype"
-                            " is not compatible.");
-                    throw std::runtime_error(error);
-                }
-                DynamicType dynamic_type =
-                    dynamic_data::get_member_type(struct_type, mace.field());
-                const StringType &string_type = static_cast<const StringType &>(
-                        dynamic_type);
-                // If the type is a string, check that the content fits into
-                // the DDS String
-                if (string_type.bounds() >= mace.value_string().length()) {
-                    cached_data_->value<std::string>(
-                            mace.field(),
-                            mace.value_string());
-                } else {
-                    std::string error(
-                            "Error: the string constant value <"
-                            + mace.value_string()
-                            + "> doesn't fit in the bounds of the field <"
-                            + mace.field() + ">.");
-                    throw std::runtime_error(error);
-                }
-                continue;
-            } else if (mace.constant_kind() == ConstantValueKind::array_kind) {
-                if (member_kind != TypeKind::ARRAY_TYPE
-                        && member_kind != TypeKind::SEQUENCE_TYPE) {
-                    std::string error(
-                            "Error: unable to set field <" + mace.field() + ">."
-                            " This is set as a constant array, but its datatype"
-                            " is not compatible.");
-                    throw std::runtime_error(error);
-                }
-                // It is not needed to check the element_kind since it is done
-                // inside the set_vector_values
-                dynamic_data::set_vector_values(
-                        *cached_data_,
-                        element_kind,
-                        mace.field(),
-                        mace.value_array());
-                continue;
-            } else {
-                // primitive type
-                if (mace.constant_kind() == ConstantValueKind::float_kind
-                        || mace.constant_kind() == ConstantValueKind::boolean_kind
-                        || mace.constant_kind()
-                                == ConstantValueKind::integer_kind) {
-                    dynamic_data::set_dds_primitive_or_enum_type_value(
-                            *cached_data_,
-                            element_kind,
-                            mace.field(),
-                            mace.value_numeric());
+void ModbusStreamReader::fetch_requests(
+        const ModbusPollingGroup& group,
+        const std::vector<size_t>& requests,
+        std::vector<ModbusReadResult>& results,
+        std::vector<std::vector<ModbusReadResult>>& element_results)
+{
+    for (auto index : requests) {
+        auto& request = group.read_plan.requests()[index];
+        fetch_request(request, results[index]);
+
+        if (!results[index].error.empty() && request.elements.size() > 1) {
+            // The request may have failed because of a single element (e.g.
+            // an address that doesn't exist), read the elements one by one
+            // so the rest of them are still updated.
+            element_results[index].resize(request.elements.size());
+            for (size_t i = 0; i < request.elements.size(); ++i) {
+                fetch_request(
+                        element_request(request, request.elements[i]),
+                        element_results[index][i]);
+            }
+        }
+    }
+}
+
+ModbusReadRequest ModbusStreamReader::element_request(
+        const ModbusReadRequest& request,
+        size_t index) const
+{
+    auto& mace = *field_plan_.entries()[index].element;
+    ModbusReadRequest element_request;
+
+    element_request.slave_id = request.slave_id;
+    element_request.function = request.function;
+    element_request.address = mace.modbus_register_address();
+    element_request.count = mace.modbus_register_count();
+    element_request.elements.push_back(index);
+    return element_request;
+}
+
+bool ModbusStreamReader::process_result(
+        const ModbusReadRequest& request,
+        const ModbusReadResult& result,
+        const std::vector<ModbusReadResult>& element_results)
+{
+    bool is_coil_request =
+            request.function == ModbusReadFunction::read_coils
+            || request.function == ModbusReadFunction::read_discrete_inputs;
+    bool has_changed = false;
+
+    if (!result.error.empty()) {
+        if (!element_results.empty()) {
+            // the elements have been read one by one, see fetch_requests()
+            for (size_t i = 0; i < request.elements.size(); ++i) {
+                if (process_result(
+                            element_request(request, request.elements[i]),
+                            element_results[i],
+                            std::vector<ModbusReadResult>())) {
+                    has_changed = true;
                 }
-                continue;
             }
-        } else if (
-                mace.modbus_datatype() == ModbusDataType::coil_boolean
-                || mace.modbus_datatype()
-                        == ModbusDataType::discrete_input_boolean) {
-            // read coils and store them in a uint8_t array
-            std::vector<uint8_t> values(mace.modbus_register_count());
-            bool read_discrete_input =
-                    mace.modbus_datatype()
-                            == ModbusDataType::discrete_input_boolean;
-
-            auto size = -1;
-            try {
-                size = connection_.read_coils(
-                    values,
-                    mace.modbus_register_address(),
-                    mace.modbus_register_count(),
-                    read_discrete_input);
-            } catch (const std::exception &ex) {
-                std::cerr << ex.what() << std::endl;
-                // if the value is not correct, we don't store it in
-                // the cached_data_
-                continue;
+        } else {
+            std::cerr << result.error << std::endl;
+        }
+        // if the value is not correct, we don't store it in the cached_data_
+        return has_changed;
+    }
+
+    if (result.size < 1) {
+        // if no value has been read and the field is not optional, do
+        // nothing and keep the previous value in the dynamic data
+        return clear_optional_members(request);
+    }
+
+    // scatter the values read into the fields of each element
+    for (auto index : request.elements) {
+        auto& entry = field_plan_.entries()[index];
+        auto& mace = *entry.element;
+        size_t offset = mace.modbus_register_address() - request.address;
+        std::vector<long double> float_vector;
+
+        if (publish_on_change_) {
+            // nothing to convert if the registers haven't changed
+            ModbusFieldState& state = field_states_[index];
+            std::vector<uint16_t> raw(mace.modbus_register_count());
+            for (size_t i = 0; i < raw.size(); ++i) {
+                raw[i] = is_coil_request ? result.coils[offset + i]
+                                         : result.registers[offset + i];
             }
-            if (size == 0 && struct_type.member(mace.field()).is_optional()) {
-                // unset the field as it is optional and couldn't be read
-                cached_data_->clear_optional_member(mace.field());
+            if (state.is_set && raw == state.raw) {
+                continue;
             }
-            if (size > 0) {
+            state.raw.swap(raw);
+        }
+
+        try {
+            if (is_coil_request) {
                 // set the read value into float_vector
                 for (int i = 0; i < mace.modbus_register_count(); ++i) {
-                    float_vector.push_back(values[i]);
+                    float_vector.push_back(result.coils[offset + i]);
                 }
+            } else {
+                float_vector = mace.get_float_value(
+                        result.registers.data() + offset,
+                        entry.element_kind);
             }
+        } catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            // if the value is not correct, we don't store it in
+            // the cached_data_
+            continue;
+        }
 
-            // if no value has been read and the field is not optional, do
-            // nothing and keep the previous value in the dynamic data
-        } else {
-            // read registers of any type
-            std::vector<uint16_t> registers(mace.modbus_register_count());
-            bool read_input_registers =
-                    mace.modbus_datatype()
-                            == ModbusDataType::input_register_int8
-                    || mace.modbus_datatype()
-                            == ModbusDataType::input_register_int16
-                    || mace.modbus_datatype()
-                            == ModbusDataType::input_register_int32
-                    || mace.modbus_datatype()
-                            == ModbusDataType::input_register_int64
-                    || mace.modbus_datatype()
-                            == ModbusDataType::input_register_float_abcd
-                    || mace.modbus_datatype()
-                            == ModbusDataType::input_register_float_badc
-                    || mace.modbus_datatype()
-                            == ModbusDataType::input_register_float_cdab
-                    || mace.modbus_datatype()
-                            == ModbusDataType::input_register_float_dcba;
-
-            int size = -1;
-            try {
-                size = connection_.read_registers(
-                        registers,
-                        mace.modbus_register_address(),
-                        mace.modbus_register_count(),
-                        read_input_registers);
-                if (size < 1
-                        && struct_type.member(mace.field()).is_optional()) {
-                    // unset the field as it is optional and couldn't be read
-                    cached_data_->clear_optional_member(mace.field());
-                }
-                if (size > 0) {
-                    // set the read value into float_vector
-                    float_vector =
-                            mace.get_float_value(registers, element_kind);
-                }
-            } catch (const std::exception &ex) {
-                std::cerr << ex.what() << std::endl;
-                // if the value is not correct, we don't store it in
-                // the cached_data_
+        if (publish_on_change_) {
+            ModbusFieldState& state = field_states_[index];
+            if (state.is_set
+                    && !exceeds_deadband(mace, state.values, float_vector)) {
+                // keep the last published value, so small changes are
+                // accumulated until they exceed the deadband
                 continue;
             }
+            state.values = float_vector;
+            state.is_set = true;
         }
 
-        if (float_vector.size() == 1) {
-            // an array with one element means that it's a simple value
-            dynamic_data::set_dds_primitive_or_enum_type_value(
-                    *cached_data_,
-                    element_kind,
-                    mace.field(),
-                    float_vector[0]);
-        } else if (float_vector.size() > 1) {
-            dynamic_data::set_vector_values(
-                    *cached_data_,
-                    element_kind,
-                    mace.field(),
-                    float_vector);
-            // when checking type_consistency() we ensure that the number of
-            // elements won't be higher than mace.array_elements(). Therefore
-            // float_vector.size() can be used safely.
+        set_member_value(entry, float_vector);
+        has_changed = true;
+    }
+    return has_changed;
+}
+
+bool ModbusStreamReader::read_data_from_modbus(ModbusPollingGroup& group)
+{
+    auto& requests = group.read_plan.requests();
+
+    // Registers and coils are read with as few requests as possible, see
+    // ModbusReadPlan. They are read into local results without holding
+    // cached_data_mutex_, so take() is not blocked by the modbus I/O.
+    std::vector<ModbusReadResult> results(requests.size());
+    std::vector<std::vector<ModbusReadResult>> element_results(
+            requests.size());
+
+    // The requests to different slaves are independent, so they are spread
+    // over the threads of the scheduler, which are as many as the requests
+    // that the pool may have in flight.
+    scheduler_.run_concurrently(
+            group.slave_requests.size(),
+            [&](size_t slave) {
+                fetch_requests(
+                        group,
+                        group.slave_requests[slave],
+                        results,
+                        element_results);
+            });
+
+    // This protection is required since take() executes on a different
+    // Routing Service thread.
+    std::lock_guard<std::mutex> guard(cached_data_mutex_);
+
+    // the values are stored in cached_data_ once all of them have been read.
+    // Constant values are already set in cached_data_.
+    bool has_changed = false;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (process_result(requests[i], results[i], element_results[i])) {
+            has_changed = true;
         }
-        // in case of the size == 0, do nothing because nothing has been read
     }
+    if (has_changed) {
+        has_new_data_ = true;
+    }
+    return has_changed;
 }
 
 void ModbusStreamReader::read(
         std::vector<dds::core::xtypes::DynamicData *>& samples,
         std::vector<dds::sub::SampleInfo *>& infos)
 {
-    // If no reading thread has been created, the sample is filled out
-    // asynchronously.
+    // If the elements are not polled by the scheduler, the sample is filled
+    // out synchronously.
     if (timeout_msecs_ < 0) {
-        read_data_from_modbus();
+        for (auto& group : polling_groups_) {
+            read_data_from_modbus(group);
+        }
     }
 
     /**
@@ -339,9 +565,18 @@ void ModbusStreamReader::read(
      */
     std::lock_guard<std::mutex> guard(cached_data_mutex_);
 
+    // when publishing on change, there is no sample if nothing has changed
+    // since the last one
+    if (publish_on_change_ && !has_new_data_) {
+        samples.resize(0);
+        infos.resize(0);
+        return;
+    }
+    has_new_data_ = false;
+
     /**
      * Note that we read one sample at a time from modbus in the
-     * function modbus_reading_thread()
+     * function read_data_from_modbus()
      */
     samples.resize(1);
     infos.resize(1);
@@ -16,13 +16,15 @@
 #pragma once
 
 #include <mutex>
-#include <thread>
 
 #include <rti/routing/adapter/AdapterPlugin.hpp>
 #include <rti/routing/adapter/StreamReader.hpp>
 
 #include "ModbusAdapterConfiguration.hpp"
-#include "LibModbusClient.hpp"
+#include "ModbusFieldPlan.hpp"
+#include "ModbusReadPlan.hpp"
+#include "ModbusConnectionPool.hpp"
+#include "ModbusPollingScheduler.hpp"
 
 using namespace dds::core;
 using namespace dds::domain;
@@ -46,13 +48,15 @@ public:
      * @brief Parametrized constructor
      * @details constructor that creates a StreamReader with the specified
      * modbus connection. It reads the properties to load the JSON configuration
-     * as well as the polling period.
+     * as well as the polling period. If the polling period is set, the
+     * elements are read periodically by the scheduler of the connection.
      */
     ModbusStreamReader(
             const PropertySet& properties,
             const rti::routing::StreamInfo& info,
             rti::routing::adapter::StreamReaderListener* listener,
-            LibModbusClient& connection);
+            ModbusConnectionPool& connection,
+            ModbusPollingScheduler& scheduler);
 
     ~ModbusStreamReader();
 
@@ -82,38 +86,164 @@ public:
             std::vector<dds::sub::SampleInfo *>& infos) final;
 
 private:
+    // Registers/coils read by a request of a ModbusReadPlan
+    struct ModbusReadResult {
+        int size = -1;
+        // error message if the request failed
+        std::string error;
+        std::vector<uint16_t> registers;
+        std::vector<uint8_t> coils;
+    };
+
+    // Elements of the configuration that are read with the same period
+    struct ModbusPollingGroup {
+        int period_msecs = -1;
+        ModbusReadPlan read_plan;
+        // indexes of the requests of the read_plan, grouped by slave ID
+        std::vector<std::vector<size_t>> slave_requests;
+        ModbusPollingScheduler::TaskId task_id = 0;
+    };
+
+    // Last values read and published for an element, used when publishing
+    // on change.
+    struct ModbusFieldState {
+        bool is_set = false;
+        // registers (or coils) as read from the modbus device
+        std::vector<uint16_t> raw;
+        // transformed values last set into cached_data_
+        std::vector<long double> values;
+    };
+
     /**
-     * @brief Creates a new thread that puts the data from a modbus device
-     * into the StreamReaderListener.
+     * @brief Creates the polling groups from the polling period of each
+     * element of the configuration.
      */
-    void modbus_reading_thread();
+    void create_polling_groups();
 
     /**
-     * @brief Creates a new thread that reads data from a modbus device
+     * @brief Task that the ModbusPollingScheduler runs every period of a
+     * polling group. It reads the elements of the group, and notifies the
+     * StreamReaderListener.
+     * @param group the polling group to read
      */
-    void on_data_available_thread();
+    void poll(ModbusPollingGroup& group);
 
     /**
      * @brief Calls LibModbusClient functions to read data from the modbus
      * device specified in the connection. This function will read modbus
      * registers depending on the ModbusAdapterConfiguration and store these
-     * values in cached_data_
+     * values in cached_data_. cached_data_mutex_ is only held to store
+     * the values, once all of them have been read.
+     * @param group the polling group whose elements are read
+     * @return Whether cached_data_ has changed
+     */
+    bool read_data_from_modbus(ModbusPollingGroup& group);
+
+    /**
+     * @brief Performs a request to the modbus device. It doesn't access
+     * cached_data_, so several requests may be performed concurrently.
+     * @param request the request to perform
+     * @param [out] result the registers/coils read, or the error
+     */
+    void fetch_request(
+            const ModbusReadRequest& request,
+            ModbusReadResult& result);
+
+    /**
+     * @brief Performs several requests of a polling group, one after another.
+     * If a request fails and covers more than one element, the elements are
+     * read one by one.
+     * @param group the polling group of the requests
+     * @param requests the indexes of the requests in the group read_plan
+     * @param [out] results one result per request of the group read_plan
+     * @param [out] element_results for every request of the group read_plan,
+     * the results of reading its elements one by one, if it failed
+     */
+    void fetch_requests(
+            const ModbusPollingGroup& group,
+            const std::vector<size_t>& requests,
+            std::vector<ModbusReadResult>& results,
+            std::vector<std::vector<ModbusReadResult>>& element_results);
+
+    /**
+     * @brief Creates a request that reads a single element of another request
+     * @param request the request that covers the element
+     * @param index the index of the element in the configuration
+     */
+    ModbusReadRequest element_request(
+            const ModbusReadRequest& request,
+            size_t index) const;
+
+    /**
+     * @brief Stores the values read by a request into the fields of all the
+     * elements covered by the request. If the request failed and covers more
+     * than one element, the results of reading them one by one are stored
+     * instead.
+     * @param request the request that has been performed
+     * @param result the result of the request
+     * @param element_results the results of reading the elements of the
+     * request one by one, in the same order. Empty if they haven't been read.
+     * @return Whether any of the fields has changed
+     */
+    bool process_result(
+            const ModbusReadRequest& request,
+            const ModbusReadResult& result,
+            const std::vector<ModbusReadResult>& element_results);
+
+    /**
+     * @brief Checks whether the values read for an element differ enough
+     * from the last published ones to be published, according to the
+     * deadband and deadband_percentage of the element. If no deadband is set,
+     * any change is published.
+     * @param mace the element that has been read
+     * @param previous the values last published for the element
+     * @param current the values read, already transformed
+     */
+    static bool exceeds_deadband(
+            const ModbusAdapterConfigurationElement& mace,
+            const std::vector<long double>& previous,
+            const std::vector<long double>& current);
+
+    /**
+     * @brief Sets the constant value of an element into cached_data_
+     * @param entry the entry of an element whose modbus_datatype is
+     * constant_value
+     */
+    void set_constant_value(const ModbusFieldPlanEntry& entry);
+
+    /**
+     * @brief Sets the values read for an element into cached_data_
+     * @param entry the entry of the element that has been read
+     * @param float_vector the values read, already transformed
+     */
+    void set_member_value(
+            const ModbusFieldPlanEntry& entry,
+            const std::vector<long double>& float_vector);
+
+    /**
+     * @brief Unsets the optional fields of the elements covered by a request
+     * @param request the request that couldn't be read
+     * @return Whether any of the fields has changed
      */
-    void read_data_from_modbus();
+    bool clear_optional_members(const ModbusReadRequest& request);
 
 private:
     ModbusAdapterConfiguration config_;
+    ModbusFieldPlan field_plan_;
     const StreamInfo& info_;
-    LibModbusClient& connection_;
+    ModbusConnectionPool& connection_;
+    ModbusPollingScheduler& scheduler_;
     StreamReaderListener *reader_listener_;
     dds::core::xtypes::DynamicType *adapter_type_;
     dds::core::xtypes::DynamicData *cached_data_;
-    std::thread modbus_thread_;
-    std::thread on_data_available_thread_;
     std::mutex cached_data_mutex_;
+    std::vector<ModbusPollingGroup> polling_groups_;
+    // one state per element of the configuration, in the same order
+    std::vector<ModbusFieldState> field_states_;
 
     int timeout_msecs_ = -1;
-    bool stop_thread_ = false;
+    bool publish_on_change_ = false;
+    bool has_new_data_ = false;
 };
 
 }}}  // namespace rti::adapter::modbus
@@ -33,7 +33,7 @@ using namespace rti::adapter::modbus;
 ModbusStreamWriter::ModbusStreamWriter(
         const PropertySet& properties,
         const StreamInfo& stream_info,
-        LibModbusClient& connection)
+        ModbusConnectionPool& connection)
         : info_(stream_info),
           connection_(connection),
           config_(RoutingServiceEntityType::stream_writer)
@@ -60,6 +60,8 @@ ModbusStreamWriter::ModbusStreamWriter(
     const StructType &dynamic_struct = static_cast<const StructType &>(*type);
 
     config_.check_configuration_consistency(dynamic_struct);
+
+    field_plan_ = ModbusFieldPlan(config_, dynamic_struct);
 }
 
 int ModbusStreamWriter::write(
@@ -71,74 +73,56 @@ int ModbusStreamWriter::write(
         auto info = infos[i];
 
         if (info->valid()) {
-            // mace -> ModbusAdapterConfigurationElement
-            for (auto mace : config_.config()) {
-                const StructType &dynamic_struct =
-                        static_cast<const StructType &>(sample->type());
-                auto member_kind = dynamic_data::get_member_type(
-                        dynamic_struct,
-                        mace.field()).kind();
-                TypeKind element_kind = member_kind;
+            for (auto& entry : field_plan_.entries()) {
+                // mace -> ModbusAdapterConfigurationElement
+                auto& mace = *entry.element;
                 std::vector<long double> float_vector;
 
-                // Sets the slave ID before reading, only when the datatype is
-                // not constant and the slave ID is different from the previous
-                // one.
-                try {
-                    bool is_constant = mace.modbus_datatype()
-                            == ModbusDataType::constant_value;
-                    bool is_same_slave_id = connection_.get_slave_id()
-                            == mace.modbus_slave_device_id();
-                    if (!is_constant && !is_same_slave_id) {
-                        connection_.set_slave_id(mace.modbus_slave_device_id());
-                    }
-                } catch (const std::exception &ex) {
-                    std::cerr << ex.what() << std::endl;
-                    continue;
-                }
-
                 // If the type is optional and it is not set, do nothing
-                if (!sample->member_exists(mace.field())) {
+                if (!ModbusFieldPlan::member_exists(*sample, entry)) {
                     continue;
                 }
 
                 // get the values that will be written for this specific field
-                DynamicType dynamic_type = dynamic_data::get_member_type(
-                        dynamic_struct,
-                        mace.field());
-                if (is_primitive_type(dynamic_type)
-                        || member_kind == TypeKind::ENUMERATION_TYPE) {
-                    // an array with one element means that it's a simple value
-                    float_vector.push_back(
-                            dynamic_data::
-                                    get_dds_primitive_or_enum_type_value(
-                                            *sample,
-                                            mace.field()));
-                } else if (member_kind == TypeKind::ARRAY_TYPE
-                        || member_kind == TypeKind::SEQUENCE_TYPE) {
-                    element_kind =
-                            sample->member_info(mace.field()).element_kind();
-                    float_vector = dynamic_data::get_vector_values(
-                            *sample,
-                            mace.field());
-                    // when checking type_consistency() we ensure that the
-                    // number of elements won't be higher than
-                    // mace.array_elements(). Therefore float_vector.size() can
-                    // be used safely.
-                }
+                ModbusFieldPlan::with_member(
+                        *sample,
+                        entry,
+                        [&](DynamicData& data, uint32_t index) {
+                            if (entry.is_collection) {
+                                float_vector = dynamic_data::get_vector_values(
+                                        data,
+                                        entry.element_kind,
+                                        index);
+                                // when checking type_consistency() we ensure
+                                // that the number of elements won't be higher
+                                // than mace.array_elements(). Therefore
+                                // float_vector.size() can be used safely.
+                            } else {
+                                // an array with one element means that it's a
+                                // simple value
+                                long double value = dynamic_data::
+                                        get_dds_primitive_or_enum_type_value(
+                                                data,
+                                                entry.member_kind,
+                                                index);
+                                float_vector.push_back(value);
+                            }
+                        });
 
                 if (mace.modbus_datatype() == ModbusDataType::coil_boolean) {
-                    std::vector<uint8_t> values(mace.modbus_register_count());
+                    coil_buffer_.assign(mace.modbus_register_count(), 0);
 
                     for (int i = 0; i < float_vector.size(); ++i) {
-                        values[i] = static_cast<uint8_t>(float_vector[i]);
+                        coil_buffer_[i] = static_cast<uint8_t>(float_vector[i]);
                     }
                     // write coils to a modbus server
                     try {
+                        // the slave ID is set in the same transaction
                         connection_.write_coils(
+                                mace.modbus_slave_device_id(),
                                 mace.modbus_register_address(),
                                 mace.modbus_register_count(),
-                                values);
+                                coil_buffer_);
                         // no need of checking write_coils error, because it
                         // is logged inside
                     } catch (const std::exception &ex) {
@@ -146,18 +130,18 @@ int ModbusStreamWriter::write(
                         continue;
                     }
                 } else {
-                    std::vector<uint16_t>
-                            registers(mace.modbus_register_count());
+                    register_buffer_.assign(mace.modbus_register_count(), 0);
                     try {
                         mace.get_registers_value(
-                                registers,
+                                register_buffer_,
                                 float_vector,
-                                element_kind);
+                                entry.element_kind);
                         // write register/s to the modbus device
                         connection_.write_registers(
+                                mace.modbus_slave_device_id(),
                                 mace.modbus_register_address(),
                                 mace.modbus_register_count(),
-                                registers);
+                                register_buffer_);
                     } catch (const std::exception &ex) {
                         std::cerr << ex.what() << std::endl;
                         continue;
@@ -19,7 +19,8 @@
 #include <rti/routing/adapter/StreamWriter.hpp>
 
 #include "ModbusAdapterConfiguration.hpp"
-#include "LibModbusClient.hpp"
+#include "ModbusFieldPlan.hpp"
+#include "ModbusConnectionPool.hpp"
 
 using namespace dds::core;
 using namespace dds::domain;
@@ -47,7 +48,7 @@ public:
     ModbusStreamWriter(
             const PropertySet& properties,
             const StreamInfo& stream_info,
-            LibModbusClient& connection);
+            ModbusConnectionPool& connection);
 
     /**
      * @brief Calls LibModbusClient functions to write data to the modbus
@@ -60,8 +61,11 @@ public:
 
 private:
     ModbusAdapterConfiguration config_;
+    ModbusFieldPlan field_plan_;
     const StreamInfo& info_;
-    LibModbusClient& connection_;
+    ModbusConnectionPool& connection_;
+    std::vector<uint16_t> register_buffer_;
+    std::vector<uint8_t> coil_buffer_;
 };
 
 }}}  // namespace rti::adapter::modbus
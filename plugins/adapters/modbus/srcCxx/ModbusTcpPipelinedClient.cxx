@@ -0,0 +1,682 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+  #include <winsock2.h>
+  #include <ws2tcpip.h>
+#else
+  #include <unistd.h>
+  #include <netdb.h>
+  #include <netinet/in.h>
+  #include <netinet/tcp.h>
+  #include <sys/socket.h>
+#endif
+
+#include "ModbusTcpPipelinedClient.hpp"
+
+using namespace rti::adapter::modbus;
+
+// size of the MBAP header, including the unit identifier
+#define MODBUS_MBAP_HEADER_LENGTH 7
+// max size of a PDU
+#define MODBUS_MAX_PDU_LENGTH 253
+// unit identifier used when talking to a Modbus TCP device directly
+#define MODBUS_TCP_UNIT_ID 0xFF
+
+// function codes
+#define MODBUS_FC_READ_COILS 0x01
+#define MODBUS_FC_READ_DISCRETE_INPUTS 0x02
+#define MODBUS_FC_READ_HOLDING_REGISTERS 0x03
+#define MODBUS_FC_READ_INPUT_REGISTERS 0x04
+#define MODBUS_FC_WRITE_SINGLE_COIL 0x05
+#define MODBUS_FC_WRITE_SINGLE_REGISTER 0x06
+#define MODBUS_FC_WRITE_MULTIPLE_COILS 0x0F
+#define MODBUS_FC_WRITE_MULTIPLE_REGISTERS 0x10
+
+// max number of registers/coils of a single request
+#define MODBUS_MAX_READ_REGISTERS 125
+#define MODBUS_MAX_WRITE_REGISTERS 123
+#define MODBUS_MAX_READ_BITS 2000
+#define MODBUS_MAX_WRITE_BITS 1968
+
+#ifdef _WIN32
+  #define MODBUS_INVALID_SOCKET INVALID_SOCKET
+#else
+  #define MODBUS_INVALID_SOCKET -1
+#endif
+
+static void close_socket(ModbusSocket socket)
+{
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+static std::string socket_error_string()
+{
+#ifdef _WIN32
+    return "error " + std::to_string(WSAGetLastError());
+#else
+    return std::strerror(errno);
+#endif
+}
+
+static void push_uint16(std::vector<uint8_t>& buffer, uint16_t value)
+{
+    buffer.push_back(static_cast<uint8_t>(value >> 8));
+    buffer.push_back(static_cast<uint8_t>(value & 0xFF));
+}
+
+static uint16_t get_uint16(const uint8_t *buffer)
+{
+    return static_cast<uint16_t>((buffer[0] << 8) | buffer[1]);
+}
+
+static std::string exception_to_string(uint8_t exception_code)
+{
+    switch (exception_code) {
+    case 0x01:
+        return "Illegal function";
+    case 0x02:
+        return "Illegal data address";
+    case 0x03:
+        return "Illegal data value";
+    case 0x04:
+        return "Slave device or server failure";
+    case 0x05:
+        return "Acknowledge";
+    case 0x06:
+        return "Slave device or server is busy";
+    case 0x08:
+        return "Memory parity error";
+    case 0x0A:
+        return "Gateway path unavailable";
+    case 0x0B:
+        return "Target device failed to respond";
+    default:
+        return "Modbus exception " + std::to_string(exception_code);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+////////////////////////// ModbusTcpPipeline class ////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+ModbusTcpPipeline::SocketLibrary::SocketLibrary()
+{
+#ifdef _WIN32
+    WSADATA wsa_data;
+    int result = WSAStartup(MAKEWORD(2, 2), &wsa_data);
+    if (result != 0) {
+        throw std::runtime_error(
+                "Error initializing Winsock: error " + std::to_string(result));
+    }
+#endif
+}
+
+ModbusTcpPipeline::SocketLibrary::~SocketLibrary()
+{
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+ModbusTcpPipeline::ModbusTcpPipeline(
+        const std::string& ip,
+        uint16_t port,
+        size_t max_in_flight)
+        : ip_address_(ip),
+          port_number_(port),
+          max_in_flight_(max_in_flight),
+          socket_(MODBUS_INVALID_SOCKET)
+{
+    if (max_in_flight_ < 1) {
+        std::string error(
+                "Error: the max number of requests in flight to Modbus "
+                "server <" + ip + ":" + std::to_string(port)
+                + "> must be at least 1.");
+        throw std::runtime_error(error);
+    }
+
+    socket_ = open_socket();
+    is_receiving_ = true;
+    receive_thread_ = std::thread(&ModbusTcpPipeline::receive_responses, this);
+}
+
+ModbusTcpPipeline::~ModbusTcpPipeline()
+{
+    // there is no socket if the last reconnection failed
+    if (socket_ != MODBUS_INVALID_SOCKET) {
+        // unblock the receiving thread
+#ifdef _WIN32
+        shutdown(socket_, SD_BOTH);
+#else
+        shutdown(socket_, SHUT_RDWR);
+#endif
+    }
+    if (receive_thread_.joinable()) {
+        receive_thread_.join();
+    }
+    if (socket_ != MODBUS_INVALID_SOCKET) {
+        close_socket(socket_);
+    }
+}
+
+ModbusSocket ModbusTcpPipeline::open_socket()
+{
+    struct addrinfo hints;
+    struct addrinfo *addresses = nullptr;
+    ModbusSocket new_socket = MODBUS_INVALID_SOCKET;
+
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int result = getaddrinfo(
+            ip_address_.c_str(),
+            std::to_string(port_number_).c_str(),
+            &hints,
+            &addresses);
+    if (result != 0) {
+        std::string error(
+                "Error initializing Modbus <" + ip_address_ + ":"
+                + std::to_string(port_number_) + "> "
+                + gai_strerror(result));
+        throw std::runtime_error(error);
+    }
+
+    std::string error_string;
+    for (auto address = addresses; address != nullptr;
+         address = address->ai_next) {
+        new_socket = socket(
+                address->ai_family,
+                address->ai_socktype,
+                address->ai_protocol);
+        if (new_socket == MODBUS_INVALID_SOCKET) {
+            error_string = socket_error_string();
+            continue;
+        }
+        if (::connect(
+                    new_socket,
+                    address->ai_addr,
+                    static_cast<int>(address->ai_addrlen))
+                == 0) {
+            break;
+        }
+        error_string = socket_error_string();
+        close_socket(new_socket);
+        new_socket = MODBUS_INVALID_SOCKET;
+    }
+    freeaddrinfo(addresses);
+
+    if (new_socket == MODBUS_INVALID_SOCKET) {
+        std::string error(
+                "Error connecting to Modbus server <" + ip_address_ + ":"
+                + std::to_string(port_number_) + "> " + error_string);
+        throw std::runtime_error(error);
+    }
+
+    // requests are small and must not wait for the following ones
+    int no_delay = 1;
+    setsockopt(
+            new_socket,
+            IPPROTO_TCP,
+            TCP_NODELAY,
+            reinterpret_cast<const char *>(&no_delay),
+            sizeof(no_delay));
+
+    return new_socket;
+}
+
+bool ModbusTcpPipeline::reconnect(std::unique_lock<std::mutex>& lock)
+{
+    // the socket cannot be replaced while other transactions may be using
+    // it, nor while another thread is reconnecting
+    transactions_condition_.wait(lock, [&]() {
+        return connection_error_.empty()
+                || (!is_reconnecting_ && !is_receiving_
+                    && pending_transactions_.empty());
+    });
+    if (connection_error_.empty()) {
+        // another thread has reconnected
+        return true;
+    }
+
+    is_reconnecting_ = true;
+    lock.unlock();
+
+    // the receiving thread has failed, so it is about to finish
+    if (receive_thread_.joinable()) {
+        receive_thread_.join();
+    }
+    if (socket_ != MODBUS_INVALID_SOCKET) {
+        close_socket(socket_);
+        socket_ = MODBUS_INVALID_SOCKET;
+    }
+
+    ModbusSocket new_socket = MODBUS_INVALID_SOCKET;
+    std::string error;
+    try {
+        new_socket = open_socket();
+    } catch (const std::exception &ex) {
+        error = ex.what();
+    }
+
+    lock.lock();
+    is_reconnecting_ = false;
+    transactions_condition_.notify_all();
+    if (new_socket == MODBUS_INVALID_SOCKET) {
+        connection_error_ = error;
+        return false;
+    }
+
+    socket_ = new_socket;
+    connection_error_.clear();
+    is_receiving_ = true;
+    receive_thread_ = std::thread(&ModbusTcpPipeline::receive_responses, this);
+    return true;
+}
+
+std::vector<uint8_t> ModbusTcpPipeline::transaction(
+        uint8_t unit_id,
+        const std::vector<uint8_t>& request,
+        std::chrono::microseconds timeout)
+{
+    PendingTransaction pending;
+    std::vector<uint8_t> frame;
+    uint16_t transaction_id = 0;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        // Wait until there is room for another request in the connection.
+        // This doesn't need a timeout, since the requests in flight either
+        // get a response or time out.
+        transactions_condition_.wait(lock, [&]() {
+            return !connection_error_.empty()
+                    || pending_transactions_.size() < max_in_flight_;
+        });
+        if (!connection_error_.empty() && !reconnect(lock)) {
+            throw std::runtime_error(connection_error_);
+        }
+        // wait again if other transactions have taken the room meanwhile
+        transactions_condition_.wait(lock, [&]() {
+            return !connection_error_.empty()
+                    || pending_transactions_.size() < max_in_flight_;
+        });
+        if (!connection_error_.empty()) {
+            throw std::runtime_error(connection_error_);
+        }
+
+        // skip the identifiers of the transactions still in flight
+        do {
+            transaction_id = next_transaction_id_++;
+        } while (pending_transactions_.count(transaction_id) != 0);
+        pending.unit_id = unit_id;
+        pending_transactions_[transaction_id] = &pending;
+    }
+
+    // MBAP header: transaction id, protocol id, length and unit id
+    frame.reserve(MODBUS_MBAP_HEADER_LENGTH + request.size());
+    push_uint16(frame, transaction_id);
+    push_uint16(frame, 0);
+    push_uint16(frame, static_cast<uint16_t>(request.size() + 1));
+    frame.push_back(unit_id);
+    frame.insert(frame.end(), request.begin(), request.end());
+
+    bool is_sent = true;
+    {
+        std::lock_guard<std::mutex> guard(send_mutex_);
+        size_t sent = 0;
+        while (sent < frame.size()) {
+#ifdef MSG_NOSIGNAL
+            int flags = MSG_NOSIGNAL;
+#else
+            int flags = 0;
+#endif
+            auto result = send(
+                    socket_,
+                    reinterpret_cast<const char *>(frame.data()) + sent,
+                    static_cast<int>(frame.size() - sent),
+                    flags);
+            if (result <= 0) {
+                is_sent = false;
+                break;
+            }
+            sent += result;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!is_sent) {
+        pending_transactions_.erase(transaction_id);
+        transactions_condition_.notify_all();
+        throw std::runtime_error(
+                "Error sending request: " + socket_error_string());
+    }
+
+    transactions_condition_.wait_for(lock, timeout, [&]() {
+        return pending.is_done;
+    });
+    // a late response is discarded by the receiving thread once the
+    // transaction is not pending
+    pending_transactions_.erase(transaction_id);
+    transactions_condition_.notify_all();
+
+    if (!pending.is_done) {
+        throw std::runtime_error("Connection timed out");
+    }
+    if (!pending.error.empty()) {
+        throw std::runtime_error(pending.error);
+    }
+    return pending.response;
+}
+
+bool ModbusTcpPipeline::receive(uint8_t *buffer, size_t size)
+{
+    size_t received = 0;
+
+    while (received < size) {
+        auto result = recv(
+                socket_,
+                reinterpret_cast<char *>(buffer) + received,
+                static_cast<int>(size - received),
+                0);
+        if (result <= 0) {
+            return false;
+        }
+        received += result;
+    }
+    return true;
+}
+
+void ModbusTcpPipeline::receive_responses()
+{
+    uint8_t header[MODBUS_MBAP_HEADER_LENGTH];
+    std::vector<uint8_t> response;
+
+    while (receive(header, MODBUS_MBAP_HEADER_LENGTH)) {
+        uint16_t transaction_id = get_uint16(header);
+        uint16_t length = get_uint16(header + 4);
+
+        // the length includes the unit identifier
+        if (get_uint16(header + 2) != 0 || length < 2
+                || length > MODBUS_MAX_PDU_LENGTH + 1) {
+            fail_transactions(
+                    "Error: invalid response from Modbus server <"
+                    + ip_address_ + ":" + std::to_string(port_number_) + ">");
+            return;
+        }
+
+        response.resize(length - 1);
+        if (!receive(response.data(), response.size())) {
+            break;
+        }
+
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto pending = pending_transactions_.find(transaction_id);
+        if (pending != pending_transactions_.end()) {
+            // the unit identifier is echoed by the server, a different one
+            // means that the response is not for this request
+            if (header[6] != pending->second->unit_id) {
+                pending->second->error =
+                        "Error: response from unit "
+                        + std::to_string(header[6]) + " to a request to unit "
+                        + std::to_string(pending->second->unit_id);
+            } else {
+                pending->second->response.swap(response);
+            }
+            pending->second->is_done = true;
+            transactions_condition_.notify_all();
+        }
+    }
+
+    fail_transactions(
+            "Error: connection to Modbus server <" + ip_address_ + ":"
+            + std::to_string(port_number_) + "> closed");
+}
+
+void ModbusTcpPipeline::fail_transactions(const std::string& error)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+
+    connection_error_ = error;
+    is_receiving_ = false;
+    for (auto& pending : pending_transactions_) {
+        pending.second->error = error;
+        pending.second->is_done = true;
+    }
+    transactions_condition_.notify_all();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/////////////////////// ModbusTcpPipelinedClient class ////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+const uint32_t ModbusTcpPipelinedClient::DEFAULT_RESPONSE_TIMEOUT_USEC;
+
+ModbusTcpPipelinedClient::ModbusTcpPipelinedClient(
+        std::shared_ptr<ModbusTcpPipeline> pipeline)
+        : pipeline_(pipeline),
+          max_in_flight_(pipeline->max_in_flight()),
+          slave_id_(MODBUS_TCP_UNIT_ID),
+          response_timeout_(DEFAULT_RESPONSE_TIMEOUT_USEC)
+{
+}
+
+ModbusTcpPipelinedClient::ModbusTcpPipelinedClient(
+        const std::string& ip,
+        uint16_t port,
+        size_t max_in_flight)
+        : max_in_flight_(max_in_flight),
+          slave_id_(MODBUS_TCP_UNIT_ID),
+          response_timeout_(DEFAULT_RESPONSE_TIMEOUT_USEC)
+{
+    connect(ip, port);
+}
+
+void ModbusTcpPipelinedClient::connect(const std::string& ip, uint16_t port)
+{
+    pipeline_ = std::make_shared<ModbusTcpPipeline>(ip, port, max_in_flight_);
+}
+
+void ModbusTcpPipelinedClient::disconnect()
+{
+    pipeline_.reset();
+}
+
+void ModbusTcpPipelinedClient::set_slave_id(uint8_t slave_id)
+{
+    slave_id_ = slave_id;
+}
+
+int ModbusTcpPipelinedClient::get_slave_id()
+{
+    return slave_id_;
+}
+
+void ModbusTcpPipelinedClient::set_response_timeout(
+        uint32_t sec,
+        uint32_t usec)
+{
+    response_timeout_ = std::chrono::seconds(sec)
+            + std::chrono::microseconds(usec);
+}
+
+std::vector<uint8_t> ModbusTcpPipelinedClient::transaction(
+        const std::vector<uint8_t>& request,
+        size_t response_size,
+        const std::string& operation)
+{
+    if (!pipeline_) {
+        throw std::runtime_error(
+                "Error " + operation + ": the client is not connected");
+    }
+
+    std::vector<uint8_t> response;
+    try {
+        response = pipeline_->transaction(
+                slave_id_,
+                request,
+                response_timeout_);
+    } catch (const std::exception &ex) {
+        throw std::runtime_error("Error " + operation + ": " + ex.what());
+    }
+
+    if (response.size() == 2 && response[0] == (request[0] | 0x80)) {
+        throw std::runtime_error(
+                "Error " + operation + ": "
+                + exception_to_string(response[1]));
+    }
+    if (response.size() != response_size || response[0] != request[0]) {
+        throw std::runtime_error(
+                "Error " + operation + ": Invalid data");
+    }
+    return response;
+}
+
+int ModbusTcpPipelinedClient::write_registers(
+        uint32_t address,
+        uint32_t register_count,
+        const std::vector<uint16_t>& registers)
+{
+    std::vector<uint8_t> request;
+
+    if (register_count < 1 || register_count > MODBUS_MAX_WRITE_REGISTERS) {
+        throw std::runtime_error(
+                "Error writing registers: Too many data");
+    }
+
+    // Differentiate when writing 1 ore more registers
+    if (register_count == 1) {
+        request.push_back(MODBUS_FC_WRITE_SINGLE_REGISTER);
+        push_uint16(request, static_cast<uint16_t>(address));
+        push_uint16(request, registers[0]);
+    } else {
+        request.push_back(MODBUS_FC_WRITE_MULTIPLE_REGISTERS);
+        push_uint16(request, static_cast<uint16_t>(address));
+        push_uint16(request, static_cast<uint16_t>(register_count));
+        request.push_back(static_cast<uint8_t>(register_count * 2));
+        for (uint32_t i = 0; i < register_count; ++i) {
+            push_uint16(request, registers[i]);
+        }
+    }
+
+    // both responses have the function code, address and value/count
+    auto response = transaction(request, 5, "writing registers");
+    return register_count == 1 ? 1 : get_uint16(response.data() + 3);
+}
+
+int ModbusTcpPipelinedClient::read_registers(
+        std::vector<uint16_t>& registers,
+        uint32_t address,
+        uint32_t register_count,
+        bool read_input_registers)
+{
+    std::vector<uint8_t> request;
+
+    if (register_count < 1 || register_count > MODBUS_MAX_READ_REGISTERS) {
+        throw std::runtime_error(
+                "Error reading registers: Too many data");
+    }
+
+    // Differentiate when reading input registers or holding registers
+    request.push_back(
+            read_input_registers ? MODBUS_FC_READ_INPUT_REGISTERS
+                                 : MODBUS_FC_READ_HOLDING_REGISTERS);
+    push_uint16(request, static_cast<uint16_t>(address));
+    push_uint16(request, static_cast<uint16_t>(register_count));
+
+    // function code, byte count and the registers
+    auto response = transaction(
+            request,
+            2 + register_count * 2,
+            "reading registers");
+    for (uint32_t i = 0; i < register_count; ++i) {
+        registers[i] = get_uint16(response.data() + 2 + i * 2);
+    }
+    return register_count;
+}
+
+int ModbusTcpPipelinedClient::write_coils(
+        uint32_t address,
+        uint32_t register_count,
+        const std::vector<uint8_t>& values)
+{
+    std::vector<uint8_t> request;
+
+    if (register_count < 1 || register_count > MODBUS_MAX_WRITE_BITS) {
+        throw std::runtime_error("Error writing coils: Too many data");
+    }
+
+    // Differentiate when writing 1 or more coils
+    if (register_count == 1) {
+        request.push_back(MODBUS_FC_WRITE_SINGLE_COIL);
+        push_uint16(request, static_cast<uint16_t>(address));
+        push_uint16(request, values[0] ? 0xFF00 : 0x0000);
+    } else {
+        uint32_t byte_count = (register_count + 7) / 8;
+        request.push_back(MODBUS_FC_WRITE_MULTIPLE_COILS);
+        push_uint16(request, static_cast<uint16_t>(address));
+        push_uint16(request, static_cast<uint16_t>(register_count));
+        request.push_back(static_cast<uint8_t>(byte_count));
+        // coils are packed in bytes, the first one in the lowest bit
+        request.resize(request.size() + byte_count, 0);
+        uint8_t *coils = request.data() + request.size() - byte_count;
+        for (uint32_t i = 0; i < register_count; ++i) {
+            if (values[i]) {
+                coils[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+            }
+        }
+    }
+
+    // both responses have the function code, address and value/count
+    auto response = transaction(request, 5, "writing coils");
+    return register_count == 1 ? 1 : get_uint16(response.data() + 3);
+}
+
+int ModbusTcpPipelinedClient::read_coils(
+        std::vector<uint8_t>& values,
+        uint32_t address,
+        uint32_t register_count,
+        bool read_discrete_inputs)
+{
+    std::vector<uint8_t> request;
+
+    if (register_count < 1 || register_count > MODBUS_MAX_READ_BITS) {
+        throw std::runtime_error("Error reading coils: Too many data");
+    }
+
+    // Differentiate when reading discrete inputs or coils
+    request.push_back(
+            read_discrete_inputs ? MODBUS_FC_READ_DISCRETE_INPUTS
+                                 : MODBUS_FC_READ_COILS);
+    push_uint16(request, static_cast<uint16_t>(address));
+    push_uint16(request, static_cast<uint16_t>(register_count));
+
+    // function code, byte count and the coils packed in bytes
+    auto response = transaction(
+            request,
+            2 + (register_count + 7) / 8,
+            "reading coils");
+    for (uint32_t i = 0; i < register_count; ++i) {
+        values[i] = (response[2 + i / 8] >> (i % 8)) & 0x01;
+    }
+    return register_count;
+}
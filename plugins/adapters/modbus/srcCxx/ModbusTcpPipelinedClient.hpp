@@ -0,0 +1,273 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+  #include <winsock2.h>
+#endif
+
+#include "ModbusClient.hpp"
+
+namespace rti { namespace adapter { namespace modbus {
+
+#ifdef _WIN32
+typedef SOCKET ModbusSocket;
+#else
+typedef int ModbusSocket;
+#endif
+
+/**
+ * @class ModbusTcpPipeline
+ *
+ * @brief A Modbus TCP connection that allows several outstanding
+ * transactions.
+ *
+ * Requests are sent as soon as there is room for them in the connection
+ * (max_in_flight()), without waiting for the responses of the previous
+ * ones. A receiving thread matches every response with its request by the
+ * transaction identifier of the MBAP header.
+ *
+ * If the connection fails, the transactions in flight fail and the next
+ * transaction connects again to the modbus server.
+ */
+class ModbusTcpPipeline {
+public:
+    /**
+     * @brief Parametrized constructor
+     * @details constructor that connects to a modbus server and starts the
+     * thread that receives the responses. Connection errors are reported
+     * here, so the pool doesn't add a connection that doesn't work.
+     * @param ip IP of the modbus server
+     * @param port port of the modbus server
+     * @param max_in_flight max number of requests waiting for a response
+     */
+    ModbusTcpPipeline(
+            const std::string& ip,
+            uint16_t port,
+            size_t max_in_flight);
+
+    /**
+     * @brief Closes the connection. The transactions that are waiting for a
+     * response fail.
+     */
+    ~ModbusTcpPipeline();
+
+    /**
+     * @brief Sends a request and waits for its response.
+     * @param unit_id the unit identifier (slave ID) of the request
+     * @param request the PDU of the request: function code and data
+     * @param timeout max time to wait for the response
+     * @return The PDU of the response. Exception responses are returned too.
+     * Throws an exception if the connection fails, there is no response or
+     * the response is from another unit.
+     */
+    std::vector<uint8_t> transaction(
+            uint8_t unit_id,
+            const std::vector<uint8_t>& request,
+            std::chrono::microseconds timeout);
+
+    // public getters
+    inline size_t const max_in_flight() const
+    {
+        return max_in_flight_;
+    }
+
+private:
+    // Initializes the sockets library on Windows while the pipeline exists
+    struct SocketLibrary {
+        SocketLibrary();
+        ~SocketLibrary();
+    };
+
+    // A request that is waiting for its response
+    struct PendingTransaction {
+        uint8_t unit_id = 0;
+        bool is_done = false;
+        std::string error;
+        std::vector<uint8_t> response;
+    };
+
+    /**
+     * @brief Opens a TCP connection to the modbus server
+     * @return The socket of the connection. Throws an exception if it
+     * cannot connect.
+     */
+    ModbusSocket open_socket();
+
+    /**
+     * @brief Connects again to the modbus server after the connection has
+     * failed, once the transactions that were in flight have finished.
+     * Only one thread reconnects, the rest of them wait for it.
+     * @param lock the lock of mutex_, held by the caller
+     * @return Whether the connection works. If it cannot connect, the
+     * next transaction tries again.
+     */
+    bool reconnect(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * @brief Function executed by the receiving thread. It receives the
+     * responses and hands them to the transactions that are waiting for
+     * them, until the connection is closed.
+     */
+    void receive_responses();
+
+    /**
+     * @brief Receives exactly size bytes from the socket
+     * @return false if the connection has been closed or failed
+     */
+    bool receive(uint8_t *buffer, size_t size);
+
+    /**
+     * @brief Makes all the pending transactions fail, and stops the
+     * receiving thread. The following transactions reconnect.
+     * @param error the reason of the failure
+     */
+    void fail_transactions(const std::string& error);
+
+private:
+    SocketLibrary socket_library_;
+    std::string ip_address_;
+    uint16_t port_number_;
+    size_t max_in_flight_;
+    ModbusSocket socket_;
+    // whether the receiving thread is running, false once it has failed
+    bool is_receiving_ = false;
+    // whether a thread is reconnecting
+    bool is_reconnecting_ = false;
+    uint16_t next_transaction_id_ = 0;
+    std::map<uint16_t, PendingTransaction *> pending_transactions_;
+    // error of the connection, empty while it works
+    std::string connection_error_;
+    std::mutex mutex_;
+    std::mutex send_mutex_;
+    std::condition_variable transactions_condition_;
+    std::thread receive_thread_;
+};
+
+/**
+ * @class ModbusTcpPipelinedClient
+ *
+ * @brief implementation of the ModbusClient over a ModbusTcpPipeline.
+ *
+ * Several clients may share the same ModbusTcpPipeline, so their
+ * operations are in flight at the same time on the same connection. Every
+ * client keeps its own slave ID and response timeout, and must only be used
+ * by one thread at a time, like LibModbusClient.
+ */
+class ModbusTcpPipelinedClient : public ModbusClient {
+public:
+    // same default as libmodbus
+    static const uint32_t DEFAULT_RESPONSE_TIMEOUT_USEC = 500000;
+
+    /**
+     * @brief Parametrized constructor
+     * @details constructor that creates a client on an existing connection
+     * @param pipeline the connection to the modbus server
+     */
+    ModbusTcpPipelinedClient(std::shared_ptr<ModbusTcpPipeline> pipeline);
+
+    /**
+     * @brief Parametrized constructor
+     * @details constructor that connects to a modbus server
+     *
+     * @see connect
+     */
+    ModbusTcpPipelinedClient(
+            const std::string& ip,
+            uint16_t port,
+            size_t max_in_flight);
+
+    /**
+     * @brief Creates a new ModbusTcpPipeline and connects to it
+     * @param ip IP of the modbus device
+     * @param port Port of the modbus device to connect
+     *
+     * @see disconnect
+     */
+    void connect(const std::string& ip, uint16_t port);
+
+    /**
+     * @brief Stops using the ModbusTcpPipeline. It is closed once none of
+     * the clients that share it use it.
+     *
+     * @see connect
+     */
+    void disconnect();
+
+    void set_slave_id(uint8_t slave_id);
+
+    int get_slave_id();
+
+    int write_registers(
+            uint32_t address,
+            uint32_t register_count,
+            const std::vector<uint16_t>& registers);
+
+    int read_registers(
+            std::vector<uint16_t>& registers,
+            uint32_t address,
+            uint32_t register_count,
+            bool read_input_registers);
+
+    int write_coils(
+            uint32_t address,
+            uint32_t register_count,
+            const std::vector<uint8_t>& values);
+
+    int read_coils(
+            std::vector<uint8_t>& values,
+            uint32_t address,
+            uint32_t register_count,
+            bool read_discrete_inputs);
+
+    void set_response_timeout(uint32_t sec, uint32_t usec);
+
+    // public getters
+    inline std::shared_ptr<ModbusTcpPipeline> const pipeline() const
+    {
+        return pipeline_;
+    }
+
+private:
+    /**
+     * @brief Performs a transaction and checks that the response has the
+     * function code of the request and the expected size.
+     * @param request the PDU of the request
+     * @param response_size the size of a valid response PDU
+     * @param operation description of the operation for error messages
+     */
+    std::vector<uint8_t> transaction(
+            const std::vector<uint8_t>& request,
+            size_t response_size,
+            const std::string& operation);
+
+private:
+    std::shared_ptr<ModbusTcpPipeline> pipeline_;
+    size_t max_in_flight_;
+    uint8_t slave_id_;
+    std::chrono::microseconds response_timeout_;
+};
+
+}}}  // namespace rti::adapter::modbus
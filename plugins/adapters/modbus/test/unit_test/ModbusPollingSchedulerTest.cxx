@@ -0,0 +1,230 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "ModbusPollingScheduler.hpp"
+#include "UtilsUnitTest.h"
+
+using namespace rti::adapter::modbus;
+using namespace rti::utils::test;
+
+static void sleep_msecs(int msecs)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(msecs));
+}
+
+static bool test_tasks_run_every_period()
+{
+    // a single thread, so the tasks run one after another by deadline
+    ModbusPollingScheduler scheduler(1);
+    std::atomic<int> fast_runs(0);
+    std::atomic<int> slow_runs(0);
+
+    auto fast_id = scheduler.schedule(
+            std::chrono::milliseconds(20),
+            [&fast_runs]() { ++fast_runs; });
+    auto slow_id = scheduler.schedule(
+            std::chrono::milliseconds(100),
+            [&slow_runs]() { ++slow_runs; });
+    sleep_msecs(250);
+    scheduler.cancel(fast_id);
+    scheduler.cancel(slow_id);
+
+    // the first run is immediate, allow some slack for loaded machines
+    RTI_UTILS_TEST_CHECK(fast_runs >= 6 && fast_runs <= 14);
+    RTI_UTILS_TEST_CHECK(slow_runs >= 2 && slow_runs <= 4);
+    return true;
+}
+
+static bool test_missed_runs_are_skipped()
+{
+    ModbusPollingScheduler scheduler(1);
+    std::atomic<int> runs(0);
+
+    // every run takes longer than three periods
+    auto id = scheduler.schedule(
+            std::chrono::milliseconds(10),
+            [&runs]() {
+                ++runs;
+                sleep_msecs(35);
+            });
+    sleep_msecs(150);
+    scheduler.cancel(id);
+
+    RTI_UTILS_TEST_CHECK(runs >= 2 && runs <= 6);
+    return true;
+}
+
+static bool test_cancel_waits_for_running_task()
+{
+    ModbusPollingScheduler scheduler(2);
+    std::atomic<bool> is_running(false);
+    std::atomic<int> runs(0);
+
+    auto id = scheduler.schedule(
+            std::chrono::milliseconds(5),
+            [&is_running, &runs]() {
+                is_running = true;
+                sleep_msecs(30);
+                ++runs;
+                is_running = false;
+            });
+    while (!is_running) {
+        sleep_msecs(1);
+    }
+    scheduler.cancel(id);
+    RTI_UTILS_TEST_CHECK(!is_running);
+
+    // the task isn't called after cancel() returns
+    int runs_after_cancel = runs;
+    sleep_msecs(50);
+    RTI_UTILS_TEST_CHECK(runs == runs_after_cancel);
+    return true;
+}
+
+static bool test_task_cancels_itself()
+{
+    ModbusPollingScheduler scheduler(2);
+    std::atomic<int> runs(0);
+    std::atomic<ModbusPollingScheduler::TaskId> id(0);
+
+    id = scheduler.schedule(
+            std::chrono::milliseconds(5),
+            [&scheduler, &runs, &id]() {
+                // the id is set once schedule() returns
+                while (id == 0) {
+                    std::this_thread::yield();
+                }
+                if (++runs == 3) {
+                    scheduler.cancel(id);
+                }
+            });
+    sleep_msecs(100);
+
+    RTI_UTILS_TEST_CHECK(runs == 3);
+    return true;
+}
+
+static bool test_task_does_not_overlap_itself()
+{
+    ModbusPollingScheduler scheduler(4);
+    std::atomic<int> concurrent_runs(0);
+    std::atomic<int> max_concurrent_runs(0);
+
+    // the task takes longer than its period, and there are idle threads
+    auto id = scheduler.schedule(
+            std::chrono::milliseconds(1),
+            [&concurrent_runs, &max_concurrent_runs]() {
+                int current = ++concurrent_runs;
+                if (current > max_concurrent_runs) {
+                    max_concurrent_runs = current;
+                }
+                sleep_msecs(10);
+                --concurrent_runs;
+            });
+    sleep_msecs(100);
+    scheduler.cancel(id);
+
+    RTI_UTILS_TEST_CHECK(max_concurrent_runs == 1);
+    return true;
+}
+
+static bool test_tasks_run_concurrently()
+{
+    ModbusPollingScheduler scheduler(2);
+    std::atomic<int> concurrent_runs(0);
+    std::atomic<int> max_concurrent_runs(0);
+
+    auto task = [&concurrent_runs, &max_concurrent_runs]() {
+        int current = ++concurrent_runs;
+        if (current > max_concurrent_runs) {
+            max_concurrent_runs = current;
+        }
+        sleep_msecs(20);
+        --concurrent_runs;
+    };
+    auto first_id = scheduler.schedule(std::chrono::milliseconds(5), task);
+    auto second_id = scheduler.schedule(std::chrono::milliseconds(5), task);
+    sleep_msecs(100);
+    scheduler.cancel(first_id);
+    scheduler.cancel(second_id);
+
+    RTI_UTILS_TEST_CHECK(max_concurrent_runs == 2);
+    return true;
+}
+
+static bool test_run_concurrently_calls_every_index()
+{
+    ModbusPollingScheduler scheduler(3);
+    const size_t count = 100;
+    std::vector<std::atomic<int>> calls(count);
+
+    for (auto& call : calls) {
+        call = 0;
+    }
+    scheduler.run_concurrently(count, [&calls](size_t i) { ++calls[i]; });
+
+    for (auto& call : calls) {
+        RTI_UTILS_TEST_CHECK(call == 1);
+    }
+    return true;
+}
+
+static bool test_run_concurrently_from_task()
+{
+    // the only thread of the scheduler runs the task, so the calling thread
+    // has to make all the calls
+    ModbusPollingScheduler scheduler(1);
+    std::atomic<int> calls(0);
+    std::atomic<bool> is_done(false);
+
+    auto id = scheduler.schedule(
+            std::chrono::milliseconds(1000),
+            [&scheduler, &calls, &is_done]() {
+                scheduler.run_concurrently(
+                        10,
+                        [&calls](size_t) { ++calls; });
+                is_done = true;
+            });
+    for (int i = 0; i < 1000 && !is_done; ++i) {
+        sleep_msecs(1);
+    }
+    scheduler.cancel(id);
+
+    RTI_UTILS_TEST_CHECK(is_done);
+    RTI_UTILS_TEST_CHECK(calls == 10);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    return run_unit_tests({
+            { "tasks run every period", test_tasks_run_every_period },
+            { "missed runs are skipped", test_missed_runs_are_skipped },
+            { "cancel waits for running task",
+              test_cancel_waits_for_running_task },
+            { "task cancels itself", test_task_cancels_itself },
+            { "task does not overlap itself",
+              test_task_does_not_overlap_itself },
+            { "tasks run concurrently", test_tasks_run_concurrently },
+            { "run_concurrently calls every index",
+              test_run_concurrently_calls_every_index },
+            { "run_concurrently from task", test_run_concurrently_from_task },
+    });
+}
@@ -0,0 +1,175 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+
+#include "ModbusReadPlan.hpp"
+#include "UtilsUnitTest.h"
+
+using namespace rti::adapter::modbus;
+using namespace rti::utils::test;
+
+static ModbusReadPlan create_plan(const std::string& json)
+{
+    ModbusAdapterConfiguration config(RoutingServiceEntityType::stream_reader);
+    config.parse_json_config_string(json);
+    return ModbusReadPlan(config);
+}
+
+static bool test_adjacent_elements_are_merged()
+{
+    // INT16 uses register 0, INT32 uses registers 1 and 2
+    auto plan = create_plan(R"([
+        {"field": "a", "modbus_register_address": 0,
+         "modbus_datatype": "HOLDING_REGISTER_INT16"},
+        {"field": "b", "modbus_register_address": 1,
+         "modbus_datatype": "HOLDING_REGISTER_INT32"}
+    ])");
+
+    RTI_UTILS_TEST_CHECK(plan.requests().size() == 1);
+    auto& request = plan.requests()[0];
+    RTI_UTILS_TEST_CHECK(
+            request.function == ModbusReadFunction::read_holding_registers);
+    RTI_UTILS_TEST_CHECK(request.address == 0);
+    RTI_UTILS_TEST_CHECK(request.count == 3);
+    RTI_UTILS_TEST_CHECK((request.elements == std::vector<size_t> { 0, 1 }));
+    return true;
+}
+
+static bool test_overlapping_elements_are_merged()
+{
+    // the INT16 reads the second register of the INT32. The elements are
+    // not sorted by address in the configuration.
+    auto plan = create_plan(R"([
+        {"field": "a", "modbus_register_address": 11,
+         "modbus_datatype": "HOLDING_REGISTER_INT16"},
+        {"field": "b", "modbus_register_address": 10,
+         "modbus_datatype": "HOLDING_REGISTER_INT32"},
+        {"field": "c", "modbus_register_address": 10,
+         "modbus_datatype": "HOLDING_REGISTER_INT16"}
+    ])");
+
+    RTI_UTILS_TEST_CHECK(plan.requests().size() == 1);
+    auto& request = plan.requests()[0];
+    RTI_UTILS_TEST_CHECK(request.address == 10);
+    RTI_UTILS_TEST_CHECK(request.count == 2);
+    RTI_UTILS_TEST_CHECK((request.elements == std::vector<size_t> { 1, 2, 0 }));
+    return true;
+}
+
+static bool test_gaps_are_not_merged()
+{
+    auto plan = create_plan(R"([
+        {"field": "a", "modbus_register_address": 20,
+         "modbus_datatype": "HOLDING_REGISTER_INT16"},
+        {"field": "b", "modbus_register_address": 22,
+         "modbus_datatype": "HOLDING_REGISTER_INT16"}
+    ])");
+
+    RTI_UTILS_TEST_CHECK(plan.requests().size() == 2);
+    RTI_UTILS_TEST_CHECK(plan.requests()[0].address == 20);
+    RTI_UTILS_TEST_CHECK(plan.requests()[0].count == 1);
+    RTI_UTILS_TEST_CHECK(plan.requests()[1].address == 22);
+    RTI_UTILS_TEST_CHECK(plan.requests()[1].count == 1);
+    return true;
+}
+
+static bool test_different_slaves_and_functions_are_not_merged()
+{
+    auto plan = create_plan(R"([
+        {"field": "a", "modbus_register_address": 0,
+         "modbus_datatype": "HOLDING_REGISTER_INT16",
+         "modbus_slave_device_id": 2},
+        {"field": "b", "modbus_register_address": 1,
+         "modbus_datatype": "HOLDING_REGISTER_INT16",
+         "modbus_slave_device_id": 1},
+        {"field": "c", "modbus_register_address": 1,
+         "modbus_datatype": "INPUT_REGISTER_INT16",
+         "modbus_slave_device_id": 1},
+        {"field": "d", "modbus_register_address": 0,
+         "modbus_datatype": "COIL_BOOLEAN",
+         "modbus_slave_device_id": 1}
+    ])");
+
+    // sorted by slave ID, function and address
+    RTI_UTILS_TEST_CHECK(plan.requests().size() == 4);
+    RTI_UTILS_TEST_CHECK(plan.requests()[0].slave_id == 1);
+    RTI_UTILS_TEST_CHECK(
+            plan.requests()[0].function == ModbusReadFunction::read_coils);
+    RTI_UTILS_TEST_CHECK(plan.requests()[1].slave_id == 1);
+    RTI_UTILS_TEST_CHECK(
+            plan.requests()[1].function
+            == ModbusReadFunction::read_holding_registers);
+    RTI_UTILS_TEST_CHECK(plan.requests()[2].slave_id == 1);
+    RTI_UTILS_TEST_CHECK(
+            plan.requests()[2].function
+            == ModbusReadFunction::read_input_registers);
+    RTI_UTILS_TEST_CHECK(plan.requests()[3].slave_id == 2);
+    return true;
+}
+
+static bool test_max_request_size_is_not_exceeded()
+{
+    // an array that fills a whole request, followed by an adjacent element
+    auto plan = create_plan(R"([
+        {"field": "a", "modbus_register_address": 0,
+         "modbus_datatype": "HOLDING_REGISTER_INT16",
+         "modbus_register_count": 125},
+        {"field": "b", "modbus_register_address": 125,
+         "modbus_datatype": "HOLDING_REGISTER_INT16"}
+    ])");
+
+    RTI_UTILS_TEST_CHECK(plan.requests().size() == 2);
+    RTI_UTILS_TEST_CHECK(
+            plan.requests()[0].count == ModbusReadPlan::MAX_READ_REGISTERS);
+    RTI_UTILS_TEST_CHECK(plan.requests()[1].address == 125);
+    return true;
+}
+
+static bool test_constant_values_are_not_read()
+{
+    auto plan = create_plan(R"([
+        {"field": "a", "value": 5},
+        {"field": "b", "modbus_register_address": 3,
+         "modbus_datatype": "DISCRETE_INPUT_BOOLEAN"},
+        {"field": "c", "modbus_register_address": 4,
+         "modbus_datatype": "DISCRETE_INPUT_BOOLEAN"}
+    ])");
+
+    RTI_UTILS_TEST_CHECK(plan.requests().size() == 1);
+    auto& request = plan.requests()[0];
+    RTI_UTILS_TEST_CHECK(
+            request.function == ModbusReadFunction::read_discrete_inputs);
+    RTI_UTILS_TEST_CHECK(request.address == 3);
+    RTI_UTILS_TEST_CHECK(request.count == 2);
+    RTI_UTILS_TEST_CHECK((request.elements == std::vector<size_t> { 1, 2 }));
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    return run_unit_tests({
+            { "adjacent elements are merged",
+              test_adjacent_elements_are_merged },
+            { "overlapping elements are merged",
+              test_overlapping_elements_are_merged },
+            { "gaps are not merged", test_gaps_are_not_merged },
+            { "different slaves and functions are not merged",
+              test_different_slaves_and_functions_are_not_merged },
+            { "max request size is not exceeded",
+              test_max_request_size_is_not_exceeded },
+            { "constant values are not read",
+              test_constant_values_are_not_read },
+    });
+}
@@ -0,0 +1,524 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "ModbusTcpPipelinedClient.hpp"
+#include "UtilsUnitTest.h"
+
+using namespace rti::adapter::modbus;
+using namespace rti::utils::test;
+
+#define LOCALHOST "127.0.0.1"
+
+static void sleep_msecs(int msecs)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(msecs));
+}
+
+static uint16_t get_uint16(const uint8_t *buffer)
+{
+    return static_cast<uint16_t>((buffer[0] << 8) | buffer[1]);
+}
+
+static void push_uint16(std::vector<uint8_t>& buffer, uint16_t value)
+{
+    buffer.push_back(static_cast<uint8_t>(value >> 8));
+    buffer.push_back(static_cast<uint8_t>(value & 0xFF));
+}
+
+/**
+ * @brief Creates a Modbus TCP frame: MBAP header followed by the PDU
+ */
+static std::vector<uint8_t> mbap_frame(
+        uint16_t transaction_id,
+        uint16_t protocol_id,
+        uint8_t unit_id,
+        const std::vector<uint8_t>& pdu)
+{
+    std::vector<uint8_t> frame;
+
+    push_uint16(frame, transaction_id);
+    push_uint16(frame, protocol_id);
+    push_uint16(frame, static_cast<uint16_t>(pdu.size() + 1));
+    frame.push_back(unit_id);
+    frame.insert(frame.end(), pdu.begin(), pdu.end());
+    return frame;
+}
+
+/**
+ * @brief Creates the response PDU of a read holding/input registers
+ * request. Every register has the value of its address plus offset.
+ */
+static std::vector<uint8_t> read_response(
+        const std::vector<uint8_t>& request,
+        uint16_t offset = 0)
+{
+    uint16_t address = get_uint16(request.data() + 1);
+    uint16_t count = get_uint16(request.data() + 3);
+    std::vector<uint8_t> response;
+
+    response.push_back(request[0]);
+    response.push_back(static_cast<uint8_t>(count * 2));
+    for (uint16_t i = 0; i < count; ++i) {
+        push_uint16(response, static_cast<uint16_t>(address + i + offset));
+    }
+    return response;
+}
+
+// A request received by the FakeModbusServer
+struct FakeRequest {
+    uint16_t transaction_id = 0;
+    uint8_t unit_id = 0;
+    std::vector<uint8_t> pdu;
+};
+
+/**
+ * @class FakeConnection
+ *
+ * @brief A connection accepted by the FakeModbusServer. It is closed when
+ * destroyed.
+ */
+class FakeConnection {
+public:
+    explicit FakeConnection(int socket) : socket_(socket)
+    {
+    }
+
+    ~FakeConnection()
+    {
+        close(socket_);
+    }
+
+    /**
+     * @brief Receives a request and checks its MBAP header
+     * @return false if the connection is closed or the header is invalid
+     */
+    bool receive_request(FakeRequest& request)
+    {
+        uint8_t header[7];
+
+        if (!receive(header, sizeof(header))) {
+            return false;
+        }
+        uint16_t length = get_uint16(header + 4);
+        if (get_uint16(header + 2) != 0 || length < 2) {
+            return false;
+        }
+        request.transaction_id = get_uint16(header);
+        request.unit_id = header[6];
+        request.pdu.resize(length - 1);
+        return receive(request.pdu.data(), request.pdu.size());
+    }
+
+    /**
+     * @brief Sends the response to a request
+     * @param in_fragments whether the frame is sent one byte at a time
+     */
+    void send_response(
+            uint16_t transaction_id,
+            uint8_t unit_id,
+            const std::vector<uint8_t>& pdu,
+            bool in_fragments = false)
+    {
+        auto frame = mbap_frame(transaction_id, 0, unit_id, pdu);
+
+        if (!in_fragments) {
+            send_bytes(frame);
+            return;
+        }
+        for (auto byte : frame) {
+            send_bytes(std::vector<uint8_t>(1, byte));
+            sleep_msecs(1);
+        }
+    }
+
+    void send_bytes(const std::vector<uint8_t>& bytes)
+    {
+        send(socket_, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+    }
+
+private:
+    bool receive(uint8_t *buffer, size_t size)
+    {
+        size_t received = 0;
+
+        while (received < size) {
+            auto result = recv(socket_, buffer + received, size - received, 0);
+            if (result <= 0) {
+                return false;
+            }
+            received += result;
+        }
+        return true;
+    }
+
+private:
+    int socket_;
+};
+
+/**
+ * @brief Responds to the read requests of a connection until it is closed
+ */
+static void serve_requests(FakeConnection& connection)
+{
+    FakeRequest request;
+
+    while (connection.receive_request(request)) {
+        connection.send_response(
+                request.transaction_id,
+                request.unit_id,
+                read_response(request.pdu));
+    }
+}
+
+/**
+ * @class FakeModbusServer
+ *
+ * @brief Modbus TCP server that listens on a free port of localhost. Every
+ * connection is handled by the same function, one after another, and is
+ * closed once the function returns.
+ */
+class FakeModbusServer {
+public:
+    // the index of the connection starts at 0 and increases on reconnection
+    typedef std::function<void(FakeConnection&, int)> Handler;
+
+    explicit FakeModbusServer(Handler handler) : handler_(handler)
+    {
+        struct sockaddr_in address;
+        socklen_t address_length = sizeof(address);
+
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        listen_socket_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_socket_ < 0
+                || bind(listen_socket_,
+                        reinterpret_cast<struct sockaddr *>(&address),
+                        sizeof(address))
+                        != 0
+                || listen(listen_socket_, 4) != 0
+                || getsockname(
+                           listen_socket_,
+                           reinterpret_cast<struct sockaddr *>(&address),
+                           &address_length)
+                        != 0) {
+            throw std::runtime_error("Error creating the fake server");
+        }
+        port_ = ntohs(address.sin_port);
+
+        thread_ = std::thread([this]() {
+            for (int i = 0;; ++i) {
+                int connection_socket = accept(listen_socket_, nullptr, 0);
+                if (connection_socket < 0) {
+                    return;
+                }
+                FakeConnection connection(connection_socket);
+                handler_(connection, i);
+            }
+        });
+    }
+
+    ~FakeModbusServer()
+    {
+        // unblock accept()
+        shutdown(listen_socket_, SHUT_RDWR);
+        thread_.join();
+        close(listen_socket_);
+    }
+
+    inline uint16_t port() const
+    {
+        return port_;
+    }
+
+private:
+    Handler handler_;
+    int listen_socket_;
+    uint16_t port_;
+    std::thread thread_;
+};
+
+/**
+ * @brief Reads a holding register, returns -1 if the read fails
+ */
+static int read_register(ModbusTcpPipelinedClient& client, uint32_t address)
+{
+    std::vector<uint16_t> registers(1);
+
+    try {
+        client.read_registers(registers, address, 1, false);
+    } catch (const std::exception &) {
+        return -1;
+    }
+    return registers[0];
+}
+
+static bool test_request_frame()
+{
+    std::atomic<bool> is_valid(false);
+    FakeModbusServer server([&is_valid](FakeConnection& connection, int) {
+        FakeRequest request;
+        if (!connection.receive_request(request)) {
+            return;
+        }
+        // read 2 holding registers from address 0x0102
+        std::vector<uint8_t> expected_pdu { 0x03, 0x01, 0x02, 0x00, 0x02 };
+        is_valid = request.unit_id == 7 && request.pdu == expected_pdu;
+        connection.send_response(
+                request.transaction_id,
+                request.unit_id,
+                read_response(request.pdu));
+        serve_requests(connection);
+    });
+    ModbusTcpPipelinedClient client(LOCALHOST, server.port(), 1);
+    std::vector<uint16_t> registers(2);
+
+    client.set_slave_id(7);
+    client.read_registers(registers, 0x0102, 2, false);
+    RTI_UTILS_TEST_CHECK(is_valid);
+    RTI_UTILS_TEST_CHECK(registers[0] == 0x0102 && registers[1] == 0x0103);
+    return true;
+}
+
+static bool test_response_in_fragments()
+{
+    FakeModbusServer server([](FakeConnection& connection, int) {
+        FakeRequest request;
+        while (connection.receive_request(request)) {
+            connection.send_response(
+                    request.transaction_id,
+                    request.unit_id,
+                    read_response(request.pdu),
+                    true);
+        }
+    });
+    ModbusTcpPipelinedClient client(LOCALHOST, server.port(), 1);
+
+    RTI_UTILS_TEST_CHECK(read_register(client, 42) == 42);
+    RTI_UTILS_TEST_CHECK(read_register(client, 43) == 43);
+    return true;
+}
+
+static bool test_responses_matched_by_transaction_id()
+{
+    const int request_count = 4;
+    FakeModbusServer server([](FakeConnection& connection, int) {
+        // wait for all the requests and respond in the reverse order
+        std::vector<FakeRequest> requests(request_count);
+        for (auto& request : requests) {
+            if (!connection.receive_request(request)) {
+                return;
+            }
+        }
+        for (auto it = requests.rbegin(); it != requests.rend(); ++it) {
+            connection.send_response(
+                    it->transaction_id,
+                    it->unit_id,
+                    read_response(it->pdu));
+        }
+        serve_requests(connection);
+    });
+    auto pipeline = std::make_shared<ModbusTcpPipeline>(
+            LOCALHOST,
+            server.port(),
+            request_count);
+    std::vector<int> values(request_count, -1);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < request_count; ++i) {
+        threads.emplace_back([&pipeline, &values, i]() {
+            ModbusTcpPipelinedClient client(pipeline);
+            client.set_response_timeout(2, 0);
+            values[i] = read_register(client, 100 + i);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (int i = 0; i < request_count; ++i) {
+        RTI_UTILS_TEST_CHECK(values[i] == 100 + i);
+    }
+    return true;
+}
+
+static bool test_unknown_and_duplicate_ids_discarded()
+{
+    FakeModbusServer server([](FakeConnection& connection, int) {
+        FakeRequest first;
+        FakeRequest second;
+        if (!connection.receive_request(first)) {
+            return;
+        }
+        // a response to a transaction that doesn't exist, and the
+        // response of the first request
+        connection.send_response(
+                first.transaction_id + 100,
+                first.unit_id,
+                read_response(first.pdu, 1000));
+        connection.send_response(
+                first.transaction_id,
+                first.unit_id,
+                read_response(first.pdu));
+        if (!connection.receive_request(second)) {
+            return;
+        }
+        // the first response again, before the one of the second request
+        connection.send_response(
+                first.transaction_id,
+                first.unit_id,
+                read_response(first.pdu, 1000));
+        connection.send_response(
+                second.transaction_id,
+                second.unit_id,
+                read_response(second.pdu));
+        serve_requests(connection);
+    });
+    ModbusTcpPipelinedClient client(LOCALHOST, server.port(), 2);
+
+    RTI_UTILS_TEST_CHECK(read_register(client, 1) == 1);
+    RTI_UTILS_TEST_CHECK(read_register(client, 2) == 2);
+    RTI_UTILS_TEST_CHECK(read_register(client, 3) == 3);
+    return true;
+}
+
+static bool test_late_response_discarded()
+{
+    FakeModbusServer server([](FakeConnection& connection, int) {
+        FakeRequest request;
+        if (!connection.receive_request(request)) {
+            return;
+        }
+        // respond after the client has given up
+        sleep_msecs(200);
+        connection.send_response(
+                request.transaction_id,
+                request.unit_id,
+                read_response(request.pdu, 1000));
+        serve_requests(connection);
+    });
+    ModbusTcpPipelinedClient client(LOCALHOST, server.port(), 1);
+
+    client.set_response_timeout(0, 50000);
+    RTI_UTILS_TEST_CHECK(read_register(client, 5) == -1);
+    client.set_response_timeout(1, 0);
+    RTI_UTILS_TEST_CHECK(read_register(client, 6) == 6);
+    return true;
+}
+
+static bool test_response_from_other_unit_fails()
+{
+    FakeModbusServer server([](FakeConnection& connection, int) {
+        FakeRequest request;
+        while (connection.receive_request(request)) {
+            // unit 9 is answered by unit 10
+            connection.send_response(
+                    request.transaction_id,
+                    request.unit_id == 9 ? 10 : request.unit_id,
+                    read_response(request.pdu));
+        }
+    });
+    ModbusTcpPipelinedClient client(LOCALHOST, server.port(), 1);
+    std::vector<uint16_t> registers(1);
+    std::string error;
+
+    client.set_slave_id(9);
+    try {
+        client.read_registers(registers, 0, 1, false);
+    } catch (const std::exception &ex) {
+        error = ex.what();
+    }
+    RTI_UTILS_TEST_CHECK(error.find("unit 10") != std::string::npos);
+
+    // the connection still works
+    client.set_slave_id(1);
+    RTI_UTILS_TEST_CHECK(read_register(client, 8) == 8);
+    return true;
+}
+
+static bool test_exception_response()
+{
+    FakeModbusServer server([](FakeConnection& connection, int) {
+        FakeRequest request;
+        while (connection.receive_request(request)) {
+            // illegal data address
+            connection.send_response(
+                    request.transaction_id,
+                    request.unit_id,
+                    { static_cast<uint8_t>(request.pdu[0] | 0x80), 0x02 });
+        }
+    });
+    ModbusTcpPipelinedClient client(LOCALHOST, server.port(), 1);
+
+    RTI_UTILS_TEST_CHECK(read_register(client, 0) == -1);
+    RTI_UTILS_TEST_CHECK(read_register(client, 1) == -1);
+    return true;
+}
+
+static bool test_reconnects_after_invalid_header()
+{
+    FakeModbusServer server([](FakeConnection& connection, int index) {
+        if (index > 0) {
+            serve_requests(connection);
+            return;
+        }
+        // a protocol identifier other than 0 breaks the framing, so the
+        // connection is closed
+        FakeRequest request;
+        if (connection.receive_request(request)) {
+            connection.send_bytes(mbap_frame(
+                    request.transaction_id,
+                    1,
+                    request.unit_id,
+                    read_response(request.pdu)));
+        }
+    });
+    ModbusTcpPipelinedClient client(LOCALHOST, server.port(), 1);
+
+    client.set_response_timeout(1, 0);
+    RTI_UTILS_TEST_CHECK(read_register(client, 11) == -1);
+    RTI_UTILS_TEST_CHECK(read_register(client, 12) == 12);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    return run_unit_tests({
+            { "request frame", test_request_frame },
+            { "response in fragments", test_response_in_fragments },
+            { "responses matched by transaction id",
+              test_responses_matched_by_transaction_id },
+            { "unknown and duplicate ids discarded",
+              test_unknown_and_duplicate_ids_discarded },
+            { "late response discarded", test_late_response_discarded },
+            { "response from other unit fails",
+              test_response_from_other_unit_fails },
+            { "exception response", test_exception_response },
+            { "reconnects after invalid header",
+              test_reconnects_after_invalid_header },
+    });
+}
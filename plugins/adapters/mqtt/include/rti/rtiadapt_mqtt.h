@@ -611,6 +611,46 @@
     #define RTI_MQTT_PROPERTY_SUBSCRIPTION_QUEUE_SIZE \
         RTI_MQTT_PROPERTY_PREFIX_SUBSCRIPTION "queue_size"
 
+    /**
+     * @brief Configuration property to let the message queue of an
+     * `RTI_MQTT_Subscription` keep received messages in the buffers of the
+     * MQTT client library, so that their payload is only copied when they
+     * are read.
+     */
+    #define RTI_MQTT_PROPERTY_SUBSCRIPTION_DEFER_PAYLOAD_COPY \
+        RTI_MQTT_PROPERTY_PREFIX_SUBSCRIPTION "defer_payload_copy"
+
+    /**
+     * @brief Configuration property to control how many messages an
+     * `RTI_MQTT_Subscription` may receive before notifying its reader again,
+     * while the reader has not yet read the messages it was notified of.
+     */
+    #define RTI_MQTT_PROPERTY_SUBSCRIPTION_DATA_AVAILABLE_BATCH_SIZE \
+        RTI_MQTT_PROPERTY_PREFIX_SUBSCRIPTION "data_available_batch_size"
+
+    /**
+     * @brief Common prefix for configuration properties controlling the
+     * maximum time for which an `RTI_MQTT_Subscription` may delay notifying
+     * its reader again, while the reader has not yet read the messages it
+     * was notified of.
+     */
+    #define RTI_MQTT_PROPERTY_SUBSCRIPTION_DATA_AVAILABLE_MAX_DELAY \
+        RTI_MQTT_PROPERTY_PREFIX_SUBSCRIPTION "data_available_max_delay"
+
+    /**
+     * @brief Configuration property to specify the seconds component of
+     * `RTI_MQTT_PROPERTY_SUBSCRIPTION_DATA_AVAILABLE_MAX_DELAY`.
+     */
+    #define RTI_MQTT_PROPERTY_SUBSCRIPTION_DATA_AVAILABLE_MAX_DELAY_SEC \
+        RTI_MQTT_PROPERTY_SUBSCRIPTION_DATA_AVAILABLE_MAX_DELAY ".sec"
+
+    /**
+     * @brief Configuration property to specify the nanoseconds component of
+     * `RTI_MQTT_PROPERTY_SUBSCRIPTION_DATA_AVAILABLE_MAX_DELAY`.
+     */
+    #define RTI_MQTT_PROPERTY_SUBSCRIPTION_DATA_AVAILABLE_MAX_DELAY_NANOSEC \
+        RTI_MQTT_PROPERTY_SUBSCRIPTION_DATA_AVAILABLE_MAX_DELAY ".nanosec"
+
 
     /**
      * @}
@@ -678,6 +718,15 @@
     #define RTI_MQTT_PROPERTY_PUBLICATION_MAX_WAIT_TIME_NANOSECONDS \
         RTI_MQTT_PROPERTY_PUBLICATION_MAX_WAIT_TIME ".nanosec"
 
+    /**
+     * @brief Configuration property to control the maximum number of
+     * messages that an `RTI_MQTT_Publication` may have published without
+     * having received a result from the MQTT Broker. A value of 0 disables
+     * pipelining, and every write blocks until its result is received.
+     */
+    #define RTI_MQTT_PROPERTY_PUBLICATION_MAX_INFLIGHT_MESSAGES \
+        RTI_MQTT_PROPERTY_PREFIX_PUBLICATION "max_inflight_messages"
+
 
 /** @} */
 
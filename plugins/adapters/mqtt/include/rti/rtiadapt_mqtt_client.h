@@ -271,11 +271,14 @@ extern const RTI_MQTT_SubscriptionConfig RTI_MQTT_SubscriptionConfig_DEFAULT;
  * @brief Default initializer for static values of
  * `RTI_MQTT_SubscriptionConfig`.
  */
-#define RTI_MQTT_SubscriptionConfig_INITIALIZER                 \
-    {                                                           \
-        DDS_SEQUENCE_INITIALIZER,      /* topic_filters */      \
-                RTI_MQTT_QosLevel_TWO, /* max_qos */            \
-                0                      /* message_queue_size */ \
+#define RTI_MQTT_SubscriptionConfig_INITIALIZER                                \
+    {                                                                          \
+        DDS_SEQUENCE_INITIALIZER,      /* topic_filters */                     \
+                RTI_MQTT_QosLevel_TWO, /* max_qos */                           \
+                0,                     /* message_queue_size */                \
+                DDS_BOOLEAN_FALSE,     /* defer_payload_copy */                \
+                1, /* data_available_batch_size */                             \
+                RTI_MQTT_Time_INITIALIZER(0, 0) /* data_available_max_delay */ \
     }
 
 /**
@@ -344,13 +347,14 @@ extern const RTI_MQTT_PublicationConfig RTI_MQTT_PublicationConfig_DEFAULT;
  * @brief Default initializer for static values of
  * `RTI_MQTT_PublicationConfig`.
  */
-#define RTI_MQTT_PublicationConfig_INITIALIZER                          \
-    {                                                                   \
-        "",                                      /* topic */            \
-                RTI_MQTT_QosLevel_ZERO,          /* qos */              \
-                DDS_BOOLEAN_FALSE,               /* retained */         \
-                DDS_BOOLEAN_FALSE,               /* use_message_info */ \
-                RTI_MQTT_Time_INITIALIZER(10, 0) /* max_wait_time */    \
+#define RTI_MQTT_PublicationConfig_INITIALIZER                                \
+    {                                                                         \
+        "",                                       /* topic */                 \
+                RTI_MQTT_QosLevel_ZERO,           /* qos */                   \
+                DDS_BOOLEAN_FALSE,                /* retained */              \
+                DDS_BOOLEAN_FALSE,                /* use_message_info */      \
+                RTI_MQTT_Time_INITIALIZER(10, 0), /* max_wait_time */         \
+                0                                 /* max_inflight_messages */ \
     }
 
 /**
@@ -734,6 +738,41 @@ DDS_ReturnCode_t RTI_MQTT_Publication_write(
         struct RTI_MQTT_Publication *self,
         DDS_DynamicData *message);
 
+/**
+ * @brief Write a batch of MQTT messages from `DDS_DynamicData` samples.
+ *
+ * The messages are written in order, as if by `RTI_MQTT_Publication_write`.
+ * When the `RTI_MQTT_Publication` is configured with a non-zero
+ * `max_inflight_messages`, the messages are passed to the MQTT client library
+ * back-to-back, without releasing the client's locks in between, and the
+ * operation only blocks when the in-flight window is full. Otherwise, every
+ * message is acknowledged before the next one is written, and the client's
+ * locks are taken and released once per message, exactly as if
+ * `RTI_MQTT_Publication_write` was called for each of them: batching
+ * requires a non-zero `max_inflight_messages`.
+ *
+ * @param self the `RTI_MQTT_Publication` used to write the MQTT messages.
+ * @param messages The messages to write.
+ * @param count Number of messages in `messages`.
+ * @param results If a value is passed, the operation will wait for the
+ * result of every written message, and store it in the corresponding element
+ * of this array, which must contain at least `count` elements. Messages
+ * which could not be written, or whose result was not received within the
+ * client's `max_reply_timeout`, are reported as `DDS_RETCODE_ERROR`.
+ * @param written_out If a value is passed, it will be set to the number of
+ * messages which were passed to the MQTT client library.
+ * @return DDS_ReturnCode_t `DDS_RETCODE_OK` if all messages were
+ * successfully written (and, if `results` was passed, all results were
+ * received), `DDS_RETCODE_ERROR` otherwise.
+ *
+ */
+DDS_ReturnCode_t RTI_MQTT_Publication_write_batch(
+        struct RTI_MQTT_Publication *self,
+        DDS_DynamicData **messages,
+        DDS_UnsignedLong count,
+        DDS_ReturnCode_t *results,
+        DDS_UnsignedLong *written_out);
+
 /**
  * @brief Write an MQTT message from a raw buffer, using custom write
  * parameters.
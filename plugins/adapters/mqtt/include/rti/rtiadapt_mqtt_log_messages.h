@@ -355,6 +355,11 @@
         "pub=%p, topic=%s, qos=%d, ret=%d, msg=%p", \
         (p_), (t_), (q_), (r_), (msg_))
 
+#define RTI_MQTT_LOG_PUBLICATION_WRITE_BATCH_FAILED(p_,w_,c_,msg_) \
+    RTI_MQTT_ERROR_4("failed to write batch of messages:", \
+        "pub=%p, written=%u, count=%u, failed_msg=%p", \
+        (p_), (w_), (c_), (msg_))
+
 #define RTI_MQTT_LOG_PUBLICATION_WRITE_NOT_IN_PROGRESS(p_) \
     RTI_MQTT_ERROR_1("no write currently in progress for publication:", \
         "pub=%p", (p_))
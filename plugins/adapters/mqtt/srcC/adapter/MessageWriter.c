@@ -110,30 +110,36 @@ int RTI_RS_MQTT_MessageWriter_write(
     struct RTI_RS_MQTT_MessageWriter *writer =
             (struct RTI_RS_MQTT_MessageWriter *) stream_writer;
     DDS_DynamicData **samples_list = (DDS_DynamicData **) samples_list_in;
-    int written_messages = 0;
-    struct DDS_TypeAllocationParams_t alloc_params =
-            DDS_TYPE_ALLOCATION_PARAMS_DEFAULT;
-    DDS_Boolean failed = DDS_BOOLEAN_FALSE;
-    int i = 0;
+    DDS_UnsignedLong written_messages = 0;
 
     RTI_MQTT_LOG_FN(RTI_RS_MQTT_MessageWriter_write)
 
-    alloc_params.allocate_memory = RTI_TRUE;
-    alloc_params.allocate_pointers = RTI_TRUE;
-    alloc_params.allocate_optional_members = RTI_TRUE;
-
-    for (i = 0; i < count; i++) {
-        DDS_DynamicData *sample = samples_list[i];
-        if (DDS_RETCODE_OK != RTI_MQTT_Publication_write(writer->pub, sample)) {
-            /* TODO Log error */
-            goto done;
-        }
-        written_messages += 1;
+    if (count <= 0) {
+        return 0;
     }
 
-done:
+    /* The batch stops at the first message which cannot be written, so
+       the number of written messages identifies it. The delivery results of
+       the written messages are only reported through the publication's
+       message status, so there is no need to wait for them before returning
+       to Routing Service. */
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_Publication_write_batch(
+                writer->pub,
+                samples_list,
+                (DDS_UnsignedLong) count,
+                NULL,
+                &written_messages)) {
+        RTI_MQTT_LOG_PUBLICATION_WRITE_BATCH_FAILED(
+                writer->pub,
+                written_messages,
+                (DDS_UnsignedLong) count,
+                (written_messages < (DDS_UnsignedLong) count)
+                        ? samples_list[written_messages]
+                        : NULL)
+    }
 
-    return written_messages;
+    return (int) written_messages;
 }
 
 
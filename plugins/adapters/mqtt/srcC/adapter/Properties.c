@@ -957,6 +957,35 @@ static DDS_ReturnCode_t RTI_MQTT_SubscriptionConfig_parse_from_properties(
             config->message_queue_size =
                     RTI_MQTT_String_to_long(pval, NULL, 0);)
 
+    RTI_RS_MQTT_lookup_property(
+            properties,
+            RTI_MQTT_PROPERTY_SUBSCRIPTION_DEFER_PAYLOAD_COPY,
+            if (DDS_RETCODE_OK
+                != DDS_Boolean_from_string(
+                        pval,
+                        &config->defer_payload_copy)) {
+                /* TODO Log error */
+                goto done;
+            })
+
+    RTI_RS_MQTT_lookup_property(
+            properties,
+            RTI_MQTT_PROPERTY_SUBSCRIPTION_DATA_AVAILABLE_BATCH_SIZE,
+            config->data_available_batch_size =
+                    RTI_MQTT_String_to_long(pval, NULL, 0);)
+
+    RTI_RS_MQTT_lookup_property(
+            properties,
+            RTI_MQTT_PROPERTY_SUBSCRIPTION_DATA_AVAILABLE_MAX_DELAY_SEC,
+            config->data_available_max_delay.seconds =
+                    RTI_MQTT_String_to_long(pval, NULL, 0);)
+
+    RTI_RS_MQTT_lookup_property(
+            properties,
+            RTI_MQTT_PROPERTY_SUBSCRIPTION_DATA_AVAILABLE_MAX_DELAY_NANOSEC,
+            config->data_available_max_delay.nanoseconds =
+                    RTI_MQTT_String_to_long(pval, NULL, 0);)
+
     *config_out = config;
 
     retval = DDS_RETCODE_OK;
@@ -1167,6 +1196,22 @@ static DDS_ReturnCode_t RTI_MQTT_PublicationConfig_parse_from_properties(
             config->max_wait_time.nanoseconds =
                     RTI_MQTT_String_to_long(pval, NULL, 0);)
 
+    RTI_RS_MQTT_lookup_property(
+            properties,
+            RTI_MQTT_PROPERTY_PUBLICATION_MAX_INFLIGHT_MESSAGES,
+            char *pend = NULL;
+            long max_inflight = RTI_MQTT_String_to_long(pval, &pend, 0);
+            if (pend == pval || *pend != '\0' || max_inflight < 0) {
+                RTI_MQTT_ERROR_1(
+                        "invalid value for "
+                        RTI_MQTT_PROPERTY_PUBLICATION_MAX_INFLIGHT_MESSAGES
+                        ":",
+                        "%s",
+                        pval)
+                goto done;
+            } config->max_inflight_messages =
+                    (DDS_UnsignedLong) max_inflight;)
+
     *config_out = config;
 
     retval = DDS_RETCODE_OK;
@@ -77,6 +77,10 @@ static void RTI_MQTT_Client_on_write_delivery_result(
         struct RTI_MQTT_PendingRequest *req,
         DDS_ReturnCode_t result);
 
+static void RTI_MQTT_Client_on_inflight_write_result(
+        struct RTI_MQTT_PendingRequest *req,
+        DDS_ReturnCode_t result);
+
 static void RTI_MQTT_Client_on_subscription_result(
         struct RTI_MQTT_PendingRequest *req,
         DDS_ReturnCode_t result);
@@ -116,6 +120,10 @@ static DDS_ReturnCode_t RTI_MQTT_Client_delete_subscription_requests(
         struct RTI_MQTT_Client *self,
         struct RTI_MQTT_Subscription *sub);
 
+static DDS_ReturnCode_t RTI_MQTT_Client_wait_for_inflight_writes(
+        struct RTI_MQTT_Client *self,
+        struct RTI_MQTT_Publication *pub);
+
 static DDS_ReturnCode_t RTI_MQTT_Client_add_subscription(
         struct RTI_MQTT_Client *self,
         struct RTI_MQTT_Subscription *sub);
@@ -124,6 +132,9 @@ static DDS_ReturnCode_t RTI_MQTT_Client_remove_subscription(
         struct RTI_MQTT_Client *self,
         struct RTI_MQTT_Subscription *sub);
 
+static DDS_ReturnCode_t
+        RTI_MQTT_Client_rebuild_subscription_tree(struct RTI_MQTT_Client *self);
+
 static DDS_ReturnCode_t RTI_MQTT_Client_add_publication(
         struct RTI_MQTT_Client *self,
         struct RTI_MQTT_Publication *pub);
@@ -436,6 +447,7 @@ static DDS_ReturnCode_t RTI_MQTT_Client_create_publication_requests(
         struct RTI_MQTT_Publication *pub)
 {
     DDS_ReturnCode_t retcode = DDS_RETCODE_ERROR;
+    DDS_UnsignedLong i = 0;
 
     RTI_MQTT_LOG_FN(RTI_MQTT_Client_create_publication_requests)
 
@@ -454,6 +466,22 @@ static DDS_ReturnCode_t RTI_MQTT_Client_create_publication_requests(
         goto done;
     }
 
+    /* In pipelined mode, each in-flight message is tracked with its own
+       request, while pub->req is only used to wait for space in the
+       in-flight window. These requests are never waited on directly, so
+       they don't need a WaitSet, nor a timeout, of their own. A message
+       only leaves the window when the MQTT client library reports its
+       result: expiring it earlier would let the slot be reused while the
+       library may still complete the original request. */
+    for (i = 0; i < pub->inflight.max_messages; i++) {
+        struct RTI_MQTT_PublicationInflightMessage *msg =
+                &pub->inflight.messages[i];
+
+        msg->req.client = self;
+        msg->req.context = msg;
+        msg->req.result_handler = RTI_MQTT_Client_on_inflight_write_result;
+    }
+
     retcode = DDS_RETCODE_OK;
 
 done:
@@ -652,11 +680,11 @@ DDS_ReturnCode_t RTI_MQTT_Client_on_message_arrived(
         const char *topic,
         const char *buffer,
         DDS_UnsignedLong buffer_len,
-        RTI_MQTT_MessageInfo *msg_info)
+        RTI_MQTT_MessageInfo *msg_info,
+        struct RTI_MQTT_DeferredMessage *deferred)
 {
     DDS_ReturnCode_t retcode = DDS_RETCODE_ERROR;
 
-    DDS_Boolean match = DDS_BOOLEAN_FALSE;
     DDS_UnsignedLong seq_len = 0, i = 0;
 
     RTI_MQTT_LOG_FN(RTI_MQTT_Client_on_message_arrived)
@@ -669,38 +697,53 @@ DDS_ReturnCode_t RTI_MQTT_Client_on_message_arrived(
 
     RTI_MQTT_Mutex_assert(&self->sub_lock);
 
-    seq_len = RTI_MQTT_SubscriptionPtrSeq_get_length(&self->subscriptions);
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_TopicTree_match(
+                &self->sub_tree,
+                topic,
+                &self->sub_matches)) {
+        RTI_MQTT_ERROR_2(
+                "failed to match subscriptions:",
+                "client=%p, topic=%s",
+                self,
+                topic)
+        goto done;
+    }
+
+    seq_len = RTI_MQTT_SubscriptionPtrSeq_get_length(&self->sub_matches);
+
+    /* A message can only be stored without copying its payload by a
+       single subscription, since its buffers are released as soon as it
+       is read. */
+    if (seq_len != 1) {
+        deferred = NULL;
+    }
+
     for (i = 0; i < seq_len; i++) {
         struct RTI_MQTT_Subscription *sub =
                 *RTI_MQTT_SubscriptionPtrSeq_get_reference(
-                        &self->subscriptions,
+                        &self->sub_matches,
                         i);
 
-        if (DDS_RETCODE_OK != RTI_MQTT_Subscription_match(sub, topic, &match)) {
-            RTI_MQTT_LOG_CLIENT_MATCH_SUBSCRIPTION_FAILED(self, sub)
-            goto done;
-        }
+        RTI_MQTT_TRACE_3(
+                "DELIVER message:",
+                "client=%p sub=%p, topic=%s",
+                self,
+                sub,
+                topic)
 
-        if (match) {
-            RTI_MQTT_TRACE_3(
-                    "DELIVER message:",
-                    "client=%p sub=%p, topic=%s",
-                    self,
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_Subscription_receive(
                     sub,
-                    topic)
-
-            if (DDS_RETCODE_OK
-                != RTI_MQTT_Subscription_receive(
-                        sub,
-                        buffer,
-                        buffer_len,
-                        topic,
-                        msg_info,
-                        NULL /* dropped */,
-                        NULL /* lost */)) {
-                RTI_MQTT_LOG_CLIENT_SUBSCRIPTION_RECEIVE_FAILED(self, sub)
-                goto done;
-            }
+                    buffer,
+                    buffer_len,
+                    topic,
+                    msg_info,
+                    deferred,
+                    NULL /* dropped */,
+                    NULL /* lost */)) {
+            RTI_MQTT_LOG_CLIENT_SUBSCRIPTION_RECEIVE_FAILED(self, sub)
+            goto done;
         }
     }
 
@@ -728,6 +771,7 @@ done:
 DDS_ReturnCode_t RTI_MQTT_Client_write_message(
         struct RTI_MQTT_Client *self,
         struct RTI_MQTT_Publication *pub,
+        struct RTI_MQTT_PendingRequest *req,
         const char *buffer,
         DDS_UnsignedLong buffer_len,
         const char *topic,
@@ -746,7 +790,7 @@ DDS_ReturnCode_t RTI_MQTT_Client_write_message(
                 buffer_len,
                 topic,
                 params,
-                pub->req)) {
+                req)) {
         /* TODO Log error */
         goto done;
     }
@@ -779,6 +823,48 @@ done:
     return retval;
 }
 
+void RTI_MQTT_Client_begin_write_batch(struct RTI_MQTT_Client *self)
+{
+    RTI_MQTT_LOG_FN(RTI_MQTT_Client_begin_write_batch)
+
+    /* Same order in which the locks are taken by write_message() */
+    RTI_MQTT_Mutex_assert(&self->pub_lock);
+    RTI_MQTT_Mutex_assert(&self->mqtt_lock);
+}
+
+void RTI_MQTT_Client_end_write_batch(struct RTI_MQTT_Client *self)
+{
+    RTI_MQTT_LOG_FN(RTI_MQTT_Client_end_write_batch)
+
+    RTI_MQTT_Mutex_release(&self->mqtt_lock);
+    RTI_MQTT_Mutex_release(&self->pub_lock);
+}
+
+static DDS_ReturnCode_t RTI_MQTT_Client_wait_for_inflight_writes(
+        struct RTI_MQTT_Client *self,
+        struct RTI_MQTT_Publication *pub)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_Client_wait_for_inflight_writes)
+
+    /* Results for in-flight messages reference the publication, so it
+       cannot be deleted until all of them have been received. Every result
+       triggers pub->req, so we keep waiting as long as some progress is
+       being made within the configured reply timeout. */
+    while (RTI_MQTT_Publication_get_inflight_count(pub) > 0) {
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_Client_wait_for_request(self, pub->req)) {
+            RTI_MQTT_LOG_CLIENT_WAIT_FAILED(self, "in-flight publication")
+            goto done;
+        }
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
 /*****************************************************************************
  *                     RTI_MQTT_PendingRequest Result Handlers
  *****************************************************************************/
@@ -987,6 +1073,55 @@ done:
     }
 }
 
+static void RTI_MQTT_Client_on_inflight_write_result(
+        struct RTI_MQTT_PendingRequest *req,
+        DDS_ReturnCode_t result)
+{
+    struct RTI_MQTT_Client *self = req->client;
+    struct RTI_MQTT_PublicationInflightMessage *msg =
+            (struct RTI_MQTT_PublicationInflightMessage *) req->context;
+    struct RTI_MQTT_Publication *pub = msg->pub;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_Client_on_inflight_write_result)
+
+#if RTI_MQTT_USE_LOG
+    if (result != DDS_RETCODE_OK) {
+        RTI_MQTT_ERROR_4(
+                "write ERROR",
+                "client=%p, pub=%p, req=%p, result=%d",
+                self,
+                pub,
+                req,
+                result)
+    } else {
+        RTI_MQTT_TRACE_3(
+                "write OK",
+                "client=%p, pub=%p, req=%p",
+                self,
+                pub,
+                req)
+    }
+#endif /* RTI_MQTT_USE_LOG */
+
+    /* The slot must not be returned to the window until pub->req has been
+       signaled: once the window is empty, RTI_MQTT_Client_unpublish() may
+       delete the publication, so neither `pub` nor `msg` can be accessed
+       after the lock is released. */
+    RTI_MQTT_Mutex_assert(&pub->inflight.lock);
+
+    /* Wake up the writer if it is waiting for space in the window. The
+       result of the write operation is tracked by the publication's
+       statistics, so it is not propagated to the writer. */
+    RTI_MQTT_Client_handle_request_result(pub->req, DDS_RETCODE_OK);
+
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_Publication_on_inflight_write_result(pub, msg, result)) {
+        RTI_MQTT_LOG_CLIENT_NOTIFY_WRITE_RESULTS_FAILED(self, pub)
+    }
+
+    RTI_MQTT_Mutex_release(&pub->inflight.lock);
+}
+
 /*****************************************************************************
  *                          Public API Implementation
  *****************************************************************************/
@@ -1387,6 +1522,10 @@ DDS_ReturnCode_t RTI_MQTT_Client_publish(
                 RTI_MQTT_QosLevel_as_string(pub->data->config->qos))
         RTI_MQTT_LOG_1("  - retained:", "%d", pub->data->config->retained)
     }
+    RTI_MQTT_LOG_1(
+            "  - max in-flight messages:",
+            "%u",
+            pub->inflight.max_messages)
     RTI_MQTT_LOG_2(
             "  - max wait time:",
             "%ds %uns",
@@ -1428,6 +1567,20 @@ DDS_ReturnCode_t RTI_MQTT_Client_unpublish(
 
     RTI_MQTT_LOG_FN(RTI_MQTT_Client_unpublish)
 
+    if (RTI_MQTT_Publication_is_pipelined(pub)
+        && DDS_RETCODE_OK
+                != RTI_MQTT_Client_wait_for_inflight_writes(self, pub)) {
+        /* Results may still be delivered for the messages in flight, and
+           they reference both the publication and its requests, so they
+           are leaked rather than deleted. */
+        RTI_MQTT_ERROR_2(
+                "cannot delete publication with messages still in-flight:",
+                "client=%p, pub=%p",
+                self,
+                pub)
+        return DDS_RETCODE_ERROR;
+    }
+
     if (DDS_RETCODE_OK
         != RTI_MQTT_Client_delete_publication_requests(self, pub)) {
         /* TODO Log error */
@@ -1516,6 +1669,16 @@ static DDS_ReturnCode_t RTI_MQTT_Client_initialize(
         goto done;
     }
 
+    if (!RTI_MQTT_SubscriptionPtrSeq_initialize(&self->sub_matches)) {
+        RTI_MQTT_LOG_INITIALIZE_SEQUENCE_FAILED(&self->sub_matches)
+        goto done;
+    }
+
+    if (DDS_RETCODE_OK != RTI_MQTT_TopicTree_initialize(&self->sub_tree)) {
+        /* TODO Log error */
+        goto done;
+    }
+
     if (!RTI_MQTT_PublicationPtrSeq_initialize(&self->publications)) {
         RTI_MQTT_LOG_INITIALIZE_SEQUENCE_FAILED(&self->publications)
         goto done;
@@ -1622,6 +1785,13 @@ static DDS_ReturnCode_t RTI_MQTT_Client_finalize(struct RTI_MQTT_Client *self)
         goto done;
     }
 
+    RTI_MQTT_TopicTree_finalize(&self->sub_tree);
+
+    if (!RTI_MQTT_SubscriptionPtrSeq_finalize(&self->sub_matches)) {
+        RTI_MQTT_LOG_FINALIZE_SEQUENCE_FAILED(&self->sub_matches)
+        goto done;
+    }
+
     if (!RTI_MQTT_PublicationPtrSeq_finalize(&self->publications)) {
         RTI_MQTT_LOG_FINALIZE_SEQUENCE_FAILED(&self->publications)
         goto done;
@@ -2079,6 +2249,21 @@ static DDS_ReturnCode_t RTI_MQTT_Client_add_subscription(
             seq_len);
     *sub_ref = sub;
 
+    if (DDS_RETCODE_OK != RTI_MQTT_Client_rebuild_subscription_tree(self)) {
+        /* Leave the subscriptions as they were before */
+        if (!RTI_MQTT_SubscriptionPtrSeq_set_length(
+                    &self->subscriptions,
+                    seq_len)) {
+            RTI_MQTT_LOG_SET_SEQUENCE_LENGTH_FAILED(
+                    &self->subscriptions,
+                    seq_len)
+        }
+        if (DDS_RETCODE_OK != RTI_MQTT_Client_rebuild_subscription_tree(self)) {
+            /* TODO Log error */
+        }
+        goto done;
+    }
+
     retcode = DDS_RETCODE_OK;
 
 done:
@@ -2138,12 +2323,57 @@ static DDS_ReturnCode_t RTI_MQTT_Client_remove_subscription(
         goto done;
     }
 
+    if (DDS_RETCODE_OK != RTI_MQTT_Client_rebuild_subscription_tree(self)) {
+        /* TODO Log error */
+        goto done;
+    }
+
     retcode = DDS_RETCODE_OK;
 
 done:
     RTI_MQTT_Mutex_release(&self->sub_lock) return retcode;
 }
 
+static DDS_ReturnCode_t
+        RTI_MQTT_Client_rebuild_subscription_tree(struct RTI_MQTT_Client *self)
+{
+    DDS_ReturnCode_t retcode = DDS_RETCODE_ERROR;
+    DDS_UnsignedLong seq_len = 0, i = 0;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_Client_rebuild_subscription_tree)
+
+    RTI_MQTT_Mutex_assert(&self->sub_lock);
+
+    /* The tree is only modified when subscriptions are added or removed,
+       which is rare compared to the arrival of messages, so we just
+       rebuild it from scratch. */
+    RTI_MQTT_TopicTree_clear(&self->sub_tree);
+
+    seq_len = RTI_MQTT_SubscriptionPtrSeq_get_length(&self->subscriptions);
+    for (i = 0; i < seq_len; i++) {
+        struct RTI_MQTT_Subscription *sub =
+                *RTI_MQTT_SubscriptionPtrSeq_get_reference(
+                        &self->subscriptions,
+                        i);
+
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_TopicTree_add_subscription(&self->sub_tree, sub)) {
+            RTI_MQTT_ERROR_2(
+                    "failed to index subscription:",
+                    "client=%p, sub=%p",
+                    self,
+                    sub)
+            goto done;
+        }
+    }
+
+    retcode = DDS_RETCODE_OK;
+
+done:
+    RTI_MQTT_Mutex_release(&self->sub_lock);
+    return retcode;
+}
+
 static DDS_ReturnCode_t RTI_MQTT_Client_add_publication(
         struct RTI_MQTT_Client *self,
         struct RTI_MQTT_Publication *pub)
@@ -22,6 +22,7 @@
 #include "Infrastructure.h"
 #include "Publication.h"
 #include "Subscription.h"
+#include "TopicTree.h"
 
 struct RTI_MQTT_Client {
     RTI_MQTT_ClientStatus *data;
@@ -33,6 +34,8 @@ struct RTI_MQTT_Client {
     struct RTI_MQTT_SubscriptionRequestContext req_ctx_sub;
     struct RTI_MQTT_SubscriptionParamsSeq params_sub;
     struct RTI_MQTT_SubscriptionPtrSeq subscriptions;
+    struct RTI_MQTT_TopicTree sub_tree;
+    struct RTI_MQTT_SubscriptionPtrSeq sub_matches;
     struct RTI_MQTT_PublicationPtrSeq publications;
     RTI_MQTT_Mutex cfg_lock;
     RTI_MQTT_Mutex mqtt_lock;
@@ -51,6 +54,8 @@ struct RTI_MQTT_Client {
         RTI_MQTT_SubscriptionRequestContext_INITIALIZER, /* req_ctx_sub */ \
         DDS_SEQUENCE_INITIALIZER,  /* params_sub */                        \
         DDS_SEQUENCE_INITIALIZER,  /* subscriptions */                     \
+        RTI_MQTT_TopicTree_INITIALIZER, /* sub_tree */                     \
+        DDS_SEQUENCE_INITIALIZER,  /* sub_matches */                       \
         DDS_SEQUENCE_INITIALIZER,  /* publications */                      \
         RTI_MQTT_Mutex_INITIALIZER /* lock */                              \
     }
@@ -58,6 +63,7 @@ struct RTI_MQTT_Client {
 DDS_ReturnCode_t RTI_MQTT_Client_write_message(
         struct RTI_MQTT_Client *self,
         struct RTI_MQTT_Publication *pub,
+        struct RTI_MQTT_PendingRequest *req,
         const char *buffer,
         DDS_UnsignedLong buffer_len,
         const char *topic,
@@ -67,6 +73,13 @@ DDS_ReturnCode_t RTI_MQTT_Client_wait_for_write_result(
         struct RTI_MQTT_Client *self,
         struct RTI_MQTT_Publication *pub);
 
+/* Hold the locks taken by RTI_MQTT_Client_write_message() until
+   RTI_MQTT_Client_end_write_batch() is called, so that a batch of messages
+   can be passed to the MQTT client library back-to-back. */
+void RTI_MQTT_Client_begin_write_batch(struct RTI_MQTT_Client *self);
+
+void RTI_MQTT_Client_end_write_batch(struct RTI_MQTT_Client *self);
+
 DDS_ReturnCode_t
         RTI_MQTT_Client_on_connection_lost(struct RTI_MQTT_Client *self);
 
@@ -75,6 +88,7 @@ DDS_ReturnCode_t RTI_MQTT_Client_on_message_arrived(
         const char *topic,
         const char *buffer,
         DDS_UnsignedLong buffer_len,
-        RTI_MQTT_MessageInfo *msg_info);
+        RTI_MQTT_MessageInfo *msg_info,
+        struct RTI_MQTT_DeferredMessage *deferred);
 
 #endif /* Client_h */
@@ -604,6 +604,16 @@ done:
     }
 }
 
+static void RTI_MQTT_ClientMqttApi_Paho_release_message(
+        void *message,
+        char *topic)
+{
+    MQTTAsync_message *msg = (MQTTAsync_message *) message;
+
+    MQTTAsync_freeMessage(&msg);
+    MQTTAsync_free(topic);
+}
+
 int RTI_MQTT_ClientMqttApi_Paho_on_message_arrived(
         void *ctx,
         char *topic_name,
@@ -612,12 +622,15 @@ int RTI_MQTT_ClientMqttApi_Paho_on_message_arrived(
 {
     DDS_Boolean retval = DDS_BOOLEAN_FALSE;
     RTI_MQTT_MessageInfo msg_info;
+    struct RTI_MQTT_DeferredMessage deferred;
     struct RTI_MQTT_Client *self = (struct RTI_MQTT_Client *) ctx;
 
     RTI_MQTT_LOG_FN(RTI_MQTT_ClientMqttApi_Paho_on_message_arrived)
 
     RTI_MQTT_TRACE_1("message RECEIVED:", "topic=%s", topic_name)
 
+    deferred.owned = DDS_BOOLEAN_FALSE;
+
     if (DDS_RETCODE_OK
         != RTI_MQTT_QosLevel_from_mqtt_qos(message->qos, &msg_info.qos_level)) {
         /* TODO Log error */
@@ -627,13 +640,21 @@ int RTI_MQTT_ClientMqttApi_Paho_on_message_arrived(
             (message->retained) ? DDS_BOOLEAN_TRUE : DDS_BOOLEAN_FALSE;
     msg_info.duplicate = (message->dup) ? DDS_BOOLEAN_TRUE : DDS_BOOLEAN_FALSE;
 
+    deferred.message = message;
+    deferred.topic = topic_name;
+    deferred.payload = (const char *) message->payload;
+    deferred.payload_len = message->payloadlen;
+    deferred.info = msg_info;
+    deferred.release = RTI_MQTT_ClientMqttApi_Paho_release_message;
+
     if (DDS_RETCODE_OK
         != RTI_MQTT_Client_on_message_arrived(
                 self,
                 topic_name,
                 message->payload,
                 message->payloadlen,
-                &msg_info)) {
+                &msg_info,
+                &deferred)) {
         /* TODO Log error */
         goto done;
     }
@@ -641,8 +662,12 @@ int RTI_MQTT_ClientMqttApi_Paho_on_message_arrived(
     retval = DDS_BOOLEAN_TRUE;
 done:
 
-    MQTTAsync_freeMessage(&message);
-    MQTTAsync_free(topic_name);
+    /* If the message is owned by a subscription, it will be released
+       once it is read */
+    if (!deferred.owned) {
+        MQTTAsync_freeMessage(&message);
+        MQTTAsync_free(topic_name);
+    }
 
     return retval;
 }
@@ -19,6 +19,7 @@
 
 #if RTI_MQTT_PLATFORM == RTI_MQTT_PLATFORM_POSIX
     #include <pthread.h>
+    #include <time.h>
 #elif RTI_MQTT_PLATFORM == RTI_MQTT_PLATFORM_WINDOWS
     #include <process.h>
     #include <windows.h>
@@ -101,6 +102,35 @@ DDS_ReturnCode_t RTI_MQTT_Time_to_dds_duration(
     return DDS_RETCODE_OK;
 }
 
+DDS_ReturnCode_t RTI_MQTT_Time_get_monotonic(RTI_MQTT_Time *time_out)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+#if RTI_MQTT_PLATFORM == RTI_MQTT_PLATFORM_POSIX
+    struct timespec ts;
+
+    if (0 != clock_gettime(CLOCK_MONOTONIC, &ts)) {
+        /* TODO Log error */
+        goto done;
+    }
+    time_out->seconds = (DDS_Long) ts.tv_sec;
+    time_out->nanoseconds = (DDS_UnsignedLong) ts.tv_nsec;
+#elif RTI_MQTT_PLATFORM == RTI_MQTT_PLATFORM_WINDOWS
+    LARGE_INTEGER count, freq;
+
+    if (!QueryPerformanceFrequency(&freq)
+        || !QueryPerformanceCounter(&count)) {
+        /* TODO Log error */
+        goto done;
+    }
+    time_out->seconds = (DDS_Long) (count.QuadPart / freq.QuadPart);
+    time_out->nanoseconds = (DDS_UnsignedLong) (
+            ((count.QuadPart % freq.QuadPart) * 1000000000) / freq.QuadPart);
+#endif
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
 
 DDS_ReturnCode_t RTI_MQTT_DDS_OctetSeq_to_string(
         struct DDS_OctetSeq *self,
@@ -200,8 +230,26 @@ DDS_ReturnCode_t RTI_MQTT_Thread_spawn(
         goto done;
     }
 
-    *native_handle =
-            (HANDLE) _beginthread((void(__cdecl *)(void *)) thread, 0, arg);
+    /* The handle returned by _beginthread() is closed when the thread
+       exits, so it can only be waited on if the thread is started with
+       _beginthreadex() */
+    if (handle_out == NULL) {
+        *native_handle = (HANDLE) _beginthread(
+                (void(__cdecl *)(void *)) thread,
+                0,
+                arg);
+        if (*native_handle == (HANDLE) -1L) {
+            *native_handle = NULL;
+        }
+    } else {
+        *native_handle = (HANDLE) _beginthreadex(
+                NULL,
+                0,
+                (unsigned(__stdcall *)(void *)) thread,
+                arg,
+                0,
+                NULL);
+    }
     if (*native_handle == NULL) {
         RTI_MQTT_WIN_BEGIN_THREAD_FAILED()
         goto done;
@@ -240,9 +288,17 @@ DDS_ReturnCode_t RTI_MQTT_Thread_join(void *handle, void **result_out)
 #elif RTI_MQTT_PLATFORM == RTI_MQTT_PLATFORM_WINDOWS
     HANDLE *native_handle = (HANDLE *) handle;
 
-    /* TODO Implement me */
+    RTI_MQTT_LOG_FN(RTI_MQTT_Thread_join)
 
-    goto done;
+    if (WaitForSingleObject(*native_handle, INFINITE) != WAIT_OBJECT_0) {
+        /* TODO Log error */
+        goto done;
+    }
+    CloseHandle(*native_handle);
+
+    if (result_out != NULL) {
+        *result_out = NULL;
+    }
 
 #endif
 
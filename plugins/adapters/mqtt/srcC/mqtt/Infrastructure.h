@@ -23,9 +23,11 @@
 
     #define RTI_MQTT_String_length strlen
     #define RTI_MQTT_String_compare strcmp
+    #define RTI_MQTT_String_compare_n strncmp
     #define RTI_MQTT_Memory_compare memcmp
     #define RTI_MQTT_String_to_long strtol
     #define RTI_MQTT_String_find_substring strstr
+    #define RTI_MQTT_String_find_char strchr
     #define RTI_MQTT_Heap_allocate malloc
 
     #if 0
@@ -44,6 +46,50 @@
     #define RTI_MQTT_Memory_move memmove
 #endif
 
+/* Atomic operations on 32-bit unsigned integers (e.g. DDS_UnsignedLong).
+   Loads have acquire semantics, stores have release semantics, and all
+   other operations act as full barriers. */
+#if RTI_MQTT_PLATFORM == RTI_MQTT_PLATFORM_POSIX
+    #define RTI_MQTT_Atomic_load(ptr_) __atomic_load_n((ptr_), __ATOMIC_ACQUIRE)
+    #define RTI_MQTT_Atomic_store(ptr_, val_) \
+        __atomic_store_n((ptr_), (val_), __ATOMIC_RELEASE)
+    #define RTI_MQTT_Atomic_compare_and_swap(ptr_, old_, new_) \
+        __sync_bool_compare_and_swap((ptr_), (old_), (new_))
+    #define RTI_MQTT_Atomic_add(ptr_, val_) \
+        ((void) __sync_add_and_fetch((ptr_), (val_)))
+    #define RTI_MQTT_Atomic_subtract(ptr_, val_) \
+        ((void) __sync_sub_and_fetch((ptr_), (val_)))
+#elif RTI_MQTT_PLATFORM == RTI_MQTT_PLATFORM_WINDOWS
+    #define RTI_MQTT_Atomic_load(ptr_) \
+        ((DDS_UnsignedLong) InterlockedCompareExchange( \
+                (volatile LONG *) (ptr_),               \
+                0,                                      \
+                0))
+    #define RTI_MQTT_Atomic_store(ptr_, val_) \
+        ((void) InterlockedExchange((volatile LONG *) (ptr_), (LONG) (val_)))
+    #define RTI_MQTT_Atomic_compare_and_swap(ptr_, old_, new_) \
+        (InterlockedCompareExchange(                           \
+                 (volatile LONG *) (ptr_),                     \
+                 (LONG) (new_),                                \
+                 (LONG) (old_))                                \
+         == (LONG) (old_))
+    #define RTI_MQTT_Atomic_add(ptr_, val_) \
+        ((void) InterlockedExchangeAdd((volatile LONG *) (ptr_), (LONG) (val_)))
+    #define RTI_MQTT_Atomic_subtract(ptr_, val_) \
+        ((void) InterlockedExchangeAdd(         \
+                (volatile LONG *) (ptr_),       \
+                -((LONG) (val_))))
+#endif
+
+/* Give up the processor while waiting for another thread to complete a
+   short operation on a lock-free data structure. */
+#if RTI_MQTT_PLATFORM == RTI_MQTT_PLATFORM_POSIX
+    #include <sched.h>
+    #define RTI_MQTT_Thread_yield() ((void) sched_yield())
+#elif RTI_MQTT_PLATFORM == RTI_MQTT_PLATFORM_WINDOWS
+    #define RTI_MQTT_Thread_yield() ((void) SwitchToThread())
+#endif
+
 #define MQTT_TOPIC_NAME_MAX_LEN 65535
 
 #define RTI_MQTT_String_is_equal(s_, o_) \
@@ -66,6 +112,13 @@ DDS_ReturnCode_t RTI_MQTT_Time_to_dds_duration(
 
 #define RTI_MQTT_Time_is_zero(t_) ((t_)->seconds == 0 && (t_)->nanoseconds == 0)
 
+#define RTI_MQTT_Time_to_microseconds(t_)     \
+    (((DDS_LongLong) (t_)->seconds) * 1000000 \
+     + (DDS_LongLong) ((t_)->nanoseconds / 1000))
+
+/* Read a monotonic clock, which is only suitable to measure intervals. */
+DDS_ReturnCode_t RTI_MQTT_Time_get_monotonic(RTI_MQTT_Time *time_out);
+
 DDS_ReturnCode_t RTI_MQTT_DDS_OctetSeq_to_string(
         struct DDS_OctetSeq *self,
         char **str_out);
@@ -67,6 +67,10 @@ DDS_ReturnCode_t RTI_MQTT_ReceivedMessage_initialize(
 {
     self->message = NULL;
     self->read = DDS_BOOLEAN_FALSE;
+    RTI_MQTT_Memory_zero(
+            &self->deferred,
+            sizeof(struct RTI_MQTT_DeferredMessage));
+    self->sequence = 0;
     return DDS_RETCODE_OK;
 }
 
@@ -76,7 +80,7 @@ DDS_ReturnCode_t
     DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
 
     /* Data must have already been deleted */
-    if (self->message != NULL) {
+    if (self->message != NULL || self->deferred.message != NULL) {
         /* TODO Log error */
         goto done;
     }
@@ -142,6 +146,562 @@ RTIBool RTI_MQTT_ReceivedMessagePtr_copy(
                 (q_)->msg_status->lost_count)              \
     }
 
+static DDS_ReturnCode_t RTI_MQTT_MessageMemberIds_lookup(
+        const DDS_TypeCode *tc,
+        const char *member_name,
+        DDS_DynamicDataMemberId *id_out,
+        DDS_TypeCode **member_tc_out)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    DDS_ExceptionCode_t ex = DDS_NO_EXCEPTION_CODE;
+    DDS_UnsignedLong member_idx = 0;
+
+    member_idx = DDS_TypeCode_find_member_by_name(tc, member_name, &ex);
+    if (ex != DDS_NO_EXCEPTION_CODE) {
+        RTI_MQTT_ERROR_1("failed to find member:", "%s", member_name)
+        goto done;
+    }
+
+    *id_out = DDS_TypeCode_member_id(tc, member_idx, &ex);
+    if (ex != DDS_NO_EXCEPTION_CODE) {
+        RTI_MQTT_ERROR_1("failed to get member id:", "%s", member_name)
+        goto done;
+    }
+
+    if (member_tc_out != NULL) {
+        *member_tc_out = DDS_TypeCode_member_type(tc, member_idx, &ex);
+        if (ex != DDS_NO_EXCEPTION_CODE) {
+            RTI_MQTT_ERROR_1("failed to get member type:", "%s", member_name)
+            goto done;
+        }
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+DDS_ReturnCode_t RTI_MQTT_MessageMemberIds_initialize(
+        struct RTI_MQTT_MessageMemberIds *self)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    const DDS_TypeCode *msg_tc = RTI_MQTT_Message_get_typecode();
+    DDS_TypeCode *info_tc = NULL, *payload_tc = NULL;
+
+    if (DDS_RETCODE_OK
+                != RTI_MQTT_MessageMemberIds_lookup(
+                        msg_tc,
+                        "topic",
+                        &self->topic,
+                        NULL)
+        || DDS_RETCODE_OK
+                != RTI_MQTT_MessageMemberIds_lookup(
+                        msg_tc,
+                        "info",
+                        &self->info,
+                        &info_tc)
+        || DDS_RETCODE_OK
+                != RTI_MQTT_MessageMemberIds_lookup(
+                        msg_tc,
+                        "payload",
+                        &self->payload,
+                        &payload_tc)) {
+        goto done;
+    }
+
+    if (DDS_RETCODE_OK
+                != RTI_MQTT_MessageMemberIds_lookup(
+                        info_tc,
+                        "id",
+                        &self->info_id,
+                        NULL)
+        || DDS_RETCODE_OK
+                != RTI_MQTT_MessageMemberIds_lookup(
+                        info_tc,
+                        "qos_level",
+                        &self->info_qos_level,
+                        NULL)
+        || DDS_RETCODE_OK
+                != RTI_MQTT_MessageMemberIds_lookup(
+                        info_tc,
+                        "retained",
+                        &self->info_retained,
+                        NULL)
+        || DDS_RETCODE_OK
+                != RTI_MQTT_MessageMemberIds_lookup(
+                        info_tc,
+                        "duplicate",
+                        &self->info_duplicate,
+                        NULL)) {
+        goto done;
+    }
+
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_MessageMemberIds_lookup(
+                payload_tc,
+                "data",
+                &self->payload_data,
+                NULL)) {
+        goto done;
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+/* Positions in a ring buffer of `size_` elements wrap around at the largest
+   multiple of `size_` which fits in a DDS_UnsignedLong, so that they can be
+   mapped to an index with a modulo, and so that a position is not reused
+   until after billions of messages. */
+#define RTI_MQTT_RingPosition_max(size_) ((0xFFFFFFFF / (size_)) * (size_))
+
+#define RTI_MQTT_RingPosition_advance(p_, max_) \
+    (((p_) + 1 == (max_)) ? 0 : (p_) + 1)
+
+#define RTI_MQTT_RingPosition_add(p_, n_, max_) \
+    (((p_) >= (max_) - (n_)) ? (p_) - ((max_) - (n_)) : (p_) + (n_))
+
+#define RTI_MQTT_RingPosition_subtract(p_, n_, max_) \
+    (((p_) >= (n_)) ? (p_) - (n_) : (max_) - (n_) + (p_))
+
+/* Take a sample from the pool, or return NULL if the pool is empty. May be
+   called concurrently by the producer and the consumer. */
+static DDS_DynamicData *RTI_MQTT_MessageReceiveQueue_take_pooled_sample(
+        struct RTI_MQTT_MessageReceiveQueue *self)
+{
+    DDS_DynamicData *sample = NULL;
+    DDS_UnsignedLong head = 0, *sequence = NULL;
+
+    /* A slot is claimed by advancing `pool_head` past it, after checking
+       that it stores a sample. If `pool_head` was read before another
+       thread advanced it, the slot may have been claimed, or even refilled,
+       in the meantime, so the compare-and-swap fails and we try again. */
+    do {
+        head = RTI_MQTT_Atomic_load(&self->pool_head);
+        if (head == RTI_MQTT_Atomic_load(&self->pool_tail)) {
+            return NULL;
+        }
+        sequence = DDS_UnsignedLongSeq_get_reference(
+                &self->pool_sequences,
+                head % self->sample_pool_max);
+    } while (RTI_MQTT_Atomic_load(sequence)
+                     != RTI_MQTT_RingPosition_advance(
+                             head,
+                             self->pool_position_max)
+             || !RTI_MQTT_Atomic_compare_and_swap(
+                     &self->pool_head,
+                     head,
+                     RTI_MQTT_RingPosition_advance(
+                             head,
+                             self->pool_position_max)));
+
+    sample = *RTI_MQTT_DDS_DynamicDataPtrSeq_get_reference(
+            &self->sample_pool,
+            head % self->sample_pool_max);
+
+    /* Free the slot for the sample that will be returned to it after
+       `sample_pool_max` more positions */
+    RTI_MQTT_Atomic_store(
+            sequence,
+            RTI_MQTT_RingPosition_add(
+                    head,
+                    self->sample_pool_max,
+                    self->pool_position_max));
+
+    return sample;
+}
+
+/* Take a sample from the pool, or allocate a new one if the pool is empty.
+   The producer sets `receiver` to reuse its spare sample first. */
+static DDS_DynamicData *RTI_MQTT_MessageReceiveQueue_acquire_sample(
+        struct RTI_MQTT_MessageReceiveQueue *self,
+        DDS_Boolean receiver)
+{
+    DDS_DynamicData *sample = NULL;
+
+    if (receiver && self->spare_sample != NULL) {
+        sample = self->spare_sample;
+        self->spare_sample = NULL;
+        return sample;
+    }
+
+    sample = RTI_MQTT_MessageReceiveQueue_take_pooled_sample(self);
+    if (sample != NULL) {
+        return sample;
+    }
+
+    return DDS_DynamicDataTypeSupport_create_data(self->dyn_data);
+}
+
+/* Return a sample to the pool, or delete it if the pool is already full.
+   Must only be called by the consumer, with self->lock held. */
+static void RTI_MQTT_MessageReceiveQueue_release_sample(
+        struct RTI_MQTT_MessageReceiveQueue *self,
+        DDS_DynamicData *sample)
+{
+    DDS_UnsignedLong tail = self->pool_tail, *sequence = NULL;
+
+    sequence = DDS_UnsignedLongSeq_get_reference(
+            &self->pool_sequences,
+            tail % self->sample_pool_max);
+
+    /* The slot is not free if the pool is full, or if the sample it stores
+       was claimed but has not been copied out of it yet. The sample is
+       deleted in both cases, since the pool is (nearly) full anyway. */
+    if (RTI_MQTT_Atomic_load(sequence) == tail) {
+        *RTI_MQTT_DDS_DynamicDataPtrSeq_get_reference(
+                &self->sample_pool,
+                tail % self->sample_pool_max) = sample;
+        RTI_MQTT_Atomic_store(
+                sequence,
+                RTI_MQTT_RingPosition_advance(tail, self->pool_position_max));
+        RTI_MQTT_Atomic_store(
+                &self->pool_tail,
+                RTI_MQTT_RingPosition_advance(tail, self->pool_position_max));
+        return;
+    }
+
+    if (!DDS_DynamicDataTypeSupport_delete_data(self->dyn_data, sample)) {
+        /* TODO Log error */
+    }
+}
+
+/* Dispose of a sample on behalf of the producer, which keeps it for the next
+   message it receives, unless it is already holding a spare sample. */
+static void RTI_MQTT_MessageReceiveQueue_release_received_sample(
+        struct RTI_MQTT_MessageReceiveQueue *self,
+        DDS_DynamicData *sample)
+{
+    if (self->spare_sample == NULL) {
+        self->spare_sample = sample;
+        return;
+    }
+
+    if (!DDS_DynamicDataTypeSupport_delete_data(self->dyn_data, sample)) {
+        /* TODO Log error */
+    }
+}
+
+static void RTI_MQTT_MessageReceiveQueue_finalize_pool(
+        struct RTI_MQTT_MessageReceiveQueue *self)
+{
+    DDS_DynamicData *sample = NULL;
+
+    while (NULL
+           != (sample = RTI_MQTT_MessageReceiveQueue_take_pooled_sample(
+                       self))) {
+        if (!DDS_DynamicDataTypeSupport_delete_data(self->dyn_data, sample)) {
+            /* TODO Log error */
+        }
+    }
+
+    if (self->spare_sample != NULL) {
+        if (!DDS_DynamicDataTypeSupport_delete_data(
+                    self->dyn_data,
+                    self->spare_sample)) {
+            /* TODO Log error */
+        }
+        self->spare_sample = NULL;
+    }
+
+    if (!RTI_MQTT_DDS_DynamicDataPtrSeq_finalize(&self->sample_pool)) {
+        RTI_MQTT_LOG_FINALIZE_SEQUENCE_FAILED(&self->sample_pool)
+    }
+
+    if (!DDS_UnsignedLongSeq_finalize(&self->pool_sequences)) {
+        RTI_MQTT_LOG_FINALIZE_SEQUENCE_FAILED(&self->pool_sequences)
+    }
+
+    if (self->member_binder != NULL) {
+        DDS_DynamicData_delete(self->member_binder);
+        self->member_binder = NULL;
+    }
+    if (self->read_member_binder != NULL) {
+        DDS_DynamicData_delete(self->read_member_binder);
+        self->read_member_binder = NULL;
+    }
+}
+
+static DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_initialize_pool(
+        struct RTI_MQTT_MessageReceiveQueue *self)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    DDS_UnsignedLong pool_len = 0, i = 0;
+
+    if (!RTI_MQTT_DDS_DynamicDataPtrSeq_initialize(&self->sample_pool)) {
+        RTI_MQTT_LOG_INITIALIZE_SEQUENCE_FAILED(&self->sample_pool)
+        goto done;
+    }
+
+    if (!DDS_UnsignedLongSeq_initialize(&self->pool_sequences)) {
+        RTI_MQTT_LOG_INITIALIZE_SEQUENCE_FAILED(&self->pool_sequences)
+        goto done;
+    }
+
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_MessageMemberIds_initialize(&self->member_ids)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    self->member_binder =
+            DDS_DynamicData_new(NULL, &DDS_DYNAMIC_DATA_PROPERTY_DEFAULT);
+    if (self->member_binder == NULL) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    self->read_member_binder =
+            DDS_DynamicData_new(NULL, &DDS_DYNAMIC_DATA_PROPERTY_DEFAULT);
+    if (self->read_member_binder == NULL) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    /* A circular queue may store up to `capacity` messages while a reader
+     * holds a loan on as many more, so that is the most samples that will
+     * ever be in use at the same time. */
+    if (self->capacity > 0) {
+        pool_len = self->capacity;
+        self->sample_pool_max = 2 * self->capacity;
+    } else {
+        pool_len = RTI_MQTT_MESSAGE_RECEIVE_QUEUE_UNBOUNDED_POOL_SIZE;
+        self->sample_pool_max =
+                RTI_MQTT_MESSAGE_RECEIVE_QUEUE_UNBOUNDED_POOL_SIZE;
+    }
+    self->pool_position_max =
+            RTI_MQTT_RingPosition_max(self->sample_pool_max);
+
+    if (!RTI_MQTT_DDS_DynamicDataPtrSeq_ensure_length(
+                &self->sample_pool,
+                self->sample_pool_max,
+                self->sample_pool_max)) {
+        RTI_MQTT_LOG_SET_SEQUENCE_ENSURE_LENGTH_FAILED(
+                &self->sample_pool,
+                self->sample_pool_max,
+                self->sample_pool_max)
+        goto done;
+    }
+
+    if (!DDS_UnsignedLongSeq_ensure_length(
+                &self->pool_sequences,
+                self->sample_pool_max,
+                self->sample_pool_max)) {
+        RTI_MQTT_LOG_SET_SEQUENCE_ENSURE_LENGTH_FAILED(
+                &self->pool_sequences,
+                self->sample_pool_max,
+                self->sample_pool_max)
+        goto done;
+    }
+
+    for (i = 0; i < self->sample_pool_max; i++) {
+        *DDS_UnsignedLongSeq_get_reference(&self->pool_sequences, i) = i;
+    }
+
+    for (i = 0; i < pool_len; i++) {
+        DDS_DynamicData *sample =
+                DDS_DynamicDataTypeSupport_create_data(self->dyn_data);
+        if (sample == NULL) {
+            /* TODO Log error */
+            goto done;
+        }
+        RTI_MQTT_MessageReceiveQueue_release_sample(self, sample);
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    if (DDS_RETCODE_OK != retval) {
+        RTI_MQTT_MessageReceiveQueue_finalize_pool(self);
+    }
+    return retval;
+}
+
+/* Equivalent to RTI_MQTT_Message_to_dynamic_data(), but accessing all
+   members by their cached ids. Since samples are recycled, optional members
+   which are not part of the message are explicitly cleared. */
+static DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_fill_sample(
+        struct RTI_MQTT_MessageReceiveQueue *self,
+        RTI_MQTT_Message *msg,
+        DDS_DynamicData *binder,
+        DDS_DynamicData *sample)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    DDS_Boolean bound = DDS_BOOLEAN_FALSE;
+    const struct RTI_MQTT_MessageMemberIds *ids = &self->member_ids;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_MessageReceiveQueue_fill_sample)
+
+    if (msg->topic != NULL) {
+        if (DDS_RETCODE_OK
+            != DDS_DynamicData_set_string(
+                    sample,
+                    NULL,
+                    ids->topic,
+                    msg->topic)) {
+            /* TODO Log error */
+            goto done;
+        }
+    } else if (
+            DDS_RETCODE_OK
+            != DDS_DynamicData_clear_optional_member(
+                    sample,
+                    NULL,
+                    ids->topic)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    if (msg->info != NULL) {
+        if (DDS_RETCODE_OK
+            != DDS_DynamicData_bind_complex_member(
+                    sample,
+                    binder,
+                    NULL,
+                    ids->info)) {
+            /* TODO Log error */
+            goto done;
+        }
+        bound = DDS_BOOLEAN_TRUE;
+
+        if (DDS_RETCODE_OK
+                    != DDS_DynamicData_set_long(
+                            binder,
+                            NULL,
+                            ids->info_id,
+                            msg->info->id)
+            || DDS_RETCODE_OK
+                    != DDS_DynamicData_set_long(
+                            binder,
+                            NULL,
+                            ids->info_qos_level,
+                            msg->info->qos_level)
+            || DDS_RETCODE_OK
+                    != DDS_DynamicData_set_boolean(
+                            binder,
+                            NULL,
+                            ids->info_retained,
+                            msg->info->retained)
+            || DDS_RETCODE_OK
+                    != DDS_DynamicData_set_boolean(
+                            binder,
+                            NULL,
+                            ids->info_duplicate,
+                            msg->info->duplicate)) {
+            /* TODO Log error */
+            goto done;
+        }
+
+        bound = DDS_BOOLEAN_FALSE;
+        if (DDS_RETCODE_OK
+            != DDS_DynamicData_unbind_complex_member(
+                    sample,
+                    binder)) {
+            /* TODO Log error */
+            goto done;
+        }
+    } else if (
+            DDS_RETCODE_OK
+            != DDS_DynamicData_clear_optional_member(sample, NULL, ids->info)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    if (DDS_RETCODE_OK
+        != DDS_DynamicData_bind_complex_member(
+                sample,
+                binder,
+                NULL,
+                ids->payload)) {
+        /* TODO Log error */
+        goto done;
+    }
+    bound = DDS_BOOLEAN_TRUE;
+
+    if (DDS_RETCODE_OK
+        != DDS_DynamicData_set_octet_seq(
+                binder,
+                NULL,
+                ids->payload_data,
+                &msg->payload.data)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    if (bound) {
+        if (DDS_RETCODE_OK
+            != DDS_DynamicData_unbind_complex_member(
+                    sample,
+                    binder)) {
+            /* TODO Log error */
+            retval = DDS_RETCODE_ERROR;
+        }
+    }
+    return retval;
+}
+
+/* Copy a message whose copy was deferred when it was received into a
+   DynamicData sample, and return its buffers to the MQTT client library.
+   Must only be called by the consumer, with self->lock held. */
+static DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_fill_from_deferred(
+        struct RTI_MQTT_MessageReceiveQueue *self,
+        struct RTI_MQTT_ReceivedMessage *rcvd_msg)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    DDS_DynamicData *sample = NULL;
+    RTI_MQTT_Message msg_static;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_MessageReceiveQueue_fill_from_deferred)
+
+    sample = RTI_MQTT_MessageReceiveQueue_acquire_sample(
+            self,
+            DDS_BOOLEAN_FALSE);
+    if (sample == NULL) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    msg_static.topic = rcvd_msg->deferred.topic;
+    msg_static.info = &rcvd_msg->deferred.info;
+
+    if (!DDS_OctetSeq_initialize(&msg_static.payload.data)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    if (!DDS_OctetSeq_loan_contiguous(
+                &msg_static.payload.data,
+                (DDS_Octet *) rcvd_msg->deferred.payload,
+                rcvd_msg->deferred.payload_len,
+                rcvd_msg->deferred.payload_len)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_MessageReceiveQueue_fill_sample(
+                self,
+                &msg_static,
+                self->read_member_binder,
+                sample)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    RTI_MQTT_DeferredMessage_release(&rcvd_msg->deferred);
+    rcvd_msg->message = sample;
+    sample = NULL;
+
+    retval = DDS_RETCODE_OK;
+done:
+    if (sample != NULL) {
+        RTI_MQTT_MessageReceiveQueue_release_sample(self, sample);
+    }
+    return retval;
+}
+
 DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_new(
         DDS_UnsignedLong size,
         RTI_MQTT_SubscriptionMessageStatus *msg_status,
@@ -242,6 +802,7 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_initialize_circular(
             RTI_MQTT_LOG_RECEIVED_MESSAGE_CREATE_FAILED()
             goto done;
         }
+        msg->sequence = i;
         *msg_ref = msg;
 
         initd_msgs += 1;
@@ -306,19 +867,26 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_initialize(
         DDS_UnsignedLong size,
         RTI_MQTT_SubscriptionMessageStatus *msg_status)
 {
-    DDS_Boolean queue_initd = DDS_BOOLEAN_FALSE, lock_initd = DDS_BOOLEAN_FALSE;
+    DDS_Boolean queue_initd = DDS_BOOLEAN_FALSE, lock_initd = DDS_BOOLEAN_FALSE,
+                pool_initd = DDS_BOOLEAN_FALSE;
     DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
     DDS_UnsignedLong i = 0, initd_msgs = 0;
 
     self->capacity = size;
-    self->size = 0;
     self->head = 0;
     self->next = 0;
-    self->next_unread = 0;
+    self->position_max = (size > 0) ? RTI_MQTT_RingPosition_max(size) : 0;
     self->listener_data_avail = NULL;
     self->listener_data_avail_arg = NULL;
     self->dyn_data = NULL;
     self->msg_status = msg_status;
+    self->sample_pool_max = 0;
+    self->pool_head = 0;
+    self->pool_tail = 0;
+    self->pool_position_max = 0;
+    self->spare_sample = NULL;
+    self->member_binder = NULL;
+    self->read_member_binder = NULL;
 
     if (DDS_RETCODE_OK != RTI_MQTT_Mutex_initialize(&self->lock)) {
         /* TODO Log error */
@@ -340,6 +908,12 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_initialize(
         goto done;
     }
 
+    if (DDS_RETCODE_OK != RTI_MQTT_MessageReceiveQueue_initialize_pool(self)) {
+        /* TODO Log error */
+        goto done;
+    }
+    pool_initd = DDS_BOOLEAN_TRUE;
+
     if (self->capacity > 0) {
         if (DDS_RETCODE_OK
             != RTI_MQTT_MessageReceiveQueue_initialize_circular(self)) {
@@ -366,6 +940,9 @@ done:
                 if (!RTI_MQTT_ReceivedMessagePtrSeq_finalize(&self->queue)) {
                     RTI_MQTT_LOG_FINALIZE_SEQUENCE_FAILED(&self->queue)
                 }
+                if (pool_initd) {
+                    RTI_MQTT_MessageReceiveQueue_finalize_pool(self);
+                }
                 if (self->dyn_data != NULL) {
                     DDS_DynamicDataTypeSupport_delete(self->dyn_data);
                     self->dyn_data = NULL;
@@ -381,18 +958,37 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_finalize(
         struct RTI_MQTT_MessageReceiveQueue *self)
 {
     DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
-    DDS_UnsignedLong seq_len = 0, i = 0;
+    DDS_UnsignedLong seq_len = 0, i = 0, pos = 0;
+
+    /* The slots of a circular queue which are not between head and next
+       may still reference messages which were already read */
+    if (self->capacity > 0) {
+        for (pos = self->head; pos != self->next;
+             pos = RTI_MQTT_RingPosition_advance(pos, self->position_max)) {
+            struct RTI_MQTT_ReceivedMessage *msg =
+                    *RTI_MQTT_ReceivedMessagePtrSeq_get_reference(
+                            &self->queue,
+                            pos % self->capacity);
+            if (msg->message != NULL) {
+                DDS_DynamicDataTypeSupport_delete_data(
+                        self->dyn_data,
+                        msg->message);
+            }
+            RTI_MQTT_DeferredMessage_release(&msg->deferred);
+        }
+    }
 
     seq_len = RTI_MQTT_ReceivedMessagePtrSeq_get_length(&self->queue);
     for (i = 0; i < seq_len; i++) {
         struct RTI_MQTT_ReceivedMessage *msg =
                 *RTI_MQTT_ReceivedMessagePtrSeq_get_reference(&self->queue, i);
-        if (msg->message != NULL) {
+        if (self->capacity == 0 && msg->message != NULL) {
             DDS_DynamicDataTypeSupport_delete_data(
                     self->dyn_data,
                     msg->message);
-            msg->message = NULL;
         }
+        msg->message = NULL;
+        msg->deferred.message = NULL;
         RTI_MQTT_ReceivedMessage_delete(msg);
     }
 
@@ -404,6 +1000,8 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_finalize(
         RTI_MQTT_LOG_FINALIZE_SEQUENCE_FAILED(&self->read_buffer)
     }
 
+    RTI_MQTT_MessageReceiveQueue_finalize_pool(self);
+
     if (self->dyn_data != NULL) {
         DDS_DynamicDataTypeSupport_delete(self->dyn_data);
         self->dyn_data = NULL;
@@ -418,38 +1016,99 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_finalize(
     return retval;
 }
 
-void RTI_MQTT_MessageReceiveQueue_receive_circular(
+/* Remove the message at position `pos` from a circular queue, if it is
+   still the oldest unread message, and copy it into `msg_out`. May be called
+   concurrently by the producer and the consumer. */
+static DDS_Boolean RTI_MQTT_MessageReceiveQueue_claim_circular(
+        struct RTI_MQTT_MessageReceiveQueue *self,
+        DDS_UnsignedLong pos,
+        struct RTI_MQTT_ReceivedMessage *msg_out)
+{
+    struct RTI_MQTT_ReceivedMessage *slot = NULL;
+    DDS_UnsignedLong pos_next =
+            RTI_MQTT_RingPosition_advance(pos, self->position_max);
+
+    slot = *RTI_MQTT_ReceivedMessagePtrSeq_get_reference(
+            &self->queue,
+            pos % self->capacity);
+
+    if (RTI_MQTT_Atomic_load(&slot->sequence) != pos_next
+        || !RTI_MQTT_Atomic_compare_and_swap(&self->head, pos, pos_next)) {
+        return DDS_BOOLEAN_FALSE;
+    }
+
+    *msg_out = *slot;
+
+    /* Free the slot for the message that will be stored in it after
+       `capacity` more positions */
+    RTI_MQTT_Atomic_store(
+            &slot->sequence,
+            RTI_MQTT_RingPosition_add(pos, self->capacity, self->position_max));
+
+    return DDS_BOOLEAN_TRUE;
+}
+
+/* Store a message in a circular queue, dropping the oldest unread
+   message if the queue is full. Must only be called by the producer. */
+static void RTI_MQTT_MessageReceiveQueue_receive_circular(
         struct RTI_MQTT_MessageReceiveQueue *self,
         DDS_DynamicData *msg,
+        struct RTI_MQTT_DeferredMessage *deferred,
         DDS_DynamicData **dropped_out,
         DDS_Boolean *lost_out)
 {
     DDS_Boolean lost = DDS_BOOLEAN_FALSE;
     DDS_DynamicData *dropped = NULL;
-    struct RTI_MQTT_ReceivedMessage *msg_new = NULL;
-    DDS_UnsignedLong seq_len = 0, i = 0;
+    struct RTI_MQTT_ReceivedMessage *msg_new = NULL, msg_old;
+    DDS_UnsignedLong oldest = 0, next = self->next;
 
     msg_new = *RTI_MQTT_ReceivedMessagePtrSeq_get_reference(
             &self->queue,
-            self->next);
+            next % self->capacity);
+
+    /* If the slot is not free, the queue is full and the slot stores the
+       oldest unread message. Try to remove it. If the consumer claimed it
+       first, wait for it to be copied out of the slot instead. */
+    if (RTI_MQTT_Atomic_load(&msg_new->sequence) != next) {
+        oldest = RTI_MQTT_RingPosition_subtract(
+                next,
+                self->capacity,
+                self->position_max);
+        lost = RTI_MQTT_MessageReceiveQueue_claim_circular(
+                self,
+                oldest,
+                &msg_old);
+        while (RTI_MQTT_Atomic_load(&msg_new->sequence) != next) {
+            RTI_MQTT_Thread_yield();
+        }
+    }
 
-    if (msg_new->message != NULL) {
-        dropped = msg_new->message;
-        lost = dropped != NULL;
+    if (lost) {
+        if (msg_old.message != NULL) {
+            dropped = msg_old.message;
+        } else {
+            /* The message was never read, so it was never copied either */
+            RTI_MQTT_DeferredMessage_release(&msg_old.deferred);
+        }
     }
-    msg_new->message = msg;
 
-    if (self->size < self->capacity) {
-        self->size += 1;
+    msg_new->message = msg;
+    msg_new->read = DDS_BOOLEAN_FALSE;
+    if (deferred != NULL) {
+        deferred->owned = DDS_BOOLEAN_TRUE;
+        msg_new->deferred = *deferred;
     } else {
-        self->head = (self->head += 1) % self->capacity;
+        msg_new->deferred.message = NULL;
+        msg_new->deferred.topic = NULL;
     }
 
-    self->next = (self->next + 1) % self->capacity;
-
-    if (lost) {
-        self->next_unread = (self->next_unread + 1) % self->capacity;
-    }
+    /* Publish the message to the consumer */
+    RTI_MQTT_Atomic_store(
+            &msg_new->sequence,
+            RTI_MQTT_RingPosition_advance(next, self->position_max));
+    RTI_MQTT_Atomic_store(
+            &self->next,
+            RTI_MQTT_RingPosition_advance(next, self->position_max));
 
     if (self->listener_data_avail != NULL) {
         self->listener_data_avail(self, self->listener_data_avail_arg);
@@ -463,6 +1122,29 @@ void RTI_MQTT_MessageReceiveQueue_receive_circular(
     }
 }
 
+/* Remove the oldest message from a circular queue. Must only be called by
+   the consumer. */
+static DDS_Boolean RTI_MQTT_MessageReceiveQueue_take_circular(
+        struct RTI_MQTT_MessageReceiveQueue *self,
+        struct RTI_MQTT_ReceivedMessage *msg_out)
+{
+    DDS_UnsignedLong head = 0;
+
+    /* The claim only fails if the producer dropped the message at `head`
+       in the meantime, in which case the next one is tried */
+    do {
+        head = RTI_MQTT_Atomic_load(&self->head);
+        if (head == RTI_MQTT_Atomic_load(&self->next)) {
+            return DDS_BOOLEAN_FALSE;
+        }
+    } while (!RTI_MQTT_MessageReceiveQueue_claim_circular(
+            self,
+            head,
+            msg_out));
+
+    return DDS_BOOLEAN_TRUE;
+}
+
 static DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_receive_unbounded(
         struct RTI_MQTT_MessageReceiveQueue *self,
         DDS_DynamicData *msg,
@@ -504,12 +1186,8 @@ done:
     if (retval != DDS_RETCODE_OK) {
         if (msg_ref != NULL) {
             if (*msg_ref != NULL) {
-                if ((*msg_ref)->message != NULL) {
-                    DDS_DynamicDataTypeSupport_delete_data(
-                            self->dyn_data,
-                            (*msg_ref)->message);
-                    (*msg_ref)->message = NULL;
-                }
+                /* The message is returned to the pool by the caller */
+                (*msg_ref)->message = NULL;
 
                 RTI_MQTT_ReceivedMessage_delete(*msg_ref);
             }
@@ -536,12 +1214,13 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_receive(
         DDS_UnsignedLong buffer_len,
         const char *topic,
         RTI_MQTT_MessageInfo *msg_info,
+        struct RTI_MQTT_DeferredMessage *deferred,
         DDS_DynamicData **dropped_out,
         DDS_Boolean *lost_out)
 {
     DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
     DDS_Boolean lost = DDS_BOOLEAN_FALSE, locked = DDS_BOOLEAN_FALSE;
-    DDS_DynamicData *msg = NULL;
+    DDS_DynamicData *msg = NULL, *dropped = NULL;
     RTI_MQTT_Message msg_static;
 
     if (dropped_out != NULL) {
@@ -551,42 +1230,69 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_receive(
         *lost_out = DDS_BOOLEAN_FALSE;
     }
 
-    msg = DDS_DynamicDataTypeSupport_create_data(self->dyn_data);
-    if (msg == NULL) {
-        /* TODO Log error */
-        goto done;
+    /* Deferred messages can only be tracked by the slots of a circular
+       queue */
+    if (self->capacity == 0) {
+        deferred = NULL;
     }
-    msg_static.topic = (char *) topic;
 
-    if (!DDS_OctetSeq_initialize(&msg_static.payload.data)) {
-        /* TODO Log error */
-        goto done;
-    }
+    if (deferred == NULL) {
+        msg = RTI_MQTT_MessageReceiveQueue_acquire_sample(
+                self,
+                DDS_BOOLEAN_TRUE);
+        if (msg == NULL) {
+            /* TODO Log error */
+            goto done;
+        }
+        msg_static.topic = (char *) topic;
 
-    if (!DDS_OctetSeq_loan_contiguous(
-                &msg_static.payload.data,
-                (DDS_Octet *) buffer,
-                buffer_len,
-                buffer_len)) {
-        /* TODO Log error */
-        goto done;
-    }
-    msg_static.info = msg_info;
+        if (!DDS_OctetSeq_initialize(&msg_static.payload.data)) {
+            /* TODO Log error */
+            goto done;
+        }
 
-    if (DDS_RETCODE_OK != RTI_MQTT_Message_to_dynamic_data(&msg_static, msg)) {
-        /* TODO Log error */
-        goto done;
-    }
+        if (!DDS_OctetSeq_loan_contiguous(
+                    &msg_static.payload.data,
+                    (DDS_Octet *) buffer,
+                    buffer_len,
+                    buffer_len)) {
+            /* TODO Log error */
+            goto done;
+        }
+        msg_static.info = msg_info;
 
-    RTI_MQTT_Mutex_assert_w_state(&self->lock, &locked);
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_MessageReceiveQueue_fill_sample(
+                    self,
+                    &msg_static,
+                    self->member_binder,
+                    msg)) {
+            /* TODO Log error */
+            goto done;
+        }
+    }
 
     if (self->capacity > 0) {
+        /* Circular queues are shared with the reader without locking */
         RTI_MQTT_MessageReceiveQueue_receive_circular(
             self,
             msg,
-            dropped_out,
+            deferred,
+            &dropped,
             &lost);
+        msg = NULL;
+        /* Unless the caller asked for it, recycle the overwritten sample */
+        if (dropped != NULL) {
+            if (dropped_out != NULL) {
+                *dropped_out = dropped;
+            } else {
+                RTI_MQTT_MessageReceiveQueue_release_received_sample(
+                        self,
+                        dropped);
+            }
+        }
     } else {
+        RTI_MQTT_Mutex_assert_w_state(&self->lock, &locked);
         if (DDS_RETCODE_OK
             != RTI_MQTT_MessageReceiveQueue_receive_unbounded(
                     self,
@@ -596,14 +1302,17 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_receive(
             RTI_MQTT_LOG_MSG_RECV_QUEUE_RECEIVE_UNBOUNDED_FAILED(self)
             goto done;
         }
+        msg = NULL;
+        RTI_MQTT_Mutex_release_w_state(&self->lock, &locked);
     }
 
-    /* Update message state */
-    self->msg_status->received_count += 1;
-    self->msg_status->unread_count += 1;
+    /* Update message state. The counters are also updated by the reader,
+       which may not hold the same lock. */
+    RTI_MQTT_Atomic_add(&self->msg_status->received_count, 1);
     if (lost) {
-        self->msg_status->lost_count += 1;
-        self->msg_status->unread_count -= 1;
+        RTI_MQTT_Atomic_add(&self->msg_status->lost_count, 1);
+    } else {
+        RTI_MQTT_Atomic_add(&self->msg_status->unread_count, 1);
     }
 
     if (lost_out != NULL) {
@@ -612,11 +1321,14 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_receive(
 
     retval = DDS_RETCODE_OK;
 done:
-
     if (locked) {
-        RTI_MQTT_MessageReceiveQueue_log_message_state(self);
         RTI_MQTT_Mutex_release_w_state(&self->lock, &locked);
     }
+    if (msg != NULL) {
+        RTI_MQTT_MessageReceiveQueue_release_received_sample(self, msg);
+    }
+
+    RTI_MQTT_MessageReceiveQueue_log_message_state(self);
 
     return retval;
 }
@@ -628,10 +1340,9 @@ static DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_read_circular(
         struct DDS_DynamicDataSeq *messages)
 {
     DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
-    DDS_UnsignedLong i = 0, idx = 0, tot_messages = 0, messages_max = 0,
-                     loaned_max = 0;
-    DDS_Boolean loan = DDS_BOOLEAN_FALSE;
-    struct RTI_MQTT_ReceivedMessage *rcvd_msg = NULL;
+    DDS_UnsignedLong i = 0, tot_messages = 0, messages_max = 0;
+    DDS_Boolean loan = DDS_BOOLEAN_FALSE, taken = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_ReceivedMessage rcvd_msg;
 
     RTI_MQTT_LOG_FN(RTI_MQTT_MessageReceiveQueue_read_circular)
 
@@ -681,34 +1392,42 @@ static DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_read_circular(
         }
     }
 
-    for (i = 0, idx = self->next_unread; i < max_messages && idx != self->next;
-         i++, idx = (self->next_unread + i) % self->capacity) {
-        struct RTI_MQTT_ReceivedMessage **rcvd_msg_ref =
-                RTI_MQTT_ReceivedMessagePtrSeq_get_reference(&self->queue, idx);
+    for (i = 0; i < max_messages; i++) {
+        /* Each message is copied out of its slot when it is removed from
+           the queue, and it is then stored into a sample outside of it */
+        taken = RTI_MQTT_MessageReceiveQueue_take_circular(self, &rcvd_msg);
+        if (!taken) {
+            break;
+        }
 
-        rcvd_msg = *rcvd_msg_ref;
+        if (rcvd_msg.message == NULL) {
+            if (DDS_RETCODE_OK
+                != RTI_MQTT_MessageReceiveQueue_fill_from_deferred(
+                        self,
+                        &rcvd_msg)) {
+                /* TODO Log error */
+                goto done;
+            }
+        }
 
         if (loan) {
             *RTI_MQTT_DDS_DynamicDataPtrSeq_get_reference(
                     &self->read_buffer,
-                    i) = rcvd_msg->message;
-            rcvd_msg->message = NULL;
+                    i) = rcvd_msg.message;
         } else {
             if (!DDS_DynamicDataTypeSupport_copy_data(
                         self->dyn_data,
                         DDS_DynamicDataSeq_get_reference(messages, i),
-                        rcvd_msg->message)) {
+                        rcvd_msg.message)) {
                 /* TODO Log error */
                 goto done;
             }
-            if (!DDS_DynamicDataTypeSupport_delete_data(
-                        self->dyn_data,
-                        rcvd_msg->message)) {
-                /* TODO Log error */
-                goto done;
-            }
-            rcvd_msg->message = NULL;
+            RTI_MQTT_MessageReceiveQueue_release_sample(
+                    self,
+                    rcvd_msg.message);
         }
+        rcvd_msg.message = NULL;
+        taken = DDS_BOOLEAN_FALSE;
 
         tot_messages += 1;
     }
@@ -734,15 +1453,25 @@ static DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_read_circular(
         }
     }
 
-    self->next_unread = idx;
-    self->size -= tot_messages;
-    self->head = (self->head + tot_messages) % self->capacity;
-
     retval = DDS_RETCODE_OK;
 done:
     if (retval != DDS_RETCODE_OK) {
+        /* Messages already removed from the queue cannot be put back */
+        if (taken) {
+            if (rcvd_msg.message != NULL) {
+                RTI_MQTT_MessageReceiveQueue_release_sample(
+                        self,
+                        rcvd_msg.message);
+            }
+            RTI_MQTT_DeferredMessage_release(&rcvd_msg.deferred);
+            tot_messages += 1;
+        }
+        RTI_MQTT_Atomic_add(&self->msg_status->lost_count, tot_messages);
+        RTI_MQTT_Atomic_subtract(
+                &self->msg_status->unread_count,
+                tot_messages);
+
         if (self->read_buffer_loaned) {
-            self->msg_status->lost_count += tot_messages;
             if (DDS_RETCODE_OK
                 != RTI_MQTT_MessageReceiveQueue_return_loan(self, messages)) {
                 /* TODO Log error */
@@ -754,22 +1483,12 @@ done:
                                 &self->read_buffer,
                                 i);
                 if (*msg_ref != NULL) {
-                    if (!DDS_DynamicDataTypeSupport_delete_data(
-                                self->dyn_data,
-                                *msg_ref)) {
-                        /* TODO Log error */
-                    }
+                    RTI_MQTT_MessageReceiveQueue_release_sample(
+                            self,
+                            *msg_ref);
                     *msg_ref = NULL;
                 }
             }
-        } else if (rcvd_msg != NULL && rcvd_msg->message != NULL) {
-            if (!DDS_DynamicDataTypeSupport_delete_data(
-                        self->dyn_data,
-                        rcvd_msg->message)) {
-                /* TODO Log error */
-                goto done;
-            }
-            rcvd_msg->message = NULL;
         }
     }
 
@@ -871,12 +1590,9 @@ static DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_read_unbounded(
                 /* TODO Log error */
                 goto done;
             }
-            if (!DDS_DynamicDataTypeSupport_delete_data(
-                        self->dyn_data,
-                        rcvd_msg->message)) {
-                /* TODO Log error */
-                goto done;
-            }
+            RTI_MQTT_MessageReceiveQueue_release_sample(
+                    self,
+                    rcvd_msg->message);
             rcvd_msg->message = NULL;
         }
 
@@ -930,7 +1646,7 @@ static DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_read_unbounded(
     retval = DDS_RETCODE_OK;
 done:
     if (retval != DDS_RETCODE_OK) {
-        self->msg_status->lost_count += tot_messages;
+        RTI_MQTT_Atomic_add(&self->msg_status->lost_count, tot_messages);
 
         if (self->read_buffer_loaned) {
             if (DDS_RETCODE_OK
@@ -944,11 +1660,9 @@ done:
                                 &self->read_buffer,
                                 i);
                 if (*msg_ref != NULL) {
-                    if (!DDS_DynamicDataTypeSupport_delete_data(
-                                self->dyn_data,
-                                *msg_ref)) {
-                        /* TODO Log error */
-                    }
+                    RTI_MQTT_MessageReceiveQueue_release_sample(
+                            self,
+                            *msg_ref);
                     *msg_ref = NULL;
                 }
             }
@@ -995,8 +1709,8 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_read(
     messages_len = DDS_DynamicDataSeq_get_length(messages);
 
     /* Update message state */
-    self->msg_status->unread_count -= messages_len;
-    self->msg_status->read_count += messages_len;
+    RTI_MQTT_Atomic_subtract(&self->msg_status->unread_count, messages_len);
+    RTI_MQTT_Atomic_add(&self->msg_status->read_count, messages_len);
 
     retval = DDS_RETCODE_OK;
 done:
@@ -1048,7 +1762,7 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_return_loan(
             continue;
         }
 
-        DDS_DynamicDataTypeSupport_delete_data(self->dyn_data, *msg);
+        RTI_MQTT_MessageReceiveQueue_release_sample(self, *msg);
         *msg = NULL;
     }
 
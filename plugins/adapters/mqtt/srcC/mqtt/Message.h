@@ -20,9 +20,40 @@
 
 #include "Infrastructure.h"
 
+typedef void (*RTI_MQTT_DeferredMessage_ReleaseFn)(void *message, char *topic);
+
+/* A message received by the MQTT client library, which a message queue may
+   keep without copying it, deferring the copy of its payload into a sample
+   until the message is read. The queue takes ownership of the message by
+   setting `owned`, and it will later return it to the library using
+   `release`. */
+struct RTI_MQTT_DeferredMessage {
+    void *message;
+    char *topic;
+    const char *payload;
+    DDS_UnsignedLong payload_len;
+    RTI_MQTT_MessageInfo info;
+    RTI_MQTT_DeferredMessage_ReleaseFn release;
+    DDS_Boolean owned;
+};
+
+#define RTI_MQTT_DeferredMessage_release(d_)                   \
+    {                                                          \
+        if ((d_)->message != NULL) {                           \
+            (d_)->release((d_)->message, (d_)->topic);         \
+            (d_)->message = NULL;                              \
+            (d_)->topic = NULL;                                \
+        }                                                      \
+    }
+
 struct RTI_MQTT_ReceivedMessage {
     DDS_DynamicData *message;
     DDS_Boolean read;
+    /* A message which has not yet been stored into `message` */
+    struct RTI_MQTT_DeferredMessage deferred;
+    /* Sequence number of the slot of a circular queue which stores this
+       message (see RTI_MQTT_MessageReceiveQueue) */
+    DDS_UnsignedLong sequence;
 };
 
 DDS_ReturnCode_t
@@ -56,13 +87,54 @@ typedef void (*RTI_MQTT_MessageReceiveQueue_OnDataAvailableCallback)(
         struct RTI_MQTT_MessageReceiveQueue *queue,
         void *arg);
 
+/* Member IDs of the RTI_MQTT_Message type, resolved once when a receive
+   queue or a publication is created, so that messages can be accessed in
+   DynamicData samples without having to look up members by name. */
+struct RTI_MQTT_MessageMemberIds {
+    DDS_DynamicDataMemberId topic;
+    DDS_DynamicDataMemberId info;
+    DDS_DynamicDataMemberId info_id;
+    DDS_DynamicDataMemberId info_qos_level;
+    DDS_DynamicDataMemberId info_retained;
+    DDS_DynamicDataMemberId info_duplicate;
+    DDS_DynamicDataMemberId payload;
+    DDS_DynamicDataMemberId payload_data;
+};
+
+DDS_ReturnCode_t RTI_MQTT_MessageMemberIds_initialize(
+        struct RTI_MQTT_MessageMemberIds *self);
+
+/* Number of samples preallocated by an unbounded receive queue, which
+   cannot derive the size of its sample pool from its capacity. */
+#define RTI_MQTT_MESSAGE_RECEIVE_QUEUE_UNBOUNDED_POOL_SIZE 32
+
+/* A bounded queue (capacity > 0) is a lock-free ring buffer, with a single
+   producer (the receiving client, which serializes calls to
+   RTI_MQTT_MessageReceiveQueue_receive()) and a single consumer (the reader).
+   Positions in the ring increase monotonically, modulo `position_max`.
+   The producer is the only one to advance `next`, while `head` may be
+   advanced with a compare-and-swap both by the consumer, when it reads a
+   message, and by the producer, when it drops the oldest unread message
+   of a full queue.
+
+   Each slot has a sequence number, which is equal to the position of the
+   next message that may be stored in it while the slot is free, and to that
+   position plus one once the message is stored. Whoever advances `head`
+   claims the message at the old `head`, copies it out of its slot, and only
+   then frees the slot by adding `capacity` to its sequence number. The
+   producer never writes a slot which is not free, so a claimed message
+   cannot be overwritten while it is being copied: if the consumer claimed
+   the oldest message of a full queue, the producer waits for it to free the
+   slot instead of dropping a message.
+
+   The lock is only used by the consumer, and by the producer of an
+   unbounded queue. */
 struct RTI_MQTT_MessageReceiveQueue {
     RTI_MQTT_Mutex lock;
     DDS_UnsignedLong capacity;
-    DDS_UnsignedLong size;
     DDS_UnsignedLong head;
     DDS_UnsignedLong next;
-    DDS_UnsignedLong next_unread;
+    DDS_UnsignedLong position_max;
     struct RTI_MQTT_DDS_DynamicDataPtrSeq read_buffer;
     struct DDS_DynamicDataTypeSupport *dyn_data;
     DDS_Boolean read_buffer_loaned;
@@ -70,18 +142,37 @@ struct RTI_MQTT_MessageReceiveQueue {
     RTI_MQTT_MessageReceiveQueue_OnDataAvailableCallback listener_data_avail;
     void *listener_data_avail_arg;
     RTI_MQTT_SubscriptionMessageStatus *msg_status;
+    /* Samples which are not currently stored in the queue, nor loaned to a
+       reader, and which can be reused to store new messages. The pool is a
+       ring buffer like the queue, with one sequence number per slot in
+       `pool_sequences`. Samples are only returned to it by the consumer, and
+       they are taken from it with a compare-and-swap of `pool_head`. The
+       producer keeps the samples it discards in `spare_sample`. */
+    struct RTI_MQTT_DDS_DynamicDataPtrSeq sample_pool;
+    struct DDS_UnsignedLongSeq pool_sequences;
+    DDS_UnsignedLong sample_pool_max;
+    DDS_UnsignedLong pool_head;
+    DDS_UnsignedLong pool_tail;
+    DDS_UnsignedLong pool_position_max;
+    DDS_DynamicData *spare_sample;
+    struct RTI_MQTT_MessageMemberIds member_ids;
+    /* Used to bind the nested members of a sample while it is being filled.
+       Only accessed by RTI_MQTT_MessageReceiveQueue_receive(), whose
+       invocations are serialized by the owning client. */
+    DDS_DynamicData *member_binder;
+    /* Used like member_binder, to fill deferred messages when they are
+       read */
+    DDS_DynamicData *read_member_binder;
 };
 
 #define RTI_MQTT_LOG_MESSAGE_QUEUE_STATE(msg_, q_)                           \
-    RTI_MQTT_TRACE_8(                                                        \
+    RTI_MQTT_TRACE_6(                                                        \
             (msg_),                                                          \
-            "[cap=%u, size=%u, head=%u, next=%u, next_un=%u, queue.len=%u, " \
-            "queue.max=%u, loaned=%d]",                                      \
+            "[cap=%u, head=%u, next=%u, queue.len=%u, queue.max=%u, "        \
+            "loaned=%d]",                                                    \
             (q_)->capacity,                                                  \
-            (q_)->size,                                                      \
-            (q_)->head,                                                      \
-            (q_)->next,                                                      \
-            (q_)->next_unread,                                               \
+            RTI_MQTT_Atomic_load(&(q_)->head),                               \
+            RTI_MQTT_Atomic_load(&(q_)->next),                               \
             RTI_MQTT_ReceivedMessagePtrSeq_get_length(&(q_)->queue),         \
             RTI_MQTT_ReceivedMessagePtrSeq_get_maximum(&(q_)->queue),        \
             (q_)->read_buffer_loaned)
@@ -108,6 +199,7 @@ DDS_ReturnCode_t RTI_MQTT_MessageReceiveQueue_receive(
         DDS_UnsignedLong buffer_len,
         const char *topic,
         RTI_MQTT_MessageInfo *msg_info,
+        struct RTI_MQTT_DeferredMessage *deferred,
         DDS_DynamicData **dropped_out,
         DDS_Boolean *lost_out);
 
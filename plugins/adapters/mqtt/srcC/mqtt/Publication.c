@@ -36,6 +36,29 @@ static DDS_ReturnCode_t RTI_MQTT_Publication_store_topic(
         struct RTI_MQTT_Publication *self,
         const char *topic);
 
+static DDS_ReturnCode_t RTI_MQTT_Publication_reserve_topic(
+        struct RTI_MQTT_Publication *self,
+        DDS_UnsignedLong topic_max);
+
+static DDS_ReturnCode_t RTI_MQTT_Publication_read_topic(
+        struct RTI_MQTT_Publication *self,
+        DDS_DynamicData *message);
+
+static DDS_ReturnCode_t RTI_MQTT_Publication_read_message(
+        struct RTI_MQTT_Publication *self,
+        DDS_DynamicData *message,
+        DDS_Boolean use_message_info,
+        RTI_MQTT_WriteParams *params);
+
+static DDS_ReturnCode_t RTI_MQTT_Publication_acquire_inflight(
+        struct RTI_MQTT_Publication *self,
+        RTI_MQTT_QosLevel qos,
+        struct RTI_MQTT_PublicationInflightMessage **msg_out);
+
+static void RTI_MQTT_Publication_release_inflight(
+        struct RTI_MQTT_Publication *self,
+        struct RTI_MQTT_PublicationInflightMessage *msg);
+
 DDS_ReturnCode_t RTI_MQTT_Publication_new(
         struct RTI_MQTT_Client *client,
         RTI_MQTT_PublicationConfig *config,
@@ -95,9 +118,6 @@ DDS_ReturnCode_t RTI_MQTT_Publication_write(
 {
     DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
     RTI_MQTT_WriteParams params = RTI_MQTT_WriteParams_INITIALIZER;
-    char *payload_buffer = NULL, *topic = NULL;
-    DDS_UnsignedLong topic_len = 0, payload_len = 0;
-    struct DDS_OctetSeq payload = DDS_SEQUENCE_INITIALIZER;
     DDS_Boolean use_message_info = DDS_BOOLEAN_FALSE,
                 locked = DDS_BOOLEAN_FALSE;
 
@@ -123,74 +143,22 @@ DDS_ReturnCode_t RTI_MQTT_Publication_write(
     /* TODO RM Mutex: only used to protect self->data->config */
     RTI_MQTT_Mutex_release_w_state(&self->client->pub_lock, &locked);
 
-    if (use_message_info) {
-        if (!DDS_DynamicData_member_exists(
-                    message,
-                    "info",
-                    DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED)) {
-            RTI_MQTT_LOG_PUBLICATION_WRITE_MESSAGE_INFO_NOT_FOUND(self, message)
-            goto done;
-        }
-        if (DDS_RETCODE_OK
-            != DDS_DynamicData_get_long(
-                    message,
-                    (DDS_Long *) &params.qos_level,
-                    "info.qos_level",
-                    DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED)) {
-            /* TODO Log error */
-            goto done;
-        }
-        if (DDS_RETCODE_OK
-            != DDS_DynamicData_get_boolean(
-                    message,
-                    &params.retained,
-                    "info.retained",
-                    DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED)) {
-            /* TODO Log error */
-            goto done;
-        }
-        if (DDS_RETCODE_OK
-            != DDS_DynamicData_get_string(
-                    message,
-                    &topic,
-                    &topic_len,
-                    "topic",
-                    DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED)) {
-            /* TODO Log error */
-            goto done;
-        }
-        DDS_String_replace(&self->req_ctx.topic, topic);
-        if (self->req_ctx.topic == NULL) {
-            /* TODO Log error */
-            goto done;
-        }
-        self->req_ctx.topic_len = topic_len;
-    }
-
     if (DDS_RETCODE_OK
-        != DDS_DynamicData_get_octet_seq(
+        != RTI_MQTT_Publication_read_message(
+                self,
                 message,
-                &payload,
-                "payload.data",
-                DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED)) {
-        /* TODO Log error */
-        goto done;
-    }
-
-    if (!DDS_OctetSeq_copy(&self->req_ctx.payload, &payload)) {
+                use_message_info,
+                &params)) {
         /* TODO Log error */
         goto done;
     }
 
-    payload_buffer =
-            (char *) DDS_OctetSeq_get_contiguous_buffer(&self->req_ctx.payload);
-    payload_len = DDS_OctetSeq_get_length(&self->req_ctx.payload);
-
     if (DDS_RETCODE_OK
         != RTI_MQTT_Publication_write_w_params(
                 self,
-                payload_buffer,
-                payload_len,
+                (char *) DDS_OctetSeq_get_contiguous_buffer(
+                        &self->req_ctx.payload),
+                DDS_OctetSeq_get_length(&self->req_ctx.payload),
                 self->req_ctx.topic,
                 &params)) {
         /* TODO Log error */
@@ -202,11 +170,186 @@ done:
     /* TODO RM Mutex: only used to protect self->data->config */
     RTI_MQTT_Mutex_release_from_state(&self->client->pub_lock, &locked);
 
-    if (topic != NULL) {
-        DDS_String_free(topic);
+    return retval;
+}
+
+DDS_ReturnCode_t RTI_MQTT_Publication_write_batch(
+        struct RTI_MQTT_Publication *self,
+        DDS_DynamicData **messages,
+        DDS_UnsignedLong count,
+        DDS_ReturnCode_t *results,
+        DDS_UnsignedLong *written_out)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR, write_rc = DDS_RETCODE_ERROR;
+    RTI_MQTT_WriteParams params = RTI_MQTT_WriteParams_INITIALIZER;
+    struct RTI_MQTT_PublicationInflightMessage *msg = NULL;
+    DDS_UnsignedLong i = 0, written = 0, batch_pending = 0;
+    DDS_Boolean use_message_info = DDS_BOOLEAN_FALSE,
+                batching = DDS_BOOLEAN_FALSE;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_Publication_write_batch)
+
+    if (results != NULL) {
+        for (i = 0; i < count; i++) {
+            results[i] = DDS_RETCODE_ERROR;
+        }
     }
-    if (!DDS_OctetSeq_finalize(&payload)) {
-        /* TODO Log error */
+
+    /* Without an in-flight window, each message must be acknowledged before
+       the next one can be written, through the single request of the
+       publication. Holding the client's locks while waiting for each
+       acknowledgement would block every other publication of the client
+       for a round-trip to the Broker, so the messages are written one at
+       a time, taking and releasing the locks for each of them. Batching
+       requires max_inflight_messages > 0. */
+    if (!RTI_MQTT_Publication_is_pipelined(self)) {
+        for (written = 0; written < count; written++) {
+            write_rc = RTI_MQTT_Publication_write(self, messages[written]);
+            if (results != NULL) {
+                results[written] = write_rc;
+            }
+            if (DDS_RETCODE_OK != write_rc) {
+                /* TODO Log error */
+                goto done;
+            }
+        }
+        retval = DDS_RETCODE_OK;
+        goto done;
+    }
+
+    RTI_MQTT_Client_begin_write_batch(self->client);
+    batching = DDS_BOOLEAN_TRUE;
+
+    /* The configuration is protected by the client's pub_lock, which is
+       held for as long as the batch is being written */
+    use_message_info = self->data->config->use_message_info;
+    if (!use_message_info) {
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_Publication_store_topic(
+                    self,
+                    self->data->config->topic)) {
+            /* TODO Log error */
+            goto done;
+        }
+    }
+
+    for (written = 0; written < count; written++) {
+        if (!use_message_info) {
+            params.retained = self->data->config->retained;
+            params.qos_level = self->data->config->qos;
+        }
+
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_Publication_read_message(
+                    self,
+                    messages[written],
+                    use_message_info,
+                    &params)) {
+            /* TODO Log error */
+            goto done;
+        }
+
+        if (!RTI_MQTT_Publication_is_configuration_valid(
+                    self,
+                    params.qos_level,
+                    self->req_ctx.topic)) {
+            RTI_MQTT_LOG_PUBLICATION_INVALID_WRITE_CONFIG_DETECTED(self)
+            goto done;
+        }
+
+        msg = RTI_MQTT_Publication_try_acquire_inflight(
+                self,
+                params.qos_level,
+                (results != NULL) ? &results[written] : NULL,
+                (results != NULL) ? &batch_pending : NULL);
+        while (msg == NULL) {
+            /* The window is full: let other writers make progress while
+               waiting for the results of some of the in-flight messages */
+            RTI_MQTT_Client_end_write_batch(self->client);
+            batching = DDS_BOOLEAN_FALSE;
+
+            RTI_MQTT_TRACE_2(
+                    "in-flight window FULL:",
+                    "pub=%p, max=%u",
+                    self,
+                    self->inflight.max_messages)
+
+            if (DDS_RETCODE_OK
+                != RTI_MQTT_Client_wait_for_write_result(self->client, self)) {
+                RTI_MQTT_LOG_CLIENT_WAIT_FOR_WRITE_RESULTS_FAILED(
+                        self->client,
+                        self)
+                goto done;
+            }
+
+            RTI_MQTT_Client_begin_write_batch(self->client);
+            batching = DDS_BOOLEAN_TRUE;
+
+            msg = RTI_MQTT_Publication_try_acquire_inflight(
+                    self,
+                    params.qos_level,
+                    (results != NULL) ? &results[written] : NULL,
+                    (results != NULL) ? &batch_pending : NULL);
+        }
+
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_Client_write_message(
+                    self->client,
+                    self,
+                    &msg->req,
+                    (char *) DDS_OctetSeq_get_contiguous_buffer(
+                            &self->req_ctx.payload),
+                    DDS_OctetSeq_get_length(&self->req_ctx.payload),
+                    self->req_ctx.topic,
+                    &params)) {
+            RTI_MQTT_LOG_PUBLICATION_WRITE_MESSAGE_FAILED(
+                    self,
+                    self->req_ctx.topic,
+                    params.qos_level,
+                    params.retained,
+                    DDS_OctetSeq_get_contiguous_buffer(&self->req_ctx.payload))
+            RTI_MQTT_Mutex_assert(&self->inflight.lock);
+            RTI_MQTT_Publication_release_inflight(self, msg);
+            RTI_MQTT_Mutex_release(&self->inflight.lock);
+            goto done;
+        }
+
+        RTI_MQTT_Mutex_assert(&self->inflight.lock);
+        self->data->message_status->sent_count += 1;
+        RTI_MQTT_Mutex_release(&self->inflight.lock);
+    }
+
+    RTI_MQTT_Client_end_write_batch(self->client);
+    batching = DDS_BOOLEAN_FALSE;
+
+    /* Wait for the result of every message in the batch */
+    if (results != NULL) {
+        RTI_MQTT_Mutex_assert(&self->inflight.lock);
+        while (batch_pending > 0) {
+            RTI_MQTT_Mutex_release(&self->inflight.lock);
+            if (DDS_RETCODE_OK
+                != RTI_MQTT_Client_wait_for_write_result(self->client, self)) {
+                RTI_MQTT_LOG_CLIENT_WAIT_FOR_WRITE_RESULTS_FAILED(
+                        self->client,
+                        self)
+                goto done;
+            }
+            RTI_MQTT_Mutex_assert(&self->inflight.lock);
+        }
+        RTI_MQTT_Mutex_release(&self->inflight.lock);
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    if (batching) {
+        RTI_MQTT_Client_end_write_batch(self->client);
+    }
+    if (results != NULL) {
+        /* Results of messages still in flight can no longer be reported */
+        RTI_MQTT_Publication_detach_inflight_batch(self, &batch_pending);
+    }
+    if (written_out != NULL) {
+        *written_out = written;
     }
 
     return retval;
@@ -288,6 +431,64 @@ done:
     return retval;
 }
 
+DDS_ReturnCode_t RTI_MQTT_Publication_on_inflight_write_result(
+        struct RTI_MQTT_Publication *self,
+        struct RTI_MQTT_PublicationInflightMessage *msg,
+        DDS_ReturnCode_t result)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_Publication_on_inflight_write_result)
+
+    if (self->inflight.count == 0
+        || self->data->message_status->pending_count == 0) {
+        RTI_MQTT_LOG_PUBLICATION_NO_PENDING_MESSAGES_FOUND(self)
+        goto done;
+    }
+
+    /* Results for in-flight messages are only reported once the MQTT client
+       library has completed the whole delivery protocol for the message's
+       QoS (i.e. PUBACK for Qos 1, PUBCOMP for Qos 2), so there is no separate
+       delivery notification to wait for. */
+    if (DDS_RETCODE_OK == result) {
+        self->data->message_status->ok_count += 1;
+    } else {
+        self->data->message_status->error_count += 1;
+    }
+
+    if (msg->result != NULL) {
+        *msg->result = result;
+    }
+
+    RTI_MQTT_Publication_release_inflight(self, msg);
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+DDS_Boolean
+        RTI_MQTT_Publication_is_pipelined(struct RTI_MQTT_Publication *self)
+{
+    return (self->inflight.max_messages > 0);
+}
+
+DDS_UnsignedLong RTI_MQTT_Publication_get_inflight_count(
+        struct RTI_MQTT_Publication *self)
+{
+    DDS_UnsignedLong count = 0;
+
+    if (!RTI_MQTT_Publication_is_pipelined(self)) {
+        return 0;
+    }
+
+    RTI_MQTT_Mutex_assert(&self->inflight.lock);
+    count = self->inflight.count;
+    RTI_MQTT_Mutex_release(&self->inflight.lock);
+
+    return count;
+}
+
 static DDS_Boolean RTI_MQTT_Publication_is_configuration_valid(
         struct RTI_MQTT_Publication *pub,
         RTI_MQTT_QosLevel qos,
@@ -322,6 +523,7 @@ static DDS_ReturnCode_t RTI_MQTT_Publication_initialize(
 {
     DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
     struct RTI_MQTT_Publication def_self = RTI_MQTT_Publication_INITIALIZER;
+    DDS_UnsignedLong max_inflight = 0;
 
     RTI_MQTT_LOG_FN(RTI_MQTT_Publication_initialize)
 
@@ -343,6 +545,19 @@ static DDS_ReturnCode_t RTI_MQTT_Publication_initialize(
         goto done;
     }
 
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_MessageMemberIds_initialize(&self->member_ids)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    self->member_binder =
+            DDS_DynamicData_new(NULL, &DDS_DYNAMIC_DATA_PROPERTY_DEFAULT);
+    if (self->member_binder == NULL) {
+        /* TODO Log error */
+        goto done;
+    }
+
     if (DDS_RETCODE_OK
         != RTI_MQTT_PublicationStatus_new(DDS_BOOLEAN_TRUE, &self->data)) {
         RTI_MQTT_LOG_CREATE_DATA_FAILED("RTI_MQTT_PublicationStatus")
@@ -366,6 +581,26 @@ static DDS_ReturnCode_t RTI_MQTT_Publication_initialize(
         goto done;
     }
 
+    max_inflight = self->data->config->max_inflight_messages;
+    if (max_inflight > 0) {
+        /* The MQTT client library will refuse to send more messages than
+           the maximum number of unacknowledged messages configured on the
+           client, so there is no point in allowing a larger window. */
+        if (max_inflight > client->data->config->max_unack_messages) {
+            RTI_MQTT_LOG_2(
+                    "publication in-flight window limited by client:",
+                    "max_inflight_messages=%u, max_unack_messages=%d",
+                    max_inflight,
+                    client->data->config->max_unack_messages)
+            max_inflight = client->data->config->max_unack_messages;
+        }
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_Publication_initialize_inflight(self, max_inflight)) {
+            /* TODO Log error */
+            goto done;
+        }
+    }
+
     retval = DDS_RETCODE_OK;
 done:
     if (DDS_RETCODE_OK != retval) {
@@ -384,6 +619,8 @@ static DDS_ReturnCode_t
 
     RTI_MQTT_LOG_FN(RTI_MQTT_Publication_finalize)
 
+    RTI_MQTT_Publication_finalize_inflight(self);
+
     if (self->data != NULL) {
         RTI_MQTT_PublicationStatusTypeSupport_delete_data(self->data);
         self->data = NULL;
@@ -393,10 +630,16 @@ static DDS_ReturnCode_t
         RTI_MQTT_LOG_FINALIZE_SEQUENCE_FAILED(&self->req_ctx.payload)
     }
 
+    if (self->member_binder != NULL) {
+        DDS_DynamicData_delete(self->member_binder);
+        self->member_binder = NULL;
+    }
+
     if (self->req_ctx.topic != NULL) {
         DDS_String_free(self->req_ctx.topic);
         self->req_ctx.topic = NULL;
         self->req_ctx.topic_len = 0;
+        self->req_ctx.topic_max = 0;
     }
 
     *self = def_self;
@@ -414,6 +657,8 @@ DDS_ReturnCode_t RTI_MQTT_Publication_write_w_params(
         RTI_MQTT_WriteParams *params)
 {
     DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    struct RTI_MQTT_PublicationInflightMessage *msg = NULL;
+    struct RTI_MQTT_PendingRequest *req = NULL;
 
     RTI_MQTT_LOG_FN(RTI_MQTT_Publication_write_w_params)
 
@@ -425,13 +670,30 @@ DDS_ReturnCode_t RTI_MQTT_Publication_write_w_params(
         goto done;
     }
 
-    self->req_ctx.last_write_qos = params->qos_level;
-    self->data->message_status->pending_count += 1;
+    if (RTI_MQTT_Publication_is_pipelined(self)) {
+        /* Only block if the in-flight window is full */
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_Publication_acquire_inflight(
+                    self,
+                    params->qos_level,
+                    &msg)) {
+            RTI_MQTT_LOG_CLIENT_WAIT_FOR_WRITE_RESULTS_FAILED(
+                    self->client,
+                    self)
+            goto done;
+        }
+        req = &msg->req;
+    } else {
+        self->req_ctx.last_write_qos = params->qos_level;
+        self->data->message_status->pending_count += 1;
+        req = self->req;
+    }
 
     if (DDS_RETCODE_OK
         != RTI_MQTT_Client_write_message(
                 self->client,
                 self,
+                req,
                 buffer,
                 buffer_len,
                 topic,
@@ -442,21 +704,424 @@ DDS_ReturnCode_t RTI_MQTT_Publication_write_w_params(
                 params->qos_level,
                 params->retained,
                 buffer)
-        self->data->message_status->pending_count -= 1;
+        if (msg != NULL) {
+            RTI_MQTT_Mutex_assert(&self->inflight.lock);
+            RTI_MQTT_Publication_release_inflight(self, msg);
+            RTI_MQTT_Mutex_release(&self->inflight.lock);
+        } else {
+            self->data->message_status->pending_count -= 1;
+        }
+        goto done;
+    }
+
+    if (msg != NULL) {
+        RTI_MQTT_Mutex_assert(&self->inflight.lock);
+        self->data->message_status->sent_count += 1;
+        RTI_MQTT_Mutex_release(&self->inflight.lock);
+    } else {
+        self->data->message_status->sent_count += 1;
+
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_Client_wait_for_write_result(self->client, self)) {
+            RTI_MQTT_LOG_CLIENT_WAIT_FOR_WRITE_RESULTS_FAILED(
+                    self->client,
+                    self)
+            goto done;
+        }
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+
+    return retval;
+}
+
+DDS_ReturnCode_t RTI_MQTT_Publication_initialize_inflight(
+        struct RTI_MQTT_Publication *self,
+        DDS_UnsignedLong max_messages)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    struct RTI_MQTT_PendingRequest def_req =
+            RTI_MQTT_PendingRequest_INITIALIZER;
+    DDS_UnsignedLong i = 0;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_Publication_initialize_inflight)
+
+    self->inflight.messages =
+            (struct RTI_MQTT_PublicationInflightMessage *)
+                    RTI_MQTT_Heap_allocate(
+                            sizeof(struct RTI_MQTT_PublicationInflightMessage)
+                            * max_messages);
+    if (self->inflight.messages == NULL) {
+        RTI_MQTT_HEAP_ALLOCATE_FAILED(
+                sizeof(struct RTI_MQTT_PublicationInflightMessage)
+                * max_messages)
         goto done;
     }
 
-    self->data->message_status->sent_count += 1;
+    if (DDS_RETCODE_OK != RTI_MQTT_Mutex_initialize(&self->inflight.lock)) {
+        /* TODO Log error */
+        RTI_MQTT_Heap_free(self->inflight.messages);
+        self->inflight.messages = NULL;
+        goto done;
+    }
+
+    /* The request of each message is completed by the RTI_MQTT_Client when
+       the publication's requests are created. */
+    self->inflight.free_list = NULL;
+    for (i = max_messages; i > 0; i--) {
+        struct RTI_MQTT_PublicationInflightMessage *msg =
+                &self->inflight.messages[i - 1];
+
+        msg->req = def_req;
+        msg->pub = self;
+        msg->qos = RTI_MQTT_QosLevel_UNKNOWN;
+        msg->result = NULL;
+        msg->batch_pending = NULL;
+        msg->next = self->inflight.free_list;
+        self->inflight.free_list = msg;
+    }
+
+    self->inflight.max_messages = max_messages;
+    self->inflight.count = 0;
 
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+void RTI_MQTT_Publication_finalize_inflight(
+        struct RTI_MQTT_Publication *self)
+{
+    RTI_MQTT_LOG_FN(RTI_MQTT_Publication_finalize_inflight)
+
+    if (self->inflight.messages == NULL) {
+        return;
+    }
+
+    if (self->inflight.count > 0) {
+        RTI_MQTT_ERROR_2(
+                "deleting publication with messages still in-flight:",
+                "pub=%p, count=%u",
+                self,
+                self->inflight.count)
+    }
+
+    if (DDS_RETCODE_OK != RTI_MQTT_Mutex_finalize(&self->inflight.lock)) {
+        /* TODO Log error */
+    }
+
+    RTI_MQTT_Heap_free(self->inflight.messages);
+    self->inflight.messages = NULL;
+    self->inflight.free_list = NULL;
+    self->inflight.max_messages = 0;
+    self->inflight.count = 0;
+}
+
+static DDS_ReturnCode_t RTI_MQTT_Publication_acquire_inflight(
+        struct RTI_MQTT_Publication *self,
+        RTI_MQTT_QosLevel qos,
+        struct RTI_MQTT_PublicationInflightMessage **msg_out)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    struct RTI_MQTT_PublicationInflightMessage *msg = NULL;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_Publication_acquire_inflight)
+
+    *msg_out = NULL;
+
+    while (msg == NULL) {
+        msg = RTI_MQTT_Publication_try_acquire_inflight(self, qos, NULL, NULL);
+
+        if (msg == NULL) {
+            /* The window is full: wait for the result of any of the
+               in-flight messages to be notified by the client. The
+               request's condition may have been triggered by results
+               received before this call, in which case we will just
+               check the window again. */
+            RTI_MQTT_TRACE_2(
+                    "in-flight window FULL:",
+                    "pub=%p, max=%u",
+                    self,
+                    self->inflight.max_messages)
+
+            if (DDS_RETCODE_OK
+                != RTI_MQTT_Client_wait_for_write_result(self->client, self)) {
+                goto done;
+            }
+        }
+    }
+
+    *msg_out = msg;
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+struct RTI_MQTT_PublicationInflightMessage *
+        RTI_MQTT_Publication_try_acquire_inflight(
+                struct RTI_MQTT_Publication *self,
+                RTI_MQTT_QosLevel qos,
+                DDS_ReturnCode_t *result,
+                DDS_UnsignedLong *batch_pending)
+{
+    struct RTI_MQTT_PublicationInflightMessage *msg = NULL;
+
+    RTI_MQTT_Mutex_assert(&self->inflight.lock);
+    msg = self->inflight.free_list;
+    if (msg != NULL) {
+        self->inflight.free_list = msg->next;
+        self->inflight.count += 1;
+        self->data->message_status->pending_count += 1;
+        msg->next = NULL;
+        msg->qos = qos;
+        msg->result = result;
+        msg->batch_pending = batch_pending;
+        if (batch_pending != NULL) {
+            *batch_pending += 1;
+        }
+    }
+    RTI_MQTT_Mutex_release(&self->inflight.lock);
+
+    return msg;
+}
+
+void RTI_MQTT_Publication_detach_inflight_batch(
+        struct RTI_MQTT_Publication *self,
+        DDS_UnsignedLong *batch_pending)
+{
+    DDS_UnsignedLong i = 0;
+
+    RTI_MQTT_Mutex_assert(&self->inflight.lock);
+    for (i = 0; i < self->inflight.max_messages && *batch_pending > 0; i++) {
+        struct RTI_MQTT_PublicationInflightMessage *msg =
+                &self->inflight.messages[i];
+
+        if (msg->batch_pending == batch_pending) {
+            msg->result = NULL;
+            msg->batch_pending = NULL;
+            *batch_pending -= 1;
+        }
+    }
+    RTI_MQTT_Mutex_release(&self->inflight.lock);
+}
+
+/* Must be called with self->inflight.lock taken */
+static void RTI_MQTT_Publication_release_inflight(
+        struct RTI_MQTT_Publication *self,
+        struct RTI_MQTT_PublicationInflightMessage *msg)
+{
+    RTI_MQTT_LOG_FN(RTI_MQTT_Publication_release_inflight)
+
+    if (msg->batch_pending != NULL) {
+        *msg->batch_pending -= 1;
+    }
+    msg->result = NULL;
+    msg->batch_pending = NULL;
+    msg->qos = RTI_MQTT_QosLevel_UNKNOWN;
+    msg->next = self->inflight.free_list;
+    self->inflight.free_list = msg;
+    self->inflight.count -= 1;
+    self->data->message_status->pending_count -= 1;
+}
+
+/* Read the payload of a message into self->req_ctx.payload, and, if
+   `use_message_info` is set, its topic into self->req_ctx.topic and its
+   publication settings into `params`. */
+static DDS_ReturnCode_t RTI_MQTT_Publication_read_message(
+        struct RTI_MQTT_Publication *self,
+        DDS_DynamicData *message,
+        DDS_Boolean use_message_info,
+        RTI_MQTT_WriteParams *params)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    const struct RTI_MQTT_MessageMemberIds *ids = &self->member_ids;
+    DDS_Boolean bound = DDS_BOOLEAN_FALSE;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_Publication_read_message)
+
+    if (use_message_info) {
+        if (!DDS_DynamicData_member_exists(message, NULL, ids->info)) {
+            RTI_MQTT_LOG_PUBLICATION_WRITE_MESSAGE_INFO_NOT_FOUND(self, message)
+            goto done;
+        }
+        if (DDS_RETCODE_OK
+            != DDS_DynamicData_bind_complex_member(
+                    message,
+                    self->member_binder,
+                    NULL,
+                    ids->info)) {
+            /* TODO Log error */
+            goto done;
+        }
+        bound = DDS_BOOLEAN_TRUE;
+        if (DDS_RETCODE_OK
+            != DDS_DynamicData_get_long(
+                    self->member_binder,
+                    (DDS_Long *) &params->qos_level,
+                    NULL,
+                    ids->info_qos_level)) {
+            /* TODO Log error */
+            goto done;
+        }
+        if (DDS_RETCODE_OK
+            != DDS_DynamicData_get_boolean(
+                    self->member_binder,
+                    &params->retained,
+                    NULL,
+                    ids->info_retained)) {
+            /* TODO Log error */
+            goto done;
+        }
+        if (DDS_RETCODE_OK
+            != DDS_DynamicData_unbind_complex_member(
+                    message,
+                    self->member_binder)) {
+            /* TODO Log error */
+            goto done;
+        }
+        bound = DDS_BOOLEAN_FALSE;
+
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_Publication_read_topic(self, message)) {
+            /* TODO Log error */
+            goto done;
+        }
+    }
+
+    if (DDS_RETCODE_OK
+        != DDS_DynamicData_bind_complex_member(
+                message,
+                self->member_binder,
+                NULL,
+                ids->payload)) {
+        /* TODO Log error */
+        goto done;
+    }
+    bound = DDS_BOOLEAN_TRUE;
+
+    /* The payload is copied straight into the sequence reused by every
+       write, which only needs to grow to fit the largest message. */
     if (DDS_RETCODE_OK
-        != RTI_MQTT_Client_wait_for_write_result(self->client, self)) {
-        RTI_MQTT_LOG_CLIENT_WAIT_FOR_WRITE_RESULTS_FAILED(self->client, self)
+        != DDS_DynamicData_get_octet_seq(
+                self->member_binder,
+                &self->req_ctx.payload,
+                NULL,
+                ids->payload_data)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    if (bound) {
+        if (DDS_RETCODE_OK
+            != DDS_DynamicData_unbind_complex_member(
+                    message,
+                    self->member_binder)) {
+            /* TODO Log error */
+            retval = DDS_RETCODE_ERROR;
+        }
+    }
+
+    return retval;
+}
+
+/* Make sure that self->req_ctx.topic can store at least `topic_max`
+   characters, including the terminator. The buffer's previous contents
+   are discarded if it must be reallocated. */
+static DDS_ReturnCode_t RTI_MQTT_Publication_reserve_topic(
+        struct RTI_MQTT_Publication *self,
+        DDS_UnsignedLong topic_max)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+
+    if (topic_max <= self->req_ctx.topic_max) {
+        retval = DDS_RETCODE_OK;
+        goto done;
+    }
+
+    if (self->req_ctx.topic != NULL) {
+        DDS_String_free(self->req_ctx.topic);
+    }
+    self->req_ctx.topic_len = 0;
+    self->req_ctx.topic_max = 0;
+
+    self->req_ctx.topic = DDS_String_alloc(topic_max - 1);
+    if (self->req_ctx.topic == NULL) {
+        RTI_MQTT_HEAP_ALLOCATE_FAILED(topic_max)
         goto done;
     }
+    self->req_ctx.topic_max = topic_max;
 
     retval = DDS_RETCODE_OK;
 done:
+    return retval;
+}
+
+/* Read the topic of a message into self->req_ctx.topic. If the topic doesn't
+   fit, the buffer is grown to the size reported by DynamicData and the topic
+   is read again, as long as it's not longer than the longest MQTT topic. */
+static DDS_ReturnCode_t RTI_MQTT_Publication_read_topic(
+        struct RTI_MQTT_Publication *self,
+        DDS_DynamicData *message)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR, get_rc = DDS_RETCODE_ERROR;
+    DDS_UnsignedLong topic_max = self->req_ctx.topic_max, topic_len = 0;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_Publication_read_topic)
+
+    if (topic_max < RTI_MQTT_PUBLICATION_TOPIC_BUFFER_SIZE) {
+        topic_max = RTI_MQTT_PUBLICATION_TOPIC_BUFFER_SIZE;
+    }
+    if (DDS_RETCODE_OK != RTI_MQTT_Publication_reserve_topic(self, topic_max)) {
+        goto done;
+    }
+
+    topic_len = self->req_ctx.topic_max;
+    get_rc = DDS_DynamicData_get_string(
+            message,
+            &self->req_ctx.topic,
+            &topic_len,
+            NULL,
+            self->member_ids.topic);
+
+    /* Any other error (e.g. a missing topic) won't be fixed by retrying.
+       On DDS_RETCODE_OUT_OF_RESOURCES, topic_len is the size required by the
+       topic, which is reserved with room for its terminator. */
+    if (DDS_RETCODE_OUT_OF_RESOURCES == get_rc) {
+        if (topic_len < self->req_ctx.topic_max
+            || topic_len > MQTT_TOPIC_NAME_MAX_LEN + 1) {
+            RTI_MQTT_ERROR_2(
+                    "cannot read topic of message:",
+                    "pub=%p, required_len=%u",
+                    self,
+                    topic_len)
+            goto done;
+        }
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_Publication_reserve_topic(self, topic_len + 1)) {
+            goto done;
+        }
+
+        topic_len = self->req_ctx.topic_max;
+        get_rc = DDS_DynamicData_get_string(
+                message,
+                &self->req_ctx.topic,
+                &topic_len,
+                NULL,
+                self->member_ids.topic);
+    }
+
+    if (DDS_RETCODE_OK != get_rc) {
+        /* TODO Log error */
+        goto done;
+    }
+    self->req_ctx.topic_len = topic_len;
 
+    retval = DDS_RETCODE_OK;
+done:
     return retval;
 }
 
@@ -469,39 +1134,24 @@ static DDS_ReturnCode_t RTI_MQTT_Publication_store_topic(
 
     RTI_MQTT_LOG_FN(RTI_MQTT_Publication_store_topic)
 
-    if (self->req_ctx.topic == NULL) {
-        self->req_ctx.topic = DDS_String_dup(topic);
-        if (self->req_ctx.topic == NULL) {
-            /* TODO Log error */
-            goto done;
-        }
-        self->req_ctx.topic_len =
-                (DDS_UnsignedLong) RTI_MQTT_String_length(self->req_ctx.topic);
-    } else {
-        topic_len =
-                (DDS_UnsignedLong) RTI_MQTT_String_length(topic);
+    if (topic == NULL) {
+        /* TODO Log error */
+        goto done;
+    }
 
-        if (topic_len <= self->req_ctx.topic_len) {
-            RTI_MQTT_Memory_copy(
-                    self->req_ctx.topic,
-                    topic,
-                    sizeof(char) * topic_len);
-            self->req_ctx.topic[topic_len] = '\0';
-            if (self->req_ctx.topic == NULL) {
-                /* TODO Log error */
-                goto done;
-            }
-        } else {
-            DDS_String_replace(&self->req_ctx.topic, topic);
-            if (self->req_ctx.topic == NULL) {
-                /* TODO Log error */
-                goto done;
-            }
-            self->req_ctx.topic_len = (DDS_UnsignedLong)
-                    RTI_MQTT_String_length(self->req_ctx.topic);
-        }
+    topic_len = (DDS_UnsignedLong) RTI_MQTT_String_length(topic);
+
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_Publication_reserve_topic(self, topic_len + 1)) {
+        goto done;
     }
 
+    RTI_MQTT_Memory_copy(
+            self->req_ctx.topic,
+            topic,
+            sizeof(char) * (topic_len + 1));
+    self->req_ctx.topic_len = topic_len;
+
     retcode = DDS_RETCODE_OK;
 
 done:
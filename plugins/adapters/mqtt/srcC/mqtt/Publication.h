@@ -19,14 +19,18 @@
 #include "rtiadapt_mqtt.h"
 
 #include "Infrastructure.h"
+#include "Message.h"
 
 struct RTI_MQTT_Publication;
 
 struct RTI_MQTT_PublicationRequestContext {
     struct RTI_MQTT_Publication *pub;
     RTI_MQTT_QosLevel last_write_qos;
+    /* Buffer reused to store the topic of every written message. It is
+       only reallocated when a longer topic must be stored. */
     char *topic;
     DDS_UnsignedLong topic_len;
+    DDS_UnsignedLong topic_max;
     struct DDS_OctetSeq payload;
 };
 
@@ -36,22 +40,66 @@ struct RTI_MQTT_PublicationRequestContext {
         RTI_MQTT_QosLevel_UNKNOWN, /* last_write_qos */ \
         NULL, /* topic */                               \
         0, /* topic_len */                              \
+        0, /* topic_max */                              \
         DDS_SEQUENCE_INITIALIZER /* payload */          \
     }
 
+/* Initial size of the buffer used by an RTI_MQTT_Publication to read the
+   topic of messages written with use_message_info enabled */
+#define RTI_MQTT_PUBLICATION_TOPIC_BUFFER_SIZE 128
+
+/* A message published in pipelined mode, for which the publication is still
+   waiting for a result from the MQTT client library. Each in-flight message
+   carries its own request, which is passed to the library as the context of
+   the write operation, so that results can be tracked per message. */
+struct RTI_MQTT_PublicationInflightMessage {
+    struct RTI_MQTT_PendingRequest req;
+    struct RTI_MQTT_Publication *pub;
+    RTI_MQTT_QosLevel qos;
+    /* Only set for messages written by RTI_MQTT_Publication_write_batch()
+       with a result array, to report the message's result to the writer */
+    DDS_ReturnCode_t *result;
+    DDS_UnsignedLong *batch_pending;
+    struct RTI_MQTT_PublicationInflightMessage *next;
+};
+
+struct RTI_MQTT_PublicationInflightWindow {
+    RTI_MQTT_Mutex lock;
+    DDS_UnsignedLong max_messages;
+    DDS_UnsignedLong count;
+    struct RTI_MQTT_PublicationInflightMessage *messages;
+    struct RTI_MQTT_PublicationInflightMessage *free_list;
+};
+
+#define RTI_MQTT_PublicationInflightWindow_INITIALIZER \
+    {                                                  \
+        RTI_MQTT_Mutex_INITIALIZER, /* lock */         \
+        0, /* max_messages */                          \
+        0, /* count */                                 \
+        NULL, /* messages */                           \
+        NULL /* free_list */                           \
+    }
+
 struct RTI_MQTT_Publication {
     RTI_MQTT_PublicationStatus *data;
     struct RTI_MQTT_Client *client;
     struct RTI_MQTT_PendingRequest *req;
     struct RTI_MQTT_PublicationRequestContext req_ctx;
+    struct RTI_MQTT_PublicationInflightWindow inflight;
+    struct RTI_MQTT_MessageMemberIds member_ids;
+    /* Used to bind the nested members of a message while it is written */
+    DDS_DynamicData *member_binder;
 };
 
-#define RTI_MQTT_Publication_INITIALIZER                              \
-    {                                                                 \
-        NULL, /* data */                                              \
-        NULL, /* client */                                            \
-        NULL, /* req_publish */                                       \
-        RTI_MQTT_PublicationRequestContext_INITIALIZER, /* req_ctx */ \
+#define RTI_MQTT_Publication_INITIALIZER                                 \
+    {                                                                    \
+        NULL, /* data */                                                 \
+        NULL, /* client */                                               \
+        NULL, /* req_publish */                                          \
+        RTI_MQTT_PublicationRequestContext_INITIALIZER, /* req_ctx */    \
+        RTI_MQTT_PublicationInflightWindow_INITIALIZER, /* inflight */   \
+        { 0, 0, 0, 0, 0, 0, 0, 0 }, /* member_ids */                     \
+        NULL /* member_binder */                                         \
     }
 
 DDS_ReturnCode_t RTI_MQTT_Publication_new(
@@ -69,6 +117,42 @@ DDS_ReturnCode_t RTI_MQTT_Publication_on_write_delivery_result(
         struct RTI_MQTT_Publication *self,
         DDS_ReturnCode_t result);
 
+/* Must be called with self->inflight.lock taken */
+DDS_ReturnCode_t RTI_MQTT_Publication_on_inflight_write_result(
+        struct RTI_MQTT_Publication *self,
+        struct RTI_MQTT_PublicationInflightMessage *msg,
+        DDS_ReturnCode_t result);
+
+DDS_Boolean RTI_MQTT_Publication_is_pipelined(
+        struct RTI_MQTT_Publication *self);
+
+/* Allocate the in-flight window of a pipelined publication, with room for
+   `max_messages` messages */
+DDS_ReturnCode_t RTI_MQTT_Publication_initialize_inflight(
+        struct RTI_MQTT_Publication *self,
+        DDS_UnsignedLong max_messages);
+
+void RTI_MQTT_Publication_finalize_inflight(
+        struct RTI_MQTT_Publication *self);
+
+/* Take a message from the in-flight window, or return NULL if the window
+   is full. If `batch_pending` is specified, it will be decremented once the
+   message's result has been stored into `result`. */
+struct RTI_MQTT_PublicationInflightMessage *
+        RTI_MQTT_Publication_try_acquire_inflight(
+                struct RTI_MQTT_Publication *self,
+                RTI_MQTT_QosLevel qos,
+                DDS_ReturnCode_t *result,
+                DDS_UnsignedLong *batch_pending);
+
+/* Stop reporting results to a batch which is no longer being waited for */
+void RTI_MQTT_Publication_detach_inflight_batch(
+        struct RTI_MQTT_Publication *self,
+        DDS_UnsignedLong *batch_pending);
+
+DDS_UnsignedLong RTI_MQTT_Publication_get_inflight_count(
+        struct RTI_MQTT_Publication *self);
+
 DDS_SEQUENCE(RTI_MQTT_PublicationPtrSeq, struct RTI_MQTT_Publication *);
 
 #endif /* Publication_h */
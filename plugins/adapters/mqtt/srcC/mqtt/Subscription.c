@@ -26,6 +26,16 @@ static DDS_ReturnCode_t RTI_MQTT_Subscription_initialize(
 static DDS_ReturnCode_t
         RTI_MQTT_Subscription_finalize(struct RTI_MQTT_Subscription *self);
 
+static DDS_Boolean RTI_MQTT_Subscription_should_notify_data_available(
+        struct RTI_MQTT_Subscription *self);
+
+static DDS_ReturnCode_t RTI_MQTT_SubscriptionDataAvailableTimer_new(
+        struct RTI_MQTT_Subscription *sub,
+        struct RTI_MQTT_SubscriptionDataAvailableTimer **timer_out);
+
+static void RTI_MQTT_SubscriptionDataAvailableTimer_delete(
+        struct RTI_MQTT_SubscriptionDataAvailableTimer *self);
+
 
 DDS_ReturnCode_t RTI_MQTT_Subscription_new(
         struct RTI_MQTT_Client *client,
@@ -125,6 +135,7 @@ DDS_ReturnCode_t RTI_MQTT_Subscription_receive(
         DDS_UnsignedLong buffer_len,
         const char *topic,
         RTI_MQTT_MessageInfo *msg_info,
+        struct RTI_MQTT_DeferredMessage *deferred,
         DDS_DynamicData **dropped_out,
         DDS_Boolean *lost_out)
 {
@@ -139,13 +150,15 @@ DDS_ReturnCode_t RTI_MQTT_Subscription_receive(
                 buffer_len,
                 topic,
                 msg_info,
+                (self->data->config->defer_payload_copy) ? deferred : NULL,
                 dropped_out,
                 lost_out)) {
         RTI_MQTT_LOG_SUBSCRIPTION_ADD_TO_QUEUE_FAILED(self, buffer)
         goto done;
     }
 
-    if (self->data_avail_listener != NULL) {
+    if (self->data_avail_listener != NULL
+        && RTI_MQTT_Subscription_should_notify_data_available(self)) {
         self->data_avail_listener(self->data_avail_listener_data, self);
     }
 
@@ -163,6 +176,10 @@ DDS_ReturnCode_t RTI_MQTT_Subscription_read(
 
     RTI_MQTT_LOG_FN(RTI_MQTT_Subscription_read)
 
+    /* Any message received from now on must trigger a new notification,
+       since this read might not return it */
+    RTI_MQTT_Atomic_store(&self->data_avail_notified, 0);
+
     if (DDS_RETCODE_OK
         != RTI_MQTT_MessageReceiveQueue_read(
                 self->queue,
@@ -206,11 +223,256 @@ DDS_ReturnCode_t RTI_MQTT_Subscription_set_data_available_listener(
         RTI_MQTT_Subscription_DataAvailableCallback listener,
         void *listener_data)
 {
+    if (self->data_avail_timer != NULL) {
+        RTI_MQTT_Mutex_assert(&self->data_avail_timer->lock);
+    }
     self->data_avail_listener = listener;
     self->data_avail_listener_data = listener_data;
+    if (self->data_avail_timer != NULL) {
+        RTI_MQTT_Mutex_release(&self->data_avail_timer->lock);
+    }
     return DDS_RETCODE_OK;
 }
 
+/* Determine whether the data available listener should be notified of a
+   newly received message. The listener is notified of the first message
+   received after the reader last read, and then again only once
+   data_available_batch_size messages have been received, or once
+   data_available_max_delay has elapsed, since the last notification.
+   Calls are serialized by the client's sub_lock, and by the lock of the
+   data available timer, if there is one, with the timer's thread. */
+static DDS_Boolean RTI_MQTT_Subscription_should_notify_data_available(
+        struct RTI_MQTT_Subscription *self)
+{
+    DDS_Boolean notify = DDS_BOOLEAN_FALSE;
+    DDS_UnsignedLong batch_size =
+            self->data->config->data_available_batch_size;
+    RTI_MQTT_Time now = RTI_MQTT_Time_INITIALIZER(0, 0);
+    DDS_LongLong now_ts = 0;
+
+    if (self->data_avail_timer != NULL) {
+        RTI_MQTT_Mutex_assert(&self->data_avail_timer->lock);
+    }
+
+    self->data_avail_pending += 1;
+
+    if (!RTI_MQTT_Atomic_compare_and_swap(&self->data_avail_notified, 0, 1)) {
+        notify = (batch_size > 0 && self->data_avail_pending >= batch_size);
+    } else {
+        notify = DDS_BOOLEAN_TRUE;
+    }
+
+    if (self->data_avail_max_delay > 0) {
+        if (DDS_RETCODE_OK != RTI_MQTT_Time_get_monotonic(&now)) {
+            /* TODO Log error */
+            notify = DDS_BOOLEAN_TRUE;
+        } else {
+            now_ts = RTI_MQTT_Time_to_microseconds(&now);
+            if (!notify
+                && now_ts - self->data_avail_notify_ts
+                        >= self->data_avail_max_delay) {
+                notify = DDS_BOOLEAN_TRUE;
+            }
+        }
+    }
+
+    if (notify) {
+        self->data_avail_pending = 0;
+        self->data_avail_notify_ts = now_ts;
+    }
+
+    if (self->data_avail_timer != NULL) {
+        RTI_MQTT_Mutex_release(&self->data_avail_timer->lock);
+    }
+
+    return notify;
+}
+
+static void *RTI_MQTT_SubscriptionDataAvailableTimer_thread(void *arg)
+{
+    struct RTI_MQTT_SubscriptionDataAvailableTimer *self =
+            (struct RTI_MQTT_SubscriptionDataAvailableTimer *) arg;
+    struct RTI_MQTT_Subscription *sub = self->sub;
+    RTI_MQTT_Subscription_DataAvailableCallback listener = NULL;
+    void *listener_data = NULL;
+    RTI_MQTT_Time now = RTI_MQTT_Time_INITIALIZER(0, 0);
+    struct DDS_Duration_t timeout = DDS_DURATION_ZERO;
+    DDS_LongLong now_ts = 0, wait_us = 0;
+    DDS_ReturnCode_t retcode = DDS_RETCODE_ERROR;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_SubscriptionDataAvailableTimer_thread)
+
+    while (DDS_RETCODE_OK == RTI_MQTT_Time_get_monotonic(&now)) {
+        now_ts = RTI_MQTT_Time_to_microseconds(&now);
+        wait_us = sub->data_avail_max_delay;
+        listener = NULL;
+
+        RTI_MQTT_Mutex_assert(&self->lock);
+        if (sub->data_avail_pending > 0
+            && RTI_MQTT_Atomic_load(&sub->data_avail_notified)) {
+            wait_us = sub->data_avail_notify_ts + sub->data_avail_max_delay
+                    - now_ts;
+            if (wait_us <= 0) {
+                listener = sub->data_avail_listener;
+                listener_data = sub->data_avail_listener_data;
+                sub->data_avail_pending = 0;
+                sub->data_avail_notify_ts = now_ts;
+                wait_us = sub->data_avail_max_delay;
+            }
+        }
+        RTI_MQTT_Mutex_release(&self->lock);
+
+        if (listener != NULL) {
+            listener(listener_data, sub);
+        }
+
+        timeout.sec = (DDS_Long) (wait_us / 1000000);
+        timeout.nanosec = (DDS_UnsignedLong) ((wait_us % 1000000) * 1000);
+
+        /* The stop condition is the only one attached to the waitset */
+        retcode = DDS_WaitSet_wait(
+                self->waitset,
+                &self->active_conditions,
+                &timeout);
+        if (retcode == DDS_RETCODE_OK) {
+            break;
+        } else if (retcode != DDS_RETCODE_TIMEOUT) {
+            RTI_MQTT_WAITSET_WAIT_FAILED(self->waitset)
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static DDS_ReturnCode_t RTI_MQTT_SubscriptionDataAvailableTimer_new(
+        struct RTI_MQTT_Subscription *sub,
+        struct RTI_MQTT_SubscriptionDataAvailableTimer **timer_out)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    struct RTI_MQTT_SubscriptionDataAvailableTimer *timer = NULL;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_SubscriptionDataAvailableTimer_new)
+
+    timer = (struct RTI_MQTT_SubscriptionDataAvailableTimer *)
+            RTI_MQTT_Heap_allocate(
+                    sizeof(struct RTI_MQTT_SubscriptionDataAvailableTimer));
+    if (timer == NULL) {
+        RTI_MQTT_HEAP_ALLOCATE_FAILED(
+                sizeof(struct RTI_MQTT_SubscriptionDataAvailableTimer))
+        goto done;
+    }
+    timer->sub = sub;
+    timer->waitset = NULL;
+    timer->stop = NULL;
+    timer->thread = NULL;
+
+    if (!DDS_ConditionSeq_initialize(&timer->active_conditions)) {
+        RTI_MQTT_LOG_INITIALIZE_SEQUENCE_FAILED(&timer->active_conditions)
+        RTI_MQTT_Heap_free(timer);
+        timer = NULL;
+        goto done;
+    }
+
+    if (DDS_RETCODE_OK != RTI_MQTT_Mutex_initialize(&timer->lock)) {
+        /* TODO Log error */
+        (void) DDS_ConditionSeq_finalize(&timer->active_conditions);
+        RTI_MQTT_Heap_free(timer);
+        timer = NULL;
+        goto done;
+    }
+
+    if (!DDS_ConditionSeq_set_maximum(&timer->active_conditions, 1)) {
+        RTI_MQTT_LOG_SET_SEQUENCE_MAX_FAILED(&timer->active_conditions, 1)
+        goto done;
+    }
+
+    timer->stop = DDS_GuardCondition_new();
+    if (timer->stop == NULL) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    timer->waitset = DDS_WaitSet_new();
+    if (timer->waitset == NULL) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    if (DDS_RETCODE_OK
+        != DDS_WaitSet_attach_condition(
+                timer->waitset,
+                DDS_GuardCondition_as_condition(timer->stop))) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_Thread_spawn(
+                RTI_MQTT_SubscriptionDataAvailableTimer_thread,
+                timer,
+                &timer->thread)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    *timer_out = timer;
+
+    retval = DDS_RETCODE_OK;
+done:
+    if (DDS_RETCODE_OK != retval && timer != NULL) {
+        RTI_MQTT_SubscriptionDataAvailableTimer_delete(timer);
+    }
+    return retval;
+}
+
+static void RTI_MQTT_SubscriptionDataAvailableTimer_delete(
+        struct RTI_MQTT_SubscriptionDataAvailableTimer *self)
+{
+    RTI_MQTT_LOG_FN(RTI_MQTT_SubscriptionDataAvailableTimer_delete)
+
+    if (self->thread != NULL) {
+        if (DDS_RETCODE_OK
+            != DDS_GuardCondition_set_trigger_value(
+                    self->stop,
+                    DDS_BOOLEAN_TRUE)) {
+            /* TODO Log error */
+        }
+        if (DDS_RETCODE_OK != RTI_MQTT_Thread_join(self->thread, NULL)) {
+            /* TODO Log error */
+        }
+        RTI_MQTT_Heap_free(self->thread);
+        self->thread = NULL;
+    }
+
+    if (self->waitset != NULL) {
+        if (self->stop != NULL) {
+            (void) DDS_WaitSet_detach_condition(
+                    self->waitset,
+                    DDS_GuardCondition_as_condition(self->stop));
+        }
+        if (DDS_RETCODE_OK != DDS_WaitSet_delete(self->waitset)) {
+            /* TODO Log error */
+        }
+    }
+
+    if (self->stop != NULL) {
+        if (DDS_RETCODE_OK != DDS_GuardCondition_delete(self->stop)) {
+            /* TODO Log error */
+        }
+    }
+
+    if (!DDS_ConditionSeq_finalize(&self->active_conditions)) {
+        RTI_MQTT_LOG_FINALIZE_SEQUENCE_FAILED(&self->active_conditions)
+    }
+
+    if (DDS_RETCODE_OK != RTI_MQTT_Mutex_finalize(&self->lock)) {
+        /* TODO Log error */
+    }
+
+    RTI_MQTT_Heap_free(self);
+}
+
 
 static DDS_ReturnCode_t RTI_MQTT_Subscription_initialize(
         struct RTI_MQTT_Subscription *self,
@@ -241,6 +503,9 @@ static DDS_ReturnCode_t RTI_MQTT_Subscription_initialize(
         goto done;
     }
 
+    self->data_avail_max_delay = RTI_MQTT_Time_to_microseconds(
+            &self->data->config->data_available_max_delay);
+
     if (DDS_RETCODE_OK
         != RTI_MQTT_MessageReceiveQueue_new(
                 self->data->config->message_queue_size,
@@ -253,6 +518,16 @@ static DDS_ReturnCode_t RTI_MQTT_Subscription_initialize(
         goto done;
     }
 
+    if (self->data_avail_max_delay > 0) {
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_SubscriptionDataAvailableTimer_new(
+                    self,
+                    &self->data_avail_timer)) {
+            /* TODO Log error */
+            goto done;
+        }
+    }
+
     retval = DDS_RETCODE_OK;
 done:
     if (DDS_RETCODE_OK != retval && self != NULL) {
@@ -271,6 +546,11 @@ static DDS_ReturnCode_t
 
     RTI_MQTT_LOG_FN(RTI_MQTT_Subscription_finalize)
 
+    if (self->data_avail_timer != NULL) {
+        RTI_MQTT_SubscriptionDataAvailableTimer_delete(self->data_avail_timer);
+        self->data_avail_timer = NULL;
+    }
+
     if (self->queue != NULL) {
         RTI_MQTT_MessageReceiveQueue_delete(self->queue);
         self->queue = NULL;
@@ -34,12 +34,37 @@ struct RTI_MQTT_SubscriptionRequestContext {
         DDS_SEQUENCE_INITIALIZER /* params */           \
     }
 
+/* Thread which notifies the data available listener of a subscription once
+   data_available_max_delay has elapsed since the last notification, if
+   messages were received in the meantime and the reader has not read them.
+   Without it, the delay would only be enforced when yet another message is
+   received. The lock serializes the updates of the notification state of
+   the subscription between this thread and the receiving client. */
+struct RTI_MQTT_SubscriptionDataAvailableTimer {
+    struct RTI_MQTT_Subscription *sub;
+    RTI_MQTT_Mutex lock;
+    DDS_WaitSet *waitset;
+    DDS_GuardCondition *stop;
+    struct DDS_ConditionSeq active_conditions;
+    void *thread;
+};
+
 struct RTI_MQTT_Subscription {
     RTI_MQTT_SubscriptionStatus *data;
     struct RTI_MQTT_MessageReceiveQueue *queue;
     struct RTI_MQTT_Client *client;
     RTI_MQTT_Subscription_DataAvailableCallback data_avail_listener;
     void *data_avail_listener_data;
+    /* Set when the listener is notified, and reset when the reader reads,
+       so that the listener is only notified of a batch of messages once */
+    DDS_UnsignedLong data_avail_notified;
+    /* Messages received since the listener was last notified */
+    DDS_UnsignedLong data_avail_pending;
+    /* Value of the monotonic clock when the listener was last notified */
+    DDS_LongLong data_avail_notify_ts;
+    DDS_LongLong data_avail_max_delay;
+    /* Only created when data_avail_max_delay is set */
+    struct RTI_MQTT_SubscriptionDataAvailableTimer *data_avail_timer;
     struct RTI_MQTT_PendingRequest *req_sub;
     struct RTI_MQTT_PendingRequest *req_unsub;
     struct RTI_MQTT_SubscriptionRequestContext req_ctx;
@@ -52,6 +77,11 @@ struct RTI_MQTT_Subscription {
         NULL, /* client */                                            \
         NULL, /* data_avail_listener */                               \
         NULL, /* data_avail_listener_data */                          \
+        0, /* data_avail_notified */                                  \
+        0, /* data_avail_pending */                                   \
+        0, /* data_avail_notify_ts */                                 \
+        0, /* data_avail_max_delay */                                 \
+        NULL, /* data_avail_timer */                                  \
         NULL, /* req_sub */                                           \
         NULL, /* req_unsub */                                         \
         RTI_MQTT_SubscriptionRequestContext_INITIALIZER /* req_ctx */ \
@@ -75,6 +105,7 @@ DDS_ReturnCode_t RTI_MQTT_Subscription_receive(
         DDS_UnsignedLong buffer_len,
         const char *topic,
         RTI_MQTT_MessageInfo *msg_info,
+        struct RTI_MQTT_DeferredMessage *deferred,
         DDS_DynamicData **dropped_out,
         DDS_Boolean *lost_out);
 
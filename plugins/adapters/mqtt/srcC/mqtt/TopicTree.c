@@ -0,0 +1,619 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#include "TopicTree.h"
+
+#define RTI_MQTT_LOG_ARGS "RTI::MQTT::TopicTree"
+
+#define RTI_MQTT_TopicTree_LEVEL_SEPARATOR '/'
+#define RTI_MQTT_TopicTree_WILDCARD_SINGLE '+'
+#define RTI_MQTT_TopicTree_WILDCARD_MULTI '#'
+#define RTI_MQTT_TopicTree_SYSTEM_PREFIX '$'
+
+static DDS_ReturnCode_t RTI_MQTT_TopicTreeNode_new(
+        const char *level,
+        DDS_UnsignedLong level_len,
+        struct RTI_MQTT_TopicTreeNode **node_out);
+
+static void RTI_MQTT_TopicTreeNode_delete(struct RTI_MQTT_TopicTreeNode *self);
+
+static int RTI_MQTT_TopicTreeNode_compare_level(
+        const struct RTI_MQTT_TopicTreeNode *self,
+        const char *level,
+        DDS_UnsignedLong level_len);
+
+static struct RTI_MQTT_TopicTreeNode *RTI_MQTT_TopicTreeNode_find_child(
+        struct RTI_MQTT_TopicTreeNode *self,
+        const char *level,
+        DDS_UnsignedLong level_len,
+        DDS_UnsignedLong *index_out);
+
+static DDS_ReturnCode_t RTI_MQTT_TopicTreeNode_assert_child(
+        struct RTI_MQTT_TopicTreeNode *self,
+        const char *level,
+        DDS_UnsignedLong level_len,
+        struct RTI_MQTT_TopicTreeNode **child_out);
+
+static DDS_ReturnCode_t RTI_MQTT_TopicTreeNode_add_subscription(
+        struct RTI_MQTT_TopicTreeNode *self,
+        struct RTI_MQTT_Subscription *sub);
+
+static DDS_ReturnCode_t RTI_MQTT_TopicTreeNode_match(
+        struct RTI_MQTT_TopicTreeNode *self,
+        const char *level,
+        DDS_Boolean first_level,
+        struct RTI_MQTT_SubscriptionPtrSeq *matches);
+
+static DDS_ReturnCode_t RTI_MQTT_TopicTree_add_matches(
+        struct RTI_MQTT_SubscriptionPtrSeq *subs,
+        struct RTI_MQTT_SubscriptionPtrSeq *matches);
+
+DDS_ReturnCode_t RTI_MQTT_TopicTree_initialize(struct RTI_MQTT_TopicTree *self)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    struct RTI_MQTT_TopicTree def_self = RTI_MQTT_TopicTree_INITIALIZER;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_TopicTree_initialize)
+
+    *self = def_self;
+
+    if (DDS_RETCODE_OK != RTI_MQTT_TopicTreeNode_new(NULL, 0, &self->root)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+void RTI_MQTT_TopicTree_finalize(struct RTI_MQTT_TopicTree *self)
+{
+    RTI_MQTT_LOG_FN(RTI_MQTT_TopicTree_finalize)
+
+    if (self->root != NULL) {
+        RTI_MQTT_TopicTreeNode_delete(self->root);
+        self->root = NULL;
+    }
+}
+
+void RTI_MQTT_TopicTree_clear(struct RTI_MQTT_TopicTree *self)
+{
+    DDS_UnsignedLong i = 0;
+    struct RTI_MQTT_TopicTreeNode *root = self->root;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_TopicTree_clear)
+
+    if (root == NULL) {
+        return;
+    }
+
+    /* Release everything but the root node, so that clearing the tree
+       never requires allocating memory */
+    for (i = 0; i < root->children_len; i++) {
+        RTI_MQTT_TopicTreeNode_delete(root->children[i]);
+        root->children[i] = NULL;
+    }
+    root->children_len = 0;
+
+    if (root->plus != NULL) {
+        RTI_MQTT_TopicTreeNode_delete(root->plus);
+        root->plus = NULL;
+    }
+    if (root->hash != NULL) {
+        RTI_MQTT_TopicTreeNode_delete(root->hash);
+        root->hash = NULL;
+    }
+    if (!RTI_MQTT_SubscriptionPtrSeq_set_length(&root->subscriptions, 0)) {
+        RTI_MQTT_LOG_SET_SEQUENCE_LENGTH_FAILED(&root->subscriptions, 0)
+    }
+}
+
+DDS_ReturnCode_t RTI_MQTT_TopicTree_add_filter(
+        struct RTI_MQTT_TopicTree *self,
+        const char *topic_filter,
+        struct RTI_MQTT_Subscription *sub)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    struct RTI_MQTT_TopicTreeNode *node = self->root, **wildcard_ref = NULL;
+    const char *level = topic_filter, *level_end = NULL;
+    DDS_UnsignedLong level_len = 0, i = 0;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_TopicTree_add_filter)
+
+    if (topic_filter == NULL || topic_filter[0] == '\0') {
+        RTI_MQTT_ERROR_1("invalid topic filter:", "filter='%s'", "")
+        goto done;
+    }
+
+    while (level != NULL) {
+        level_end = RTI_MQTT_String_find_char(
+                level,
+                RTI_MQTT_TopicTree_LEVEL_SEPARATOR);
+        level_len = (level_end != NULL)
+                ? (DDS_UnsignedLong)(level_end - level)
+                : (DDS_UnsignedLong) RTI_MQTT_String_length(level);
+
+        wildcard_ref = NULL;
+        if (level_len == 1 && level[0] == RTI_MQTT_TopicTree_WILDCARD_MULTI) {
+            /* The multi-level wildcard must be the last level */
+            if (level_end != NULL) {
+                RTI_MQTT_ERROR_1(
+                        "invalid topic filter:",
+                        "filter='%s'",
+                        topic_filter)
+                goto done;
+            }
+            wildcard_ref = &node->hash;
+        } else if (
+                level_len == 1
+                && level[0] == RTI_MQTT_TopicTree_WILDCARD_SINGLE) {
+            wildcard_ref = &node->plus;
+        } else {
+            /* Wildcards can only be used to specify a whole level */
+            for (i = 0; i < level_len; i++) {
+                if (level[i] == RTI_MQTT_TopicTree_WILDCARD_MULTI
+                    || level[i] == RTI_MQTT_TopicTree_WILDCARD_SINGLE) {
+                    RTI_MQTT_ERROR_1(
+                            "invalid topic filter:",
+                            "filter='%s'",
+                            topic_filter)
+                    goto done;
+                }
+            }
+        }
+
+        if (wildcard_ref != NULL) {
+            if (*wildcard_ref == NULL
+                && DDS_RETCODE_OK
+                        != RTI_MQTT_TopicTreeNode_new(
+                                level,
+                                level_len,
+                                wildcard_ref)) {
+                /* TODO Log error */
+                goto done;
+            }
+            node = *wildcard_ref;
+        } else if (
+                DDS_RETCODE_OK
+                != RTI_MQTT_TopicTreeNode_assert_child(
+                        node,
+                        level,
+                        level_len,
+                        &node)) {
+            /* TODO Log error */
+            goto done;
+        }
+
+        level = (level_end != NULL) ? level_end + 1 : NULL;
+    }
+
+    if (DDS_RETCODE_OK != RTI_MQTT_TopicTreeNode_add_subscription(node, sub)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+DDS_ReturnCode_t RTI_MQTT_TopicTree_add_subscription(
+        struct RTI_MQTT_TopicTree *self,
+        struct RTI_MQTT_Subscription *sub)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    DDS_UnsignedLong seq_len = 0, i = 0;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_TopicTree_add_subscription)
+
+    seq_len = DDS_StringSeq_get_length(&sub->data->config->topic_filters);
+    for (i = 0; i < seq_len; i++) {
+        const char *topic_filter = *DDS_StringSeq_get_reference(
+                &sub->data->config->topic_filters,
+                i);
+
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_TopicTree_add_filter(self, topic_filter, sub)) {
+            /* TODO Log error */
+            goto done;
+        }
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+DDS_ReturnCode_t RTI_MQTT_TopicTree_match(
+        struct RTI_MQTT_TopicTree *self,
+        const char *topic_name,
+        struct RTI_MQTT_SubscriptionPtrSeq *matches_out)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_TopicTree_match)
+
+    if (!RTI_MQTT_SubscriptionPtrSeq_set_length(matches_out, 0)) {
+        RTI_MQTT_LOG_SET_SEQUENCE_LENGTH_FAILED(matches_out, 0)
+        goto done;
+    }
+
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_TopicTreeNode_match(
+                self->root,
+                topic_name,
+                DDS_BOOLEAN_TRUE,
+                matches_out)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+/*****************************************************************************
+ *                     Private Functions Implementation
+ *****************************************************************************/
+
+static DDS_ReturnCode_t RTI_MQTT_TopicTreeNode_new(
+        const char *level,
+        DDS_UnsignedLong level_len,
+        struct RTI_MQTT_TopicTreeNode **node_out)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    struct RTI_MQTT_TopicTreeNode *node = NULL,
+                                  def_node = RTI_MQTT_TopicTreeNode_INITIALIZER;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_TopicTreeNode_new)
+
+    *node_out = NULL;
+
+    node = (struct RTI_MQTT_TopicTreeNode *) RTI_MQTT_Heap_allocate(
+            sizeof(struct RTI_MQTT_TopicTreeNode));
+    if (node == NULL) {
+        RTI_MQTT_HEAP_ALLOCATE_FAILED(sizeof(struct RTI_MQTT_TopicTreeNode))
+        goto done;
+    }
+    *node = def_node;
+
+    if (!RTI_MQTT_SubscriptionPtrSeq_initialize(&node->subscriptions)) {
+        RTI_MQTT_LOG_INITIALIZE_SEQUENCE_FAILED(&node->subscriptions)
+        goto done;
+    }
+
+    if (level != NULL) {
+        node->level = (char *) RTI_MQTT_Heap_allocate(
+                sizeof(char) * (level_len + 1));
+        if (node->level == NULL) {
+            RTI_MQTT_HEAP_ALLOCATE_FAILED(sizeof(char) * (level_len + 1))
+            goto done;
+        }
+        RTI_MQTT_Memory_copy(node->level, level, sizeof(char) * level_len);
+        node->level[level_len] = '\0';
+    }
+
+    *node_out = node;
+
+    retval = DDS_RETCODE_OK;
+done:
+    if (retval != DDS_RETCODE_OK) {
+        if (node != NULL) {
+            RTI_MQTT_TopicTreeNode_delete(node);
+        }
+    }
+    return retval;
+}
+
+static void RTI_MQTT_TopicTreeNode_delete(struct RTI_MQTT_TopicTreeNode *self)
+{
+    DDS_UnsignedLong i = 0;
+
+    if (self == NULL) {
+        return;
+    }
+
+    for (i = 0; i < self->children_len; i++) {
+        RTI_MQTT_TopicTreeNode_delete(self->children[i]);
+    }
+    if (self->children != NULL) {
+        RTI_MQTT_Heap_free(self->children);
+    }
+    RTI_MQTT_TopicTreeNode_delete(self->plus);
+    RTI_MQTT_TopicTreeNode_delete(self->hash);
+
+    if (!RTI_MQTT_SubscriptionPtrSeq_finalize(&self->subscriptions)) {
+        RTI_MQTT_LOG_FINALIZE_SEQUENCE_FAILED(&self->subscriptions)
+    }
+    if (self->level != NULL) {
+        RTI_MQTT_Heap_free(self->level);
+    }
+
+    RTI_MQTT_Heap_free(self);
+}
+
+static int RTI_MQTT_TopicTreeNode_compare_level(
+        const struct RTI_MQTT_TopicTreeNode *self,
+        const char *level,
+        DDS_UnsignedLong level_len)
+{
+    int cmp = RTI_MQTT_String_compare_n(self->level, level, level_len);
+
+    if (cmp == 0 && self->level[level_len] != '\0') {
+        /* `level` is a prefix of the node's level */
+        cmp = 1;
+    }
+    return cmp;
+}
+
+static struct RTI_MQTT_TopicTreeNode *RTI_MQTT_TopicTreeNode_find_child(
+        struct RTI_MQTT_TopicTreeNode *self,
+        const char *level,
+        DDS_UnsignedLong level_len,
+        DDS_UnsignedLong *index_out)
+{
+    DDS_UnsignedLong lo = 0, hi = self->children_len, mid = 0;
+    int cmp = 0;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        cmp = RTI_MQTT_TopicTreeNode_compare_level(
+                self->children[mid],
+                level,
+                level_len);
+        if (cmp == 0) {
+            if (index_out != NULL) {
+                *index_out = mid;
+            }
+            return self->children[mid];
+        } else if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (index_out != NULL) {
+        *index_out = lo;
+    }
+    return NULL;
+}
+
+static DDS_ReturnCode_t RTI_MQTT_TopicTreeNode_assert_child(
+        struct RTI_MQTT_TopicTreeNode *self,
+        const char *level,
+        DDS_UnsignedLong level_len,
+        struct RTI_MQTT_TopicTreeNode **child_out)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    struct RTI_MQTT_TopicTreeNode *child = NULL, **children = NULL;
+    DDS_UnsignedLong index = 0, children_max = 0;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_TopicTreeNode_assert_child)
+
+    child = RTI_MQTT_TopicTreeNode_find_child(self, level, level_len, &index);
+    if (child != NULL) {
+        *child_out = child;
+        retval = DDS_RETCODE_OK;
+        goto done;
+    }
+
+    if (self->children_len == self->children_max) {
+        children_max = (self->children_max == 0) ? 4 : self->children_max * 2;
+        children = (struct RTI_MQTT_TopicTreeNode **) RTI_MQTT_Heap_allocate(
+                sizeof(struct RTI_MQTT_TopicTreeNode *) * children_max);
+        if (children == NULL) {
+            RTI_MQTT_HEAP_ALLOCATE_FAILED(
+                    sizeof(struct RTI_MQTT_TopicTreeNode *) * children_max)
+            goto done;
+        }
+        if (self->children != NULL) {
+            RTI_MQTT_Memory_copy(
+                    children,
+                    self->children,
+                    sizeof(struct RTI_MQTT_TopicTreeNode *)
+                            * self->children_len);
+            RTI_MQTT_Heap_free(self->children);
+        }
+        self->children = children;
+        self->children_max = children_max;
+    }
+
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_TopicTreeNode_new(level, level_len, &child)) {
+        /* TODO Log error */
+        goto done;
+    }
+
+    /* Keep children sorted by level */
+    RTI_MQTT_Memory_move(
+            &self->children[index + 1],
+            &self->children[index],
+            sizeof(struct RTI_MQTT_TopicTreeNode *)
+                    * (self->children_len - index));
+    self->children[index] = child;
+    self->children_len += 1;
+
+    *child_out = child;
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+static DDS_ReturnCode_t RTI_MQTT_TopicTreeNode_add_subscription(
+        struct RTI_MQTT_TopicTreeNode *self,
+        struct RTI_MQTT_Subscription *sub)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    DDS_UnsignedLong seq_len = 0, i = 0;
+
+    RTI_MQTT_LOG_FN(RTI_MQTT_TopicTreeNode_add_subscription)
+
+    seq_len = RTI_MQTT_SubscriptionPtrSeq_get_length(&self->subscriptions);
+
+    /* A subscription might specify the same filter more than once */
+    for (i = 0; i < seq_len; i++) {
+        if (*RTI_MQTT_SubscriptionPtrSeq_get_reference(&self->subscriptions, i)
+            == sub) {
+            retval = DDS_RETCODE_OK;
+            goto done;
+        }
+    }
+
+    if (!RTI_MQTT_SubscriptionPtrSeq_ensure_length(
+                &self->subscriptions,
+                seq_len + 1,
+                seq_len + 1)) {
+        RTI_MQTT_LOG_SET_SEQUENCE_ENSURE_LENGTH_FAILED(
+                &self->subscriptions,
+                seq_len + 1,
+                seq_len + 1)
+        goto done;
+    }
+    *RTI_MQTT_SubscriptionPtrSeq_get_reference(&self->subscriptions, seq_len) =
+            sub;
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+static DDS_ReturnCode_t RTI_MQTT_TopicTreeNode_match(
+        struct RTI_MQTT_TopicTreeNode *self,
+        const char *level,
+        DDS_Boolean first_level,
+        struct RTI_MQTT_SubscriptionPtrSeq *matches)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    const char *level_end = NULL, *next_level = NULL;
+    DDS_UnsignedLong level_len = 0;
+    DDS_Boolean use_wildcards = DDS_BOOLEAN_TRUE;
+    struct RTI_MQTT_TopicTreeNode *child = NULL;
+
+    if (level == NULL) {
+        /* All levels of the topic name have been consumed. A multi-level
+           wildcard also matches its parent level (e.g. "foo/#" matches
+           "foo"). */
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_TopicTree_add_matches(&self->subscriptions, matches)) {
+            goto done;
+        }
+        if (self->hash != NULL
+            && DDS_RETCODE_OK
+                    != RTI_MQTT_TopicTree_add_matches(
+                            &self->hash->subscriptions,
+                            matches)) {
+            goto done;
+        }
+        retval = DDS_RETCODE_OK;
+        goto done;
+    }
+
+    level_end = RTI_MQTT_String_find_char(
+            level,
+            RTI_MQTT_TopicTree_LEVEL_SEPARATOR);
+    if (level_end != NULL) {
+        level_len = (DDS_UnsignedLong)(level_end - level);
+        next_level = level_end + 1;
+    } else {
+        level_len = (DDS_UnsignedLong) RTI_MQTT_String_length(level);
+        next_level = NULL;
+    }
+
+    /* Topic names starting with '$' are not matched by filters starting
+       with a wildcard */
+    use_wildcards =
+            !(first_level && level[0] == RTI_MQTT_TopicTree_SYSTEM_PREFIX);
+
+    if (use_wildcards && self->hash != NULL
+        && DDS_RETCODE_OK
+                != RTI_MQTT_TopicTree_add_matches(
+                        &self->hash->subscriptions,
+                        matches)) {
+        goto done;
+    }
+
+    child = RTI_MQTT_TopicTreeNode_find_child(self, level, level_len, NULL);
+    if (child != NULL
+        && DDS_RETCODE_OK
+                != RTI_MQTT_TopicTreeNode_match(
+                        child,
+                        next_level,
+                        DDS_BOOLEAN_FALSE,
+                        matches)) {
+        goto done;
+    }
+
+    if (use_wildcards && self->plus != NULL
+        && DDS_RETCODE_OK
+                != RTI_MQTT_TopicTreeNode_match(
+                        self->plus,
+                        next_level,
+                        DDS_BOOLEAN_FALSE,
+                        matches)) {
+        goto done;
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
+
+static DDS_ReturnCode_t RTI_MQTT_TopicTree_add_matches(
+        struct RTI_MQTT_SubscriptionPtrSeq *subs,
+        struct RTI_MQTT_SubscriptionPtrSeq *matches)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+    DDS_UnsignedLong subs_len = 0, matches_len = 0, i = 0, j = 0;
+    DDS_Boolean found = DDS_BOOLEAN_FALSE;
+
+    subs_len = RTI_MQTT_SubscriptionPtrSeq_get_length(subs);
+    for (i = 0; i < subs_len; i++) {
+        struct RTI_MQTT_Subscription *sub =
+                *RTI_MQTT_SubscriptionPtrSeq_get_reference(subs, i);
+
+        /* A subscription might match through more than one of its filters,
+           but it must only be returned once. The number of matches for a
+           single topic is expected to be small. */
+        matches_len = RTI_MQTT_SubscriptionPtrSeq_get_length(matches);
+        found = DDS_BOOLEAN_FALSE;
+        for (j = 0; j < matches_len && !found; j++) {
+            found = (*RTI_MQTT_SubscriptionPtrSeq_get_reference(matches, j)
+                     == sub);
+        }
+        if (found) {
+            continue;
+        }
+
+        if (!RTI_MQTT_SubscriptionPtrSeq_ensure_length(
+                    matches,
+                    matches_len + 1,
+                    (matches_len + 1) * 2)) {
+            RTI_MQTT_LOG_SET_SEQUENCE_ENSURE_LENGTH_FAILED(
+                    matches,
+                    matches_len + 1,
+                    (matches_len + 1) * 2)
+            goto done;
+        }
+        *RTI_MQTT_SubscriptionPtrSeq_get_reference(matches, matches_len) = sub;
+    }
+
+    retval = DDS_RETCODE_OK;
+done:
+    return retval;
+}
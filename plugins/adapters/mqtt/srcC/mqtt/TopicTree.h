@@ -0,0 +1,84 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#ifndef TopicTree_h
+#define TopicTree_h
+
+#include "rtiadapt_mqtt.h"
+
+#include "Infrastructure.h"
+#include "Subscription.h"
+
+/* A node of an RTI_MQTT_TopicTree. Each node corresponds to one level of a
+   topic filter. Children matching a literal level are kept sorted by level,
+   while the single-level ('+') and multi-level ('#') wildcards are stored
+   separately, since they must be visited for any topic level. */
+struct RTI_MQTT_TopicTreeNode {
+    char *level;
+    struct RTI_MQTT_TopicTreeNode **children;
+    DDS_UnsignedLong children_len;
+    DDS_UnsignedLong children_max;
+    struct RTI_MQTT_TopicTreeNode *plus;
+    struct RTI_MQTT_TopicTreeNode *hash;
+    struct RTI_MQTT_SubscriptionPtrSeq subscriptions;
+};
+
+#define RTI_MQTT_TopicTreeNode_INITIALIZER              \
+    {                                                   \
+        NULL, /* level */                               \
+        NULL, /* children */                            \
+        0, /* children_len */                           \
+        0, /* children_max */                           \
+        NULL, /* plus */                                \
+        NULL, /* hash */                                \
+        DDS_SEQUENCE_INITIALIZER /* subscriptions */    \
+    }
+
+/* A precompiled index of the topic filters of a set of subscriptions,
+   which allows all the subscriptions matching a topic name to be found in
+   time proportional to the number of levels in the topic name. */
+struct RTI_MQTT_TopicTree {
+    struct RTI_MQTT_TopicTreeNode *root;
+};
+
+#define RTI_MQTT_TopicTree_INITIALIZER \
+    {                                  \
+        NULL /* root */                \
+    }
+
+DDS_ReturnCode_t RTI_MQTT_TopicTree_initialize(struct RTI_MQTT_TopicTree *self);
+
+void RTI_MQTT_TopicTree_finalize(struct RTI_MQTT_TopicTree *self);
+
+void RTI_MQTT_TopicTree_clear(struct RTI_MQTT_TopicTree *self);
+
+DDS_ReturnCode_t RTI_MQTT_TopicTree_add_filter(
+        struct RTI_MQTT_TopicTree *self,
+        const char *topic_filter,
+        struct RTI_MQTT_Subscription *sub);
+
+DDS_ReturnCode_t RTI_MQTT_TopicTree_add_subscription(
+        struct RTI_MQTT_TopicTree *self,
+        struct RTI_MQTT_Subscription *sub);
+
+/* Find all subscriptions with at least one topic filter matching the
+   specified topic name. Each matching subscription is returned only once
+   in `matches_out`, which is reset by the function. */
+DDS_ReturnCode_t RTI_MQTT_TopicTree_match(
+        struct RTI_MQTT_TopicTree *self,
+        const char *topic_name,
+        struct RTI_MQTT_SubscriptionPtrSeq *matches_out);
+
+#endif /* TopicTree_h */
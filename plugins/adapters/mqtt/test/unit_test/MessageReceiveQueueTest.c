@@ -0,0 +1,312 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Message.h"
+#include "UtilsUnitTest.h"
+
+/* Every test deletes its queue when a check fails */
+#define RTI_MQTT_TEST_CHECK(cond_) RTI_UTILS_TEST_CHECK_OR(cond_, goto done)
+
+#define RTI_MQTT_TEST_CAPACITY 3
+#define RTI_MQTT_TEST_TOPIC_MAX 32
+
+struct RTI_MQTT_MessageReceiveQueueTest {
+    RTI_MQTT_SubscriptionStatus *status;
+    struct RTI_MQTT_MessageReceiveQueue *queue;
+};
+
+static DDS_Boolean RTI_MQTT_MessageReceiveQueueTest_initialize(
+        struct RTI_MQTT_MessageReceiveQueueTest *self)
+{
+    self->status = NULL;
+    self->queue = NULL;
+
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_SubscriptionStatus_new(DDS_BOOLEAN_TRUE, &self->status)) {
+        return DDS_BOOLEAN_FALSE;
+    }
+    return DDS_RETCODE_OK
+            == RTI_MQTT_MessageReceiveQueue_new(
+                    RTI_MQTT_TEST_CAPACITY,
+                    self->status->message_status,
+                    &self->queue);
+}
+
+static void RTI_MQTT_MessageReceiveQueueTest_finalize(
+        struct RTI_MQTT_MessageReceiveQueueTest *self)
+{
+    if (self->queue != NULL) {
+        RTI_MQTT_MessageReceiveQueue_delete(self->queue);
+        self->queue = NULL;
+    }
+    if (self->status != NULL) {
+        RTI_MQTT_SubscriptionStatus_delete(self->status);
+        self->status = NULL;
+    }
+}
+
+/* Receive the i-th message of a test, which is told apart by its topic */
+static DDS_Boolean RTI_MQTT_MessageReceiveQueueTest_receive(
+        struct RTI_MQTT_MessageReceiveQueueTest *self,
+        int i,
+        DDS_Boolean expect_lost)
+{
+    char topic[RTI_MQTT_TEST_TOPIC_MAX];
+    DDS_Boolean lost = DDS_BOOLEAN_FALSE;
+
+    sprintf(topic, "msg/%d", i);
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_MessageReceiveQueue_receive(
+                self->queue,
+                "payload",
+                7,
+                topic,
+                NULL,
+                NULL,
+                NULL,
+                &lost)) {
+        printf("failed to receive message: %s\n", topic);
+        return DDS_BOOLEAN_FALSE;
+    }
+    if (lost != expect_lost) {
+        printf("unexpected lost=%d receiving message: %s\n", lost, topic);
+        return DDS_BOOLEAN_FALSE;
+    }
+
+    return DDS_BOOLEAN_TRUE;
+}
+
+/* Checks that a read returns exactly the messages [first, first + count) */
+static DDS_Boolean RTI_MQTT_MessageReceiveQueueTest_read(
+        struct RTI_MQTT_MessageReceiveQueueTest *self,
+        int first,
+        int count)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE, loaned = DDS_BOOLEAN_FALSE;
+    struct DDS_DynamicDataSeq messages = DDS_SEQUENCE_INITIALIZER;
+    char expected[RTI_MQTT_TEST_TOPIC_MAX], topic[RTI_MQTT_TEST_TOPIC_MAX];
+    char *topic_ptr = NULL;
+    DDS_UnsignedLong topic_len = 0;
+    int i = 0;
+
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_MessageReceiveQueue_read(
+                self->queue,
+                RTI_MQTT_SUBSCRIPTION_READ_LENGTH_UNLIMITED,
+                &messages)) {
+        printf("failed to read messages\n");
+        goto done;
+    }
+    /* Nothing is loaned when there are no messages to read */
+    loaned = (DDS_DynamicDataSeq_get_length(&messages) > 0);
+
+    if (DDS_DynamicDataSeq_get_length(&messages) != (DDS_UnsignedLong) count) {
+        printf("read %u messages, expected %d\n",
+               DDS_DynamicDataSeq_get_length(&messages),
+               count);
+        goto done;
+    }
+
+    for (i = 0; i < count; i++) {
+        sprintf(expected, "msg/%d", first + i);
+        topic_ptr = topic;
+        topic_len = RTI_MQTT_TEST_TOPIC_MAX;
+        if (DDS_RETCODE_OK
+            != DDS_DynamicData_get_string(
+                    DDS_DynamicDataSeq_get_reference(&messages, i),
+                    &topic_ptr,
+                    &topic_len,
+                    "topic",
+                    DDS_DYNAMIC_DATA_MEMBER_ID_UNSPECIFIED)
+            || strcmp(topic, expected) != 0) {
+            printf("read message %d is not %s\n", i, expected);
+            goto done;
+        }
+    }
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    if (loaned) {
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_MessageReceiveQueue_return_loan(
+                    self->queue,
+                    &messages)) {
+            printf("failed to return loan\n");
+            retval = DDS_BOOLEAN_FALSE;
+        }
+    }
+    DDS_DynamicDataSeq_finalize(&messages);
+    return retval;
+}
+
+/* Move an empty queue to position `pos`, as if it had already received
+   `pos` messages, so that the tests can reach the end of the ring. Each
+   free slot expects the next position that maps to it. */
+static void RTI_MQTT_MessageReceiveQueueTest_move_to(
+        struct RTI_MQTT_MessageReceiveQueueTest *self,
+        DDS_UnsignedLong pos)
+{
+    struct RTI_MQTT_MessageReceiveQueue *queue = self->queue;
+    DDS_UnsignedLong i = 0, slot_pos = 0;
+
+    queue->head = pos;
+    queue->next = pos;
+    for (i = 0; i < queue->capacity; i++) {
+        slot_pos = (pos + i) % queue->position_max;
+        (*RTI_MQTT_ReceivedMessagePtrSeq_get_reference(
+                 &queue->queue,
+                 slot_pos % queue->capacity))
+                ->sequence = slot_pos;
+    }
+}
+
+static int RTI_MQTT_MessageReceiveQueueTest_empty_and_full(void)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_MessageReceiveQueueTest test;
+    RTI_MQTT_SubscriptionMessageStatus *msg_status = NULL;
+    int i = 0;
+
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_initialize(&test));
+    msg_status = test.status->message_status;
+
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_read(&test, 0, 0));
+
+    /* In a full queue, head and next map to the same slot, like in an empty
+       one, but their positions are `capacity` apart */
+    for (i = 0; i < RTI_MQTT_TEST_CAPACITY; i++) {
+        RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_receive(
+                &test,
+                i,
+                DDS_BOOLEAN_FALSE));
+    }
+    RTI_MQTT_TEST_CHECK(
+            test.queue->head % RTI_MQTT_TEST_CAPACITY
+            == test.queue->next % RTI_MQTT_TEST_CAPACITY);
+    RTI_MQTT_TEST_CHECK(
+            test.queue->next - test.queue->head == RTI_MQTT_TEST_CAPACITY);
+
+    /* The oldest message is dropped to store a new one */
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_receive(
+            &test,
+            RTI_MQTT_TEST_CAPACITY,
+            DDS_BOOLEAN_TRUE));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_read(
+            &test,
+            1,
+            RTI_MQTT_TEST_CAPACITY));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_read(&test, 0, 0));
+
+    RTI_MQTT_TEST_CHECK(
+            msg_status->received_count == RTI_MQTT_TEST_CAPACITY + 1);
+    RTI_MQTT_TEST_CHECK(msg_status->lost_count == 1);
+    RTI_MQTT_TEST_CHECK(msg_status->read_count == RTI_MQTT_TEST_CAPACITY);
+    RTI_MQTT_TEST_CHECK(msg_status->unread_count == 0);
+
+    /* Reading frees the slots, so the queue can be filled again */
+    for (i = 0; i < RTI_MQTT_TEST_CAPACITY; i++) {
+        RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_receive(
+                &test,
+                10 + i,
+                DDS_BOOLEAN_FALSE));
+    }
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_read(
+            &test,
+            10,
+            RTI_MQTT_TEST_CAPACITY));
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_MessageReceiveQueueTest_finalize(&test);
+    return retval;
+}
+
+/* Positions wrap around from position_max to 0 without losing or
+   reordering messages, also when a full queue drops its oldest message
+   across the wraparound */
+static int RTI_MQTT_MessageReceiveQueueTest_wraparound(void)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_MessageReceiveQueueTest test;
+    int i = 0;
+
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_initialize(&test));
+    RTI_MQTT_TEST_CHECK(
+            test.queue->position_max % RTI_MQTT_TEST_CAPACITY == 0);
+    RTI_MQTT_TEST_CHECK(
+            test.queue->position_max > 0xFFFFFFFF - RTI_MQTT_TEST_CAPACITY);
+
+    RTI_MQTT_MessageReceiveQueueTest_move_to(
+            &test,
+            test.queue->position_max - 2);
+
+    /* The third message is stored at position 0 */
+    for (i = 0; i < RTI_MQTT_TEST_CAPACITY; i++) {
+        RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_receive(
+                &test,
+                i,
+                DDS_BOOLEAN_FALSE));
+    }
+    RTI_MQTT_TEST_CHECK(test.queue->head == test.queue->position_max - 2);
+    RTI_MQTT_TEST_CHECK(test.queue->next == 1);
+
+    /* The dropped message is the one at position_max - 2 */
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_receive(
+            &test,
+            RTI_MQTT_TEST_CAPACITY,
+            DDS_BOOLEAN_TRUE));
+    RTI_MQTT_TEST_CHECK(test.queue->head == test.queue->position_max - 1);
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_read(
+            &test,
+            1,
+            RTI_MQTT_TEST_CAPACITY));
+    RTI_MQTT_TEST_CHECK(test.queue->head == 2);
+    RTI_MQTT_TEST_CHECK(test.queue->next == 2);
+
+    /* The queue keeps working past the wraparound */
+    for (i = 0; i <= RTI_MQTT_TEST_CAPACITY; i++) {
+        RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_receive(
+                &test,
+                10 + i,
+                (i == RTI_MQTT_TEST_CAPACITY) ? DDS_BOOLEAN_TRUE
+                                              : DDS_BOOLEAN_FALSE));
+    }
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_read(
+            &test,
+            11,
+            RTI_MQTT_TEST_CAPACITY));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_MessageReceiveQueueTest_read(&test, 0, 0));
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_MessageReceiveQueueTest_finalize(&test);
+    return retval;
+}
+
+int main(int argc, char **argv)
+{
+    struct RTI_UTILS_UnitTest tests[] = {
+        { "empty_and_full", RTI_MQTT_MessageReceiveQueueTest_empty_and_full },
+        { "wraparound", RTI_MQTT_MessageReceiveQueueTest_wraparound }
+    };
+
+    return RTI_UTILS_UnitTest_run_all(
+            tests,
+            sizeof(tests) / sizeof(tests[0]));
+}
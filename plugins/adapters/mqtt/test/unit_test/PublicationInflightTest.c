@@ -0,0 +1,222 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+
+#include <stdio.h>
+
+#include "Publication.h"
+#include "UtilsUnitTest.h"
+
+/* Every test finalizes its publication when a check fails */
+#define RTI_MQTT_TEST_CHECK(cond_) RTI_UTILS_TEST_CHECK_OR(cond_, goto done)
+
+#define RTI_MQTT_TEST_WINDOW_SIZE 3
+
+/* The in-flight window only uses the status of a publication, so the tests
+   don't need a client */
+static DDS_Boolean RTI_MQTT_PublicationInflightTest_initialize(
+        struct RTI_MQTT_Publication *pub)
+{
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_PublicationStatus_new(DDS_BOOLEAN_TRUE, &pub->data)) {
+        return DDS_BOOLEAN_FALSE;
+    }
+    return DDS_RETCODE_OK
+            == RTI_MQTT_Publication_initialize_inflight(
+                    pub,
+                    RTI_MQTT_TEST_WINDOW_SIZE);
+}
+
+static void RTI_MQTT_PublicationInflightTest_finalize(
+        struct RTI_MQTT_Publication *pub)
+{
+    RTI_MQTT_Publication_finalize_inflight(pub);
+    if (pub->data != NULL) {
+        RTI_MQTT_PublicationStatus_delete(pub->data);
+        pub->data = NULL;
+    }
+}
+
+/* Notify the result of an in-flight message, like the client does */
+static DDS_ReturnCode_t RTI_MQTT_PublicationInflightTest_complete(
+        struct RTI_MQTT_Publication *pub,
+        struct RTI_MQTT_PublicationInflightMessage *msg,
+        DDS_ReturnCode_t result)
+{
+    DDS_ReturnCode_t retval = DDS_RETCODE_ERROR;
+
+    RTI_MQTT_Mutex_assert(&pub->inflight.lock);
+    retval = RTI_MQTT_Publication_on_inflight_write_result(pub, msg, result);
+    RTI_MQTT_Mutex_release(&pub->inflight.lock);
+
+    return retval;
+}
+
+/* Messages are only taken from the window until it's full, and a slot is
+   reused as soon as its result is notified */
+static int RTI_MQTT_PublicationInflightTest_full_window(void)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_Publication pub = RTI_MQTT_Publication_INITIALIZER;
+    struct RTI_MQTT_PublicationInflightMessage
+            *msgs[RTI_MQTT_TEST_WINDOW_SIZE];
+    struct RTI_MQTT_PublicationInflightMessage *msg = NULL;
+    int i = 0, j = 0;
+
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_PublicationInflightTest_initialize(&pub));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_Publication_is_pipelined(&pub));
+
+    for (i = 0; i < RTI_MQTT_TEST_WINDOW_SIZE; i++) {
+        msgs[i] = RTI_MQTT_Publication_try_acquire_inflight(
+                &pub,
+                RTI_MQTT_QosLevel_ONE,
+                NULL,
+                NULL);
+        RTI_MQTT_TEST_CHECK(msgs[i] != NULL);
+        RTI_MQTT_TEST_CHECK(msgs[i]->pub == &pub);
+        for (j = 0; j < i; j++) {
+            RTI_MQTT_TEST_CHECK(msgs[j] != msgs[i]);
+        }
+    }
+    RTI_MQTT_TEST_CHECK(
+            RTI_MQTT_Publication_get_inflight_count(&pub)
+            == RTI_MQTT_TEST_WINDOW_SIZE);
+    RTI_MQTT_TEST_CHECK(
+            pub.data->message_status->pending_count
+            == RTI_MQTT_TEST_WINDOW_SIZE);
+
+    RTI_MQTT_TEST_CHECK(
+            RTI_MQTT_Publication_try_acquire_inflight(
+                    &pub,
+                    RTI_MQTT_QosLevel_ONE,
+                    NULL,
+                    NULL)
+            == NULL);
+    RTI_MQTT_TEST_CHECK(
+            RTI_MQTT_Publication_get_inflight_count(&pub)
+            == RTI_MQTT_TEST_WINDOW_SIZE);
+
+    /* Results may arrive in any order */
+    RTI_MQTT_TEST_CHECK(
+            DDS_RETCODE_OK
+            == RTI_MQTT_PublicationInflightTest_complete(
+                    &pub,
+                    msgs[1],
+                    DDS_RETCODE_OK));
+    RTI_MQTT_TEST_CHECK(
+            RTI_MQTT_Publication_get_inflight_count(&pub)
+            == RTI_MQTT_TEST_WINDOW_SIZE - 1);
+    RTI_MQTT_TEST_CHECK(pub.data->message_status->ok_count == 1);
+
+    msg = RTI_MQTT_Publication_try_acquire_inflight(
+            &pub,
+            RTI_MQTT_QosLevel_TWO,
+            NULL,
+            NULL);
+    RTI_MQTT_TEST_CHECK(msg == msgs[1]);
+    RTI_MQTT_TEST_CHECK(msg->qos == RTI_MQTT_QosLevel_TWO);
+
+    for (i = 0; i < RTI_MQTT_TEST_WINDOW_SIZE; i++) {
+        RTI_MQTT_TEST_CHECK(
+                DDS_RETCODE_OK
+                == RTI_MQTT_PublicationInflightTest_complete(
+                        &pub,
+                        msgs[i],
+                        DDS_RETCODE_ERROR));
+    }
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_Publication_get_inflight_count(&pub) == 0);
+    RTI_MQTT_TEST_CHECK(pub.data->message_status->pending_count == 0);
+    RTI_MQTT_TEST_CHECK(
+            pub.data->message_status->error_count
+            == RTI_MQTT_TEST_WINDOW_SIZE);
+
+    /* A result for an empty window is rejected */
+    RTI_MQTT_TEST_CHECK(
+            DDS_RETCODE_OK
+            != RTI_MQTT_PublicationInflightTest_complete(
+                    &pub,
+                    msgs[0],
+                    DDS_RETCODE_OK));
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_PublicationInflightTest_finalize(&pub);
+    return retval;
+}
+
+/* The results of the messages of a batch are stored into its result array,
+   until the batch is detached */
+static int RTI_MQTT_PublicationInflightTest_batch_results(void)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_Publication pub = RTI_MQTT_Publication_INITIALIZER;
+    struct RTI_MQTT_PublicationInflightMessage *msgs[2] = { NULL, NULL };
+    DDS_ReturnCode_t results[2] = { DDS_RETCODE_OK, DDS_RETCODE_OK };
+    DDS_UnsignedLong batch_pending = 0;
+    int i = 0;
+
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_PublicationInflightTest_initialize(&pub));
+
+    for (i = 0; i < 2; i++) {
+        msgs[i] = RTI_MQTT_Publication_try_acquire_inflight(
+                &pub,
+                RTI_MQTT_QosLevel_ONE,
+                &results[i],
+                &batch_pending);
+        RTI_MQTT_TEST_CHECK(msgs[i] != NULL);
+    }
+    RTI_MQTT_TEST_CHECK(batch_pending == 2);
+
+    RTI_MQTT_TEST_CHECK(
+            DDS_RETCODE_OK
+            == RTI_MQTT_PublicationInflightTest_complete(
+                    &pub,
+                    msgs[0],
+                    DDS_RETCODE_TIMEOUT));
+    RTI_MQTT_TEST_CHECK(results[0] == DDS_RETCODE_TIMEOUT);
+    RTI_MQTT_TEST_CHECK(batch_pending == 1);
+
+    /* A writer that stops waiting for its batch no longer gets results */
+    RTI_MQTT_Publication_detach_inflight_batch(&pub, &batch_pending);
+    RTI_MQTT_TEST_CHECK(batch_pending == 0);
+    RTI_MQTT_TEST_CHECK(msgs[1]->result == NULL);
+
+    RTI_MQTT_TEST_CHECK(
+            DDS_RETCODE_OK
+            == RTI_MQTT_PublicationInflightTest_complete(
+                    &pub,
+                    msgs[1],
+                    DDS_RETCODE_ERROR));
+    RTI_MQTT_TEST_CHECK(results[1] == DDS_RETCODE_OK);
+    RTI_MQTT_TEST_CHECK(batch_pending == 0);
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_Publication_get_inflight_count(&pub) == 0);
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_PublicationInflightTest_finalize(&pub);
+    return retval;
+}
+
+int main(int argc, char **argv)
+{
+    struct RTI_UTILS_UnitTest tests[] = {
+        { "full_window", RTI_MQTT_PublicationInflightTest_full_window },
+        { "batch_results", RTI_MQTT_PublicationInflightTest_batch_results }
+    };
+
+    return RTI_UTILS_UnitTest_run_all(
+            tests,
+            sizeof(tests) / sizeof(tests[0]));
+}
@@ -0,0 +1,298 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+
+#include <stdio.h>
+
+#include "TopicTree.h"
+#include "UtilsUnitTest.h"
+
+/* Every test finalizes its tree when a check fails */
+#define RTI_MQTT_TEST_CHECK(cond_) RTI_UTILS_TEST_CHECK_OR(cond_, goto done)
+
+#define RTI_MQTT_TEST_SUBSCRIPTIONS_MAX 4
+
+/* The tests only compare the addresses of the subscriptions */
+static struct RTI_MQTT_Subscription
+        RTI_MQTT_TopicTreeTest_subs[RTI_MQTT_TEST_SUBSCRIPTIONS_MAX];
+
+#define RTI_MQTT_TEST_SUB(i_) (&RTI_MQTT_TopicTreeTest_subs[(i_)])
+
+/* Checks that a topic name is matched by exactly the subscriptions whose
+   bit is set in `expected` (e.g. 0x5 for the subscriptions 0 and 2), and
+   that each of them is returned only once. */
+static DDS_Boolean RTI_MQTT_TopicTreeTest_matches(
+        struct RTI_MQTT_TopicTree *tree,
+        const char *topic_name,
+        unsigned int expected)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_SubscriptionPtrSeq matches = DDS_SEQUENCE_INITIALIZER;
+    DDS_UnsignedLong matches_len = 0, i = 0;
+    unsigned int found = 0, bit = 0;
+    int j = 0;
+
+    if (!RTI_MQTT_SubscriptionPtrSeq_initialize(&matches)) {
+        goto done;
+    }
+
+    if (DDS_RETCODE_OK
+        != RTI_MQTT_TopicTree_match(tree, topic_name, &matches)) {
+        printf("failed to match topic: %s\n", topic_name);
+        goto done;
+    }
+
+    matches_len = RTI_MQTT_SubscriptionPtrSeq_get_length(&matches);
+    for (i = 0; i < matches_len; i++) {
+        struct RTI_MQTT_Subscription *sub =
+                *RTI_MQTT_SubscriptionPtrSeq_get_reference(&matches, i);
+
+        for (j = 0, bit = 0; j < RTI_MQTT_TEST_SUBSCRIPTIONS_MAX; j++) {
+            if (sub == RTI_MQTT_TEST_SUB(j)) {
+                bit = 1u << j;
+            }
+        }
+        if (bit == 0 || (found & bit)) {
+            printf("unexpected or duplicate match for topic: %s\n",
+                   topic_name);
+            goto done;
+        }
+        found |= bit;
+    }
+
+    if (found != expected) {
+        printf("topic '%s' matched 0x%x, expected 0x%x\n",
+               topic_name,
+               found,
+               expected);
+        goto done;
+    }
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_SubscriptionPtrSeq_finalize(&matches);
+    return retval;
+}
+
+/* Adds several topic filters for the same subscription */
+static DDS_Boolean RTI_MQTT_TopicTreeTest_add_filters(
+        struct RTI_MQTT_TopicTree *tree,
+        struct RTI_MQTT_Subscription *sub,
+        const char **filters)
+{
+    for (; *filters != NULL; filters++) {
+        if (DDS_RETCODE_OK
+            != RTI_MQTT_TopicTree_add_filter(tree, *filters, sub)) {
+            printf("failed to add topic filter: %s\n", *filters);
+            return DDS_BOOLEAN_FALSE;
+        }
+    }
+    return DDS_BOOLEAN_TRUE;
+}
+
+#define RTI_MQTT_TEST_MATCHES(topic_, expected_) \
+    RTI_MQTT_TopicTreeTest_matches(&tree, (topic_), (expected_))
+
+#define RTI_MQTT_TEST_ADD(sub_, ...)                            \
+    do {                                                        \
+        const char *filters_[] = { __VA_ARGS__, NULL };         \
+        RTI_MQTT_TEST_CHECK(RTI_MQTT_TopicTreeTest_add_filters( \
+                &tree,                                          \
+                RTI_MQTT_TEST_SUB(sub_),                        \
+                filters_));                                     \
+    } while (0)
+
+static int RTI_MQTT_TopicTreeTest_literal_levels(void)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_TopicTree tree = RTI_MQTT_TopicTree_INITIALIZER;
+
+    RTI_MQTT_TEST_CHECK(DDS_RETCODE_OK == RTI_MQTT_TopicTree_initialize(&tree));
+    RTI_MQTT_TEST_ADD(0, "a/b");
+    RTI_MQTT_TEST_ADD(1, "a/c");
+    RTI_MQTT_TEST_ADD(2, "a");
+
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/b", 0x1));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/c", 0x2));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a", 0x4));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/b/c", 0x0));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/", 0x0));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("b", 0x0));
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_TopicTree_finalize(&tree);
+    return retval;
+}
+
+static int RTI_MQTT_TopicTreeTest_single_level_wildcard(void)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_TopicTree tree = RTI_MQTT_TopicTree_INITIALIZER;
+
+    RTI_MQTT_TEST_CHECK(DDS_RETCODE_OK == RTI_MQTT_TopicTree_initialize(&tree));
+    RTI_MQTT_TEST_ADD(0, "a/+/c");
+    RTI_MQTT_TEST_ADD(1, "+");
+    RTI_MQTT_TEST_ADD(2, "a/+");
+
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/b/c", 0x1));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a//c", 0x1));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/b/c/d", 0x0));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a", 0x2));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/b", 0x4));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/", 0x4));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("b/b", 0x0));
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_TopicTree_finalize(&tree);
+    return retval;
+}
+
+static int RTI_MQTT_TopicTreeTest_multi_level_wildcard(void)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_TopicTree tree = RTI_MQTT_TopicTree_INITIALIZER;
+
+    RTI_MQTT_TEST_CHECK(DDS_RETCODE_OK == RTI_MQTT_TopicTree_initialize(&tree));
+    RTI_MQTT_TEST_ADD(0, "foo/#");
+    RTI_MQTT_TEST_ADD(1, "#");
+    RTI_MQTT_TEST_ADD(2, "+/bar/#");
+
+    /* "foo/#" also matches its parent level */
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("foo", 0x3));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("foo/", 0x3));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("foo/bar", 0x7));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("foo/bar/baz", 0x7));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("x/bar", 0x6));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("x", 0x2));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("foobar", 0x2));
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_TopicTree_finalize(&tree);
+    return retval;
+}
+
+static int RTI_MQTT_TopicTreeTest_system_topics(void)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_TopicTree tree = RTI_MQTT_TopicTree_INITIALIZER;
+
+    RTI_MQTT_TEST_CHECK(DDS_RETCODE_OK == RTI_MQTT_TopicTree_initialize(&tree));
+    RTI_MQTT_TEST_ADD(0, "#");
+    RTI_MQTT_TEST_ADD(1, "+/info");
+    RTI_MQTT_TEST_ADD(2, "$SYS/#");
+    RTI_MQTT_TEST_ADD(3, "$SYS/+");
+
+    /* filters starting with a wildcard don't match topics starting with
+       '$', but the '$' is only special in the first level */
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("$SYS/info", 0xC));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("$SYS", 0x4));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("x/info", 0x3));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("x/$SYS", 0x1));
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_TopicTree_finalize(&tree);
+    return retval;
+}
+
+static int RTI_MQTT_TopicTreeTest_duplicate_matches(void)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_TopicTree tree = RTI_MQTT_TopicTree_INITIALIZER;
+
+    RTI_MQTT_TEST_CHECK(DDS_RETCODE_OK == RTI_MQTT_TopicTree_initialize(&tree));
+    /* several filters of a subscription match the same topics */
+    RTI_MQTT_TEST_ADD(0, "a/b", "a/+", "+/b", "a/#", "#", "a/b");
+    RTI_MQTT_TEST_ADD(1, "a/b");
+
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/b", 0x3));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a", 0x1));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("c/b", 0x1));
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_TopicTree_finalize(&tree);
+    return retval;
+}
+
+static int RTI_MQTT_TopicTreeTest_invalid_filters(void)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_TopicTree tree = RTI_MQTT_TopicTree_INITIALIZER;
+    const char *invalid_filters[] = { "", "a/#/b", "a+/b", "a/b#", NULL };
+    const char **filter = NULL;
+
+    RTI_MQTT_TEST_CHECK(DDS_RETCODE_OK == RTI_MQTT_TopicTree_initialize(&tree));
+    for (filter = invalid_filters; *filter != NULL; filter++) {
+        RTI_MQTT_TEST_CHECK(
+                DDS_RETCODE_OK
+                != RTI_MQTT_TopicTree_add_filter(
+                        &tree,
+                        *filter,
+                        RTI_MQTT_TEST_SUB(0)));
+    }
+
+    /* the tree can still be used */
+    RTI_MQTT_TEST_ADD(1, "a/+");
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/b", 0x2));
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_TopicTree_finalize(&tree);
+    return retval;
+}
+
+static int RTI_MQTT_TopicTreeTest_clear(void)
+{
+    DDS_Boolean retval = DDS_BOOLEAN_FALSE;
+    struct RTI_MQTT_TopicTree tree = RTI_MQTT_TopicTree_INITIALIZER;
+
+    RTI_MQTT_TEST_CHECK(DDS_RETCODE_OK == RTI_MQTT_TopicTree_initialize(&tree));
+    RTI_MQTT_TEST_ADD(0, "a/b", "+", "#");
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/b", 0x1));
+
+    RTI_MQTT_TopicTree_clear(&tree);
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/b", 0x0));
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a", 0x0));
+
+    RTI_MQTT_TEST_ADD(1, "a/b");
+    RTI_MQTT_TEST_CHECK(RTI_MQTT_TEST_MATCHES("a/b", 0x2));
+
+    retval = DDS_BOOLEAN_TRUE;
+done:
+    RTI_MQTT_TopicTree_finalize(&tree);
+    return retval;
+}
+
+int main(int argc, char *argv[])
+{
+    struct RTI_UTILS_UnitTest tests[] = {
+        { "literal levels", RTI_MQTT_TopicTreeTest_literal_levels },
+        { "single-level wildcard",
+          RTI_MQTT_TopicTreeTest_single_level_wildcard },
+        { "multi-level wildcard", RTI_MQTT_TopicTreeTest_multi_level_wildcard },
+        { "system topics", RTI_MQTT_TopicTreeTest_system_topics },
+        { "duplicate matches", RTI_MQTT_TopicTreeTest_duplicate_matches },
+        { "invalid filters", RTI_MQTT_TopicTreeTest_invalid_filters },
+        { "clear", RTI_MQTT_TopicTreeTest_clear },
+    };
+
+    return RTI_UTILS_UnitTest_run_all(
+            tests,
+            sizeof(tests) / sizeof(tests[0]));
+}
@@ -16,6 +16,16 @@
 #ifndef rtiprocess_fwd_hpp
 #define rtiprocess_fwd_hpp
 
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <rtiprocess_fwd_glob.hpp>
 #include <rtiprocess_fwd_log.hpp>
 #include <rtiprocess_fwd_platform.hpp>
 #include <rtiprocess_fwd_properties.hpp>
@@ -32,35 +42,177 @@ struct InternalMatchingTableEntry {
     std::string out_name;
 };
 
+/*
+ * Bounded LRU map from the keys looked up in an InternalMatchingTable to the
+ * index of the entry they matched. Copies start empty, since the cached
+ * positions are only valid for the table that computed them. It may be used
+ * from several threads.
+ */
+class InternalMatchingTableCache {
+public:
+    InternalMatchingTableCache(size_t capacity = 0);
+
+    InternalMatchingTableCache(const InternalMatchingTableCache &other);
+
+    InternalMatchingTableCache &
+            operator=(const InternalMatchingTableCache &other);
+
+    bool get(const std::string &key, size_t &index_out);
+    void put(const std::string &key, size_t index);
+    void clear();
+
+private:
+    typedef std::list<std::pair<std::string, size_t>> LruList;
+
+    size_t capacity;
+    LruList lru;
+    std::unordered_map<std::string, LruList::iterator> positions;
+    std::mutex mutex;
+};
+
+/*
+ * Entries are matched in order and the first entry whose in_key matches wins.
+ * Entries without wildcards are stored in a hash map, and the rest are
+ * compiled into a single GlobAutomaton, so a lookup doesn't depend on the
+ * number of entries. The results are memoized per key.
+ */
 struct InternalMatchingTable {
     InternalMatchingTableEntry &find(const char *in_key);
+    InternalMatchingTableEntry &find(const std::string &in_key);
+    size_t find_index(const std::string &in_key);
     InternalMatchingTableEntry &add(const char *in_key, const char *out_name);
 
+    /* index of the entry that matches a key, or GlobAutomaton::NO_MATCH */
+    size_t lookup(const std::string &in_key);
+
     std::vector<InternalMatchingTableEntry> entries;
 
-    static InternalMatchingTable
-            from_matching_table(const fwd::MatchingTable &table);
+    InternalMatchingTable(size_t cache_size = 0);
+
+    static InternalMatchingTable from_matching_table(
+            const fwd::MatchingTable &table,
+            size_t cache_size);
+
+private:
+    std::unordered_map<std::string, size_t> exact_entries;
+    GlobAutomaton pattern_entries;
+    InternalMatchingTableCache cache;
+
+    size_t match(const std::string &in_key) const;
+};
+
+/*
+ * Fixed set of threads that run a list of tasks at a time. The thread that
+ * calls run() also runs tasks, and waits until all of them are done.
+ */
+class ForwardingWorkerPool {
+public:
+    ForwardingWorkerPool(size_t thread_count);
+
+    ~ForwardingWorkerPool();
+
+    void run(const std::vector<std::function<void()>> &tasks);
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable task_available;
+    std::condition_variable tasks_done;
+    const std::vector<std::function<void()>> *tasks;
+    size_t next_task;
+    size_t pending_tasks;
+    bool stopping;
+
+    void worker();
+
+    /* runs the next task, with the mutex locked by the lock */
+    void run_next_task(std::unique_lock<std::mutex> &lock);
 };
 
 class ForwardingEngine : public rti::routing::processor::NoOpProcessor {
 public:
     void on_data_available(rti::routing::processor::Route &);
 
+    void on_start(rti::routing::processor::Route &);
+
+    void on_input_enabled(
+            rti::routing::processor::Route &,
+            rti::routing::processor::Input &);
+
+    void on_input_disabled(
+            rti::routing::processor::Route &,
+            rti::routing::processor::Input &);
+
     ForwardingEngine(ForwardingEngineConfiguration &config);
 
 protected:
+    typedef rti::routing::processor::TypedOutput<dds::core::xtypes::DynamicData>
+            DynamicDataOutput;
+
+    /*
+     * Samples of a take() for every output, and outputs with samples in the
+     * order they were first used.
+     */
+    struct OutputBatches {
+        std::vector<std::vector<const dds::core::xtypes::DynamicData *>>
+                batches;
+        std::vector<size_t> pending_outputs;
+    };
+
     InternalMatchingTable fwd_table;
+    /* index in output_names of the output of every entry of fwd_table */
+    std::vector<size_t> fwd_entry_outputs;
+    std::vector<std::string> output_names;
+    std::map<std::string, size_t> output_indexes;
+    std::vector<std::unique_ptr<DynamicDataOutput>> outputs;
+    /* inputs that may have data, in the order they were enabled */
+    std::vector<rti::routing::processor::Input *> enabled_inputs;
+    /* one for every input that is processed at the same time */
+    std::vector<OutputBatches> input_batches;
+    std::unique_ptr<ForwardingWorkerPool> worker_pool;
+    std::vector<std::function<void()>> input_tasks;
+
+    void process_input(
+            rti::routing::processor::Route &route,
+            rti::routing::processor::Input &input,
+            OutputBatches &batches);
+
+    /*
+     * Adds the samples to the batch of their output. It doesn't use the route,
+     * so the inputs may be grouped in parallel.
+     */
+    void group_samples(
+            rti::routing::processor::TypedInput<dds::core::xtypes::DynamicData>
+                    &input,
+            rti::routing::processor::LoanedSamples<
+                    dds::core::xtypes::DynamicData> &samples,
+            OutputBatches &batches);
 
-    void forward_data(
+    /* writes the batches to their outputs, and empties them */
+    void write_batches(
             rti::routing::processor::Route &route,
             rti::routing::processor::TypedInput<dds::core::xtypes::DynamicData>
                     &input,
-            const dds::core::xtypes::DynamicData &data);
+            OutputBatches &batches);
+
+    DynamicDataOutput &get_output(
+            rti::routing::processor::Route &route,
+            size_t output_index);
+
+    size_t add_output(const std::string &out_name);
+
+    /* index in output_names of the output a sample is forwarded to */
+    virtual size_t find_forwarding_output(
+            rti::routing::processor::TypedInput<dds::core::xtypes::DynamicData>
+                    &input,
+            const dds::core::xtypes::DynamicData &data,
+            const dds::sub::SampleInfo &info);
 
     virtual void get_forwarding_key(
             rti::routing::processor::TypedInput<dds::core::xtypes::DynamicData>
                     &input,
             const dds::core::xtypes::DynamicData &data,
+            const dds::sub::SampleInfo &info,
             std::string &fwd_key_out) = 0;
 };
 
@@ -74,11 +226,66 @@ protected:
             rti::routing::processor::TypedInput<dds::core::xtypes::DynamicData>
                     &input,
             const dds::core::xtypes::DynamicData &data,
+            const dds::sub::SampleInfo &info,
             std::string &fwd_key_out);
 };
 
 
+/*
+ * Compiled form of a forwarding table for a member whose values are
+ * integers. Values are stored as ordinals, that keep the order of both signed
+ * and unsigned values in a uint64_t. Entries whose in_key is a glob pattern
+ * are not compiled, and need the value formatted as a string.
+ */
+class IntegerMatchingTable {
+public:
+    IntegerMatchingTable();
+
+    void add_range(uint64_t low, uint64_t high, size_t index);
+    void add_pattern(size_t index);
+
+    /* lowest index of the values and ranges that contain an ordinal */
+    size_t match(uint64_t ordinal) const;
+
+    size_t first_pattern() const;
+
+private:
+    struct Range {
+        uint64_t low;
+        uint64_t high;
+        size_t index;
+    };
+
+    std::unordered_map<uint64_t, size_t> values;
+    std::vector<Range> ranges;
+    size_t first_pattern_index;
+};
+
+/*
+ * Maps keys to a set of values, so that every key is always mapped to the same
+ * value, and adding or removing a value only remaps the keys of that value.
+ * Every value is placed in several points of a ring of 64-bit hashes, and a
+ * key is mapped to the value of the first point after the hash of the key.
+ * The hash doesn't depend on the platform, so different processes map a key
+ * to the same value.
+ */
+class ConsistentHashRing {
+public:
+    static const size_t POINTS_PER_VALUE;
+
+    void add(const std::string &name, size_t value);
+    size_t find(const std::string &key) const;
+    bool empty() const;
+
+    static uint64_t hash(const std::string &str);
+
+private:
+    /* sorted by hash */
+    std::vector<std::pair<uint64_t, size_t>> points;
+};
+
 struct InputMemberValue {
+    static const char *KEY_HASH;
     static const char *FORMAT_BOOLEAN;
     static const char *FORMAT_UINT8;
     static const char *FORMAT_UINT16;
@@ -94,6 +301,16 @@ struct InputMemberValue {
     std::string name;
     dds::core::optional<rti::core::xtypes::DynamicDataMemberInfo> info;
     std::string string_format;
+    /* ids of the structs that contain a nested member, and of the member */
+    std::vector<uint32_t> member_path;
+    uint32_t member_id;
+    /* the key hash of the instance, instead of a member */
+    bool is_key_hash;
+    /* integer, boolean and enum members are matched by value */
+    bool is_integer;
+    bool is_signed;
+    std::map<uint64_t, std::string> enumerator_names;
+    IntegerMatchingTable fwd_matchers;
 
     InputMemberValue();
 
@@ -101,9 +318,64 @@ struct InputMemberValue {
             const char *name,
             const dds::core::xtypes::DynamicData &data);
 
+    /*
+     * Compiles the entries of the forwarding table into fwd_matchers, for an
+     * integer member that is the whole forwarding key. Throws if an in_key is
+     * a malformed range or list of values of the member.
+     */
+    void compile_matchers(const InternalMatchingTable &fwd_table);
+
     void to_string(
             const dds::core::xtypes::DynamicData &data,
             std::string &str_out);
+
+    size_t find_entry(
+            const dds::core::xtypes::DynamicData &data,
+            InternalMatchingTable &fwd_table);
+
+    static void key_hash_to_string(
+            const dds::sub::SampleInfo &info,
+            std::string &str_out);
+
+private:
+    /*
+     * Calls a function with the struct that contains the member, loaning the
+     * nested structs if the member is nested.
+     */
+    template <typename Function>
+    void with_parent(
+            const dds::core::xtypes::DynamicData &data,
+            size_t depth,
+            Function function)
+    {
+        if (!data.member_exists(member_path[depth])) {
+            throw dds::core::InvalidArgumentError(
+                    "input member not found in sample: " + this->name);
+        }
+        if (depth + 1 == member_path.size()) {
+            function(data);
+            return;
+        }
+        /* loaning a member to read it doesn't modify the sample */
+        auto loaned_member =
+                const_cast<dds::core::xtypes::DynamicData &>(data).loan_value(
+                        member_path[depth]);
+        with_parent(loaned_member.get(), depth + 1, function);
+    }
+
+    uint64_t read_ordinal(const dds::core::xtypes::DynamicData &data);
+
+    void format_value(
+            const dds::core::xtypes::DynamicData &data,
+            std::string &str_out);
+
+    std::string ordinal_to_string(uint64_t ordinal);
+
+    bool parse_ordinal(const std::string &str, uint64_t &ordinal_out);
+
+    bool parse_matcher(
+            const std::string &in_key,
+            std::vector<std::pair<uint64_t, uint64_t>> &ranges_out);
 };
 
 class ByInputValueForwardingEngine : public ForwardingEngine {
@@ -111,23 +383,38 @@ public:
     ByInputValueForwardingEngine(
             ByInputValueForwardingEngineConfiguration &config);
 
+    /* separates the members of an input_members entry */
+    static const char MEMBER_SEPARATOR;
+    /* separates the values of the members in a forwarding key */
+    static const char KEY_SEPARATOR;
+
 protected:
-    std::map<std::string, std::map<std::string, InputMemberValue>>
+    std::map<std::string,
+             std::map<std::string, std::vector<InputMemberValue>>>
             input_members_cache;
+    std::mutex input_members_mutex;
     InternalMatchingTable input_members;
+    ConsistentHashRing hash_ring;
 
     void get_forwarding_key(
             rti::routing::processor::TypedInput<dds::core::xtypes::DynamicData>
                     &input,
             const dds::core::xtypes::DynamicData &data,
+            const dds::sub::SampleInfo &info,
             std::string &fwd_key_out);
 
-    InputMemberValue &cache_input_member(
+    size_t find_forwarding_output(
+            rti::routing::processor::TypedInput<dds::core::xtypes::DynamicData>
+                    &input,
+            const dds::core::xtypes::DynamicData &data,
+            const dds::sub::SampleInfo &info);
+
+    std::vector<InputMemberValue> &cache_input_member(
             rti::routing::processor::TypedInput<dds::core::xtypes::DynamicData>
                     &input,
             const dds::core::xtypes::DynamicData &data);
 
-    std::map<std::string, InputMemberValue> &get_input_map(
+    std::map<std::string, std::vector<InputMemberValue>> &get_input_map(
             rti::routing::processor::TypedInput<dds::core::xtypes::DynamicData>
                     &input);
 };
@@ -0,0 +1,101 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#ifndef rtiprocess_fwd_glob_hpp
+#define rtiprocess_fwd_glob_hpp
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rti { namespace prcs { namespace fwd {
+
+/*
+ * Matches a string against many glob patterns at once. The patterns follow
+ * the syntax of fnmatch() without flags ('*', '?', '[...]' and '\' escapes)
+ * and are merged into a trie, so the common prefixes of the patterns are
+ * only evaluated once. The trie is used as a non-deterministic automaton:
+ * all the states that are reachable with the characters consumed so far
+ * are kept, and every character of the string advances all of them.
+ */
+class GlobAutomaton {
+public:
+    static const size_t NO_MATCH;
+
+    GlobAutomaton();
+
+    /*
+     * Whether a string contains characters with a special meaning in a
+     * glob pattern. Strings that don't only match themselves.
+     */
+    static bool is_pattern(const std::string &str);
+
+    /*
+     * Adds a pattern identified by an id. When several patterns match a
+     * string, the lowest id is returned by match().
+     */
+    void add(const std::string &pattern, size_t id);
+
+    /*
+     * Returns the lowest id of the patterns that match a string, or
+     * NO_MATCH if none of them does.
+     */
+    size_t match(const std::string &str) const;
+
+    bool empty() const;
+
+private:
+    struct CharClass {
+        bool negated;
+        std::vector<std::pair<unsigned char, unsigned char>> ranges;
+
+        bool contains(unsigned char c) const;
+    };
+
+    struct ClassTransition {
+        std::string source;
+        CharClass char_class;
+        size_t next;
+    };
+
+    struct State {
+        std::unordered_map<unsigned char, size_t> literals;
+        std::vector<ClassTransition> classes;
+        size_t any_char;
+        size_t any_string;
+        /* reached through a '*', so any character stays in the state */
+        bool loops;
+        size_t accept_id;
+
+        State();
+    };
+
+    std::vector<State> states;
+
+    size_t new_state();
+
+    void add_state(std::vector<size_t> &active, size_t state) const;
+
+    static bool parse_class(
+            const std::string &pattern,
+            size_t &pos,
+            std::string &source,
+            CharClass &char_class);
+};
+
+}}}  // namespace rti::prcs::fwd
+
+#endif /* rtiprocess_fwd_glob_hpp */
@@ -23,6 +23,12 @@ namespace rti { namespace prcs { namespace fwd { namespace property {
 extern const std::string PREFIX;
 extern const std::string FORWARDING_TABLE;
 extern const std::string INPUT_MEMBERS_TABLE;
+extern const std::string LOOKUP_CACHE_SIZE;
+extern const std::string HASH_OUTPUTS;
+extern const std::string WORKER_THREADS;
+
+extern const uint32_t LOOKUP_CACHE_SIZE_DEFAULT;
+extern const uint32_t WORKER_THREADS_DEFAULT;
 
 extern const std::string FORWARDING_TABLE_KEY_IN_KEY;
 extern const std::string FORWARDING_TABLE_KEY_OUT_NAME;
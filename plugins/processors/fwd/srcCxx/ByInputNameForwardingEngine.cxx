@@ -34,6 +34,7 @@ ByInputNameForwardingEngine::ByInputNameForwardingEngine(
 void ByInputNameForwardingEngine::get_forwarding_key(
         TypedInput<DynamicData> &input,
         const DynamicData &data,
+        const dds::sub::SampleInfo &info,
         std::string &fwd_key_out)
 {
     RTI_PRCS_FWD_LOG_FN(
@@ -13,6 +13,10 @@
 /*                                                                            */
 /******************************************************************************/
 
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
 #include <rtiprocess_fwd.hpp>
 
 using namespace dds::core::xtypes;
@@ -23,6 +27,7 @@ using namespace rti::prcs::fwd;
 
 #define RTI_PRCS_FWD_LOG_ARGS "rti::prcs::fwd::ByInputValueForwardingEngine"
 
+const char *InputMemberValue::KEY_HASH = "@key_hash";
 const char *InputMemberValue::FORMAT_BOOLEAN = "%d";
 const char *InputMemberValue::FORMAT_UINT8 = "%u";
 const char *InputMemberValue::FORMAT_UINT16 = "%u";
@@ -36,6 +41,9 @@ const char *InputMemberValue::FORMAT_FLOAT32 = "%f";
 const char *InputMemberValue::FORMAT_FLOAT64 = "%f";
 const char *InputMemberValue::FORMAT_STRING = "%s";
 
+/* XOR'ed to signed values so their ordinals keep the same order */
+static const uint64_t SIGNED_ORDINAL_BIAS = 1ULL << 63;
+
 template <class T>
 std::string print_input_field(const std::string &format, const T &val)
 {
@@ -62,7 +70,7 @@ std::string format_primitive_field(
     RTI_PRCS_FWD_LOG_FN(format_primitive_field)
     return print_input_field<T>(
             mapping->string_format,
-            data.value<T>(mapping->name));
+            data.value<T>(mapping->member_id));
 }
 
 static std::string default_input_member_format(const TypeKind &tk)
@@ -106,6 +114,7 @@ static std::string default_input_member_format(const TypeKind &tk)
         input_fmt = InputMemberValue::FORMAT_FLOAT64;
         break;
     case TypeKind::STRING_TYPE:
+    case TypeKind::ENUMERATION_TYPE:
         input_fmt = InputMemberValue::FORMAT_STRING;
         break;
     default:
@@ -115,7 +124,108 @@ static std::string default_input_member_format(const TypeKind &tk)
     return input_fmt;
 }
 
+IntegerMatchingTable::IntegerMatchingTable()
+        : first_pattern_index(GlobAutomaton::NO_MATCH)
+{
+}
+
+void IntegerMatchingTable::add_range(uint64_t low, uint64_t high, size_t index)
+{
+    if (low == high) {
+        /* the first entry that contains a value wins */
+        if (values.find(low) == values.end()) {
+            values[low] = index;
+        }
+        return;
+    }
+
+    Range range;
+    range.low = low;
+    range.high = high;
+    range.index = index;
+    ranges.push_back(range);
+}
+
+void IntegerMatchingTable::add_pattern(size_t index)
+{
+    first_pattern_index = std::min(first_pattern_index, index);
+}
+
+size_t IntegerMatchingTable::match(uint64_t ordinal) const
+{
+    size_t index = GlobAutomaton::NO_MATCH;
+
+    auto it = values.find(ordinal);
+    if (it != values.end()) {
+        index = it->second;
+    }
+    /* ranges were added in the order of their entries */
+    for (auto &range : ranges) {
+        if (range.index >= index) {
+            break;
+        }
+        if (ordinal >= range.low && ordinal <= range.high) {
+            index = range.index;
+            break;
+        }
+    }
+
+    return index;
+}
+
+size_t IntegerMatchingTable::first_pattern() const
+{
+    return first_pattern_index;
+}
+
+/*
+ * Gets the id of every level of a (possibly nested) member name, and the
+ * information of the member from the struct that contains it. The nested
+ * structs have to be loaned in order to get the ids of their members.
+ */
+static void resolve_member_path(
+        const DynamicData &data,
+        const std::vector<std::string> &member_names,
+        size_t depth,
+        std::vector<uint32_t> &member_path,
+        dds::core::optional<rti::core::xtypes::DynamicDataMemberInfo> &info,
+        std::map<uint64_t, std::string> &enumerator_names)
+{
+    const std::string &member_name = member_names[depth];
+
+    member_path.push_back(data.member_index(member_name));
+    if (depth + 1 < member_names.size()) {
+        /* loaning a member to read it doesn't modify the sample */
+        auto loaned_member = const_cast<DynamicData &>(data).loan_value(
+                member_path.back());
+        resolve_member_path(
+                loaned_member.get(),
+                member_names,
+                depth + 1,
+                member_path,
+                info,
+                enumerator_names);
+        return;
+    }
+
+    info.set(data.member_info(member_name));
+    if (info.get().member_kind() == TypeKind::ENUMERATION_TYPE) {
+        /* the member kind is resolved, but the type may be an alias */
+        const StructType &struct_type = static_cast<const StructType &>(
+                rti::core::xtypes::resolve_alias(data.type()));
+        const EnumType &enum_type = static_cast<const EnumType &>(
+                rti::core::xtypes::resolve_alias(
+                        struct_type.member(member_name).type()));
+        for (auto &enumerator : enum_type.members()) {
+            uint64_t ordinal = static_cast<uint64_t>(enumerator.ordinal())
+                    ^ SIGNED_ORDINAL_BIAS;
+            enumerator_names[ordinal] = enumerator.name();
+        }
+    }
+}
+
 InputMemberValue::InputMemberValue()
+        : member_id(0), is_key_hash(false), is_integer(false), is_signed(false)
 {
 }
 
@@ -123,56 +233,275 @@ InputMemberValue::InputMemberValue()
 InputMemberValue::InputMemberValue(
         const char *name,
         const dds::core::xtypes::DynamicData &data)
+        : member_id(0), is_key_hash(false), is_integer(false), is_signed(false)
 {
     RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::InputMemberValue::InputMemberValue)
 
     this->name = name;
-    this->info.set(data.member_info(this->name));
+    if (this->name == KEY_HASH) {
+        this->is_key_hash = true;
+        return;
+    }
+
+    /* nested members are separated by '.' */
+    std::vector<std::string> member_names;
+    size_t begin = 0;
+    while (begin <= this->name.size()) {
+        size_t end = this->name.find('.', begin);
+        if (end == std::string::npos) {
+            end = this->name.size();
+        }
+        member_names.push_back(this->name.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    resolve_member_path(
+            data,
+            member_names,
+            0,
+            this->member_path,
+            this->info,
+            this->enumerator_names);
+    this->member_id = this->member_path.back();
     this->string_format =
             default_input_member_format(this->info.get().member_kind());
-}
 
-void InputMemberValue::to_string(const DynamicData &data, std::string &str_out)
-{
-    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::InputMemberValue::to_string)
-
-    if (!data.member_exists(this->name)) {
-        throw dds::core::InvalidArgumentError(
-                "input member not found in sample: " + this->name);
+    switch (this->info.get().member_kind().underlying()) {
+    case TypeKind::BOOLEAN_TYPE:
+    case TypeKind::UINT_8_TYPE:
+    case TypeKind::UINT_16_TYPE:
+    case TypeKind::UINT_32_TYPE:
+    case TypeKind::UINT_64_TYPE:
+        this->is_integer = true;
+        this->is_signed = false;
+        break;
+    case TypeKind::INT_16_TYPE:
+    case TypeKind::INT_32_TYPE:
+    case TypeKind::INT_64_TYPE:
+        this->is_integer = true;
+        this->is_signed = true;
+        break;
+    case TypeKind::ENUMERATION_TYPE:
+        this->is_integer = true;
+        this->is_signed = true;
+        break;
+    default:
+        return;
     }
+}
 
-    if (!this->info.is_set()) {
-        throw dds::core::InvalidArgumentError(
-                "not type information for input member: " + this->name);
+void InputMemberValue::compile_matchers(const InternalMatchingTable &fwd_table)
+{
+    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::InputMemberValue::compile_matchers)
+
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    for (size_t i = 0; i < fwd_table.entries.size(); i++) {
+        const std::string &in_key = fwd_table.entries[i].in_key;
+
+        ranges.clear();
+        if (parse_matcher(in_key, ranges)) {
+            for (auto &range : ranges) {
+                this->fwd_matchers.add_range(range.first, range.second, i);
+            }
+        } else if (GlobAutomaton::is_pattern(in_key)) {
+            this->fwd_matchers.add_pattern(i);
+        }
+        /*
+         * Any other in_key cannot be equal to a formatted value, so the entry
+         * never matches this member.
+         */
     }
+}
 
+/* data is the struct that contains the member */
+uint64_t InputMemberValue::read_ordinal(const DynamicData &data)
+{
     switch (this->info.get().member_kind().underlying()) {
     case TypeKind::BOOLEAN_TYPE:
-        str_out = format_primitive_field<bool>(this, data);
-        break;
+        return data.value<bool>(this->member_id) ? 1 : 0;
     case TypeKind::UINT_8_TYPE:
-        str_out = format_primitive_field<uint8_t>(this, data);
-        break;
+        return data.value<uint8_t>(this->member_id);
     case TypeKind::UINT_16_TYPE:
-        str_out = format_primitive_field<uint16_t>(this, data);
-        break;
+        return data.value<uint16_t>(this->member_id);
     case TypeKind::UINT_32_TYPE:
-        str_out = format_primitive_field<uint32_t>(this, data);
-        break;
+        return data.value<uint32_t>(this->member_id);
     case TypeKind::UINT_64_TYPE:
-        str_out = format_primitive_field<uint64_t>(this, data);
-        break;
-    case TypeKind::CHAR_8_TYPE:
-        str_out = format_primitive_field<char>(this, data);
-        break;
+        return data.value<uint64_t>(this->member_id);
     case TypeKind::INT_16_TYPE:
-        str_out = format_primitive_field<int16_t>(this, data);
-        break;
+        return static_cast<uint64_t>(static_cast<int64_t>(
+                       data.value<int16_t>(this->member_id)))
+                ^ SIGNED_ORDINAL_BIAS;
     case TypeKind::INT_32_TYPE:
-        str_out = format_primitive_field<int32_t>(this, data);
-        break;
+    case TypeKind::ENUMERATION_TYPE:
+        return static_cast<uint64_t>(static_cast<int64_t>(
+                       data.value<int32_t>(this->member_id)))
+                ^ SIGNED_ORDINAL_BIAS;
     case TypeKind::INT_64_TYPE:
-        str_out = format_primitive_field<int64_t>(this, data);
+        return static_cast<uint64_t>(data.value<int64_t>(this->member_id))
+                ^ SIGNED_ORDINAL_BIAS;
+    default:
+        /* Should never get here */
+        throw dds::core::InvalidArgumentError("unexpected input member type");
+    }
+}
+
+std::string InputMemberValue::ordinal_to_string(uint64_t ordinal)
+{
+    if (!this->enumerator_names.empty()) {
+        auto it = this->enumerator_names.find(ordinal);
+        if (it != this->enumerator_names.end()) {
+            return it->second;
+        }
+    }
+    if (this->is_signed) {
+        return std::to_string(
+                static_cast<int64_t>(ordinal ^ SIGNED_ORDINAL_BIAS));
+    }
+    return std::to_string(ordinal);
+}
+
+/*
+ * Parses a value of the member: a decimal number, the name of an enumerator
+ * for enum members, or true/false for boolean members.
+ */
+bool InputMemberValue::parse_ordinal(
+        const std::string &str,
+        uint64_t &ordinal_out)
+{
+    for (auto &enumerator : this->enumerator_names) {
+        if (enumerator.second == str) {
+            ordinal_out = enumerator.first;
+            return true;
+        }
+    }
+    if (this->info.get().member_kind() == TypeKind::BOOLEAN_TYPE
+        && (str == "true" || str == "false")) {
+        ordinal_out = (str == "true") ? 1 : 0;
+        return true;
+    }
+
+    size_t digits = (!str.empty() && str[0] == '-') ? 1 : 0;
+    if (str.size() == digits
+        || str.find_first_not_of("0123456789", digits) != std::string::npos
+        || (digits == 1 && !this->is_signed)) {
+        return false;
+    }
+    try {
+        if (this->is_signed) {
+            ordinal_out = static_cast<uint64_t>(std::stoll(str))
+                    ^ SIGNED_ORDINAL_BIAS;
+        } else {
+            ordinal_out = std::stoull(str);
+        }
+    } catch (const std::out_of_range &) {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Parses an in_key into ranges of ordinals. An in_key may be '*', a value,
+ * a range "low..high" (either bound may be omitted), or a comma-separated
+ * list of values and ranges.
+ * The forwarding table is shared by all the inputs, so an in_key with any
+ * part that is not a value of the member (e.g. "1,east" or "1..x") may be
+ * meant for other inputs. It's not an error: it's just not parsed, and the
+ * entry only matches the member if it's a glob pattern.
+ */
+bool InputMemberValue::parse_matcher(
+        const std::string &in_key,
+        std::vector<std::pair<uint64_t, uint64_t>> &ranges_out)
+{
+    if (in_key == "*") {
+        ranges_out.push_back(std::make_pair(0, UINT64_MAX));
+        return true;
+    }
+
+    size_t begin = 0;
+    while (begin <= in_key.size()) {
+        size_t end = in_key.find(',', begin);
+        if (end == std::string::npos) {
+            end = in_key.size();
+        }
+        std::string item = in_key.substr(begin, end - begin);
+        std::pair<uint64_t, uint64_t> range(0, UINT64_MAX);
+        bool is_valid = true;
+
+        size_t separator = item.find("..");
+        if (separator == std::string::npos) {
+            is_valid = parse_ordinal(item, range.first);
+            range.second = range.first;
+        } else {
+            std::string low = item.substr(0, separator);
+            std::string high = item.substr(separator + 2);
+            is_valid = !(low.empty() && high.empty())
+                    && (low.empty() || parse_ordinal(low, range.first))
+                    && (high.empty() || parse_ordinal(high, range.second));
+        }
+        if (!is_valid) {
+            ranges_out.clear();
+            return false;
+        }
+        if (range.first <= range.second) {
+            ranges_out.push_back(range);
+        }
+        begin = end + 1;
+    }
+
+    return true;
+}
+
+size_t InputMemberValue::find_entry(
+        const DynamicData &data,
+        InternalMatchingTable &fwd_table)
+{
+    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::InputMemberValue::find_entry)
+
+    uint64_t ordinal = 0;
+    with_parent(data, 0, [&](const DynamicData &parent) {
+        ordinal = read_ordinal(parent);
+    });
+    size_t index = this->fwd_matchers.match(ordinal);
+
+    /* glob patterns are matched against the value as a string */
+    if (this->fwd_matchers.first_pattern() < index) {
+        index = std::min(index, fwd_table.lookup(ordinal_to_string(ordinal)));
+    }
+
+    if (index == GlobAutomaton::NO_MATCH) {
+        throw dds::core::InvalidArgumentError(
+                "no entry found for key: " + ordinal_to_string(ordinal));
+    }
+
+    return index;
+}
+
+void InputMemberValue::to_string(const DynamicData &data, std::string &str_out)
+{
+    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::InputMemberValue::to_string)
+
+    if (!this->info.is_set()) {
+        throw dds::core::InvalidArgumentError(
+                "not type information for input member: " + this->name);
+    }
+
+    with_parent(data, 0, [&](const DynamicData &parent) {
+        format_value(parent, str_out);
+    });
+}
+
+/* data is the struct that contains the member */
+void InputMemberValue::format_value(
+        const DynamicData &data,
+        std::string &str_out)
+{
+    if (this->is_integer) {
+        str_out = ordinal_to_string(read_ordinal(data));
+        return;
+    }
+
+    switch (this->info.get().member_kind().underlying()) {
+    case TypeKind::CHAR_8_TYPE:
+        str_out.assign(1, data.value<char>(this->member_id));
         break;
     case TypeKind::FLOAT_32_TYPE:
         str_out = format_primitive_field<float>(this, data);
@@ -181,7 +510,7 @@ void InputMemberValue::to_string(const DynamicData &data, std::string &str_out)
         str_out = format_primitive_field<double>(this, data);
         break;
     case TypeKind::STRING_TYPE:
-        str_out = data.value<std::string>(this->name);
+        str_out = data.value<std::string>(this->member_id);
         break;
     default:
         /* Should never get here */
@@ -189,6 +518,28 @@ void InputMemberValue::to_string(const DynamicData &data, std::string &str_out)
     }
 }
 
+void InputMemberValue::key_hash_to_string(
+        const dds::sub::SampleInfo &info,
+        std::string &str_out)
+{
+    static const char *HEX_DIGITS = "0123456789abcdef";
+
+    if (info.instance_handle().is_nil()) {
+        throw dds::core::InvalidArgumentError(
+                "the sample does not belong to an instance");
+    }
+
+    const DDS_KeyHash_t &key_hash = info.instance_handle()->native().keyHash;
+    str_out.clear();
+    for (unsigned int i = 0; i < key_hash.length; i++) {
+        str_out += HEX_DIGITS[(key_hash.value[i] >> 4) & 0xf];
+        str_out += HEX_DIGITS[key_hash.value[i] & 0xf];
+    }
+}
+
+const char ByInputValueForwardingEngine::MEMBER_SEPARATOR = ',';
+const char ByInputValueForwardingEngine::KEY_SEPARATOR = '/';
+
 ByInputValueForwardingEngine::ByInputValueForwardingEngine(
         ByInputValueForwardingEngineConfiguration &config)
         : ForwardingEngine(config)
@@ -196,20 +547,66 @@ ByInputValueForwardingEngine::ByInputValueForwardingEngine(
     RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::ByInputValueForwardingEngine::
                                 ByInputValueForwardingEngine)
 
-    input_members =
-            InternalMatchingTable::from_matching_table(config.input_members());
+    input_members = InternalMatchingTable::from_matching_table(
+            config.input_members(),
+            config.lookup_cache_size());
+
+    for (auto &out_name : config.hash_outputs()) {
+        hash_ring.add(out_name, add_output(out_name));
+    }
+}
+
+size_t ByInputValueForwardingEngine::find_forwarding_output(
+        TypedInput<DynamicData> &input,
+        const DynamicData &data,
+        const dds::sub::SampleInfo &info)
+{
+    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::ByInputValueForwardingEngine::
+                                find_forwarding_output)
+
+    std::vector<InputMemberValue> &key_members =
+            cache_input_member(input, data);
+    if (hash_ring.empty() && key_members.size() == 1
+        && key_members[0].is_integer) {
+        return fwd_entry_outputs[key_members[0].find_entry(data, fwd_table)];
+    }
+
+    std::string fwd_key;
+    get_forwarding_key(input, data, info, fwd_key);
+
+    if (!hash_ring.empty()) {
+        return hash_ring.find(fwd_key);
+    }
+    return fwd_entry_outputs[fwd_table.find_index(fwd_key)];
 }
 
 void ByInputValueForwardingEngine::get_forwarding_key(
         TypedInput<DynamicData> &input,
         const DynamicData &data,
+        const dds::sub::SampleInfo &info,
         std::string &fwd_key_out)
 {
     RTI_PRCS_FWD_LOG_FN(
             rti::prcs::fwd::ByInputValueForwardingEngine::get_forwarding_key)
 
-    InputMemberValue &mem_value = cache_input_member(input, data);
-    mem_value.to_string(data, fwd_key_out);
+    std::vector<InputMemberValue> &key_members =
+            cache_input_member(input, data);
+
+    /* the values of composite keys are joined with KEY_SEPARATOR */
+    std::string member_str;
+    fwd_key_out.clear();
+    for (size_t i = 0; i < key_members.size(); i++) {
+        std::string &value_str = (i == 0) ? fwd_key_out : member_str;
+        if (key_members[i].is_key_hash) {
+            InputMemberValue::key_hash_to_string(info, value_str);
+        } else {
+            key_members[i].to_string(data, value_str);
+        }
+        if (i > 0) {
+            fwd_key_out += KEY_SEPARATOR;
+            fwd_key_out += member_str;
+        }
+    }
 
     RTI_PRCS_FWD_TRACE_3(
             "forwarding KEY:",
@@ -219,33 +616,38 @@ void ByInputValueForwardingEngine::get_forwarding_key(
             fwd_key_out.c_str())
 }
 
-std::map<std::string, InputMemberValue> &
+std::map<std::string, std::vector<InputMemberValue>> &
         ByInputValueForwardingEngine::get_input_map(
                 TypedInput<dds::core::xtypes::DynamicData> &input)
 {
     const std::string &in_name = input.name();
-    std::map<std::string, std::map<std::string, InputMemberValue>>::
+    std::map<std::string,
+             std::map<std::string, std::vector<InputMemberValue>>>::
             const_iterator input_it = input_members_cache.find(in_name);
 
     if (input_it == input_members_cache.end()) {
         /* no entry for this input, create one */
-        std::map<std::string, InputMemberValue> in_map;
+        std::map<std::string, std::vector<InputMemberValue>> in_map;
         input_members_cache[in_name] = in_map;
     }
 
     return input_members_cache[in_name];
 }
 
-InputMemberValue &ByInputValueForwardingEngine::cache_input_member(
-        TypedInput<dds::core::xtypes::DynamicData> &input,
-        const dds::core::xtypes::DynamicData &data)
+std::vector<InputMemberValue> &
+        ByInputValueForwardingEngine::cache_input_member(
+                TypedInput<dds::core::xtypes::DynamicData> &input,
+                const dds::core::xtypes::DynamicData &data)
 {
-    std::map<std::string, InputMemberValue> &in_map = get_input_map(input);
+    /* the inputs may be processed in parallel, see worker_threads */
+    std::lock_guard<std::mutex> lock(input_members_mutex);
+    std::map<std::string, std::vector<InputMemberValue>> &in_map =
+            get_input_map(input);
 
     InternalMatchingTableEntry &in_mem_entry =
-            input_members.find(input.name().c_str());
+            input_members.find(input.name());
 
-    std::map<std::string, InputMemberValue>::iterator in_mem_it =
+    std::map<std::string, std::vector<InputMemberValue>>::iterator in_mem_it =
             in_map.find(in_mem_entry.out_name);
 
     if (in_mem_it != in_map.end()) {
@@ -253,10 +655,34 @@ InputMemberValue &ByInputValueForwardingEngine::cache_input_member(
         return in_mem_it->second;
     }
 
-    InputMemberValue mem_entry(in_mem_entry.out_name.c_str(), data);
-    in_map[in_mem_entry.out_name] = mem_entry;
+    /* an entry may list several members, that make a composite key */
+    std::vector<InputMemberValue> key_members;
+    const std::string &members = in_mem_entry.out_name;
+    size_t begin = 0;
+    while (begin <= members.size()) {
+        size_t end = members.find(MEMBER_SEPARATOR, begin);
+        if (end == std::string::npos) {
+            end = members.size();
+        }
+        std::string member_name = members.substr(begin, end - begin);
+        if (member_name.empty()) {
+            throw dds::core::InvalidArgumentError(
+                    "empty member name in input member: " + members);
+        }
+        key_members.push_back(InputMemberValue(member_name.c_str(), data));
+        begin = end + 1;
+    }
+    /*
+     * the forwarding table is only compared with the value of the member
+     * when it is the whole key, see find_forwarding_output()
+     */
+    if (hash_ring.empty() && key_members.size() == 1
+        && key_members[0].is_integer) {
+        key_members[0].compile_matchers(fwd_table);
+    }
+    in_map[members] = key_members;
 
-    return in_map[in_mem_entry.out_name];
+    return in_map[members];
 }
 
 Processor *ByInputValueForwardingEnginePlugin::create_processor(
@@ -0,0 +1,72 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#include <algorithm>
+
+#include <rtiprocess_fwd.hpp>
+
+using namespace rti::prcs::fwd;
+
+const size_t ConsistentHashRing::POINTS_PER_VALUE = 64;
+
+/*
+ * 64-bit FNV-1a, followed by the finalizer of MurmurHash3 so that similar
+ * strings (e.g. "out#1" and "out#2") end up far away in the ring.
+ */
+uint64_t ConsistentHashRing::hash(const std::string &str)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : str) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+void ConsistentHashRing::add(const std::string &name, size_t value)
+{
+    for (size_t i = 0; i < POINTS_PER_VALUE; i++) {
+        points.push_back(
+                std::make_pair(hash(name + "#" + std::to_string(i)), value));
+    }
+    std::sort(points.begin(), points.end());
+}
+
+size_t ConsistentHashRing::find(const std::string &key) const
+{
+    if (points.empty()) {
+        throw dds::core::InvalidArgumentError("no values in the hash ring");
+    }
+
+    auto it = std::lower_bound(
+            points.begin(),
+            points.end(),
+            std::make_pair(hash(key), static_cast<size_t>(0)));
+    if (it == points.end()) {
+        /* the ring wraps around */
+        it = points.begin();
+    }
+    return it->second;
+}
+
+bool ConsistentHashRing::empty() const
+{
+    return points.empty();
+}
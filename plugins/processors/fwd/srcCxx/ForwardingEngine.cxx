@@ -13,6 +13,8 @@
 /*                                                                            */
 /******************************************************************************/
 
+#include <algorithm>
+
 #include <rtiprocess_fwd.hpp>
 
 #include <reda/reda_string.h>
@@ -49,38 +51,154 @@ bool InternalMatchingTableEntry::match(const char *in_key)
     }
 }
 
+InternalMatchingTableCache::InternalMatchingTableCache(size_t capacity)
+        : capacity(capacity)
+{
+}
+
+InternalMatchingTableCache::InternalMatchingTableCache(
+        const InternalMatchingTableCache &other)
+        : capacity(other.capacity)
+{
+}
+
+InternalMatchingTableCache &InternalMatchingTableCache::operator=(
+        const InternalMatchingTableCache &other)
+{
+    capacity = other.capacity;
+    clear();
+    return *this;
+}
+
+bool InternalMatchingTableCache::get(const std::string &key, size_t &index_out)
+{
+    if (capacity == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = positions.find(key);
+    if (it == positions.end()) {
+        return false;
+    }
+    /* move to the front, it is now the most recently used key */
+    lru.splice(lru.begin(), lru, it->second);
+    index_out = it->second->second;
+    return true;
+}
+
+void InternalMatchingTableCache::put(const std::string &key, size_t index)
+{
+    if (capacity == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (positions.find(key) != positions.end()) {
+        /* another thread already added it */
+        return;
+    }
+    if (lru.size() >= capacity) {
+        positions.erase(lru.back().first);
+        lru.pop_back();
+    }
+    lru.push_front(std::make_pair(key, index));
+    positions[key] = lru.begin();
+}
+
+void InternalMatchingTableCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    lru.clear();
+    positions.clear();
+}
+
+InternalMatchingTable::InternalMatchingTable(size_t cache_size)
+        : cache(cache_size)
+{
+}
+
+size_t InternalMatchingTable::match(const std::string &in_key) const
+{
+    size_t index = GlobAutomaton::NO_MATCH;
+
+    auto it = exact_entries.find(in_key);
+    if (it != exact_entries.end()) {
+        index = it->second;
+    }
+    /* a pattern that comes before the exact entry takes precedence */
+    if (index != 0 && !pattern_entries.empty()) {
+        index = std::min(index, pattern_entries.match(in_key));
+    }
+
+    return index;
+}
+
 InternalMatchingTableEntry &InternalMatchingTable::find(const char *in_key)
 {
-    for (InternalMatchingTableEntry &entry : entries) {
-        if (entry.match(in_key)) {
-            return entry;
-        }
+    return find(std::string(in_key));
+}
+
+size_t InternalMatchingTable::lookup(const std::string &in_key)
+{
+    size_t index;
+
+    if (!cache.get(in_key, index)) {
+        index = match(in_key);
+        cache.put(in_key, index);
     }
 
-    std::string in_key_str = in_key;
-    throw dds::core::InvalidArgumentError(
-            "no entry found for key: " + in_key_str);
+    return index;
+}
+
+size_t InternalMatchingTable::find_index(const std::string &in_key)
+{
+    size_t index = lookup(in_key);
+
+    if (index == GlobAutomaton::NO_MATCH) {
+        throw dds::core::InvalidArgumentError(
+                "no entry found for key: " + in_key);
+    }
+
+    return index;
+}
+
+InternalMatchingTableEntry &
+        InternalMatchingTable::find(const std::string &in_key)
+{
+    return entries[find_index(in_key)];
 }
 
 InternalMatchingTableEntry &
         InternalMatchingTable::add(const char *in_key, const char *out_name)
 {
-    try {
-        InternalMatchingTableEntry &cur_entry = find(in_key);
-        cur_entry.out_name = out_name;
-        return cur_entry;
-    } catch (...) {
-        InternalMatchingTableEntry entry(in_key, out_name);
-        entries.push_back(entry);
-        return entries.back();
+    std::string in_key_str = in_key;
+    size_t index = match(in_key_str);
+
+    /* the cached results may point to a different output now */
+    cache.clear();
+
+    if (index != GlobAutomaton::NO_MATCH) {
+        entries[index].out_name = out_name;
+        return entries[index];
     }
+
+    InternalMatchingTableEntry entry(in_key, out_name);
+    entries.push_back(entry);
+    if (GlobAutomaton::is_pattern(in_key_str)) {
+        pattern_entries.add(in_key_str, entries.size() - 1);
+    } else {
+        exact_entries[in_key_str] = entries.size() - 1;
+    }
+    return entries.back();
 }
 
 
-InternalMatchingTable
-        InternalMatchingTable::from_matching_table(const MatchingTable &table)
+InternalMatchingTable InternalMatchingTable::from_matching_table(
+        const MatchingTable &table,
+        size_t cache_size)
 {
-    InternalMatchingTable internal_table;
+    InternalMatchingTable internal_table(cache_size);
 
     RTI_PRCS_FWD_LOG_FN(
             rti::prcs::fwd::InternalMatchingTable::from_matching_table)
@@ -96,70 +214,260 @@ InternalMatchingTable
 void ForwardingEngine::on_data_available(Route &route)
 {
     RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::ForwardingEngine::on_data_available)
-    for (auto input : route.inputs<DynamicData>()) {
-        RTI_PRCS_FWD_TRACE_1(
-                "PROCESSING input:",
-                "input=%s",
-                input.name().c_str())
 
+    /*
+     * The route doesn't tell which input has data, so every enabled input is
+     * taken from on every notification, even if it has no samples.
+     */
+    if (!worker_pool || enabled_inputs.size() < 2) {
+        for (Input *input : enabled_inputs) {
+            process_input(route, *input, input_batches[0]);
+        }
+        return;
+    }
+
+    /*
+     * The inputs and outputs of the route are only used from this thread:
+     * the samples are taken here, the worker threads just find the output of
+     * every sample, and the batches are written here afterwards.
+     */
+    std::vector<TypedInput<DynamicData>> typed_inputs;
+    std::vector<LoanedSamples<DynamicData>> input_samples;
+    for (Input *input : enabled_inputs) {
         try {
-            LoanedSamples<DynamicData> samples = input->take();
+            TypedInput<DynamicData> typed_input = input->get<DynamicData>();
+            LoanedSamples<DynamicData> samples = typed_input->take();
 
             RTI_PRCS_FWD_TRACE_2(
                     "TAKEN samples:",
                     "input=%s, samples=%d",
-                    input.name().c_str(),
+                    input->name().c_str(),
                     samples.length())
 
-            for (auto sample : samples) {
-                if (sample.info().valid()) {
-                    forward_data(route, input, sample.data());
-                }
-            }
-
+            typed_inputs.push_back(typed_input);
+            input_samples.push_back(std::move(samples));
         } catch (const std::exception &e) {
             RTI_PRCS_FWD_ERROR_2(
                     "EXCEPTION processing input:",
                     "input='%s', what='%s'",
-                    input.name().c_str(),
+                    input->name().c_str(),
                     e.what())
         }
     }
+
+    /* the samples of an input are grouped by one task, so they keep their
+     * order */
+    input_tasks.clear();
+    for (size_t i = 0; i < typed_inputs.size(); i++) {
+        input_tasks.push_back([this, &typed_inputs, &input_samples, i]() {
+            group_samples(typed_inputs[i], input_samples[i], input_batches[i]);
+        });
+    }
+    worker_pool->run(input_tasks);
+
+    for (size_t i = 0; i < typed_inputs.size(); i++) {
+        write_batches(route, typed_inputs[i], input_batches[i]);
+    }
 }
 
-ForwardingEngine::ForwardingEngine(ForwardingEngineConfiguration &config)
+void ForwardingEngine::on_input_enabled(Route &route, Input &input)
 {
-    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::ForwardingEngine::ForwardingEngine)
+    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::ForwardingEngine::on_input_enabled)
 
-    this->fwd_table =
-            InternalMatchingTable::from_matching_table(config.fwd_table());
+    if (std::find(enabled_inputs.begin(), enabled_inputs.end(), &input)
+        == enabled_inputs.end()) {
+        enabled_inputs.push_back(&input);
+    }
+    if (input_batches.size() < enabled_inputs.size()) {
+        input_batches.resize(enabled_inputs.size());
+        for (auto &batches : input_batches) {
+            batches.batches.resize(output_names.size());
+        }
+    }
+}
+
+void ForwardingEngine::on_input_disabled(Route &route, Input &input)
+{
+    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::ForwardingEngine::on_input_disabled)
+
+    enabled_inputs.erase(
+            std::remove(enabled_inputs.begin(), enabled_inputs.end(), &input),
+            enabled_inputs.end());
 }
 
-void ForwardingEngine::forward_data(
+void ForwardingEngine::process_input(
         Route &route,
-        TypedInput<dds::core::xtypes::DynamicData> &input,
-        const dds::core::xtypes::DynamicData &data)
+        Input &input,
+        OutputBatches &batches)
 {
-    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::ForwardingEngine::forward_data)
+    RTI_PRCS_FWD_TRACE_1("PROCESSING input:", "input=%s", input.name().c_str())
 
     try {
-        std::string fwd_key;
-        get_forwarding_key(input, data, fwd_key);
-        InternalMatchingTableEntry &fwd_entry = fwd_table.find(fwd_key.c_str());
-        auto output = route.output<DynamicData>(fwd_entry.out_name);
-        RTI_PRCS_FWD_LOG_4(
-                "forwarding DATA:",
-                "input=%s, key=%s, match=%s, out=%s",
+        TypedInput<DynamicData> typed_input = input.get<DynamicData>();
+        LoanedSamples<DynamicData> samples = typed_input->take();
+
+        RTI_PRCS_FWD_TRACE_2(
+                "TAKEN samples:",
+                "input=%s, samples=%d",
                 input.name().c_str(),
-                fwd_key.c_str(),
-                fwd_entry.in_key.c_str(),
-                fwd_entry.out_name.c_str())
-        output.write(data);
+                samples.length())
+
+        group_samples(typed_input, samples, batches);
+        write_batches(route, typed_input, batches);
+
     } catch (const std::exception &e) {
         RTI_PRCS_FWD_ERROR_2(
-                "EXCEPTION forwarding data:",
+                "EXCEPTION processing input:",
                 "input='%s', what='%s'",
                 input.name().c_str(),
                 e.what())
     }
-}
\ No newline at end of file
+}
+
+void ForwardingEngine::on_start(Route &route)
+{
+    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::ForwardingEngine::on_start)
+
+    /* resolve the outputs once, instead of looking them up by name for every
+     * sample */
+    for (size_t i = 0; i < output_names.size(); i++) {
+        if (outputs[i]) {
+            continue;
+        }
+        try {
+            outputs[i].reset(new DynamicDataOutput(
+                    route.output<DynamicData>(output_names[i])));
+        } catch (const std::exception &e) {
+            /* it will be reported when a sample is forwarded to it */
+            RTI_PRCS_FWD_LOG_2(
+                    "output NOT FOUND:",
+                    "out=%s, what='%s'",
+                    output_names[i].c_str(),
+                    e.what())
+        }
+    }
+}
+
+ForwardingEngine::ForwardingEngine(ForwardingEngineConfiguration &config)
+{
+    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::ForwardingEngine::ForwardingEngine)
+
+    this->fwd_table = InternalMatchingTable::from_matching_table(
+            config.fwd_table(),
+            config.lookup_cache_size());
+
+    if (config.worker_threads() > 0) {
+        worker_pool.reset(new ForwardingWorkerPool(config.worker_threads()));
+    }
+    /* used when the inputs are processed one at a time */
+    input_batches.resize(1);
+
+    /* entries that forward to the same output share its batch, so the
+     * samples written to an output keep the order they were taken in */
+    for (auto &entry : fwd_table.entries) {
+        fwd_entry_outputs.push_back(add_output(entry.out_name));
+    }
+}
+
+size_t ForwardingEngine::add_output(const std::string &out_name)
+{
+    auto it = output_indexes.find(out_name);
+    if (it != output_indexes.end()) {
+        return it->second;
+    }
+
+    output_indexes[out_name] = output_names.size();
+    output_names.push_back(out_name);
+    outputs.push_back(std::unique_ptr<DynamicDataOutput>());
+    for (auto &batches : input_batches) {
+        batches.batches.push_back(std::vector<const DynamicData *>());
+    }
+    return output_names.size() - 1;
+}
+
+ForwardingEngine::DynamicDataOutput &
+        ForwardingEngine::get_output(Route &route, size_t output_index)
+{
+    if (!outputs[output_index]) {
+        outputs[output_index].reset(new DynamicDataOutput(
+                route.output<DynamicData>(output_names[output_index])));
+    }
+    return *outputs[output_index];
+}
+
+void ForwardingEngine::group_samples(
+        TypedInput<dds::core::xtypes::DynamicData> &input,
+        LoanedSamples<dds::core::xtypes::DynamicData> &samples,
+        OutputBatches &batches)
+{
+    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::ForwardingEngine::group_samples)
+
+    /* the batches point to the loaned samples, they are not copied */
+    for (auto sample : samples) {
+        if (!sample.info().valid()) {
+            continue;
+        }
+        try {
+            size_t output_index = find_forwarding_output(
+                    input,
+                    sample.data(),
+                    sample.info());
+            std::vector<const DynamicData *> &batch =
+                    batches.batches[output_index];
+            if (batch.empty()) {
+                batches.pending_outputs.push_back(output_index);
+            }
+            batch.push_back(&sample.data());
+        } catch (const std::exception &e) {
+            RTI_PRCS_FWD_ERROR_2(
+                    "EXCEPTION forwarding data:",
+                    "input='%s', what='%s'",
+                    input.name().c_str(),
+                    e.what())
+        }
+    }
+}
+
+void ForwardingEngine::write_batches(
+        Route &route,
+        TypedInput<dds::core::xtypes::DynamicData> &input,
+        OutputBatches &batches)
+{
+    RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::ForwardingEngine::write_batches)
+
+    for (size_t output_index : batches.pending_outputs) {
+        std::vector<const DynamicData *> &batch =
+                batches.batches[output_index];
+        try {
+            DynamicDataOutput &output = get_output(route, output_index);
+            RTI_PRCS_FWD_LOG_3(
+                    "forwarding DATA:",
+                    "input=%s, out=%s, samples=%lu",
+                    input.name().c_str(),
+                    output_names[output_index].c_str(),
+                    static_cast<unsigned long>(batch.size()))
+            for (const DynamicData *data : batch) {
+                output.write(*data);
+            }
+        } catch (const std::exception &e) {
+            RTI_PRCS_FWD_ERROR_3(
+                    "EXCEPTION forwarding data:",
+                    "input='%s', out='%s', what='%s'",
+                    input.name().c_str(),
+                    output_names[output_index].c_str(),
+                    e.what())
+        }
+        batch.clear();
+    }
+    batches.pending_outputs.clear();
+}
+
+size_t ForwardingEngine::find_forwarding_output(
+        TypedInput<dds::core::xtypes::DynamicData> &input,
+        const dds::core::xtypes::DynamicData &data,
+        const dds::sub::SampleInfo &info)
+{
+    std::string fwd_key;
+    get_forwarding_key(input, data, info, fwd_key);
+    return fwd_entry_outputs[fwd_table.find_index(fwd_key)];
+}
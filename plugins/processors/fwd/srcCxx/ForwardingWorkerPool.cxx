@@ -0,0 +1,83 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#include <rtiprocess_fwd.hpp>
+
+using namespace rti::prcs::fwd;
+
+ForwardingWorkerPool::ForwardingWorkerPool(size_t thread_count)
+        : tasks(nullptr), next_task(0), pending_tasks(0), stopping(false)
+{
+    for (size_t i = 0; i < thread_count; i++) {
+        threads.push_back(std::thread(&ForwardingWorkerPool::worker, this));
+    }
+}
+
+ForwardingWorkerPool::~ForwardingWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_available.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void ForwardingWorkerPool::run(const std::vector<std::function<void()>> &tasks)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    this->tasks = &tasks;
+    next_task = 0;
+    pending_tasks = tasks.size();
+    task_available.notify_all();
+
+    /* the calling thread helps instead of just waiting */
+    while (next_task < tasks.size()) {
+        run_next_task(lock);
+    }
+    tasks_done.wait(lock, [this]() { return pending_tasks == 0; });
+    this->tasks = nullptr;
+}
+
+void ForwardingWorkerPool::worker()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        task_available.wait(lock, [this]() {
+            return stopping || (tasks != nullptr && next_task < tasks->size());
+        });
+        if (stopping) {
+            return;
+        }
+        run_next_task(lock);
+    }
+}
+
+void ForwardingWorkerPool::run_next_task(std::unique_lock<std::mutex> &lock)
+{
+    const std::function<void()> &task = (*tasks)[next_task++];
+
+    lock.unlock();
+    task();
+    lock.lock();
+
+    if (--pending_tasks == 0) {
+        tasks_done.notify_all();
+    }
+}
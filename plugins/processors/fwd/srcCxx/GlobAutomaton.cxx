@@ -0,0 +1,247 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#include <algorithm>
+
+#include <rtiprocess_fwd_glob.hpp>
+
+using namespace rti::prcs::fwd;
+
+const size_t GlobAutomaton::NO_MATCH = static_cast<size_t>(-1);
+
+GlobAutomaton::State::State()
+        : any_char(NO_MATCH),
+          any_string(NO_MATCH),
+          loops(false),
+          accept_id(NO_MATCH)
+{
+}
+
+bool GlobAutomaton::CharClass::contains(unsigned char c) const
+{
+    bool found = false;
+    for (auto &range : ranges) {
+        if (c >= range.first && c <= range.second) {
+            found = true;
+            break;
+        }
+    }
+    return found != negated;
+}
+
+GlobAutomaton::GlobAutomaton()
+{
+    /* initial state */
+    new_state();
+}
+
+bool GlobAutomaton::is_pattern(const std::string &str)
+{
+    return str.find_first_of("*?[\\") != std::string::npos;
+}
+
+bool GlobAutomaton::empty() const
+{
+    return states.size() == 1;
+}
+
+size_t GlobAutomaton::new_state()
+{
+    states.push_back(State());
+    return states.size() - 1;
+}
+
+/*
+ * Parses a bracket expression starting at pattern[pos], which is a '['. On
+ * success pos is left after the closing ']'. Like fnmatch(), a '[' without a
+ * closing ']' is not a bracket expression but a regular character.
+ */
+bool GlobAutomaton::parse_class(
+        const std::string &pattern,
+        size_t &pos,
+        std::string &source,
+        CharClass &char_class)
+{
+    size_t cur = pos + 1;
+
+    char_class.negated = false;
+    char_class.ranges.clear();
+    if (cur < pattern.size() && (pattern[cur] == '!' || pattern[cur] == '^')) {
+        char_class.negated = true;
+        cur++;
+    }
+
+    bool first = true;
+    while (cur < pattern.size()) {
+        if (pattern[cur] == ']' && !first) {
+            source = pattern.substr(pos, cur + 1 - pos);
+            pos = cur + 1;
+            return true;
+        }
+        first = false;
+
+        if (pattern[cur] == '\\' && cur + 1 < pattern.size()) {
+            cur++;
+        }
+        unsigned char low = pattern[cur++];
+        unsigned char high = low;
+
+        if (cur + 1 < pattern.size() && pattern[cur] == '-'
+            && pattern[cur + 1] != ']') {
+            cur++;
+            if (pattern[cur] == '\\' && cur + 1 < pattern.size()) {
+                cur++;
+            }
+            high = pattern[cur++];
+        }
+        char_class.ranges.push_back(std::make_pair(low, high));
+    }
+
+    return false;
+}
+
+void GlobAutomaton::add(const std::string &pattern, size_t id)
+{
+    size_t state = 0;
+    size_t pos = 0;
+
+    while (pos < pattern.size()) {
+        char c = pattern[pos];
+        size_t next = NO_MATCH;
+
+        if (c == '*') {
+            /* consecutive stars are the same as a single one */
+            while (pos < pattern.size() && pattern[pos] == '*') {
+                pos++;
+            }
+            if (states[state].any_string == NO_MATCH) {
+                next = new_state();
+                states[next].loops = true;
+                states[state].any_string = next;
+            }
+            state = states[state].any_string;
+            continue;
+        }
+
+        if (c == '?') {
+            pos++;
+            if (states[state].any_char == NO_MATCH) {
+                next = new_state();
+                states[state].any_char = next;
+            }
+            state = states[state].any_char;
+            continue;
+        }
+
+        if (c == '[') {
+            std::string source;
+            CharClass char_class;
+            if (parse_class(pattern, pos, source, char_class)) {
+                for (auto &transition : states[state].classes) {
+                    if (transition.source == source) {
+                        next = transition.next;
+                        break;
+                    }
+                }
+                if (next == NO_MATCH) {
+                    next = new_state();
+                    ClassTransition transition;
+                    transition.source = source;
+                    transition.char_class = char_class;
+                    transition.next = next;
+                    states[state].classes.push_back(transition);
+                }
+                state = next;
+                continue;
+            }
+        }
+
+        if (c == '\\') {
+            if (pos + 1 == pattern.size()) {
+                /* like fnmatch(), a trailing backslash never matches */
+                return;
+            }
+            pos++;
+            c = pattern[pos];
+        }
+        pos++;
+
+        auto it = states[state].literals.find(static_cast<unsigned char>(c));
+        if (it == states[state].literals.end()) {
+            next = new_state();
+            states[state].literals[static_cast<unsigned char>(c)] = next;
+        } else {
+            next = it->second;
+        }
+        state = next;
+    }
+
+    states[state].accept_id = std::min(states[state].accept_id, id);
+}
+
+void GlobAutomaton::add_state(std::vector<size_t> &active, size_t state) const
+{
+    active.push_back(state);
+    /* a '*' may match an empty string */
+    if (states[state].any_string != NO_MATCH) {
+        active.push_back(states[state].any_string);
+    }
+}
+
+size_t GlobAutomaton::match(const std::string &str) const
+{
+    std::vector<size_t> active;
+    std::vector<size_t> next_active;
+
+    add_state(active, 0);
+
+    for (size_t i = 0; i < str.size() && !active.empty(); i++) {
+        unsigned char c = str[i];
+
+        next_active.clear();
+        for (size_t state_id : active) {
+            const State &state = states[state_id];
+
+            if (state.loops) {
+                add_state(next_active, state_id);
+            }
+            auto it = state.literals.find(c);
+            if (it != state.literals.end()) {
+                add_state(next_active, it->second);
+            }
+            if (state.any_char != NO_MATCH) {
+                add_state(next_active, state.any_char);
+            }
+            for (auto &transition : state.classes) {
+                if (transition.char_class.contains(c)) {
+                    add_state(next_active, transition.next);
+                }
+            }
+        }
+
+        /* many paths may lead to the same state after a '*' */
+        std::sort(next_active.begin(), next_active.end());
+        next_active.erase(
+                std::unique(next_active.begin(), next_active.end()),
+                next_active.end());
+        active.swap(next_active);
+    }
+
+    size_t id = NO_MATCH;
+    for (size_t state_id : active) {
+        id = std::min(id, states[state_id].accept_id);
+    }
+    return id;
+}
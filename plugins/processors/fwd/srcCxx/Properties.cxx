@@ -13,6 +13,10 @@
 /*                                                                            */
 /******************************************************************************/
 
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
 #include <json.h>
 #include <rtiprocess_fwd.hpp>
 
@@ -31,6 +35,18 @@ const std::string property::FORWARDING_TABLE =
 const std::string property::INPUT_MEMBERS_TABLE =
         property::PREFIX + "input_members";
 
+const std::string property::LOOKUP_CACHE_SIZE =
+        property::PREFIX + "lookup_cache_size";
+
+const uint32_t property::LOOKUP_CACHE_SIZE_DEFAULT = 1024;
+
+const std::string property::HASH_OUTPUTS = property::PREFIX + "hash_outputs";
+
+const std::string property::WORKER_THREADS =
+        property::PREFIX + "worker_threads";
+
+const uint32_t property::WORKER_THREADS_DEFAULT = 0;
+
 const std::string property::FORWARDING_TABLE_KEY_IN_KEY = "input";
 const std::string property::FORWARDING_TABLE_KEY_OUT_NAME = "output";
 
@@ -159,6 +175,101 @@ static void parse_matching_table(
     parse_from_json(table, json_str, prop_key, member_in_key, member_out_name);
 }
 
+static void parse_uint32(
+        const PropertySet &properties,
+        const std::string &prop_key,
+        uint32_t default_value,
+        uint32_t &prop_value)
+{
+    PropertySet::const_iterator it = properties.find(prop_key);
+    if (it == properties.end()) {
+        prop_value = default_value;
+        return;
+    }
+
+    const std::string &value = it->second;
+    if (value.empty()
+        || value.find_first_not_of("0123456789") != std::string::npos) {
+        throw dds::core::InvalidArgumentError(
+                "value must be a non-negative integer: " + prop_key);
+    }
+    try {
+        unsigned long parsed_value = std::stoul(value);
+        if (parsed_value > UINT32_MAX) {
+            throw std::out_of_range(value);
+        }
+        prop_value = static_cast<uint32_t>(parsed_value);
+    } catch (const std::out_of_range &) {
+        throw dds::core::InvalidArgumentError(
+                "value out of range: " + prop_key);
+    }
+}
+
+static void parse_engine_config(
+        const PropertySet &properties,
+        ForwardingEngineConfiguration &config)
+{
+    parse_uint32(
+            properties,
+            property::LOOKUP_CACHE_SIZE,
+            property::LOOKUP_CACHE_SIZE_DEFAULT,
+            config.lookup_cache_size());
+    parse_uint32(
+            properties,
+            property::WORKER_THREADS,
+            property::WORKER_THREADS_DEFAULT,
+            config.worker_threads());
+}
+
+static void parse_hash_outputs(
+        const PropertySet &properties,
+        std::vector<std::string> &hash_outputs)
+{
+    PropertySet::const_iterator it = properties.find(property::HASH_OUTPUTS);
+    if (it == properties.end()) {
+        return;
+    }
+    const std::string &json_str = it->second;
+
+    json_value *outputs_json_value =
+            json_parse(json_str.c_str(), json_str.length());
+    if (outputs_json_value == nullptr) {
+        throw dds::core::InvalidArgumentError(
+                "failed to parse JSON: " + json_str);
+    }
+    if (outputs_json_value->type != json_array
+        || outputs_json_value->u.array.length == 0) {
+        json_value_free(outputs_json_value);
+        throw dds::core::InvalidArgumentError(
+                "property must contain a non-empty JSON array: "
+                + property::HASH_OUTPUTS);
+    }
+
+    for (unsigned int i = 0; i < outputs_json_value->u.array.length; i++) {
+        json_value &output_json_value = *outputs_json_value->u.array.values[i];
+
+        if (output_json_value.type != json_string
+            || output_json_value.u.string.length == 0) {
+            json_value_free(outputs_json_value);
+            throw dds::core::InvalidArgumentError(
+                    "outputs must be non-empty strings: "
+                    + property::HASH_OUTPUTS);
+        }
+        std::string out_name(
+                output_json_value.u.string.ptr,
+                output_json_value.u.string.length);
+        if (std::find(hash_outputs.begin(), hash_outputs.end(), out_name)
+            != hash_outputs.end()) {
+            json_value_free(outputs_json_value);
+            throw dds::core::InvalidArgumentError(
+                    "duplicate output in " + property::HASH_OUTPUTS + ": "
+                    + out_name);
+        }
+        hash_outputs.push_back(out_name);
+    }
+    json_value_free(outputs_json_value);
+}
+
 void property::parse_config(
         const PropertySet &properties,
         ByInputNameForwardingEngineConfiguration &config)
@@ -171,6 +282,7 @@ void property::parse_config(
             property::FORWARDING_TABLE,
             property::FORWARDING_TABLE_KEY_IN_KEY,
             property::FORWARDING_TABLE_KEY_OUT_NAME);
+    parse_engine_config(properties, config);
 }
 
 void property::parse_config(
@@ -180,12 +292,21 @@ void property::parse_config(
     RTI_PRCS_FWD_LOG_FN(rti::prcs::fwd::property::parse_config<
                         ByInputValueForwardingEngineConfiguration>)
 
-    parse_matching_table(
-            config.fwd_table(),
-            properties,
-            property::FORWARDING_TABLE,
-            property::FORWARDING_TABLE_KEY_IN_KEY,
-            property::FORWARDING_TABLE_KEY_OUT_NAME);
+    /* the outputs are either selected with a table or with a hash */
+    parse_hash_outputs(properties, config.hash_outputs());
+    if (config.hash_outputs().empty()) {
+        parse_matching_table(
+                config.fwd_table(),
+                properties,
+                property::FORWARDING_TABLE,
+                property::FORWARDING_TABLE_KEY_IN_KEY,
+                property::FORWARDING_TABLE_KEY_OUT_NAME);
+    } else if (
+            properties.find(property::FORWARDING_TABLE) != properties.end()) {
+        throw dds::core::InvalidArgumentError(
+                "properties cannot be used together: "
+                + property::FORWARDING_TABLE + ", " + property::HASH_OUTPUTS);
+    }
 
     InputMembersTable table;
     parse_matching_table(
@@ -195,4 +316,5 @@ void property::parse_config(
             property::INPUT_MEMBERS_TABLE_KEY_IN_KEY,
             property::INPUT_MEMBERS_TABLE_KEY_OUT_NAME);
     config.input_members(table);
+    parse_engine_config(properties, config);
 }
@@ -0,0 +1,147 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+
+#include <rtiprocess_fwd.hpp>
+
+#include "UtilsUnitTest.h"
+
+using namespace rti::prcs::fwd;
+using namespace rti::utils::test;
+
+#define KEY_COUNT 1000
+
+static ConsistentHashRing create_ring(const std::vector<std::string> &names)
+{
+    ConsistentHashRing ring;
+
+    for (size_t value = 0; value < names.size(); value++) {
+        ring.add(names[value], value);
+    }
+
+    return ring;
+}
+
+static bool test_hash_is_stable()
+{
+    /* other processes, on any platform, must map the keys in the same way */
+    RTI_UTILS_TEST_CHECK(
+            ConsistentHashRing::hash("") == 0xefd01f60ba992926ULL);
+    RTI_UTILS_TEST_CHECK(
+            ConsistentHashRing::hash("out#0") == 0xf2c286ed9a138599ULL);
+    RTI_UTILS_TEST_CHECK(
+            ConsistentHashRing::hash("sensor_1") == 0xdb3e809b3ff2200cULL);
+
+    return true;
+}
+
+static bool test_empty_ring()
+{
+    ConsistentHashRing ring;
+    bool has_thrown = false;
+
+    RTI_UTILS_TEST_CHECK(ring.empty());
+    try {
+        ring.find("key");
+    } catch (const dds::core::InvalidArgumentError &) {
+        has_thrown = true;
+    }
+    RTI_UTILS_TEST_CHECK(has_thrown);
+
+    ring.add("out", 3);
+    RTI_UTILS_TEST_CHECK(!ring.empty());
+    RTI_UTILS_TEST_CHECK(ring.find("key") == 3);
+
+    return true;
+}
+
+static bool test_same_key_maps_to_same_value()
+{
+    ConsistentHashRing ring = create_ring({ "out_a", "out_b", "out_c" });
+    ConsistentHashRing reversed_ring;
+
+    /* the ring doesn't depend on the order in which values are added */
+    reversed_ring.add("out_c", 2);
+    reversed_ring.add("out_b", 1);
+    reversed_ring.add("out_a", 0);
+
+    for (int i = 0; i < KEY_COUNT; i++) {
+        std::string key = "key_" + std::to_string(i);
+        size_t value = ring.find(key);
+        RTI_UTILS_TEST_CHECK(value < 3);
+        RTI_UTILS_TEST_CHECK(ring.find(key) == value);
+        RTI_UTILS_TEST_CHECK(reversed_ring.find(key) == value);
+    }
+
+    return true;
+}
+
+static bool test_every_value_gets_keys()
+{
+    std::vector<std::string> names;
+
+    for (size_t value_count = 1; value_count <= 8; value_count++) {
+        names.push_back("out_" + std::to_string(value_count));
+        ConsistentHashRing ring = create_ring(names);
+        std::vector<int> key_counts(value_count, 0);
+
+        for (int i = 0; i < KEY_COUNT; i++) {
+            key_counts[ring.find("key_" + std::to_string(i))]++;
+        }
+
+        /* every value gets at least half of a fair share of the keys */
+        for (auto count : key_counts) {
+            RTI_UTILS_TEST_CHECK(
+                    static_cast<size_t>(count)
+                    > KEY_COUNT / (2 * value_count));
+        }
+    }
+
+    return true;
+}
+
+static bool test_adding_value_only_remaps_to_it()
+{
+    ConsistentHashRing ring = create_ring({ "out_a", "out_b" });
+    ConsistentHashRing bigger_ring = create_ring({ "out_a", "out_b", "out_c" });
+    int remapped_count = 0;
+
+    for (int i = 0; i < KEY_COUNT; i++) {
+        std::string key = "key_" + std::to_string(i);
+        size_t value = bigger_ring.find(key);
+        if (value != ring.find(key)) {
+            RTI_UTILS_TEST_CHECK(value == 2);
+            remapped_count++;
+        }
+    }
+
+    /* the new value takes keys from the others */
+    RTI_UTILS_TEST_CHECK(remapped_count > 0);
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    return run_unit_tests({
+            { "hash is stable", test_hash_is_stable },
+            { "empty ring", test_empty_ring },
+            { "same key maps to same value",
+              test_same_key_maps_to_same_value },
+            { "every value gets keys", test_every_value_gets_keys },
+            { "adding value only remaps to it",
+              test_adding_value_only_remaps_to_it },
+    });
+}
@@ -0,0 +1,150 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+
+#include <rtiprocess_fwd.hpp>
+#include <rtiprocess_fwd_glob.hpp>
+
+#include "UtilsUnitTest.h"
+
+using namespace rti::prcs::fwd;
+using namespace rti::utils::test;
+
+static bool test_glob_syntax()
+{
+    GlobAutomaton automaton;
+
+    automaton.add("a?c", 0);
+    automaton.add("[x-z]1", 1);
+    automaton.add("[!x-z]2", 2);
+    automaton.add("\\*3", 3);
+    automaton.add("pre*post", 4);
+
+    RTI_UTILS_TEST_CHECK(automaton.match("abc") == 0);
+    RTI_UTILS_TEST_CHECK(automaton.match("ac") == GlobAutomaton::NO_MATCH);
+    RTI_UTILS_TEST_CHECK(automaton.match("y1") == 1);
+    RTI_UTILS_TEST_CHECK(automaton.match("a1") == GlobAutomaton::NO_MATCH);
+    RTI_UTILS_TEST_CHECK(automaton.match("a2") == 2);
+    RTI_UTILS_TEST_CHECK(automaton.match("y2") == GlobAutomaton::NO_MATCH);
+    RTI_UTILS_TEST_CHECK(automaton.match("*3") == 3);
+    RTI_UTILS_TEST_CHECK(automaton.match("x3") == GlobAutomaton::NO_MATCH);
+    RTI_UTILS_TEST_CHECK(automaton.match("prepost") == 4);
+    RTI_UTILS_TEST_CHECK(automaton.match("pre/a/post") == 4);
+    RTI_UTILS_TEST_CHECK(
+            automaton.match("prepos") == GlobAutomaton::NO_MATCH);
+
+    return true;
+}
+
+static bool test_lowest_id_wins()
+{
+    GlobAutomaton automaton;
+
+    /* the patterns share a prefix, and are added out of order */
+    automaton.add("a*", 1);
+    automaton.add("ab*", 0);
+    automaton.add("*", 2);
+
+    RTI_UTILS_TEST_CHECK(automaton.match("abc") == 0);
+    RTI_UTILS_TEST_CHECK(automaton.match("ab") == 0);
+    RTI_UTILS_TEST_CHECK(automaton.match("ax") == 1);
+    RTI_UTILS_TEST_CHECK(automaton.match("x") == 2);
+    RTI_UTILS_TEST_CHECK(automaton.match("") == 2);
+
+    return true;
+}
+
+static bool test_is_pattern()
+{
+    RTI_UTILS_TEST_CHECK(!GlobAutomaton::is_pattern("sensor_1"));
+    RTI_UTILS_TEST_CHECK(!GlobAutomaton::is_pattern("1..5,7"));
+    RTI_UTILS_TEST_CHECK(GlobAutomaton::is_pattern("sensor_*"));
+    RTI_UTILS_TEST_CHECK(GlobAutomaton::is_pattern("sensor_?"));
+    RTI_UTILS_TEST_CHECK(GlobAutomaton::is_pattern("sensor_[12]"));
+
+    return true;
+}
+
+static bool test_literal_before_glob()
+{
+    InternalMatchingTable table;
+
+    table.add("sensor_1", "out_literal");
+    table.add("sensor_*", "out_glob");
+
+    RTI_UTILS_TEST_CHECK(table.lookup("sensor_1") == 0);
+    RTI_UTILS_TEST_CHECK(table.lookup("sensor_2") == 1);
+    RTI_UTILS_TEST_CHECK(table.lookup("other") == GlobAutomaton::NO_MATCH);
+
+    return true;
+}
+
+static bool test_glob_before_literal()
+{
+    InternalMatchingTable table;
+
+    table.add("sensor_1", "out_literal");
+    table.add("*", "out_glob");
+    table.add("other", "out_other");
+
+    /* the literal entry that comes after '*' is never matched */
+    RTI_UTILS_TEST_CHECK(table.lookup("sensor_1") == 0);
+    RTI_UTILS_TEST_CHECK(table.lookup("other") == 1);
+    RTI_UTILS_TEST_CHECK(table.lookup("") == 1);
+    RTI_UTILS_TEST_CHECK(table.find("other").out_name == "out_other");
+
+    return true;
+}
+
+static bool test_cached_lookups()
+{
+    InternalMatchingTable table(2);
+
+    table.add("a*", "out_a");
+    table.add("b", "out_b");
+
+    /* more keys than the size of the cache, looked up twice */
+    for (int i = 0; i < 2; i++) {
+        RTI_UTILS_TEST_CHECK(table.lookup("a1") == 0);
+        RTI_UTILS_TEST_CHECK(table.lookup("b") == 1);
+        RTI_UTILS_TEST_CHECK(table.lookup("c") == GlobAutomaton::NO_MATCH);
+    }
+
+    /* adding an entry invalidates the cached results */
+    table.add("c", "out_c");
+    RTI_UTILS_TEST_CHECK(table.lookup("c") == 2);
+
+    bool has_thrown = false;
+    try {
+        table.find_index("d");
+    } catch (const dds::core::InvalidArgumentError &) {
+        has_thrown = true;
+    }
+    RTI_UTILS_TEST_CHECK(has_thrown);
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    return run_unit_tests({
+            { "glob syntax", test_glob_syntax },
+            { "lowest id wins", test_lowest_id_wins },
+            { "is_pattern", test_is_pattern },
+            { "literal before glob", test_literal_before_glob },
+            { "glob before literal", test_glob_before_literal },
+            { "cached lookups", test_cached_lookups },
+    });
+}
@@ -0,0 +1,266 @@
+/******************************************************************************/
+/* (c) 2020 Copyright, Real-Time Innovations, Inc. (RTI) All rights reserved. */
+/*                                                                            */
+/* RTI grants Licensee a license to use, modify, compile, and create          */
+/* derivative works of the software solely for use with RTI Connext DDS.      */
+/* Licensee may redistribute copies of the software provided that all such    */
+/* copies are subject to this license.                                        */
+/* The software is provided "as is", with no warranty of any type, including  */
+/* any warranty for fitness for any purpose. RTI is under no obligation to    */
+/* maintain or support the software.  RTI shall not be liable for any         */
+/* incidental or consequential damages arising out of the use or inability to */
+/* use the software.                                                          */
+/*                                                                            */
+/******************************************************************************/
+
+
+#include <dds/core/ddscore.hpp>
+
+#include <rtiprocess_fwd.hpp>
+
+#include "UtilsUnitTest.h"
+
+using namespace dds::core::xtypes;
+using namespace rti::prcs::fwd;
+using namespace rti::utils::test;
+
+/*
+ * Struct with the kinds of members that are matched by value: a signed and
+ * an unsigned integer, an enum and an alias of the enum.
+ */
+static StructType create_sample_type()
+{
+    EnumType color_type(
+            "Color",
+            { EnumMember("RED", 0),
+              EnumMember("GREEN", 1),
+              EnumMember("BLUE", 5) });
+    AliasType color_alias_type("ColorAlias", color_type);
+    StructType type("Sample");
+
+    type.add_member(Member("id", primitive_type<int32_t>()));
+    type.add_member(Member("count", primitive_type<uint16_t>()));
+    type.add_member(Member("color", color_type));
+    type.add_member(Member("alias_color", color_alias_type));
+
+    return type;
+}
+
+/*
+ * Compiles a forwarding table for a member, and finds the entry of the
+ * value of the member in a sample. Returns GlobAutomaton::NO_MATCH if no
+ * entry matches.
+ */
+static size_t find_entry(
+        InternalMatchingTable &table,
+        const DynamicData &data,
+        const char *member_name)
+{
+    InputMemberValue member(member_name, data);
+
+    member.compile_matchers(table);
+    try {
+        return member.find_entry(data, table);
+    } catch (const dds::core::InvalidArgumentError &) {
+        return GlobAutomaton::NO_MATCH;
+    }
+}
+
+static size_t find_id_entry(InternalMatchingTable &table, int32_t id)
+{
+    StructType type = create_sample_type();
+    DynamicData data(type);
+
+    data.value<int32_t>("id", id);
+    return find_entry(table, data, "id");
+}
+
+/* whether compiling a forwarding table with an in_key throws */
+static bool compile_throws(const char *in_key, const char *member_name)
+{
+    StructType type = create_sample_type();
+    DynamicData data(type);
+    InternalMatchingTable table;
+    InputMemberValue member(member_name, data);
+
+    table.add(in_key, "out");
+    try {
+        member.compile_matchers(table);
+    } catch (const dds::core::InvalidArgumentError &) {
+        return true;
+    }
+    return false;
+}
+
+static bool test_values_ranges_and_lists()
+{
+    InternalMatchingTable table;
+
+    table.add("1..5", "out_range");
+    table.add("7,9", "out_list");
+    table.add("100..", "out_open_high");
+    table.add("..-1", "out_open_low");
+
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 1) == 0);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 3) == 0);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 5) == 0);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 7) == 1);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 9) == 1);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 100) == 2);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 1000000) == 2);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, -1) == 3);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, -1000000) == 3);
+    RTI_UTILS_TEST_CHECK(
+            find_id_entry(table, 0) == GlobAutomaton::NO_MATCH);
+    RTI_UTILS_TEST_CHECK(
+            find_id_entry(table, 6) == GlobAutomaton::NO_MATCH);
+    RTI_UTILS_TEST_CHECK(
+            find_id_entry(table, 8) == GlobAutomaton::NO_MATCH);
+
+    return true;
+}
+
+static bool test_literal_before_glob()
+{
+    InternalMatchingTable table;
+
+    table.add("5", "out_literal");
+    table.add("1*", "out_glob");
+    table.add("*", "out_any");
+
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 5) == 0);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 1) == 1);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 12) == 1);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 7) == 2);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, -3) == 2);
+
+    return true;
+}
+
+static bool test_glob_before_literal()
+{
+    InternalMatchingTable table;
+
+    /* the glob is matched against the value formatted as a string */
+    table.add("1*", "out_glob");
+    table.add("1..20", "out_range");
+    table.add("7", "out_literal");
+
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 15) == 0);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 1) == 0);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 20) == 1);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 7) == 1);
+    RTI_UTILS_TEST_CHECK(
+            find_id_entry(table, 21) == GlobAutomaton::NO_MATCH);
+
+    return true;
+}
+
+static bool test_leading_zeros()
+{
+    InternalMatchingTable table;
+
+    table.add("05", "out_five");
+    table.add("-007", "out_minus_seven");
+
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 5) == 0);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, -7) == 1);
+
+    return true;
+}
+
+static bool test_enumerators()
+{
+    StructType type = create_sample_type();
+    DynamicData data(type);
+    InternalMatchingTable table;
+
+    table.add("RED", "out_red");
+    table.add("1", "out_green");
+    table.add("BLUE..", "out_blue");
+
+    const char *member_names[] = { "color", "alias_color" };
+    for (auto member_name : member_names) {
+        data.value<int32_t>(member_name, 0);
+        RTI_UTILS_TEST_CHECK(find_entry(table, data, member_name) == 0);
+        data.value<int32_t>(member_name, 1);
+        RTI_UTILS_TEST_CHECK(find_entry(table, data, member_name) == 1);
+        data.value<int32_t>(member_name, 5);
+        RTI_UTILS_TEST_CHECK(find_entry(table, data, member_name) == 2);
+    }
+
+    return true;
+}
+
+static bool test_unsigned_values()
+{
+    StructType type = create_sample_type();
+    DynamicData data(type);
+    InternalMatchingTable table;
+
+    /* a negative value cannot be a value of the member */
+    table.add("-1", "out_negative");
+    table.add("0..10", "out_range");
+
+    data.value<uint16_t>("count", 3);
+    RTI_UTILS_TEST_CHECK(find_entry(table, data, "count") == 1);
+    data.value<uint16_t>("count", 65535);
+    RTI_UTILS_TEST_CHECK(
+            find_entry(table, data, "count") == GlobAutomaton::NO_MATCH);
+
+    return true;
+}
+
+static bool test_keys_for_other_inputs()
+{
+    /*
+     * The table is shared by all the inputs, so keys that are not values
+     * of the member are not errors, even if some of their parts are
+     */
+    const char *in_keys[] = {
+        "1..x", "x,5", "1,,2", "1,foo", "east,west", "..", "sensor"
+    };
+    for (auto in_key : in_keys) {
+        RTI_UTILS_TEST_CHECK(!compile_throws(in_key, "id"));
+    }
+    RTI_UTILS_TEST_CHECK(!compile_throws("RED,PURPLE", "color"));
+    RTI_UTILS_TEST_CHECK(!compile_throws("-1,2", "count"));
+
+    /* and they never match the member */
+    InternalMatchingTable table;
+    table.add("1,foo", "out_other");
+    table.add("x,5", "out_other");
+    table.add("1..x", "out_other");
+    table.add("east,west", "out_string");
+    table.add("1", "out_one");
+    table.add("5", "out_five");
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 1) == 4);
+    RTI_UTILS_TEST_CHECK(find_id_entry(table, 5) == 5);
+
+    StructType type = create_sample_type();
+    DynamicData data(type);
+    InternalMatchingTable other_table;
+    other_table.add("RED,PURPLE", "out_other");
+    other_table.add("-1,2", "out_other");
+    data.value<int32_t>("color", 0);
+    RTI_UTILS_TEST_CHECK(
+            find_entry(other_table, data, "color") == GlobAutomaton::NO_MATCH);
+    data.value<uint16_t>("count", 2);
+    RTI_UTILS_TEST_CHECK(
+            find_entry(other_table, data, "count") == GlobAutomaton::NO_MATCH);
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    return run_unit_tests({
+            { "values, ranges and lists", test_values_ranges_and_lists },
+            { "literal before glob", test_literal_before_glob },
+            { "glob before literal", test_glob_before_literal },
+            { "leading zeros", test_leading_zeros },
+            { "enumerators", test_enumerators },
+            { "unsigned values", test_unsigned_values },
+            { "keys for other inputs", test_keys_for_other_inputs },
+    });
+}